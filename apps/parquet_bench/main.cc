@@ -0,0 +1,518 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 Scylladb, Ltd.
+ */
+
+/* End-to-end write and scan throughput.
+ *
+ * generate: writes a synthetic file with file_writer.
+ * scan: reads a file back with one of the readers:
+ *   - column: every column chunk with column_chunk_reader, timed per column. The wall time
+ *     of a column includes waiting for I/O; its CPU time does not, so it is the time
+ *     spent parsing, decompressing and decoding the column,
+ *   - projection: like column, but only the columns selected with --columns,
+ *   - record: whole records with multi_record_reader, through a consumer which only counts values,
+ *     opening --lookahead row groups ahead of the one being read,
+ *   - sharded: like record, but with sharded_scan, which reads the row groups on all shards.
+ *
+ * Results are printed as text, or as a single JSON object with --json,
+ * which is meant to be collected across commits for regression tracking.
+ * Reactor utilization is the CPU time of the reactor thread divided by the wall time.
+ * With --mmap, scan compares the mmap read mode against DMA reads (the mode gets an _mmap suffix
+ * if the file was mapped); run it on a file on tmpfs with --mmap in_memory.
+ * With --trace FILE, scan also writes a Chrome trace-event JSON of every page load phase.
+ */
+
+#include <parquet4seastar/file_writer.hh>
+#include <parquet4seastar/record_reader.hh>
+#include <parquet4seastar/sharded_scan.hh>
+#include <parquet4seastar/tracing.hh>
+#include <seastar/core/app-template.hh>
+#include <seastar/core/thread.hh>
+#include <boost/algorithm/string.hpp>
+#include <sys/resource.h>
+#include <chrono>
+#include <random>
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+using namespace parquet4seastar;
+
+constexpr size_t batch_size = 1024;
+
+class stopwatch {
+    using clock = std::chrono::steady_clock;
+    clock::time_point _wall_start = clock::now();
+    double _cpu_start = cpu_seconds();
+    static double cpu_seconds() {
+        rusage usage;
+        getrusage(RUSAGE_THREAD, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+                + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+    }
+public:
+    double wall() const { return std::chrono::duration<double>(clock::now() - _wall_start).count(); }
+    double cpu() const { return cpu_seconds() - _cpu_start; }
+};
+
+// A JSON string literal holding s.
+std::string json_string(const std::string& s) {
+    std::string out;
+    tracing::append_json_string(out, s);
+    return out;
+}
+
+struct column_result {
+    std::string name;
+    uint64_t values = 0;
+    double seconds = 0; // Wall time, waiting for I/O included.
+    double cpu_seconds = 0;
+};
+
+struct result {
+    std::string mode;
+    std::string file;
+    uint64_t file_bytes = 0;
+    uint64_t rows = 0;
+    uint64_t values = 0;
+    double seconds = 0;
+    double cpu_seconds = 0;
+    std::vector<column_result> columns;
+
+    void print_text(std::ostream& out) const {
+        out << mode << " " << file << ": " << rows << " rows, " << values << " values, "
+            << file_bytes << " bytes in " << seconds << " s\n"
+            << "  " << file_bytes / seconds / 1e6 << " MB/s, " << rows / seconds << " rows/s, "
+            << "reactor utilization " << cpu_seconds / seconds << "\n";
+        for (const column_result& c : columns) {
+            out << "  " << c.name << ": " << c.values << " values in " << c.seconds << " s ("
+                << c.cpu_seconds << " s CPU), " << c.values / c.cpu_seconds << " values per CPU second\n";
+        }
+    }
+    void print_json(std::ostream& out) const {
+        out << "{\"mode\": " << json_string(mode) << ", \"file\": " << json_string(file)
+            << ", \"file_bytes\": " << file_bytes
+            << ", \"rows\": " << rows
+            << ", \"values\": " << values
+            << ", \"seconds\": " << seconds
+            << ", \"mb_per_s\": " << file_bytes / seconds / 1e6
+            << ", \"rows_per_s\": " << rows / seconds
+            << ", \"reactor_utilization\": " << cpu_seconds / seconds
+            << ", \"columns\": [";
+        for (size_t i = 0; i < columns.size(); ++i) {
+            const column_result& c = columns[i];
+            out << (i ? ", " : "") << "{\"name\": " << json_string(c.name)
+                << ", \"values\": " << c.values
+                << ", \"seconds\": " << c.seconds
+                << ", \"cpu_seconds\": " << c.cpu_seconds
+                << ", \"values_per_cpu_s\": " << c.values / c.cpu_seconds << "}";
+        }
+        out << "]}\n";
+    }
+};
+
+/* Generation */
+
+enum class shape { flat, optional, list };
+
+struct generator_config {
+    std::vector<std::string> types;
+    shape column_shape;
+    uint64_t rows;
+    uint64_t row_group_rows;
+    size_t page_size;
+    format::Encoding::type encoding;
+    format::CompressionCodec::type codec;
+    double null_rate;
+    uint64_t cardinality; // 0 == unbounded
+};
+
+format::Encoding::type parse_encoding(const std::string& s) {
+    if (s == "PLAIN") { return format::Encoding::PLAIN; }
+    if (s == "RLE_DICTIONARY") { return format::Encoding::RLE_DICTIONARY; }
+    if (s == "DELTA_BINARY_PACKED") { return format::Encoding::DELTA_BINARY_PACKED; }
+    throw std::invalid_argument(seastar::format("Unsupported encoding: {}", s));
+}
+
+format::CompressionCodec::type parse_codec(const std::string& s) {
+    if (s == "UNCOMPRESSED") { return format::CompressionCodec::UNCOMPRESSED; }
+    if (s == "SNAPPY") { return format::CompressionCodec::SNAPPY; }
+    if (s == "GZIP") { return format::CompressionCodec::GZIP; }
+    throw std::invalid_argument(seastar::format("Unsupported codec: {}", s));
+}
+
+shape parse_shape(const std::string& s) {
+    if (s == "flat") { return shape::flat; }
+    if (s == "optional") { return shape::optional; }
+    if (s == "list") { return shape::list; }
+    throw std::invalid_argument(seastar::format("Unsupported shape: {}", s));
+}
+
+logical_type::logical_type parse_type(const std::string& s) {
+    if (s == "boolean") { return logical_type::BOOLEAN{}; }
+    if (s == "int32") { return logical_type::INT32{}; }
+    if (s == "int64") { return logical_type::INT64{}; }
+    if (s == "float") { return logical_type::FLOAT{}; }
+    if (s == "double") { return logical_type::DOUBLE{}; }
+    if (s == "string") { return logical_type::STRING{}; }
+    if (s == "uuid") { return logical_type::UUID{}; }
+    throw std::invalid_argument(seastar::format("Unsupported column type: {}", s));
+}
+
+template <typename T>
+std::unique_ptr<T> box(T&& x) {
+    return std::make_unique<T>(std::forward<T>(x));
+}
+
+writer_schema::schema make_schema(const generator_config& config) {
+    using namespace writer_schema;
+    schema root;
+    for (size_t i = 0; i < config.types.size(); ++i) {
+        logical_type::logical_type type = parse_type(config.types[i]);
+        format::Type::type physical_type = std::visit([] (auto lt) { return lt.physical_type; }, type);
+        format::Encoding::type encoding = config.encoding;
+        if (encoding == format::Encoding::DELTA_BINARY_PACKED
+                && physical_type != format::Type::INT32 && physical_type != format::Type::INT64) {
+            encoding = format::Encoding::PLAIN;
+        }
+        std::optional<uint32_t> type_length;
+        if (physical_type == format::Type::FIXED_LEN_BYTE_ARRAY) {
+            type_length = 16;
+        }
+        std::string name = seastar::format("c{}_{}", i, config.types[i]);
+        primitive_node leaf{name, config.column_shape == shape::optional, type, type_length, encoding, config.codec};
+        if (config.column_shape == shape::list) {
+            leaf.name = "element";
+            root.fields.push_back(list_node{name, false, box<node>(std::move(leaf))});
+        } else {
+            root.fields.push_back(std::move(leaf));
+        }
+    }
+    return root;
+}
+
+// Values are derived from a random key, so that --cardinality bounds the number of distinct values of every type.
+class value_generator {
+    std::mt19937_64 _rng{0};
+    uint64_t _cardinality;
+    bytes _buffer;
+public:
+    explicit value_generator(uint64_t cardinality) : _cardinality{cardinality} {}
+    uint64_t next_key() { return _cardinality ? _rng() % _cardinality : _rng(); }
+    bool next_null(double null_rate) { return std::uniform_real_distribution<double>{}(_rng) < null_rate; }
+    uint64_t next_list_size() { return 1 + _rng() % 3; }
+
+    template <format::Type::type T>
+    typename value_decoder_traits<T>::input_type value(uint64_t key) {
+        if constexpr (T == format::Type::BOOLEAN) {
+            return key & 1;
+        } else if constexpr (T == format::Type::INT32) {
+            return static_cast<int32_t>(key);
+        } else if constexpr (T == format::Type::INT64) {
+            return static_cast<int64_t>(key);
+        } else if constexpr (T == format::Type::FLOAT) {
+            return static_cast<float>(key % 1'000'000) * 1e-3f;
+        } else if constexpr (T == format::Type::DOUBLE) {
+            return static_cast<double>(key) * 1e-3;
+        } else {
+            size_t len = (T == format::Type::FIXED_LEN_BYTE_ARRAY) ? 16 : 8 + key % 25;
+            _buffer.resize(len);
+            uint64_t x = key;
+            for (byte& c : _buffer) {
+                x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                c = 'a' + (x >> 59) % 26;
+            }
+            return _buffer;
+        }
+    }
+};
+
+template <format::Type::type T>
+void put_row(column_chunk_writer<T>& w, shape column_shape, double null_rate, value_generator& gen) {
+    switch (column_shape) {
+    case shape::flat:
+        w.put(0, 0, gen.value<T>(gen.next_key()));
+        break;
+    case shape::optional:
+        if (gen.next_null(null_rate)) {
+            w.put(0, 0, {});
+        } else {
+            w.put(1, 0, gen.value<T>(gen.next_key()));
+        }
+        break;
+    case shape::list:
+        for (uint64_t i = 0, n = gen.next_list_size(); i < n; ++i) {
+            w.put(1, i > 0, gen.value<T>(gen.next_key()));
+        }
+        break;
+    }
+}
+
+template <format::Type::type T>
+void put_field(file_writer& fw, size_t column, const generator_config& config, value_generator& gen) {
+    column_chunk_writer<T>& w = fw.column<T>(column);
+    put_row(w, config.column_shape, config.null_rate, gen);
+    if (w.current_page_max_size() >= config.page_size) {
+        w.flush_page();
+    }
+}
+
+void put_field(file_writer& fw, format::Type::type type, size_t column, const generator_config& config, value_generator& gen) {
+    switch (type) {
+    case format::Type::BOOLEAN: return put_field<format::Type::BOOLEAN>(fw, column, config, gen);
+    case format::Type::INT32: return put_field<format::Type::INT32>(fw, column, config, gen);
+    case format::Type::INT64: return put_field<format::Type::INT64>(fw, column, config, gen);
+    case format::Type::FLOAT: return put_field<format::Type::FLOAT>(fw, column, config, gen);
+    case format::Type::DOUBLE: return put_field<format::Type::DOUBLE>(fw, column, config, gen);
+    case format::Type::BYTE_ARRAY: return put_field<format::Type::BYTE_ARRAY>(fw, column, config, gen);
+    case format::Type::FIXED_LEN_BYTE_ARRAY: return put_field<format::Type::FIXED_LEN_BYTE_ARRAY>(fw, column, config, gen);
+    default: throw parquet_exception(seastar::format("Cannot generate values of type {}", type));
+    }
+}
+
+result generate(const std::string& path, const generator_config& config) {
+    writer_schema::schema schema = make_schema(config);
+    std::vector<format::Type::type> physical_types;
+    for (const std::string& type : config.types) {
+        physical_types.push_back(std::visit([] (auto lt) { return lt.physical_type; }, parse_type(type)));
+    }
+    value_generator gen{config.cardinality};
+    stopwatch sw;
+    std::unique_ptr<file_writer> fw = file_writer::open(path, schema).get0();
+    for (uint64_t row = 0; row < config.rows; ++row) {
+        for (size_t i = 0; i < physical_types.size(); ++i) {
+            put_field(*fw, physical_types[i], i, config, gen);
+        }
+        if ((row + 1) % config.row_group_rows == 0 && row + 1 < config.rows) {
+            fw->flush_row_group().get();
+        }
+    }
+    fw->close().get();
+
+    result r;
+    r.mode = "generate";
+    r.file = path;
+    r.seconds = sw.wall();
+    r.cpu_seconds = sw.cpu();
+    r.rows = config.rows;
+    r.file_bytes = seastar::file_size(path).get0();
+    return r;
+}
+
+/* Scanning */
+
+template <format::Type::type T>
+uint64_t scan_column_chunk(file_reader& fr, uint32_t row_group, uint32_t column) {
+    using output_type = typename column_chunk_reader<T>::output_type;
+    column_chunk_reader<T> reader = fr.open_column_chunk_reader<T>(row_group, column).get0();
+    std::vector<output_type> values(batch_size);
+    std::vector<int16_t> def(batch_size);
+    std::vector<int16_t> rep(batch_size);
+    uint64_t total = 0;
+    while (size_t n = reader.read_batch(batch_size, def.data(), rep.data(), values.data()).get0()) {
+        total += n;
+    }
+    return total;
+}
+
+uint64_t scan_column_chunk(file_reader& fr, format::Type::type type, uint32_t row_group, uint32_t column) {
+    switch (type) {
+    case format::Type::BOOLEAN: return scan_column_chunk<format::Type::BOOLEAN>(fr, row_group, column);
+    case format::Type::INT32: return scan_column_chunk<format::Type::INT32>(fr, row_group, column);
+    case format::Type::INT64: return scan_column_chunk<format::Type::INT64>(fr, row_group, column);
+    case format::Type::INT96: return scan_column_chunk<format::Type::INT96>(fr, row_group, column);
+    case format::Type::FLOAT: return scan_column_chunk<format::Type::FLOAT>(fr, row_group, column);
+    case format::Type::DOUBLE: return scan_column_chunk<format::Type::DOUBLE>(fr, row_group, column);
+    case format::Type::BYTE_ARRAY: return scan_column_chunk<format::Type::BYTE_ARRAY>(fr, row_group, column);
+    case format::Type::FIXED_LEN_BYTE_ARRAY:
+        return scan_column_chunk<format::Type::FIXED_LEN_BYTE_ARRAY>(fr, row_group, column);
+    }
+    throw parquet_exception(seastar::format("Unknown physical type {}", type));
+}
+
+// Counts values instead of doing anything with them.
+struct counting_consumer {
+    uint64_t records = 0;
+    uint64_t values = 0;
+    void start_record() {}
+    void end_record() { ++records; }
+    void start_column(const std::string&) {}
+    void start_struct() {}
+    void end_struct() {}
+    void start_field(const std::string&) {}
+    void start_list() {}
+    void end_list() {}
+    void start_map() {}
+    void end_map() {}
+    void separate_key_value() {}
+    void separate_list_values() {}
+    void separate_map_values() {}
+    void append_null() { ++values; }
+    template <typename LogicalType, typename Value>
+    void append_value(LogicalType, Value&&) { ++values; }
+    uint64_t finish() { return values; }
+};
+
+mmap_policy parse_mmap_policy(const std::string& s) {
+    if (s == "never") { return mmap_policy::never; }
+    if (s == "in_memory") { return mmap_policy::in_memory; }
+    if (s == "always") { return mmap_policy::always; }
+    throw std::invalid_argument(seastar::format("Unsupported mmap policy: {}", s));
+}
+
+result scan(const std::string& path, const std::string& reader, const std::vector<uint32_t>& projection,
+        mmap_policy mmap, size_t lookahead) {
+    result r;
+    r.mode = "scan_" + reader;
+    r.file = path;
+    stopwatch sw;
+    io_options options;
+    options.mmap = mmap;
+    file_reader fr = file_reader::open(path, options).get0();
+    if (fr.mapped()) {
+        r.mode += "_mmap";
+    }
+    size_t n_row_groups = fr.metadata().row_groups.size();
+    if (reader == "record") {
+        counting_consumer consumer;
+        record::multi_record_reader rr{fr, lookahead};
+        rr.read_all(consumer).finally([&rr] {
+            return rr.close();
+        }).get();
+        r.values = consumer.values;
+    } else if (reader == "sharded") {
+        sharded_scan_options scan_options;
+        scan_options.io = options;
+        sharded_scan({path}, scan_options,
+                [] (const row_group_ref&) { return counting_consumer{}; },
+                [&r] (const row_group_ref&, uint64_t values) { r.values += values; }).get();
+    } else {
+        const auto& leaves = fr.raw_schema().leaves;
+        std::vector<uint32_t> columns = projection;
+        if (reader == "column") {
+            columns.clear();
+            for (uint32_t i = 0; i < leaves.size(); ++i) {
+                columns.push_back(i);
+            }
+        }
+        for (uint32_t column : columns) {
+            if (column >= leaves.size()) {
+                throw std::invalid_argument(seastar::format("Column {} does not exist", column));
+            }
+            column_result cr;
+            cr.name = boost::algorithm::join(leaves[column]->path, ".");
+            stopwatch column_sw;
+            for (size_t rg = 0; rg < n_row_groups; ++rg) {
+                cr.values += scan_column_chunk(fr, leaves[column]->info.type, rg, column);
+            }
+            cr.seconds = column_sw.wall();
+            cr.cpu_seconds = column_sw.cpu();
+            r.values += cr.values;
+            r.columns.push_back(std::move(cr));
+        }
+    }
+    r.seconds = sw.wall();
+    r.cpu_seconds = sw.cpu();
+    r.rows = fr.metadata().num_rows;
+    r.file_bytes = seastar::file_size(path).get0();
+    fr.close().get();
+    return r;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    seastar::app_template app;
+    app.add_options()
+        ("mode", bpo::value<std::string>()->default_value("scan"), "generate or scan")
+        ("file", bpo::value<std::string>(), "Parquet file path")
+        ("json", "Print the results as JSON")
+        ("trace", bpo::value<std::string>(), "scan: write a Chrome trace-event JSON of page loads to this file")
+        ("reader", bpo::value<std::string>()->default_value("column"), "scan: column, projection, record or sharded")
+        ("columns", bpo::value<std::string>()->default_value("0"), "scan: comma-separated leaf column indices for projection")
+        ("lookahead", bpo::value<size_t>()->default_value(1), "scan: row groups opened ahead by the record reader")
+        ("mmap", bpo::value<std::string>()->default_value("never"),
+                "scan: never, in_memory (files on tmpfs) or always map the file instead of DMA reads")
+        ("types", bpo::value<std::string>()->default_value("int64,double,string"),
+                "generate: comma-separated column types (boolean, int32, int64, float, double, string, uuid)")
+        ("shape", bpo::value<std::string>()->default_value("flat"), "generate: flat, optional or list columns")
+        ("rows", bpo::value<uint64_t>()->default_value(1'000'000), "generate: number of rows")
+        ("row-group-rows", bpo::value<uint64_t>()->default_value(100'000), "generate: rows per row group")
+        ("page-size", bpo::value<size_t>()->default_value(1024 * 1024), "generate: target uncompressed page size")
+        ("encoding", bpo::value<std::string>()->default_value("PLAIN"),
+                "generate: PLAIN, RLE_DICTIONARY or DELTA_BINARY_PACKED (PLAIN is used where it does not apply)")
+        ("codec", bpo::value<std::string>()->default_value("SNAPPY"), "generate: UNCOMPRESSED, SNAPPY or GZIP")
+        ("null-rate", bpo::value<double>()->default_value(0.1), "generate: fraction of nulls in optional columns")
+        ("cardinality", bpo::value<uint64_t>()->default_value(0), "generate: distinct values per column, 0 for unbounded");
+    return app.run(argc, argv, [&app] {
+        return seastar::async([&app] {
+            auto&& config = app.configuration();
+            std::string mode = config["mode"].as<std::string>();
+            if (!config.count("file")) {
+                throw std::invalid_argument("--file is required");
+            }
+            std::string file = config["file"].as<std::string>();
+            result r;
+            if (mode == "generate") {
+                generator_config gc;
+                boost::algorithm::split(gc.types, config["types"].as<std::string>(), boost::is_any_of(","));
+                gc.column_shape = parse_shape(config["shape"].as<std::string>());
+                gc.rows = config["rows"].as<uint64_t>();
+                gc.row_group_rows = std::max<uint64_t>(1, config["row-group-rows"].as<uint64_t>());
+                gc.page_size = config["page-size"].as<size_t>();
+                gc.encoding = parse_encoding(config["encoding"].as<std::string>());
+                gc.codec = parse_codec(config["codec"].as<std::string>());
+                gc.null_rate = config["null-rate"].as<double>();
+                gc.cardinality = config["cardinality"].as<uint64_t>();
+                r = generate(file, gc);
+            } else if (mode == "scan") {
+                std::vector<std::string> column_strings;
+                boost::algorithm::split(column_strings, config["columns"].as<std::string>(), boost::is_any_of(","));
+                std::vector<uint32_t> columns;
+                for (const std::string& s : column_strings) {
+                    columns.push_back(std::stoul(s));
+                }
+                std::string reader = config["reader"].as<std::string>();
+                if (reader != "column" && reader != "projection" && reader != "record" && reader != "sharded") {
+                    throw std::invalid_argument(seastar::format("Unknown reader: {}", reader));
+                }
+                std::optional<tracing::chrome_trace_writer> tracer;
+                if (config.count("trace")) {
+                    tracer.emplace();
+                    tracing::set_tracer(&*tracer);
+                }
+                r = scan(file, reader, columns, parse_mmap_policy(config["mmap"].as<std::string>()),
+                        config["lookahead"].as<size_t>());
+                if (tracer) {
+                    tracing::set_tracer(nullptr);
+                    tracer->write(config["trace"].as<std::string>()).get();
+                }
+            } else {
+                throw std::invalid_argument(seastar::format("Unknown mode: {}", mode));
+            }
+            if (config.count("json")) {
+                r.print_json(std::cout);
+            } else {
+                r.print_text(std::cout);
+            }
+        });
+    });
+}
@@ -0,0 +1,286 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/* Data generators and encoders shared by the benchmarks.
+ * The library does not have encoders for some of the encodings it can read,
+ * so the missing ones are implemented here, in the simplest possible way.
+ */
+
+#pragma once
+
+#include <parquet4seastar/encoding.hh>
+#include <seastar/core/print.hh>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace parquet4seastar::benchmark {
+
+enum class distribution {
+    uniform,
+    sorted,
+    low_cardinality,
+    // Uniform values of an optional column, most of them null.
+    high_null_rate,
+};
+
+// Values of physical type T, together with the memory backing byte array views.
+template <format::Type::type T>
+struct generated_values {
+    using input_type = typename value_decoder_traits<T>::input_type;
+    std::vector<bytes> storage;
+    // Only the non-null values.
+    std::vector<input_type> values;
+    // Definition levels (max level 1) of all values, nulls included. Empty if the column is required.
+    std::vector<uint8_t> def_levels;
+};
+
+constexpr uint32_t flba_length = 16;
+constexpr size_t low_cardinality = 16;
+constexpr double high_null_rate = 0.9;
+
+template <format::Type::type T>
+typename value_decoder_traits<T>::input_type
+random_value(std::mt19937_64& rng, std::vector<bytes>& storage) {
+    if constexpr (T == format::Type::BOOLEAN) {
+        return rng() % 2;
+    } else if constexpr (T == format::Type::INT32) {
+        return static_cast<int32_t>(rng());
+    } else if constexpr (T == format::Type::INT64) {
+        return static_cast<int64_t>(rng());
+    } else if constexpr (T == format::Type::FLOAT) {
+        return std::uniform_real_distribution<float>(-1e6, 1e6)(rng);
+    } else if constexpr (T == format::Type::DOUBLE) {
+        return std::uniform_real_distribution<double>(-1e6, 1e6)(rng);
+    } else {
+        size_t len = (T == format::Type::FIXED_LEN_BYTE_ARRAY) ? flba_length : 8 + rng() % 25;
+        bytes b(len, 0);
+        for (byte& c : b) {
+            c = static_cast<byte>('a' + rng() % 26);
+        }
+        storage.push_back(std::move(b));
+        return storage.back();
+    }
+}
+
+template <format::Type::type T>
+generated_values<T> generate(distribution dist, size_t n, uint64_t seed = 0) {
+    std::mt19937_64 rng{seed};
+    generated_values<T> result;
+    if (dist == distribution::high_null_rate) {
+        std::bernoulli_distribution is_null{high_null_rate};
+        result.def_levels.resize(n);
+        for (auto& l : result.def_levels) {
+            l = is_null(rng) ? 0 : 1;
+        }
+        n = std::count(result.def_levels.begin(), result.def_levels.end(), 1);
+    }
+    // Views into storage must stay valid while it grows.
+    result.storage.reserve(n + low_cardinality);
+    result.values.reserve(n);
+    if (dist == distribution::low_cardinality) {
+        std::vector<typename generated_values<T>::input_type> pool;
+        for (size_t i = 0; i < low_cardinality; ++i) {
+            pool.push_back(random_value<T>(rng, result.storage));
+        }
+        for (size_t i = 0; i < n; ++i) {
+            result.values.push_back(pool[rng() % pool.size()]);
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            result.values.push_back(random_value<T>(rng, result.storage));
+        }
+        if (dist == distribution::sorted) {
+            std::sort(result.values.begin(), result.values.end());
+        }
+    }
+    return result;
+}
+
+struct encoded_page {
+    bytes data;
+    std::optional<bytes> dict; // PLAIN-encoded dictionary page, if data is dictionary encoded.
+    format::Encoding::type encoding;
+    size_t num_values; // Non-null values. Bit-packed data may be padded with extra values.
+    std::optional<bytes> def_levels; // RLE-encoded as in data pages V2, if the column is optional.
+    size_t num_levels; // As in the page header, nulls included.
+    size_t size() const { return data.size() + (dict ? dict->size() : 0) + (def_levels ? def_levels->size() : 0); }
+};
+
+template <format::Type::type T>
+bytes encode_with_library(format::Encoding::type encoding,
+        const typename value_decoder_traits<T>::input_type values[], size_t n,
+        std::optional<bytes>* dict = nullptr) {
+    auto encoder = make_value_encoder<T>(encoding);
+    encoder->put_batch(values, n);
+    bytes page(encoder->max_encoded_size(), 0);
+    auto flush_result = encoder->flush(page.data());
+    page.resize(flush_result.size);
+    if (dict) {
+        if (auto d = encoder->view_dict()) {
+            *dict = bytes(*d);
+        }
+    }
+    return page;
+}
+
+inline bytes encode_delta_binary_packed(const int32_t values[], size_t n) {
+    return encode_with_library<format::Type::INT32>(format::Encoding::DELTA_BINARY_PACKED, values, n);
+}
+
+inline bytes encode_delta_length_byte_array(const bytes_view values[], size_t n) {
+    std::vector<int32_t> lengths;
+    bytes data;
+    for (size_t i = 0; i < n; ++i) {
+        lengths.push_back(values[i].size());
+        data += values[i];
+    }
+    return encode_delta_binary_packed(lengths.data(), lengths.size()) + data;
+}
+
+inline bytes encode_delta_byte_array(const bytes_view values[], size_t n) {
+    std::vector<int32_t> prefixes;
+    std::vector<int32_t> suffix_lengths;
+    bytes suffixes;
+    bytes_view last;
+    for (size_t i = 0; i < n; ++i) {
+        size_t prefix = std::mismatch(last.begin(), last.end(), values[i].begin(), values[i].end()).first - last.begin();
+        prefixes.push_back(prefix);
+        suffix_lengths.push_back(values[i].size() - prefix);
+        suffixes += values[i].substr(prefix);
+        last = values[i];
+    }
+    return encode_delta_binary_packed(prefixes.data(), prefixes.size())
+            + encode_delta_binary_packed(suffix_lengths.data(), suffix_lengths.size())
+            + suffixes;
+}
+
+template <typename V>
+bytes encode_byte_stream_split(const V values[], size_t n) {
+    bytes out(n * sizeof(V), 0);
+    const byte* in = reinterpret_cast<const byte*>(values);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t k = 0; k < sizeof(V); ++k) {
+            out[k * n + i] = in[i * sizeof(V) + k];
+        }
+    }
+    return out;
+}
+
+inline bytes encode_rle(const uint8_t values[], size_t n, uint32_t bit_width) {
+    rle_builder builder{bit_width};
+    for (size_t i = 0; i < n; ++i) {
+        builder.put(values[i]);
+    }
+    return bytes(builder.view());
+}
+
+template <format::Type::type T>
+encoded_page encode(format::Encoding::type encoding, const generated_values<T>& v) {
+    const auto* values = v.values.data();
+    size_t n = v.values.size();
+    encoded_page page{{}, {}, encoding, n, {}, n};
+    if (!v.def_levels.empty()) {
+        page.def_levels = encode_rle(v.def_levels.data(), v.def_levels.size(), 1);
+        page.num_levels = v.def_levels.size();
+    }
+    switch (encoding) {
+    case format::Encoding::PLAIN:
+    case format::Encoding::DELTA_BINARY_PACKED:
+        page.data = encode_with_library<T>(encoding, values, n);
+        break;
+    case format::Encoding::RLE_DICTIONARY:
+        page.data = encode_with_library<T>(encoding, values, n, &page.dict);
+        break;
+    case format::Encoding::RLE:
+        if constexpr (T == format::Type::BOOLEAN) {
+            page.data = encode_rle(values, n, 1);
+            break;
+        }
+        throw parquet_exception("RLE is valid only for BOOLEAN");
+    case format::Encoding::BYTE_STREAM_SPLIT:
+        if constexpr (T == format::Type::FLOAT || T == format::Type::DOUBLE) {
+            page.data = encode_byte_stream_split(values, n);
+            break;
+        }
+        throw parquet_exception("BYTE_STREAM_SPLIT is valid only for FLOAT and DOUBLE");
+    case format::Encoding::DELTA_LENGTH_BYTE_ARRAY:
+        if constexpr (T == format::Type::BYTE_ARRAY) {
+            page.data = encode_delta_length_byte_array(values, n);
+            break;
+        }
+        throw parquet_exception("DELTA_LENGTH_BYTE_ARRAY is valid only for BYTE_ARRAY");
+    case format::Encoding::DELTA_BYTE_ARRAY:
+        if constexpr (T == format::Type::BYTE_ARRAY) {
+            page.data = encode_delta_byte_array(values, n);
+            break;
+        }
+        throw parquet_exception("DELTA_BYTE_ARRAY is valid only for BYTE_ARRAY");
+    default:
+        throw parquet_exception(seastar::format("Encoding {} not supported by the benchmarks", encoding));
+    }
+    return page;
+}
+
+// Decodes the whole page in batches of batch_size, like column_chunk_reader does.
+// The dictionary, if any, is decoded too, because it has to be done once per column chunk anyway.
+// For optional columns, each batch of definition levels is followed by its non-null values.
+// Returns the number of values, nulls included.
+template <format::Type::type T, typename Decoder = value_decoder<T>>
+size_t decode(const encoded_page& page, std::optional<uint32_t> type_length, size_t batch_size) {
+    using output_type = typename Decoder::output_type;
+    std::vector<output_type> dict;
+    Decoder decoder{type_length};
+    if (page.dict) {
+        Decoder dict_decoder{type_length};
+        dict_decoder.reset(*page.dict, format::Encoding::PLAIN);
+        dict.resize(page.dict->size());
+        dict.resize(dict_decoder.read_batch(dict.size(), dict.data()));
+        decoder.reset_dict(dict.data(), dict.size());
+    }
+    decoder.reset(page.data, page.encoding);
+    std::vector<output_type> out(batch_size);
+    if (page.def_levels) {
+        level_decoder levels{1};
+        levels.reset_v2(*page.def_levels, page.num_levels);
+        std::vector<int16_t> def(batch_size);
+        size_t total = 0;
+        while (size_t n_levels = levels.read_batch(batch_size, def.data())) {
+            size_t n_values = std::count(def.begin(), def.begin() + n_levels, 1);
+            if (decoder.read_batch(n_values, out.data()) != n_values) {
+                throw parquet_exception(seastar::format("Page ended before {} values", page.num_values));
+            }
+            total += n_levels;
+        }
+        return total;
+    }
+    size_t total = 0;
+    while (total < page.num_values) {
+        size_t n = decoder.read_batch(std::min(batch_size, page.num_values - total), out.data());
+        if (n == 0) {
+            throw parquet_exception(seastar::format("Page ended after {} of {} values", total, page.num_values));
+        }
+        total += n;
+    }
+    return total;
+}
+
+} // namespace parquet4seastar::benchmark
@@ -0,0 +1,114 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/* Throughput of the compression codecs, reported as time per uncompressed byte,
+ * and of reading sorted strings stored with DELTA_BYTE_ARRAY versus GZIP-compressed PLAIN.
+ */
+
+#include "benchmark_data.hh"
+#include <parquet4seastar/compression.hh>
+#include <seastar/testing/perf_tests.hh>
+
+using namespace parquet4seastar;
+using namespace parquet4seastar::benchmark;
+
+namespace {
+
+constexpr size_t values_per_page = 64 * 1024;
+constexpr size_t batch_size = 1024;
+
+// PLAIN-encoded pages of typical columns: text and low-cardinality integers.
+template <format::CompressionCodec::type Codec>
+class codec_fixture {
+    std::unique_ptr<compressor> _compressor;
+    bytes _raw;
+    bytes _compressed;
+public:
+    codec_fixture() : _compressor{compressor::make(Codec)} {
+        auto strings = generate<format::Type::BYTE_ARRAY>(distribution::uniform, values_per_page);
+        auto ints = generate<format::Type::INT64>(distribution::low_cardinality, values_per_page);
+        _raw = encode<format::Type::BYTE_ARRAY>(format::Encoding::PLAIN, strings).data
+                + encode<format::Type::INT64>(format::Encoding::PLAIN, ints).data;
+        _compressed = _compressor->compress(_raw);
+    }
+    size_t compress() {
+        bytes out = _compressor->compress(_raw);
+        perf_tests::do_not_optimize(out);
+        return _raw.size();
+    }
+    size_t decompress() {
+        bytes out = _compressor->decompress(_compressed, bytes(_raw.size(), 0));
+        perf_tests::do_not_optimize(out);
+        return _raw.size();
+    }
+};
+
+} // namespace
+
+struct UNCOMPRESSED : codec_fixture<format::CompressionCodec::UNCOMPRESSED> {};
+struct SNAPPY : codec_fixture<format::CompressionCodec::SNAPPY> {};
+struct GZIP : codec_fixture<format::CompressionCodec::GZIP> {};
+
+PERF_TEST_F(UNCOMPRESSED, compress) { return compress(); }
+PERF_TEST_F(UNCOMPRESSED, decompress) { return decompress(); }
+PERF_TEST_F(SNAPPY, compress) { return compress(); }
+PERF_TEST_F(SNAPPY, decompress) { return decompress(); }
+PERF_TEST_F(GZIP, compress) { return compress(); }
+PERF_TEST_F(GZIP, decompress) { return decompress(); }
+
+namespace {
+
+// Sorted strings with long shared prefixes, e.g. paths or URLs, read back value by value.
+class sorted_strings {
+    encoded_page _delta;
+    encoded_page _plain;
+    bytes _plain_gzip;
+    std::unique_ptr<compressor> _gzip = compressor::make(format::CompressionCodec::GZIP);
+public:
+    sorted_strings() {
+        generated_values<format::Type::BYTE_ARRAY> values;
+        values.storage.reserve(values_per_page);
+        std::mt19937_64 rng{0};
+        for (size_t i = 0; i < values_per_page; ++i) {
+            bytes s = reinterpret_cast<const byte*>("/data/warehouse/events/");
+            s += random_value<format::Type::BYTE_ARRAY>(rng, values.storage);
+            values.storage.back() = std::move(s);
+            values.values.push_back(values.storage.back());
+        }
+        std::sort(values.values.begin(), values.values.end());
+        _delta = encode<format::Type::BYTE_ARRAY>(format::Encoding::DELTA_BYTE_ARRAY, values);
+        _plain = encode<format::Type::BYTE_ARRAY>(format::Encoding::PLAIN, values);
+        _plain_gzip = _gzip->compress(_plain.data);
+    }
+    size_t delta_byte_array() {
+        return decode<format::Type::BYTE_ARRAY>(_delta, {}, batch_size);
+    }
+    size_t plain_gzip() {
+        encoded_page page{
+                _gzip->decompress(_plain_gzip, bytes(_plain.data.size(), 0)), {}, format::Encoding::PLAIN, _plain.num_values};
+        return decode<format::Type::BYTE_ARRAY>(page, {}, batch_size);
+    }
+};
+
+} // namespace
+
+PERF_TEST_F(sorted_strings, delta_byte_array) { return delta_byte_array(); }
+PERF_TEST_F(sorted_strings, plain_gzip) { return plain_gzip(); }
@@ -0,0 +1,232 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/* Throughput of value encoders and decoders for every supported
+ * (physical type, encoding, value distribution) combination,
+ * and of the level decoders underlying them.
+ *
+ * Test groups are named TYPE_ENCODING_DISTRIBUTION. In each group:
+ * - decode and encode report time per value, nulls included (see distribution::high_null_rate),
+ * - decode_bytes reports time per byte of encoded data (dictionary page included).
+ */
+
+#include "benchmark_data.hh"
+#include <seastar/testing/perf_tests.hh>
+
+using namespace parquet4seastar;
+using namespace parquet4seastar::benchmark;
+
+namespace {
+
+constexpr size_t values_per_page = 64 * 1024;
+constexpr size_t batch_size = 1024;
+
+template <format::Type::type T>
+class encoding_fixture {
+    generated_values<T> _values;
+    encoded_page _page;
+    std::optional<uint32_t> _type_length;
+public:
+    encoding_fixture(format::Encoding::type encoding, distribution dist)
+        : _values{generate<T>(dist, values_per_page)}
+        , _page{benchmark::encode<T>(encoding, _values)} {
+        if constexpr (T == format::Type::FIXED_LEN_BYTE_ARRAY) {
+            _type_length = flba_length;
+        }
+    }
+    template <typename Decoder = value_decoder<T>>
+    size_t decode() {
+        size_t n = benchmark::decode<T, Decoder>(_page, _type_length, batch_size);
+        perf_tests::do_not_optimize(n);
+        return n;
+    }
+    size_t decode_bytes() {
+        decode();
+        return _page.size();
+    }
+    size_t encode() {
+        bytes page = encode_with_library<T>(_page.encoding, _values.values.data(), _values.values.size());
+        perf_tests::do_not_optimize(page);
+        if (!_values.def_levels.empty()) {
+            bytes levels = encode_rle(_values.def_levels.data(), _values.def_levels.size(), 1);
+            perf_tests::do_not_optimize(levels);
+            return _values.def_levels.size();
+        }
+        return _values.values.size();
+    }
+};
+
+} // namespace
+
+#define ENCODING_FIXTURE(type, encoding, dist) \
+    struct type##_##encoding##_##dist : encoding_fixture<format::Type::type> { \
+        type##_##encoding##_##dist() \
+            : encoding_fixture(format::Encoding::encoding, distribution::dist) {} \
+    };
+
+#define DECODE_BENCHMARKS(type, encoding, dist) \
+    ENCODING_FIXTURE(type, encoding, dist) \
+    PERF_TEST_F(type##_##encoding##_##dist, decode) { return decode(); } \
+    PERF_TEST_F(type##_##encoding##_##dist, decode_bytes) { return decode_bytes(); }
+
+// For encodings which the library can also write.
+#define CODEC_BENCHMARKS(type, encoding, dist) \
+    DECODE_BENCHMARKS(type, encoding, dist) \
+    PERF_TEST_F(type##_##encoding##_##dist, encode) { return encode(); }
+
+#define ALL_DISTRIBUTIONS(benchmarks, type, encoding) \
+    benchmarks(type, encoding, uniform) \
+    benchmarks(type, encoding, sorted) \
+    benchmarks(type, encoding, low_cardinality) \
+    benchmarks(type, encoding, high_null_rate)
+
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, BOOLEAN, PLAIN)
+ALL_DISTRIBUTIONS(DECODE_BENCHMARKS, BOOLEAN, RLE)
+
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, INT32, PLAIN)
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, INT32, RLE_DICTIONARY)
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, INT32, DELTA_BINARY_PACKED)
+
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, INT64, PLAIN)
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, INT64, RLE_DICTIONARY)
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, INT64, DELTA_BINARY_PACKED)
+
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, FLOAT, PLAIN)
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, FLOAT, RLE_DICTIONARY)
+ALL_DISTRIBUTIONS(DECODE_BENCHMARKS, FLOAT, BYTE_STREAM_SPLIT)
+
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, DOUBLE, PLAIN)
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, DOUBLE, RLE_DICTIONARY)
+ALL_DISTRIBUTIONS(DECODE_BENCHMARKS, DOUBLE, BYTE_STREAM_SPLIT)
+
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, BYTE_ARRAY, PLAIN)
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, BYTE_ARRAY, RLE_DICTIONARY)
+ALL_DISTRIBUTIONS(DECODE_BENCHMARKS, BYTE_ARRAY, DELTA_LENGTH_BYTE_ARRAY)
+ALL_DISTRIBUTIONS(DECODE_BENCHMARKS, BYTE_ARRAY, DELTA_BYTE_ARRAY)
+
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, FIXED_LEN_BYTE_ARRAY, PLAIN)
+ALL_DISTRIBUTIONS(CODEC_BENCHMARKS, FIXED_LEN_BYTE_ARRAY, RLE_DICTIONARY)
+
+// FIXED_LEN_BYTE_ARRAY decoded by value instead of into temporary_buffers.
+PERF_TEST_F(FIXED_LEN_BYTE_ARRAY_PLAIN_uniform, decode_fixed_width) {
+    return decode<fixed_len_bytes_decoder<flba_length>>();
+}
+PERF_TEST_F(FIXED_LEN_BYTE_ARRAY_RLE_DICTIONARY_low_cardinality, decode_fixed_width) {
+    return decode<fixed_len_bytes_decoder<flba_length>>();
+}
+
+namespace {
+
+// Definition levels of an optional column (max level 1), RLE-encoded as in data pages V2.
+class definition_levels {
+    bytes _no_nulls;
+    bytes _high_null_rate;
+    static bytes encode_levels(double null_rate) {
+        std::mt19937_64 rng{0};
+        std::bernoulli_distribution is_null{null_rate};
+        std::vector<uint8_t> levels(values_per_page);
+        for (auto& l : levels) {
+            l = is_null(rng) ? 0 : 1;
+        }
+        return encode_rle(levels.data(), levels.size(), 1);
+    }
+    static size_t decode_levels(bytes_view encoded) {
+        level_decoder decoder{1};
+        decoder.reset_v2(encoded, values_per_page);
+        std::array<int16_t, batch_size> out;
+        size_t total = 0;
+        while (size_t n = decoder.read_batch(out.size(), out.data())) {
+            total += n;
+        }
+        perf_tests::do_not_optimize(out);
+        return total;
+    }
+public:
+    definition_levels()
+        : _no_nulls{encode_levels(0.0)}
+        , _high_null_rate{encode_levels(0.9)} {}
+    size_t no_nulls() { return decode_levels(_no_nulls); }
+    size_t high_null_rate() { return decode_levels(_high_null_rate); }
+};
+
+// Raw RleDecoder and BitReader throughput, for a few representative bit widths.
+class bit_unpacking {
+    std::vector<uint64_t> _values[3];
+    bytes _rle[3];
+    bytes _bit_packed[3];
+public:
+    static constexpr int bit_widths[3] = {1, 8, 20};
+    bit_unpacking() {
+        std::mt19937_64 rng{0};
+        for (int i = 0; i < 3; ++i) {
+            rle_builder rle{static_cast<uint32_t>(bit_widths[i])};
+            _bit_packed[i].resize(values_per_page * bit_widths[i] / 8 + 8);
+            BitUtil::BitWriter writer{_bit_packed[i].data(), static_cast<int>(_bit_packed[i].size())};
+            for (size_t j = 0; j < values_per_page; ++j) {
+                uint64_t v = rng() & ((uint64_t(1) << bit_widths[i]) - 1);
+                rle.put(v);
+                writer.PutValue(v, bit_widths[i]);
+            }
+            writer.Flush();
+            _rle[i] = bytes(rle.view());
+        }
+    }
+    size_t rle_decode(int i) {
+        RleDecoder decoder{_rle[i].data(), static_cast<int>(_rle[i].size()), bit_widths[i]};
+        std::array<uint32_t, batch_size> out;
+        size_t total = 0;
+        while (total < values_per_page) {
+            size_t n = decoder.GetBatch(out.data(), out.size());
+            if (n == 0) {
+                throw parquet_exception(seastar::format("RLE run ended after {} of {} values", total, values_per_page));
+            }
+            total += n;
+        }
+        perf_tests::do_not_optimize(out);
+        return total;
+    }
+    size_t bit_reader_decode(int i) {
+        BitUtil::BitReader reader{_bit_packed[i].data(), static_cast<int>(_bit_packed[i].size())};
+        std::array<uint32_t, batch_size> out;
+        size_t total = 0;
+        while (total < values_per_page) {
+            size_t n = reader.GetBatch(bit_widths[i], out.data(), out.size());
+            if (n == 0) {
+                throw parquet_exception(seastar::format("Bit-packed run ended after {} of {} values", total, values_per_page));
+            }
+            total += n;
+        }
+        perf_tests::do_not_optimize(out);
+        return total;
+    }
+};
+
+} // namespace
+
+PERF_TEST_F(definition_levels, no_nulls) { return no_nulls(); }
+PERF_TEST_F(definition_levels, high_null_rate) { return high_null_rate(); }
+
+PERF_TEST_F(bit_unpacking, rle_bit_width_1) { return rle_decode(0); }
+PERF_TEST_F(bit_unpacking, rle_bit_width_8) { return rle_decode(1); }
+PERF_TEST_F(bit_unpacking, rle_bit_width_20) { return rle_decode(2); }
+PERF_TEST_F(bit_unpacking, bit_reader_bit_width_1) { return bit_reader_decode(0); }
+PERF_TEST_F(bit_unpacking, bit_reader_bit_width_8) { return bit_reader_decode(1); }
+PERF_TEST_F(bit_unpacking, bit_reader_bit_width_20) { return bit_reader_decode(2); }
@@ -0,0 +1,63 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <parquet4seastar/file_reader.hh>
+#include <parquet4seastar/statistics.hh>
+
+/* COUNT(*), COUNT(column), MIN(column) and MAX(column) over column chunks, computed
+ * with as little decoding as possible:
+ * - from the statistics of the chunk, where they are exact. Min and max of byte arrays
+ *   are not taken from statistics, since writers may truncate them;
+ * - from the null counts in page headers, and by counting runs of definition levels;
+ * - as min and max of the dictionary, if all pages of the chunk are dictionary-encoded.
+ *   Writers may leave entries in the dictionary which no value uses, so these are only bounds.
+ *   They are used only when they equal the min and max of the chunk statistics,
+ *   which are then known to be exact. A statistic truncated to exactly an unused entry
+ *   would defeat this check;
+ * - by decoding the values, as a last resort.
+ */
+namespace parquet4seastar {
+
+struct column_aggregate {
+    // Records.
+    int64_t rows = 0;
+    // Non-null values of the leaf column.
+    int64_t values = 0;
+    // In the sort order of the column. Empty if the order is unknown, or if there are no values.
+    std::optional<scalar> min;
+    std::optional<scalar> max;
+    sort_order order = sort_order::UNKNOWN;
+    // Whether the values of any chunk had to be decoded.
+    bool decoded = false;
+
+    // Combine with the aggregate of other row groups of the same column.
+    void merge(const column_aggregate& other);
+};
+
+// Aggregate a leaf column of one row group. Min and max are only computed if with_min_max is set.
+seastar::future<column_aggregate> aggregate_column_chunk(
+        file_reader& fr, uint32_t row_group, uint32_t column, bool with_min_max = true);
+// Aggregate a leaf column of all row groups of the file.
+seastar::future<column_aggregate> aggregate_column(file_reader& fr, uint32_t column, bool with_min_max = true);
+
+} // namespace parquet4seastar
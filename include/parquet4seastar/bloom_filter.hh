@@ -0,0 +1,67 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <parquet4seastar/bytes.hh>
+#include <parquet4seastar/parquet_types.h>
+#include <parquet4seastar/statistics.hh>
+#include <vector>
+
+/* Split block Bloom filters of column chunks, as specified by the Parquet format.
+ *
+ * The filter is an array of 32-byte blocks of eight 32-bit words. A value is hashed
+ * with XXH64 (seed 0) over its PLAIN encoding, without the length prefix of byte arrays.
+ * The upper half of the hash selects a block, and the lower half sets one bit in each
+ * of its words. A filter has no false negatives: if find() fails, the value is absent.
+ */
+namespace parquet4seastar {
+
+uint64_t xxhash64(bytes_view data, uint64_t seed = 0);
+
+// The hash of a value in a Bloom filter of a column of its physical type.
+uint64_t bloom_filter_hash(const scalar& value);
+
+class bloom_filter {
+    std::vector<uint32_t> _words;
+public:
+    static constexpr size_t block_size = 32;
+    static constexpr size_t max_size = 128 * 1024 * 1024;
+    // An empty filter of num_bytes, rounded up to a power of 2 in [block_size, max_size].
+    explicit bloom_filter(size_t num_bytes);
+    // A filter read from a file. Throws if the size isn't a positive multiple of block_size.
+    explicit bloom_filter(bytes_view bitset);
+    // The size in bytes for the given number of distinct values and false positive probability.
+    static size_t optimal_size(uint64_t distinct_values, double fpp);
+    // Whether the filter can be read by this library.
+    static bool supported(const format::BloomFilterHeader& header);
+
+    void insert(uint64_t hash);
+    bool find(uint64_t hash) const;
+    size_t size() const { return _words.size() * sizeof(uint32_t); }
+    // The header preceding the bitset in a file.
+    format::BloomFilterHeader header() const;
+    bytes_view bitset() const {
+        return {reinterpret_cast<const byte*>(_words.data()), size()};
+    }
+};
+
+} // namespace parquet4seastar
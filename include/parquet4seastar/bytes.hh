@@ -37,6 +37,12 @@ struct bytes_hasher {
     }
 };
 
+struct bytes_view_hasher {
+    size_t operator()(bytes_view s) const {
+        return std::hash<std::string_view>{}(std::string_view{reinterpret_cast<const char *>(s.data()), s.size()});
+    }
+};
+
 template<typename T, typename = std::enable_if_t<std::is_trivially_copyable_v<T>>>
 void append_raw_bytes(bytes &b, T v) {
     const byte *data = reinterpret_cast<const byte *>(&v);
@@ -25,6 +25,12 @@
 #include <parquet4seastar/overloaded.hh>
 #include <parquet4seastar/compression.hh>
 #include <parquet4seastar/encoding.hh>
+#include <parquet4seastar/dictionary_cache.hh>
+#include <parquet4seastar/memory_limiter.hh>
+#include <parquet4seastar/page_cache.hh>
+#include <parquet4seastar/metrics.hh>
+#include <parquet4seastar/tracing.hh>
+#include <seastar/core/scheduling.hh>
 
 namespace parquet4seastar {
 
@@ -36,42 +42,112 @@ struct page {
 class page_reader {
     peekable_stream _source;
     std::unique_ptr<format::PageHeader> _latest_header;
+    seastar::lw_shared_ptr<const tracing::context> _trace_context;
+    int64_t _page_ordinal = -1;
     static constexpr uint32_t _default_expected_header_size = 1024;
     static constexpr uint32_t _max_allowed_header_size = 16 * 1024 * 1024;
 public:
-    explicit page_reader(seastar::input_stream<char>&& source)
+    // Buffers which grew beyond this size for a big page are freed before the next page.
+    static constexpr size_t max_retained_buffer_size = 1024 * 1024;
+    explicit page_reader(
+            seastar::input_stream<char>&& source,
+            seastar::lw_shared_ptr<const tracing::context> trace_context = {})
+        : page_reader{peekable_stream{std::move(source)}, std::move(trace_context)} {};
+    explicit page_reader(
+            peekable_stream&& source,
+            seastar::lw_shared_ptr<const tracing::context> trace_context = {})
         : _source{std::move(source)}
-        , _latest_header{std::make_unique<format::PageHeader>()} {};
+        , _latest_header{std::make_unique<format::PageHeader>()}
+        , _trace_context{std::move(trace_context)} {};
     // View the next page. Returns an empty result on eof.
     seastar::future<std::optional<page>> next_page();
+    // Read the header of the next page and skip its contents. Returns null on eof.
+    seastar::future<const format::PageHeader*> next_page_header();
+    // Identifies the column chunk in traces. May be null.
+    const tracing::context* trace_context() const { return _trace_context.get(); }
+    size_t buffer_size() const { return _source.buffer_size(); }
+    // Whether the contents of pages stay valid after the next page is read (see peekable_stream::mapped).
+    bool mapped() const { return _source.mapped(); }
+    // The offset of the next page, relative to the beginning of the column chunk.
+    uint64_t position() const { return _source.position(); }
+    // Skip the next page, which is n bytes long (header included), without reading it.
+    seastar::future<> skip_page(size_t n) {
+        ++_page_ordinal;
+        return _source.advance(n);
+    }
+    // Skip n bytes of pages which are not read, e.g. outside of a page range. They are not counted.
+    seastar::future<> skip_pages(size_t n) {
+        return _source.advance(n);
+    }
+    // The ordinal of the latest page read or skipped in the column chunk. -1 before the first page.
+    int64_t page_ordinal() const { return _page_ordinal; }
+};
+
+// Counts of the (rest of a) column chunk, see column_chunk_reader::count_values.
+struct chunk_value_counts {
+    // (rep, def) pairs, i.e. values including nulls.
+    int64_t levels = 0;
+    // Non-null values.
+    int64_t values = 0;
+    // Whether all data pages held dictionary indices, so that every value is in the dictionary.
+    bool dictionary_encoded = true;
 };
 
 // The core low-level interface. Takes the relevant metadata and an input_stream set to the beginning of a column chunk
 // and extracts batches of (repetition level, definition level, value (optional)) from it.
-template<format::Type::type T>
+// ValueDecoder can be swapped for a specialized decoder with the same interface as value_decoder<T>,
+// e.g. fixed_len_value_decoder for narrow FIXED_LEN_BYTE_ARRAY columns.
+template<format::Type::type T, typename ValueDecoder = value_decoder<T>>
 class column_chunk_reader {
 public:
-    using output_type = typename value_decoder_traits<T>::output_type;
+    using output_type = typename ValueDecoder::output_type;
 private:
     page_reader _source;
     std::unique_ptr<compressor> _decompressor;
+    bool _zero_copy; // Uncompressed pages of mapped files are decoded in place.
     bytes _decompression_buffer;
     level_decoder _rep_decoder;
     level_decoder _def_decoder;
-    value_decoder<T> _val_decoder;
-    std::optional<std::vector<output_type>> _dict;
+    ValueDecoder _val_decoder;
+    seastar::lw_shared_ptr<std::vector<output_type>> _dict; // May be shared with the dictionary cache.
     bool _initialized = false;
     bool _eof = false;
-    int64_t _page_ordinal = -1; // Only used for error reporting.
 private:
     uint32_t _def_level;
     uint32_t _rep_level;
     std::optional<uint32_t> _type_length;
+    seastar::scheduling_group _scheduling_group;
+    memory_account _memory;
+    size_t _fixed_memory; // Charged on top of the buffers of this reader.
+    size_t _dict_memory = 0;
+    std::optional<column_chunk_id> _page_cache_chunk; // Set if the page cache is used.
+    std::optional<column_chunk_id> _dictionary_cache_chunk; // Set if the dictionary cache is used.
+    seastar::lw_shared_ptr<const cached_page> _cached_page; // The current page, if it is cached.
+    uint64_t _page_position = 0; // Of the current page, in the column chunk.
+    size_t _page_on_disk_size = 0;
+    uint64_t _dictionary_page_end = 0; // The pages between these two positions are skipped.
+    uint64_t _data_pages_begin = 0;
+    bool _levels_only = false; // Set by count_values. Values are neither decompressed nor decoded.
+    format::Encoding::type _page_encoding = format::Encoding::PLAIN;
+    std::optional<int32_t> _page_null_count; // Set if the current page was counted from its header.
+    int32_t _page_num_values = 0;
 private:
+    void update_memory();
     seastar::future<> load_next_page();
-    void load_dictionary_page(page p);
-    void load_data_page(page p);
-    void load_data_page_v2(page p);
+    seastar::future<> load_dictionary_page(page p);
+    seastar::future<> load_data_page(page p);
+    seastar::future<> load_data_page_v2(page p);
+    seastar::future<> load_cached_page();
+    seastar::future<> decompress(bytes_view compressed, size_t uncompressed_size);
+    page_cache* page_cache_for_reads() const;
+    dictionary_cache* dictionary_cache_for_reads() const;
+    void cache_page(const format::PageHeader& header, bytes_view levels);
+    bytes_view page_values() const;
+    void init_data_page(const format::DataPageHeader& header, bytes_view contents);
+    void init_levels_v2(const format::DataPageHeaderV2& header, bytes_view levels);
+    void init_data_page_v2(const format::DataPageHeaderV2& header, bytes_view levels, bytes_view values);
+    void count_page(chunk_value_counts& counts);
+    seastar::future<> init_dictionary(const format::DictionaryPageHeader& header, size_t compressed_size);
 
     template<typename LevelT>
     seastar::future<size_t> read_batch_internal(size_t n, LevelT def[], LevelT rep[], output_type val[]);
@@ -81,27 +157,65 @@ public:
             format::CompressionCodec::type codec,
             uint32_t def_level,
             uint32_t rep_level,
-            std::optional<uint32_t> type_length)
+            std::optional<uint32_t> type_length,
+            seastar::scheduling_group scheduling_group = seastar::default_scheduling_group(),
+            memory_account memory = {})
         : _source{std::move(source)}
         , _decompressor{compressor::make(codec)}
+        , _zero_copy{_source.mapped() && codec == format::CompressionCodec::UNCOMPRESSED}
         , _rep_decoder{rep_level}
         , _def_decoder{def_level}
         , _val_decoder{type_length}
         , _def_level{def_level}
         , _rep_level{rep_level}
         , _type_length{type_length}
+        , _scheduling_group{scheduling_group}
+        , _memory{std::move(memory)}
+        , _fixed_memory{_memory.charged()}
         {};
     // Read a batch of n (rep, def, value) triplets. The last batch may be smaller than n.
     // Return the number of triplets read. Note that null values are not read into the output array.
     // Example output: def == [1, 1, 0, 1, 0], rep = [0, 0, 0, 0, 0], val = ["a", "b", "d"].
+    // The batch is decoded in the scheduling group given at construction. Calling from within
+    // that group saves a task switch per batch.
     template<typename LevelT>
     seastar::future<size_t> read_batch(size_t n, LevelT def[], LevelT rep[], output_type val[]);
+    // Charge n more bytes, held on behalf of this reader (e.g. by its consumer), to its memory account.
+    void charge_memory(size_t n) {
+        _fixed_memory += n;
+        update_memory();
+    }
+    // The memory currently charged for this reader, if it was opened with a memory_limiter.
+    size_t memory_charged() const { return _memory.charged(); }
+    // The ordinal of the current page in the column chunk (the dictionary page included),
+    // whether it was read or found in a cache. -1 before the first page.
+    int64_t page_ordinal() const { return _source.page_ordinal(); }
+    // Look up pages in the page cache of the shard (if enabled) before reading them,
+    // and insert the pages read. The chunk id must identify the contents of the column chunk.
+    void use_page_cache(column_chunk_id chunk) { _page_cache_chunk = chunk; }
+    // Look up the decoded dictionary in the dictionary cache of the shard (if enabled) before
+    // reading the dictionary page, and insert the dictionary decoded otherwise.
+    void use_dictionary_cache(column_chunk_id chunk) { _dictionary_cache_chunk = chunk; }
+    // Skip the data pages before position begin (relative to the beginning of the column chunk,
+    // at a page boundary), e.g. to read one page_range of the chunk. The dictionary page,
+    // which takes the first dictionary_size bytes of the chunk, is still read.
+    void skip_to(uint64_t begin, uint64_t dictionary_size) {
+        _dictionary_page_end = dictionary_size;
+        _data_pages_begin = begin;
+    }
+    // Count the rest of the chunk without decoding values, e.g. for COUNT aggregates.
+    // Pages are counted from the null counts in their headers where these are exact,
+    // and by counting the runs of definition levels otherwise. The dictionary, if any, is read.
+    // Afterwards, the reader is at the end of the chunk.
+    seastar::future<chunk_value_counts> count_values();
+    // The dictionary of the chunk, once read. Null if there is none.
+    const std::vector<output_type>* dictionary() const { return _dict.get(); }
 };
 
-template<format::Type::type T>
+template<format::Type::type T, typename ValueDecoder>
 template<typename LevelT>
 seastar::future<size_t>
-column_chunk_reader<T>::read_batch_internal(size_t n, LevelT def[], LevelT rep[], output_type val[]) {
+column_chunk_reader<T, ValueDecoder>::read_batch_internal(size_t n, LevelT def[], LevelT rep[], output_type val[]) {
     if (_eof) {
         return seastar::make_ready_future<size_t>(0);
     }
@@ -137,7 +251,12 @@ column_chunk_reader<T>::read_batch_internal(size_t n, LevelT def[], LevelT rep[]
             ++values_to_read;
         }
     }
-    size_t values_read = _val_decoder.read_batch(values_to_read, val);
+    size_t values_read;
+    {
+        metrics::scoped_timer timer{&metrics::stats::decode_latency};
+        tracing::span span{tracing::phase::decode, _source.trace_context(), _source.page_ordinal()};
+        values_read = _val_decoder.read_batch(values_to_read, val);
+    }
     if (values_read != values_to_read) {
         return seastar::make_exception_future<size_t>(parquet_exception::corrupted_file(seastar::format(
                 "Number of values in batch {} is less than indicated by def levels {}", values_read, values_to_read)));
@@ -145,14 +264,15 @@ column_chunk_reader<T>::read_batch_internal(size_t n, LevelT def[], LevelT rep[]
     return seastar::make_ready_future<size_t>(def_levels_read);
 }
 
-template<format::Type::type T>
+template<format::Type::type T, typename ValueDecoder>
 template<typename LevelT>
 seastar::future<size_t>
-inline column_chunk_reader<T>::read_batch(size_t n, LevelT def[], LevelT rep[], output_type val[]) {
-    return read_batch_internal(n, def, rep, val)
-    .handle_exception_type([this] (const std::exception& e) {
+inline column_chunk_reader<T, ValueDecoder>::read_batch(size_t n, LevelT def[], LevelT rep[], output_type val[]) {
+    return seastar::with_scheduling_group(_scheduling_group, [this, n, def, rep, val] {
+        return read_batch_internal(n, def, rep, val);
+    }).handle_exception_type([this] (const std::exception& e) {
         return seastar::make_exception_future<size_t>(parquet_exception(seastar::format(
-                "Error while reading page number {}: {}", _page_ordinal, e.what())));
+                "Error while reading page number {}: {}", _source.page_ordinal(), e.what())));
     });
 }
 
@@ -164,5 +284,8 @@ extern template class column_chunk_reader<format::Type::DOUBLE>;
 extern template class column_chunk_reader<format::Type::BOOLEAN>;
 extern template class column_chunk_reader<format::Type::BYTE_ARRAY>;
 extern template class column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY>;
+extern template class column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<12>>;
+extern template class column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<16>>;
+extern template class column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, decimal128_decoder>;
 
 } // namespace parquet4seastar
@@ -24,6 +24,8 @@
 #include <parquet4seastar/column_chunk_reader.hh>
 #include <parquet4seastar/bytes.hh>
 #include <parquet4seastar/encoding.hh>
+#include <parquet4seastar/metrics.hh>
+#include <parquet4seastar/statistics.hh>
 #include <boost/iterator/counting_iterator.hpp>
 #include <unordered_map>
 #include <vector>
@@ -35,6 +37,8 @@ struct writer_options {
     uint32_t rep_level;
     format::Encoding::type encoding;
     format::CompressionCodec::type compression;
+    // The order of min/max statistics. No min or max is written if it is UNKNOWN.
+    sort_order order = sort_order::UNKNOWN;
 };
 
 template <format::Type::type ParquetType>
@@ -44,6 +48,7 @@ class column_chunk_writer {
     rle_builder _def_encoder;
     std::unique_ptr<value_encoder<ParquetType>> _val_encoder;
     std::unique_ptr<compressor> _compressor;
+    statistics_builder<ParquetType> _statistics;
     std::vector<bytes> _pages;
     std::vector<format::PageHeader> _page_headers;
     bytes _dict_page;
@@ -62,11 +67,13 @@ public:
             uint32_t def_level,
             uint32_t rep_level,
             std::unique_ptr<value_encoder<ParquetType>> val_encoder,
-            std::unique_ptr<compressor> compressor)
+            std::unique_ptr<compressor> compressor,
+            sort_order order = sort_order::UNKNOWN)
         : _rep_encoder{bit_width(rep_level)}
         , _def_encoder{bit_width(def_level)}
         , _val_encoder{std::move(val_encoder)}
         , _compressor{std::move(compressor)}
+        , _statistics{order}
         , _used_encodings(10)
         , _rep_level{rep_level}
         , _def_level{def_level}
@@ -84,6 +91,9 @@ public:
         }
         if (_def_level == 0 || def_level == _def_level) {
             _val_encoder->put_batch(&val, 1);
+            _statistics.put(val);
+        } else {
+            _statistics.put_null();
         }
         ++_levels_in_current_page;
     }
@@ -96,6 +106,53 @@ public:
     }
 
     void flush_page() {
+        size_t data_offset;
+        bytes page = start_page(data_offset);
+        auto flush_info = _val_encoder->flush(page.data() + data_offset);
+        page.resize(data_offset + flush_info.size);
+        bytes compressed_page = [&] {
+            metrics::scoped_timer timer{&metrics::stats::compression_latency};
+            return _compressor->compress(page);
+        }();
+        finish_page(page.size(), std::move(compressed_page), flush_info.encoding);
+    }
+
+    // Same as flush_page, but big pages are encoded and compressed in steps
+    // which yield to the reactor. Nothing may be put until the returned future resolves.
+    seastar::future<> flush_page_preemptible() {
+        size_t data_offset;
+        bytes page = start_page(data_offset);
+        return seastar::do_with(std::move(page), [this, data_offset] (bytes& page) {
+            return _val_encoder->flush_preemptible(page.data() + data_offset).then(
+            [this, &page, data_offset] (typename value_encoder<ParquetType>::flush_result flush_info) {
+                page.resize(data_offset + flush_info.size);
+                auto compression_start = metrics::start_timer();
+                return _compressor->compress_preemptible(page).then(
+                [this, &page, flush_info, compression_start] (bytes compressed_page) {
+                    metrics::stop_timer(&metrics::stats::compression_latency, compression_start);
+                    finish_page(page.size(), std::move(compressed_page), flush_info.encoding);
+                });
+            });
+        });
+    }
+
+    seastar::future<seastar::lw_shared_ptr<format::ColumnMetaData>> flush_chunk(seastar::output_stream<char>& sink) {
+        return [this] {
+            if (_levels_in_current_page > 0) {
+                return flush_page_preemptible();
+            }
+            return seastar::make_ready_future<>();
+        }().then([this, &sink] {
+            return write_chunk(sink);
+        });
+    }
+
+    size_t rows_written() const { return _rows_written; }
+    size_t estimated_chunk_size() const { return _estimated_chunk_size; }
+
+private:
+    // Serialize the levels of the current page and make room for its values after them.
+    bytes start_page(size_t& data_offset) {
         bytes page;
         size_t page_max_size = current_page_max_size();
         page.reserve(page_max_size);
@@ -109,21 +166,20 @@ public:
             append_raw_bytes<uint32_t>(page, levels.size());
             page.insert(page.end(), levels.begin(), levels.end());
         }
-        size_t data_offset = page.size();
+        data_offset = page.size();
         page.resize(page_max_size);
-        auto flush_info = _val_encoder->flush(page.data() + data_offset);
-        page.resize(data_offset + flush_info.size);
-
-        bytes compressed_page = _compressor->compress(page);
+        return page;
+    }
 
+    void finish_page(size_t uncompressed_size, bytes compressed_page, format::Encoding::type encoding) {
         format::DataPageHeader data_page_header;
         data_page_header.__set_num_values(_levels_in_current_page);
-        data_page_header.__set_encoding(flush_info.encoding);
+        data_page_header.__set_encoding(encoding);
         data_page_header.__set_definition_level_encoding(format::Encoding::RLE);
         data_page_header.__set_repetition_level_encoding(format::Encoding::RLE);
         format::PageHeader page_header;
         page_header.__set_type(format::PageType::DATA_PAGE);
-        page_header.__set_uncompressed_page_size(page.size());
+        page_header.__set_uncompressed_page_size(uncompressed_size);
         page_header.__set_compressed_page_size(compressed_page.size());
         page_header.__set_data_page_header(data_page_header);
 
@@ -133,15 +189,13 @@ public:
         _levels_in_current_page = 0;
         _values_in_current_page = 0;
 
-        _used_encodings.insert(flush_info.encoding);
+        metrics::record_page_written(ParquetType, page_header, compressed_page.size());
+        _used_encodings.insert(encoding);
         _page_headers.push_back(std::move(page_header));
         _pages.push_back(std::move(compressed_page));
     }
 
-    seastar::future<seastar::lw_shared_ptr<format::ColumnMetaData>> flush_chunk(seastar::output_stream<char>& sink) {
-        if (_levels_in_current_page > 0) {
-            flush_page();
-        }
+    seastar::future<seastar::lw_shared_ptr<format::ColumnMetaData>> write_chunk(seastar::output_stream<char>& sink) {
         auto metadata = seastar::make_lw_shared<format::ColumnMetaData>();
         metadata->__set_type(ParquetType);
         metadata->__set_encodings(
@@ -151,6 +205,7 @@ public:
         metadata->__set_num_values(0);
         metadata->__set_total_compressed_size(0);
         metadata->__set_total_uncompressed_size(0);
+        metadata->__set_statistics(_statistics.flush());
 
         auto write_page = [this, metadata, &sink] (const format::PageHeader& header, bytes_view contents) {
             bytes_view serialized_header = _thrift_serializer.serialize(header);
@@ -168,9 +223,10 @@ public:
 
         return [this, metadata, write_page, &sink] {
             if (_val_encoder->view_dict()) {
-                fill_dictionary_page();
-                metadata->__set_dictionary_page_offset(metadata->total_compressed_size);
-                return write_page(_dict_page_header, _dict_page);
+                return fill_dictionary_page().then([this, metadata, write_page] {
+                    metadata->__set_dictionary_page_offset(metadata->total_compressed_size);
+                    return write_page(_dict_page_header, _dict_page);
+                });
             } else {
                 return seastar::make_ready_future<>();
             }
@@ -190,22 +246,26 @@ public:
         });
     }
 
-    size_t rows_written() const { return _rows_written; }
-    size_t estimated_chunk_size() const { return _estimated_chunk_size; }
-
-private:
-    void fill_dictionary_page() {
+    seastar::future<> fill_dictionary_page() {
         bytes_view dict = *_val_encoder->view_dict();
-        _dict_page = _compressor->compress(dict);
+        auto compression_start = metrics::start_timer();
+        return _compressor->compress_preemptible(dict).then([this, dict, compression_start] (bytes compressed_dict) {
+            metrics::stop_timer(&metrics::stats::compression_latency, compression_start);
+            _dict_page = std::move(compressed_dict);
+            fill_dictionary_page_header(dict.size());
+        });
+    }
 
+    void fill_dictionary_page_header(size_t uncompressed_size) {
         format::DictionaryPageHeader dictionary_page_header;
         dictionary_page_header.__set_num_values(_val_encoder->cardinality());
         dictionary_page_header.__set_encoding(format::Encoding::PLAIN);
         dictionary_page_header.__set_is_sorted(false);
         _dict_page_header.__set_type(format::PageType::DICTIONARY_PAGE);
-        _dict_page_header.__set_uncompressed_page_size(dict.size());
+        _dict_page_header.__set_uncompressed_page_size(uncompressed_size);
         _dict_page_header.__set_compressed_page_size(_dict_page.size());
         _dict_page_header.__set_dictionary_page_header(dictionary_page_header);
+        metrics::record_page_written(ParquetType, _dict_page_header, _dict_page.size());
     }
 };
 
@@ -216,7 +276,8 @@ make_column_chunk_writer(const writer_options& options) {
             options.def_level,
             options.rep_level,
             make_value_encoder<ParquetType>(options.encoding),
-            compressor::make(options.compression));
+            compressor::make(options.compression),
+            options.order);
 }
 
 } // namespace parquet4seastar
@@ -24,6 +24,7 @@
 #include <cstddef>
 #include <parquet4seastar/bytes.hh>
 #include <parquet4seastar/parquet_types.h>
+#include <seastar/core/future.hh>
 
 namespace parquet4seastar {
 
@@ -37,6 +38,13 @@ public:
     // out will be resized appropriately to hold the compressed data.
     virtual bytes compress(bytes_view in, bytes&& out = bytes()) const = 0;
 
+    // Same as decompress and compress, but big inputs are processed in steps
+    // which yield to the reactor when the task quota is exhausted.
+    // Codecs which cannot be processed incrementally (SNAPPY) fall back to the synchronous versions.
+    // in has to stay alive until the returned future resolves.
+    virtual seastar::future<bytes> decompress_preemptible(bytes_view in, bytes&& out) const;
+    virtual seastar::future<bytes> compress_preemptible(bytes_view in, bytes&& out = bytes()) const;
+
     virtual format::CompressionCodec::type type() const = 0;
 
     static std::unique_ptr<compressor> make(format::CompressionCodec::type compression);
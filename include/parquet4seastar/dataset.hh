@@ -0,0 +1,107 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <parquet4seastar/sharded_scan.hh>
+#include <parquet4seastar/statistics.hh>
+
+/* A dataset is a set of files with the same schema, e.g. the files of one table.
+ *
+ * Opening a dataset reads the footers of all files, a bounded number at a time, and checks
+ * that their schemata agree. Row groups are then selected by the statistics of their column
+ * chunks, and only the files which have selected row groups are opened by scans.
+ *
+ * The footers can also be merged, once, into a summary file (conventionally named _metadata),
+ * whose row groups refer to the data files through ColumnChunk::file_path. A dataset opened
+ * from a summary file is planned from that one footer. The summary file is a valid parquet
+ * file of its own, which file_reader can read as well.
+ */
+namespace parquet4seastar {
+
+struct dataset_options {
+    // Used to read the footers.
+    io_options io;
+    // Footers read at the same time.
+    size_t max_concurrent_reads = 100;
+};
+
+class dataset {
+    std::vector<std::string> _paths;
+    std::vector<std::unique_ptr<format::FileMetaData>> _metadata;
+    // Refers to the schema of the first file.
+    std::unique_ptr<reader_schema::raw_schema> _raw_schema;
+private:
+    dataset() = default;
+    void check_schemata() const;
+    void build_raw_schema();
+public:
+    // Fails if a footer can't be read, or if the files don't have the same schema (up to the name of the root).
+    // Listing the files, e.g. of a directory, is left to the caller.
+    static seastar::future<dataset> open(std::vector<std::string> paths, dataset_options options = {});
+    // Open the dataset described by a summary file (see summary_builder). Every row group
+    // of the summary must be stored in one data file.
+    static seastar::future<dataset> open_summary(std::string path, dataset_options options = {});
+
+    const std::vector<std::string>& paths() const { return _paths; }
+    const format::FileMetaData& metadata(uint32_t file) const { return *_metadata[file]; }
+    // The schema shared by all files.
+    const reader_schema::raw_schema& raw_schema() const { return *_raw_schema; }
+    int64_t num_rows() const;
+    // The index of the leaf column with the given dotted path, e.g. "a.list.element".
+    uint32_t leaf_index(std::string_view path) const;
+
+    // The row groups whose statistics don't rule out any of the predicates, numbered in file order.
+    // Statistics only bound the values of a row group, so some records of the selected row groups
+    // may still fail the predicates.
+    std::vector<row_group_ref> select_row_groups(const std::vector<predicate>& predicates) const;
+
+    // Reads the selected row groups on all shards, as sharded_scan does.
+    template <typename ConsumerFactory, typename Merge>
+    seastar::future<> scan(
+            const std::vector<predicate>& predicates,
+            sharded_scan_options options,
+            ConsumerFactory make_consumer,
+            Merge merge) const {
+        return seastar::futurize_invoke([&] {
+            return distribute_row_group_refs(select_row_groups(predicates), seastar::smp::count);
+        }).then([paths = _paths, options = std::move(options), make_consumer = std::move(make_consumer),
+                merge = std::move(merge)] (std::vector<std::vector<row_group_ref>> plan) mutable {
+            return sharded_scan(std::move(paths), std::move(plan), std::move(options),
+                    std::move(make_consumer), std::move(merge));
+        });
+    }
+};
+
+// Merges the footers of data files, e.g. file_writer::metadata() of each writer, into the
+// footer of a summary file. The files must have the same schema.
+class summary_builder {
+    format::FileMetaData _metadata;
+    bool _empty = true;
+public:
+    // The path of the data file is stored relative to the directory of the summary file.
+    void add(const std::string& relative_path, const format::FileMetaData& footer);
+    const format::FileMetaData& metadata() const { return _metadata; }
+    // Only the scheduling group and the output stream options apply.
+    seastar::future<> write(std::string path, io_options options = {}) const;
+};
+
+} // namespace parquet4seastar
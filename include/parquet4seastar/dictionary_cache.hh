@@ -0,0 +1,127 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <parquet4seastar/page_cache.hh>
+#include <any>
+#include <optional>
+#include <typeindex>
+#include <vector>
+
+/* A per-shard cache of decoded dictionaries, shared by all column chunk readers of the shard.
+ *
+ * A column chunk reader which finds the dictionary of its chunk in the cache skips the
+ * dictionary page and decodes straight into the cached values. Dictionaries are reference
+ * counted, so concurrent scans of the same chunk share one copy, and an evicted dictionary
+ * stays valid for the readers still using it.
+ * The cache is bounded by a byte size and shrinks under memory pressure. It is disabled by
+ * default; enable_dictionary_cache() has to be called on every shard which should use it.
+ * Readers opt out with io_options::use_dictionary_cache.
+ */
+namespace parquet4seastar {
+
+template <typename OutputType>
+struct cached_dictionary {
+    // Not const, because sharing a seastar::temporary_buffer modifies it.
+    seastar::lw_shared_ptr<std::vector<OutputType>> values;
+    size_t on_disk_size; // Of the dictionary page, with its header.
+    size_t memory_usage; // Of the values, and of the buffer they share (if any).
+};
+
+class dictionary_cache {
+public:
+    struct stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+    };
+private:
+    // The same chunk can be read with decoders of different output types.
+    struct key {
+        column_chunk_id chunk;
+        std::type_index type;
+        bool operator==(const key& o) const {
+            return chunk == o.chunk && type == o.type;
+        }
+    };
+    struct key_hash {
+        size_t operator()(const key& k) const;
+    };
+    struct entry {
+        key k;
+        std::any dictionary; // cached_dictionary<OutputType>
+        size_t memory_usage;
+    };
+    using lru_list = std::list<entry>; // Most recently used first.
+    lru_list _lru;
+    std::unordered_map<key, lru_list::iterator, key_hash> _index;
+    size_t _capacity;
+    size_t _size = 0;
+    stats _stats;
+    seastar::memory::reclaimer _reclaimer;
+    seastar::metrics::metric_groups _metrics;
+private:
+    const std::any* find_entry(const key& k);
+    const std::any& insert_entry(const key& k, std::any dictionary, size_t memory_usage);
+    void evict_one();
+    seastar::memory::reclaiming_result reclaim();
+public:
+    explicit dictionary_cache(size_t capacity);
+    dictionary_cache(const dictionary_cache&) = delete;
+    dictionary_cache& operator=(const dictionary_cache&) = delete;
+
+    template <typename OutputType>
+    std::optional<cached_dictionary<OutputType>> find(const column_chunk_id& chunk) {
+        const std::any* e = find_entry(key{chunk, typeid(OutputType)});
+        if (!e) {
+            return {};
+        }
+        return std::any_cast<const cached_dictionary<OutputType>&>(*e);
+    }
+    // Return the cached dictionary of the chunk: the given one, or the one inserted
+    // before by a concurrent reader. Dictionaries bigger than the capacity are not inserted.
+    template <typename OutputType>
+    cached_dictionary<OutputType> insert(const column_chunk_id& chunk, cached_dictionary<OutputType> dictionary) {
+        size_t memory_usage = dictionary.memory_usage;
+        if (memory_usage > _capacity) {
+            return dictionary;
+        }
+        const std::any& e = insert_entry(key{chunk, typeid(OutputType)}, std::move(dictionary), memory_usage);
+        return std::any_cast<const cached_dictionary<OutputType>&>(e);
+    }
+    // Evict least recently used dictionaries until at most `size` bytes remain.
+    void shrink(size_t size);
+    void clear() { shrink(0); }
+    size_t capacity() const { return _capacity; }
+    size_t size_bytes() const { return _size; }
+    size_t entries() const { return _index.size(); }
+    const stats& get_stats() const { return _stats; }
+};
+
+// Create the dictionary cache of this shard (replacing the existing one, if any), with the given size in bytes.
+void enable_dictionary_cache(size_t capacity);
+void disable_dictionary_cache();
+// The dictionary cache of this shard, or null if disabled.
+dictionary_cache* local_dictionary_cache();
+
+} // namespace parquet4seastar
@@ -27,6 +27,7 @@
 #include <parquet4seastar/parquet_types.h>
 #include <parquet4seastar/rle_encoding.hh>
 #include <seastar/core/temporary_buffer.hh>
+#include <seastar/core/future.hh>
 #include <seastar/core/bitops.hh>
 #include <variant>
 
@@ -79,6 +80,10 @@ public:
                 },
         }, _decoder);
     }
+
+    // Skip the remaining levels of the page. Return their number, and how many of them equal level.
+    // Runs of repeated levels are counted without being expanded.
+    std::pair<uint32_t, uint32_t> count_remaining(uint32_t level);
 };
 
 template<format::Type::type T>
@@ -183,6 +188,47 @@ extern template class value_decoder<format::Type::BOOLEAN>;
 extern template class value_decoder<format::Type::BYTE_ARRAY>;
 extern template class value_decoder<format::Type::FIXED_LEN_BYTE_ARRAY>;
 
+/* A value decoder for FIXED_LEN_BYTE_ARRAY columns of a width known in advance.
+ * value_decoder<FIXED_LEN_BYTE_ARRAY> returns every value as a separate seastar::temporary_buffer.
+ * For narrow values (UUID, INTERVAL, DECIMAL) that is mostly overhead, so this decoder
+ * returns them by value instead, in a contiguous array of OutputType:
+ * - std::array<byte, N> returns the raw bytes of values with type_length == N,
+ * - __int128 returns big-endian two's complement DECIMAL values of type_length <= 16.
+ * It can be plugged into column_chunk_reader in place of value_decoder.
+ */
+template<typename OutputType>
+class fixed_len_value_decoder {
+public:
+    using output_type = OutputType;
+private:
+    uint32_t _type_length;
+    bool _dict_encoded = false;
+    bytes_view _buffer;
+    RleDecoder _rle_decoder;
+    bool _dict_set = false;
+    const output_type* _dict = nullptr;
+    size_t _dict_size = 0;
+private:
+    size_t read_plain(size_t n, output_type out[]);
+    size_t read_dict(size_t n, output_type out[]);
+public:
+    explicit fixed_len_value_decoder(std::optional<uint32_t> type_length);
+    // Set a new dictionary (to be used for decoding RLE_DICTIONARY) for this reader.
+    void reset_dict(output_type* dictionary, size_t dictionary_size);
+    // Set a new source of encoded data.
+    void reset(bytes_view buf, format::Encoding::type encoding);
+    // Read a batch of n values (the last batch may be smaller than n).
+    size_t read_batch(size_t n, output_type out[]);
+};
+
+template<size_t N>
+using fixed_len_bytes_decoder = fixed_len_value_decoder<std::array<byte, N>>;
+using decimal128_decoder = fixed_len_value_decoder<__int128>;
+
+extern template class fixed_len_value_decoder<std::array<byte, 12>>;
+extern template class fixed_len_value_decoder<std::array<byte, 16>>;
+extern template class fixed_len_value_decoder<__int128>;
+
 template <format::Type::type ParquetType>
 class value_encoder {
 public:
@@ -194,6 +240,11 @@ public:
     virtual void put_batch(const input_type data[], size_t size) = 0;
     virtual size_t max_encoded_size() const = 0;
     virtual flush_result flush(byte sink[]) = 0;
+    // Same as flush, but encoders which do a lot of work at flush time
+    // split it into steps which yield to the reactor.
+    virtual seastar::future<flush_result> flush_preemptible(byte sink[]) {
+        return seastar::futurize_invoke([this, sink] { return flush(sink); });
+    }
     virtual std::optional<bytes_view> view_dict() { return {}; };
     virtual uint64_t cardinality() { return 0; }
     virtual ~value_encoder() = default;
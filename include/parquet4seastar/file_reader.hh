@@ -21,30 +21,126 @@
 
 #pragma once
 
+#include <parquet4seastar/bloom_filter.hh>
 #include <parquet4seastar/column_chunk_reader.hh>
+#include <parquet4seastar/io_options.hh>
+#include <parquet4seastar/page_cache.hh>
 #include <parquet4seastar/reader_schema.hh>
 #include <seastar/core/file.hh>
+#include <seastar/core/shared_future.hh>
+#include <map>
+#include <unordered_map>
 
 namespace parquet4seastar {
 
+// The data pages in [begin, end) of a column chunk, relative to the beginning of the chunk.
+// The ranges of a chunk (see file_reader::split_column_chunk) start at record boundaries,
+// so they can be read and decoded concurrently, on one shard or on several, and their
+// values concatenated in order.
+struct page_range {
+    uint32_t row_group;
+    uint32_t column;
+    uint64_t begin;
+    uint64_t end;
+    // The dictionary page takes the first dictionary_size bytes of the chunk (0 if there is none).
+    // It is read by the reader of every range.
+    uint64_t dictionary_size;
+    // Rows of the row group in this range.
+    int64_t first_row;
+    int64_t num_rows;
+};
+
+// The indexes of a column chunk which let a reader find values without scanning the chunk:
+// its Bloom filter, ColumnIndex and OffsetIndex, if the file has them.
+struct chunk_index {
+    // Empty if the chunk has none, or if its algorithm is unsupported.
+    std::optional<bloom_filter> filter;
+    std::optional<format::ColumnIndex> column_index;
+    // One range per data page, from the OffsetIndex. Empty if the chunk has none.
+    std::vector<page_range> pages;
+};
+
+// A row found by file_reader::lookup.
+struct row_position {
+    uint32_t row_group;
+    int64_t row; // Within the row group.
+};
+
+enum class sort_direction {
+    ascending,
+    descending,
+};
+
 class file_reader {
+    // The file storing a column chunk: this file, or the one named by ColumnChunk::file_path.
+    struct chunk_file {
+        seastar::file file;
+        std::optional<file_identity> identity;
+    };
     std::string _path;
     seastar::file _file;
+    seastar::lw_shared_ptr<const mapped_file> _mapping; // Set in the mmap read mode, and for files in memory.
+    bool _in_memory = false; // Opened from a buffer, without a file.
     std::unique_ptr<format::FileMetaData> _metadata;
     std::unique_ptr<reader_schema::schema> _schema;
     std::unique_ptr<reader_schema::raw_schema> _raw_schema;
+    io_options _options;
+    // The key of the file in the page and dictionary caches. Files in memory have none, and are not cached.
+    std::optional<file_identity> _identity;
+    // Files referenced by ColumnChunk::file_path, opened once and closed by close().
+    std::unordered_map<std::string, seastar::shared_future<chunk_file>> _external_files;
+    // Indexes read by read_chunk_index, by row group and column.
+    std::map<std::pair<uint32_t, uint32_t>, seastar::shared_future<seastar::lw_shared_ptr<const chunk_index>>> _chunk_indexes;
+    // Computed by sorted(), by column.
+    std::unordered_map<uint32_t, std::optional<sort_direction>> _sortedness;
 private:
     file_reader() {};
-    static seastar::future<std::unique_ptr<format::FileMetaData>> read_file_metadata(seastar::file file);
+    static seastar::future<std::unique_ptr<format::FileMetaData>> read_file_metadata(
+            seastar::file file, seastar::io_priority_class pc);
+    static std::unique_ptr<format::FileMetaData> read_file_metadata(bytes_view file);
+    seastar::future<chunk_file> open_chunk_file(const format::ColumnChunk& column_chunk);
+    peekable_stream open_stream(seastar::file f, bool mapped, uint64_t offset, uint64_t length,
+            const io_options& options) const;
+    seastar::lw_shared_ptr<const tracing::context> trace_context(const reader_schema::raw_node& leaf) const;
+    seastar::future<std::unique_ptr<format::ColumnMetaData>> read_column_metadata(
+            const format::ColumnChunk& column_chunk, seastar::file f, bool mapped, const io_options& options) const;
+    template <format::Type::type T, typename ValueDecoder>
+    seastar::future<column_chunk_reader<T, ValueDecoder>> open_column_chunk_reader_internal(
+            uint32_t row_group, uint32_t column, const io_options& options, std::optional<page_range> range,
+            std::optional<memory_account> admitted = std::nullopt);
+    seastar::future<seastar::temporary_buffer<uint8_t>> read_bytes(
+            seastar::file f, bool mapped, uint64_t offset, uint64_t length, const io_options& options) const;
+    seastar::future<chunk_index> load_chunk_index(uint32_t row_group, uint32_t column, const io_options& options);
+    template <format::Type::type T>
+    seastar::future<> find_in_pages(uint32_t row_group, uint32_t column, std::vector<page_range> ranges,
+            const scalar& key, std::vector<row_position>& found);
+    seastar::future<std::optional<int64_t>> seek_in_row_group(uint32_t row_group, uint32_t column,
+            const scalar& key, sort_order order, sort_direction direction);
     template <format::Type::type T>
-    seastar::future<column_chunk_reader<T>>
-    open_column_chunk_reader_internal(uint32_t row_group, uint32_t column);
+    seastar::future<std::optional<int64_t>> seek_in_range(page_range range,
+            const scalar& key, sort_order order, sort_direction direction);
 public:
     // The entry point to this library.
-    static seastar::future<file_reader> open(std::string path);
-    seastar::future<> close() { return _file.close(); };
+    // The options apply to reading the metadata and are the default for column chunk readers.
+    static seastar::future<file_reader> open(std::string path, io_options options = {});
+    // Read a file held in memory, e.g. received from the network. Column chunks stored in
+    // other files (ColumnChunk::file_path) cannot be read. Only the scheduling group and
+    // the memory limiter of the options apply.
+    static seastar::future<file_reader> open(seastar::temporary_buffer<char> contents, io_options options = {});
+    // Read a file held in memory in several fragments. The fragments are copied into one buffer.
+    static seastar::future<file_reader> open(
+            std::vector<seastar::temporary_buffer<char>> fragments, io_options options = {});
+    // Read only the metadata of a file, e.g. to plan which of many files to open.
+    // Only the scheduling group and the I/O priority class of the options apply.
+    static seastar::future<std::unique_ptr<format::FileMetaData>> read_metadata(std::string path, io_options options = {});
+    // Close the file and the files referenced by its column chunks.
+    seastar::future<> close();
     const std::string& path() const { return _path; }
+    // A null file for files in memory.
     seastar::file file() const { return _file; }
+    const io_options& options() const { return _options; }
+    // Whether the file is read through a memory mapping (see io_options::mmap), or is in memory.
+    bool mapped() const { return bool(_mapping); }
     const format::FileMetaData& metadata() const { return *_metadata; }
     // The schemata are computed lazily (not on open) for robustness.
     // This way lower-level operations (i.e. inspecting metadata,
@@ -63,25 +159,150 @@ public:
         return *_schema;
     }
 
-    template <format::Type::type T>
-    seastar::future<column_chunk_reader<T>> open_column_chunk_reader(uint32_t row_group, uint32_t column);
+    template <format::Type::type T, typename ValueDecoder = value_decoder<T>>
+    seastar::future<column_chunk_reader<T, ValueDecoder>> open_column_chunk_reader(uint32_t row_group, uint32_t column) {
+        return open_column_chunk_reader<T, ValueDecoder>(row_group, column, _options);
+    }
+    // Overrides the options given to open(), e.g. to read some columns of a file in the background.
+    template <format::Type::type T, typename ValueDecoder = value_decoder<T>>
+    seastar::future<column_chunk_reader<T, ValueDecoder>> open_column_chunk_reader(
+            uint32_t row_group, uint32_t column, const io_options& options);
+    // The memory a column chunk reader opened with the options is admitted with (see memory_limiter).
+    size_t admission_size(uint32_t row_group, uint32_t column, const io_options& options) const;
+    // Open a reader with memory admitted beforehand, without waiting for admission. Readers opened
+    // together (e.g. the columns of a record reader) are admitted at once for their summed
+    // admission_size, so that none holds part of the budget while waiting for the rest.
+    template <format::Type::type T, typename ValueDecoder = value_decoder<T>>
+    seastar::future<column_chunk_reader<T, ValueDecoder>> open_column_chunk_reader(
+            uint32_t row_group, uint32_t column, const io_options& options, memory_account memory);
+
+    // Split a column chunk into at most max_ranges page ranges of similar compressed size.
+    // Page boundaries are taken from the OffsetIndex of the chunk, if the file has one, and are
+    // found by reading the page headers otherwise. In the latter case, chunks of repeated columns
+    // are not split, since their pages need not start at record boundaries.
+    seastar::future<std::vector<page_range>> split_column_chunk(uint32_t row_group, uint32_t column, size_t max_ranges) {
+        return split_column_chunk(row_group, column, max_ranges, _options);
+    }
+    seastar::future<std::vector<page_range>> split_column_chunk(
+            uint32_t row_group, uint32_t column, size_t max_ranges, const io_options& options);
+    // Read the data pages of one range of a column chunk.
+    template <format::Type::type T, typename ValueDecoder = value_decoder<T>>
+    seastar::future<column_chunk_reader<T, ValueDecoder>> open_column_chunk_reader(const page_range& range) {
+        return open_column_chunk_reader<T, ValueDecoder>(range, _options);
+    }
+    template <format::Type::type T, typename ValueDecoder = value_decoder<T>>
+    seastar::future<column_chunk_reader<T, ValueDecoder>> open_column_chunk_reader(
+            const page_range& range, const io_options& options);
+
+    // Read the Bloom filter, ColumnIndex and OffsetIndex of a column chunk.
+    // They are read once, and kept until the reader is closed.
+    seastar::future<seastar::lw_shared_ptr<const chunk_index>> read_chunk_index(uint32_t row_group, uint32_t column) {
+        return read_chunk_index(row_group, column, _options);
+    }
+    // The options are those of the first read, which loads the indexes.
+    seastar::future<seastar::lw_shared_ptr<const chunk_index>> read_chunk_index(
+            uint32_t row_group, uint32_t column, const io_options& options);
+    // Find the rows whose value of a non-repeated leaf column equals the key, which must be of the
+    // physical type of the column (see scalar). Row groups are pruned by their statistics and Bloom
+    // filters, and the pages of the others by their ColumnIndex. Only the remaining pages are read,
+    // which takes an OffsetIndex; chunks without one are read whole.
+    seastar::future<std::vector<row_position>> lookup(uint32_t column, const scalar& key);
+    // The page of a column chunk holding a row of its row group, e.g. to read the other columns
+    // of a row found by lookup(). Skip row - first_row records of the range to reach it.
+    // The range is the whole chunk if its page boundaries are unknown (see split_column_chunk).
+    seastar::future<page_range> find_row(uint32_t row_group, uint32_t column, int64_t row);
+
+    // The order of the values of a non-repeated column across the file, or none if it is not known
+    // to be sorted. The column is sorted if every row group is sorted by it (it comes first in
+    // RowGroup::sorting_columns) or holds a single value, and the min/max statistics of consecutive
+    // row groups are monotone and don't overlap. Nulls are ignored, but all-null row groups are not
+    // allowed. Only the footer is read, once per column.
+    std::optional<sort_direction> sorted(uint32_t column);
+    // The first row whose value of a sorted column (see sorted()) is not ordered before the key,
+    // or {number of row groups, 0} if there is none. Null values are skipped. The row groups are
+    // binary-searched by their statistics, the pages of the row group found by its ColumnIndex, and
+    // the values of the page found as they are decoded, so one page is typically read.
+    seastar::future<row_position> seek_to_key(uint32_t column, const scalar& key);
 };
 
 extern template seastar::future<column_chunk_reader<format::Type::INT32>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::INT64>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::INT96>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::FLOAT>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::DOUBLE>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::BOOLEAN>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::BYTE_ARRAY>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<12>>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<16>>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, decimal128_decoder>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+
+extern template seastar::future<column_chunk_reader<format::Type::INT32>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+extern template seastar::future<column_chunk_reader<format::Type::INT64>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+extern template seastar::future<column_chunk_reader<format::Type::INT96>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+extern template seastar::future<column_chunk_reader<format::Type::FLOAT>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+extern template seastar::future<column_chunk_reader<format::Type::DOUBLE>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+extern template seastar::future<column_chunk_reader<format::Type::BOOLEAN>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+extern template seastar::future<column_chunk_reader<format::Type::BYTE_ARRAY>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<12>>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<16>>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, decimal128_decoder>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+
+extern template seastar::future<column_chunk_reader<format::Type::INT32>>
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 extern template seastar::future<column_chunk_reader<format::Type::INT64>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 extern template seastar::future<column_chunk_reader<format::Type::INT96>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 extern template seastar::future<column_chunk_reader<format::Type::FLOAT>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 extern template seastar::future<column_chunk_reader<format::Type::DOUBLE>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 extern template seastar::future<column_chunk_reader<format::Type::BOOLEAN>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 extern template seastar::future<column_chunk_reader<format::Type::BYTE_ARRAY>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<12>>>
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<16>>>
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
+extern template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, decimal128_decoder>>
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 
 } // namespace parquet4seastar
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <parquet4seastar/column_chunk_writer.hh>
+#include <parquet4seastar/io_options.hh>
 #include <parquet4seastar/writer_schema.hh>
 #include <parquet4seastar/y_combinator.hh>
 #include <seastar/core/seastar.hh>
@@ -46,6 +47,7 @@ private:
     std::vector<std::vector<std::string>> _leaf_paths;
     thrift_serializer _thrift_serializer;
     size_t _file_offset = 0;
+    io_options _options;
 private:
     void init_writers(const writer_schema::schema &root) {
         using namespace writer_schema;
@@ -68,7 +70,8 @@ private:
                         },
                         [&] (auto logical_type) {
                             constexpr format::Type::type parquet_type = decltype(logical_type)::physical_type;
-                            writer_options options = {def + x.optional, rep, x.encoding, x.compression};
+                            writer_options options = {
+                                    def + x.optional, rep, x.encoding, x.compression, column_sort_order(x.logical_type)};
                             _writers.push_back(make_column_chunk_writer<parquet_type>(options));
                         }
                     }, x.logical_type);
@@ -80,37 +83,74 @@ private:
         }
     }
 
-public:
+    static std::unique_ptr<file_writer> make(const writer_schema::schema& schema, io_options options) {
+        auto fw = std::unique_ptr<file_writer>(new file_writer{});
+        writer_schema::write_schema_result wsr = writer_schema::write_schema(schema);
+        fw->_metadata.schema = std::move(wsr.elements);
+        fw->_leaf_paths = std::move(wsr.leaf_paths);
+        // Statistics are written in the order defined by the logical type of each column.
+        fw->_metadata.__set_column_orders(std::vector<format::ColumnOrder>(fw->_leaf_paths.size(), [] {
+            format::ColumnOrder order;
+            order.__set_TYPE_ORDER(format::TypeDefinedOrder{});
+            return order;
+        }()));
+        fw->init_writers(schema);
+        fw->_options = std::move(options);
+        return fw;
+    }
+
     static seastar::future<std::unique_ptr<file_writer>>
-    open(const std::string& path, const writer_schema::schema& schema) {
-        return seastar::futurize_invoke([&schema, path] {
-            auto fw = std::unique_ptr<file_writer>(new file_writer{});
-            writer_schema::write_schema_result wsr = writer_schema::write_schema(schema);
-            fw->_metadata.schema = std::move(wsr.elements);
-            fw->_leaf_paths = std::move(wsr.leaf_paths);
-            fw->init_writers(schema);
+    start(std::unique_ptr<file_writer> fw, seastar::output_stream<char>&& sink) {
+        fw->_sink = std::move(sink);
+        fw->_file_offset = 4;
+        return fw->_sink.write("PAR1", 4).then(
+        [fw = std::move(fw)] () mutable {
+            return std::move(fw);
+        });
+    }
 
+public:
+    // flush_row_group() and close() run in options.scheduling_group.
+    static seastar::future<std::unique_ptr<file_writer>>
+    open(const std::string& path, const writer_schema::schema& schema, io_options options = {}) {
+        return seastar::futurize_invoke([&schema, path, options = std::move(options)] () mutable {
+            auto fw = make(schema, std::move(options));
             seastar::open_flags flags
                     = seastar::open_flags::wo
                     | seastar::open_flags::create
                     | seastar::open_flags::truncate;
             return seastar::open_file_dma(path, flags).then(
             [fw = std::move(fw)] (seastar::file file) mutable {
-                fw->_sink = seastar::make_file_output_stream(file);
-                fw->_file_offset = 4;
-                return fw->_sink.write("PAR1", 4).then(
-                [fw = std::move(fw)] () mutable {
-                    return std::move(fw);
-                });
+                auto sink = seastar::make_file_output_stream(file, fw->_options.output_stream_options());
+                return start(std::move(fw), std::move(sink));
             });
         });
     }
 
+    // Write the file to any stream, e.g. a network connection or a buffer in memory.
+    // The stream is flushed and closed by close(). Only the scheduling group of the options applies.
+    static seastar::future<std::unique_ptr<file_writer>>
+    open(seastar::output_stream<char>&& sink, const writer_schema::schema& schema, io_options options = {}) {
+        return seastar::futurize_invoke([&schema, &sink, options = std::move(options)] () mutable {
+            return start(make(schema, std::move(options)), std::move(sink));
+        });
+    }
+
+    // Write the file to a data_sink, buffered by options.write_buffer_size.
+    static seastar::future<std::unique_ptr<file_writer>>
+    open(seastar::data_sink sink, const writer_schema::schema& schema, io_options options = {}) {
+        seastar::output_stream<char> stream{std::move(sink), options.write_buffer_size};
+        return open(std::move(stream), schema, std::move(options));
+    }
+
     template <format::Type::type ParquetType>
     column_chunk_writer<ParquetType>& column(int i) {
         return std::get<column_chunk_writer<ParquetType>>(_writers[i]);
     }
 
+    // The footer, complete once close() resolves. See summary_builder.
+    const format::FileMetaData& metadata() const { return _metadata; }
+
     size_t estimated_row_group_size() const {
         size_t size = 0;
         for (const auto& writer : _writers) {
@@ -120,6 +160,19 @@ public:
     }
 
     seastar::future<> flush_row_group() {
+        return seastar::with_scheduling_group(_options.scheduling_group, [this] {
+            return flush_row_group_internal();
+        });
+    }
+
+    seastar::future<> close() {
+        return seastar::with_scheduling_group(_options.scheduling_group, [this] {
+            return close_internal();
+        });
+    }
+
+private:
+    seastar::future<> flush_row_group_internal() {
         using it = boost::counting_iterator<size_t>;
 
         _metadata.row_groups.push_back(format::RowGroup{});
@@ -154,8 +207,8 @@ public:
         });
     }
 
-    seastar::future<> close() {
-        return flush_row_group().then([this] {
+    seastar::future<> close_internal() {
+        return flush_row_group_internal().then([this] {
             for (const format::RowGroup& rg : _metadata.row_groups) {
                 _metadata.num_rows += rg.num_rows;
             }
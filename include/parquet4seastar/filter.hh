@@ -0,0 +1,150 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <parquet4seastar/bytes.hh>
+#include <seastar/core/temporary_buffer.hh>
+#include <array>
+#include <vector>
+
+/* Filter kernels over batches decoded by column_chunk_reader::read_batch.
+ *
+ * A kernel compares an array of values with a constant and produces a selection bitmap,
+ * one bit per value. The comparisons of 32-bit and 64-bit numbers use AVX2, and spread
+ * uses BMI2, where the CPU supports them (detected at run time); the other loops build
+ * 64 bits at a time without branches, which compilers vectorize on their own.
+ *
+ * read_batch returns levels for all positions, and values for the non-null ones only.
+ * compare_batch spreads the selection of the values over the positions of the batch,
+ * so that the result can be combined with selections of other columns read in step.
+ * Nulls never match.
+ */
+namespace parquet4seastar::filter {
+
+enum class compare_op {
+    eq,
+    ne,
+    lt,
+    le,
+    gt,
+    ge,
+};
+
+// A set of positions in [0, size()).
+class selection {
+    std::vector<uint64_t> _words;
+    size_t _size = 0;
+public:
+    selection() = default;
+    explicit selection(size_t size, bool value = false)
+        : _words((size + 63) / 64, value ? ~uint64_t(0) : 0)
+        , _size{size} {
+        clear_padding();
+    }
+    size_t size() const { return _size; }
+    bool test(size_t i) const { return _words[i / 64] >> (i % 64) & 1; }
+    void set(size_t i, bool value = true) {
+        uint64_t bit = uint64_t(1) << (i % 64);
+        _words[i / 64] = value ? _words[i / 64] | bit : _words[i / 64] & ~bit;
+    }
+    // The bits of positions [64 * i, 64 * i + 64). Bits past size() are zero.
+    uint64_t* words() { return _words.data(); }
+    const uint64_t* words() const { return _words.data(); }
+    size_t word_count() const { return _words.size(); }
+    // The number of positions in the set.
+    size_t count() const;
+    bool none() const { return count() == 0; }
+    selection& operator&=(const selection& other);
+    selection& operator|=(const selection& other);
+    // Complement the set.
+    void flip();
+    // Call f(i) for every position i in the set, in increasing order.
+    template <typename Func>
+    void for_each(Func f) const {
+        for (size_t w = 0; w < _words.size(); ++w) {
+            for (uint64_t word = _words[w]; word; word &= word - 1) {
+                f(w * 64 + __builtin_ctzll(word));
+            }
+        }
+    }
+    // Zero the bits past size(), after the words were written directly.
+    void clear_padding() {
+        if (_size % 64) {
+            _words.back() &= (uint64_t(1) << (_size % 64)) - 1;
+        }
+    }
+};
+
+// out (of size n) is set to the positions i for which values[i] op key holds.
+// Unsigned columns (e.g. UINT32 stored as INT32) are compared by passing the values as unsigned.
+void compare_values(const int32_t* values, size_t n, compare_op op, int32_t key, selection& out);
+void compare_values(const uint32_t* values, size_t n, compare_op op, uint32_t key, selection& out);
+void compare_values(const int64_t* values, size_t n, compare_op op, int64_t key, selection& out);
+void compare_values(const uint64_t* values, size_t n, compare_op op, uint64_t key, selection& out);
+// NaN compares as C++ does: only ne holds.
+void compare_values(const float* values, size_t n, compare_op op, float key, selection& out);
+void compare_values(const double* values, size_t n, compare_op op, double key, selection& out);
+// BOOLEAN.
+void compare_values(const uint8_t* values, size_t n, compare_op op, uint8_t key, selection& out);
+// INT96. Only eq and ne are defined.
+void compare_values(const std::array<int32_t, 3>* values, size_t n, compare_op op,
+        const std::array<int32_t, 3>& key, selection& out);
+// BYTE_ARRAY and FIXED_LEN_BYTE_ARRAY, in unsigned lexicographic order.
+void compare_values(const seastar::temporary_buffer<uint8_t>* values, size_t n, compare_op op,
+        bytes_view key, selection& out);
+void starts_with(const seastar::temporary_buffer<uint8_t>* values, size_t n, bytes_view prefix, selection& out);
+
+// The positions of a batch of n levels whose definition level is max_def_level, i.e. which have a value.
+selection validity(const int16_t* def, size_t n, uint32_t max_def_level);
+selection validity(const int32_t* def, size_t n, uint32_t max_def_level);
+
+// Spread a selection of the non-null values of a batch over the positions of the batch.
+// values.size() must be valid.count().
+selection spread(const selection& values, const selection& valid);
+
+// Use the AVX2 and BMI2 kernels on the calling thread, if the CPU supports them (the default).
+// Disabling them selects the portable kernels, e.g. to test or benchmark them.
+void enable_simd(bool enabled);
+// Whether the AVX2 (resp. BMI2) kernels are used on the calling thread.
+bool avx2_enabled();
+bool bmi2_enabled();
+
+// Compare a batch read by column_chunk_reader::read_batch. Returns a selection of its n_levels positions.
+template <typename Value, typename Level, typename Key>
+selection compare_batch(const Value* values, const Level* def, size_t n_levels, uint32_t max_def_level,
+        compare_op op, const Key& key) {
+    selection valid = validity(def, n_levels, max_def_level);
+    selection selected(valid.count());
+    compare_values(values, selected.size(), op, key, selected);
+    return spread(selected, valid);
+}
+
+template <typename Value, typename Level>
+selection starts_with_batch(const Value* values, const Level* def, size_t n_levels, uint32_t max_def_level,
+        bytes_view prefix) {
+    selection valid = validity(def, n_levels, max_def_level);
+    selection selected(valid.count());
+    starts_with(values, selected.size(), prefix, selected);
+    return spread(selected, valid);
+}
+
+} // namespace parquet4seastar::filter
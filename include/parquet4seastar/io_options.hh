@@ -0,0 +1,73 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <parquet4seastar/mapped_file.hh>
+#include <parquet4seastar/memory_limiter.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/io_priority_class.hh>
+#include <seastar/core/scheduling.hh>
+
+namespace parquet4seastar {
+
+// How readers and writers issue their I/O and where they do their CPU work.
+// Lets background work (e.g. compaction-like scans and rewrites) run with
+// a lower share than latency-sensitive reads of the same service.
+struct io_options {
+    // Used for all reads and writes: file metadata, column chunks and output streams.
+    seastar::io_priority_class io_priority_class = seastar::default_priority_class();
+    // Decompression, decoding and encoding run in this group.
+    seastar::scheduling_group scheduling_group = seastar::default_scheduling_group();
+    // Of column chunk input streams.
+    size_t read_buffer_size = 8192;
+    unsigned read_ahead = 16;
+    // Of file output streams.
+    unsigned write_buffer_size = 65536;
+    unsigned write_behind = 1;
+    // If set, column chunk readers are admitted by, and charge their buffers to, this limiter.
+    // It must outlive the readers.
+    memory_limiter* memory = nullptr;
+    // Use the page cache of the shard, if enabled. Turn off for one-off scans that would pollute it.
+    bool use_page_cache = true;
+    // Likewise for the dictionary cache of the shard.
+    bool use_dictionary_cache = true;
+    // Whether file_reader maps the file instead of reading it through DMA streams.
+    // Only effective in file_reader::open. See mapped_file.hh for when mapping is safe.
+    mmap_policy mmap = mmap_policy::never;
+
+    seastar::file_input_stream_options input_stream_options() const {
+        seastar::file_input_stream_options options;
+        options.buffer_size = read_buffer_size;
+        options.read_ahead = read_ahead;
+        options.io_priority_class = io_priority_class;
+        return options;
+    }
+    seastar::file_output_stream_options output_stream_options() const {
+        seastar::file_output_stream_options options;
+        options.buffer_size = write_buffer_size;
+        options.write_behind = write_behind;
+        options.io_priority_class = io_priority_class;
+        return options;
+    }
+};
+
+} // namespace parquet4seastar
@@ -0,0 +1,106 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/* Conversions from the physical representation of logical types to native C++ values.
+ * Every conversion comes in two forms: a scalar one, for record_reader consumers,
+ * and a batch one (in[], n, out[]), for columnar batches produced by column_chunk_reader.
+ * The batch forms are plain loops over contiguous arrays, so they are cheap to call
+ * once per batch and easy for the compiler to vectorize.
+ */
+
+#pragma once
+
+#include <parquet4seastar/logical_type.hh>
+#include <parquet4seastar/bytes.hh>
+#include <seastar/core/temporary_buffer.hh>
+#include <array>
+#include <cstring>
+#include <type_traits>
+
+namespace parquet4seastar::logical_type {
+
+using time_unit = decltype(TIMESTAMP::unit);
+
+constexpr int64_t JULIAN_DAY_OF_EPOCH = 2440588;
+constexpr int64_t SECONDS_PER_DAY = 86400;
+constexpr int64_t NANOS_PER_DAY = SECONDS_PER_DAY * 1'000'000'000;
+
+[[noreturn]] void throw_decimal_too_wide(size_t size, size_t max_size);
+
+// The legacy INT96 timestamp: nanoseconds of the day (little-endian int64) followed by the Julian day (int32).
+inline int64_t int96_to_nanoseconds(const std::array<int32_t, 3>& v) {
+    uint64_t nanos_of_day = static_cast<uint32_t>(v[0]) | (static_cast<uint64_t>(static_cast<uint32_t>(v[1])) << 32);
+    return (static_cast<int64_t>(v[2]) - JULIAN_DAY_OF_EPOCH) * NANOS_PER_DAY + static_cast<int64_t>(nanos_of_day);
+}
+
+// DECIMAL stored in BYTE_ARRAY or FIXED_LEN_BYTE_ARRAY is a big-endian two's complement integer.
+// It is sign-extended to the width of the result and byte-swapped, with no bignum arithmetic involved.
+inline __int128 decimal_to_int128(bytes_view v) {
+    if (v.size() > 16) {
+        throw_decimal_too_wide(v.size(), 16);
+    }
+    byte extended[16];
+    std::memset(extended, (!v.empty() && (v[0] & 0x80)) ? 0xFF : 0x00, 16 - v.size());
+    std::memcpy(extended + 16 - v.size(), v.data(), v.size());
+    uint64_t high;
+    uint64_t low;
+    std::memcpy(&high, extended, 8);
+    std::memcpy(&low, extended + 8, 8);
+    return static_cast<__int128>((static_cast<unsigned __int128>(__builtin_bswap64(high)) << 64) | __builtin_bswap64(low));
+}
+
+inline int64_t decimal_to_int64(bytes_view v) {
+    if (v.size() > 8) {
+        throw_decimal_too_wide(v.size(), 8);
+    }
+    byte extended[8];
+    std::memset(extended, (!v.empty() && (v[0] & 0x80)) ? 0xFF : 0x00, 8 - v.size());
+    std::memcpy(extended + 8 - v.size(), v.data(), v.size());
+    uint64_t x;
+    std::memcpy(&x, extended, 8);
+    return static_cast<int64_t>(__builtin_bswap64(x));
+}
+
+// INT8, INT16, UINT8, UINT16, UINT32 and UINT64 are stored in the wider INT32/INT64 physical types.
+template <typename Out, typename In>
+inline void narrow(const In in[], size_t n, Out out[]) {
+    static_assert(std::is_integral_v<In> && std::is_integral_v<Out> && sizeof(Out) <= sizeof(In));
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<Out>(in[i]);
+    }
+}
+
+void int96_to_nanoseconds(const std::array<int32_t, 3> in[], size_t n, int64_t out[]);
+
+// Rescale TIMESTAMP values between units. Scaling down rounds towards negative infinity.
+// Throws if a value does not fit in int64 after scaling up.
+void rescale_timestamps(const int64_t in[], size_t n, time_unit from, time_unit to, int64_t out[]);
+
+// DATE (days since the Unix epoch) to a timestamp in the given unit.
+void dates_to_timestamps(const int32_t in[], size_t n, time_unit unit, int64_t out[]);
+
+void decimal_to_int128(const seastar::temporary_buffer<uint8_t> in[], size_t n, __int128 out[]);
+void decimal_to_int64(const seastar::temporary_buffer<uint8_t> in[], size_t n, int64_t out[]);
+// For FIXED_LEN_BYTE_ARRAY decimals laid out contiguously, e.g. straight from a PLAIN page.
+void decimal_to_int128(const byte in[], size_t type_length, size_t n, __int128 out[]);
+void decimal_to_int64(const byte in[], size_t type_length, size_t n, int64_t out[]);
+
+} // namespace parquet4seastar::logical_type
@@ -0,0 +1,68 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <parquet4seastar/bytes.hh>
+#include <seastar/core/deleter.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/temporary_buffer.hh>
+#include <string>
+
+/* Read-only memory mappings of whole files, for the mmap read mode of file_reader.
+ * Files held in memory (see file_reader::open(temporary_buffer)) are read the same way.
+ *
+ * Pages and metadata of a mapped file are parsed in place, without the copies of the DMA path.
+ * But a page fault on the mapping blocks the reactor thread until the page is in memory,
+ * so mapping is only safe for files which are always in memory: files on tmpfs, or files which
+ * the application knows to be resident (e.g. locked in the page cache by the operator).
+ * A mapped file must not be truncated while mapped, since reading the missing pages raises SIGBUS.
+ */
+namespace parquet4seastar {
+
+enum class mmap_policy {
+    never,     // Read through DMA streams.
+    in_memory, // Map files on tmpfs. Other files are read through DMA streams.
+    always,    // Map every file.
+};
+
+class mapped_file {
+    const byte* _data;
+    size_t _size;
+    seastar::deleter _deleter; // Unmaps the file, or frees the buffer.
+public:
+    mapped_file(const byte* data, size_t size, seastar::deleter d)
+        : _data{data}, _size{size}, _deleter{std::move(d)} {}
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    // Map the whole file. The open and mmap system calls are done in the calling thread.
+    static seastar::lw_shared_ptr<const mapped_file> map(const std::string& path);
+    // View a file held in memory.
+    static seastar::lw_shared_ptr<const mapped_file> from_buffer(seastar::temporary_buffer<char> contents);
+    bytes_view contents() const { return {_data, _size}; }
+    size_t size() const { return _size; }
+};
+
+// Whether the file should be mapped under the policy.
+seastar::future<bool> should_map(const std::string& path, mmap_policy policy);
+
+} // namespace parquet4seastar
@@ -0,0 +1,117 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <seastar/core/semaphore.hh>
+#include <algorithm>
+#include <utility>
+
+/* Memory accounting for readers.
+ *
+ * A memory_limiter is a budget shared by a set of readers, e.g. all scans of a shard.
+ * Each column chunk reader opened with a limiter (see io_options) is admitted with
+ * an estimate of its stream buffers, and waits while the budget is exhausted.
+ * A record reader is admitted once for all its column chunks (at most the whole budget),
+ * so that concurrent readers never wait while holding part of it.
+ * Once admitted, it charges its actual buffers (stream buffer, decompression buffer,
+ * decoded dictionary, batch buffers of its record reader) to the limiter without waiting,
+ * so that open readers always make progress. Thus the budget may be exceeded temporarily
+ * by big pages, which delays the admission of new readers until memory is released.
+ */
+namespace parquet4seastar {
+
+class memory_account;
+
+class memory_limiter {
+    seastar::semaphore _sem;
+    size_t _limit;
+    friend class memory_account;
+public:
+    explicit memory_limiter(size_t limit) : _sem{limit}, _limit{limit} {}
+    memory_limiter(const memory_limiter&) = delete;
+    memory_limiter& operator=(const memory_limiter&) = delete;
+    size_t limit() const { return _limit; }
+    // Negative when the limit is exceeded.
+    ssize_t available() const { return _sem.available_units(); }
+    size_t used() const { return _limit - available(); }
+    // Number of readers waiting for admission.
+    size_t waiters() const { return _sem.waiters(); }
+    // Wait until n bytes (at most the whole limit) are available and charge them to a new account.
+    seastar::future<memory_account> admit(size_t n);
+};
+
+// The memory charged by one reader. Returns it to the limiter on destruction.
+// A default-constructed account is not attached to any limiter and charges nothing.
+class memory_account {
+    memory_limiter* _limiter = nullptr;
+    size_t _charged = 0;
+public:
+    memory_account() = default;
+    memory_account(memory_limiter& limiter, size_t charged) : _limiter{&limiter}, _charged{charged} {}
+    memory_account(memory_account&& other) noexcept
+        : _limiter{std::exchange(other._limiter, nullptr)}
+        , _charged{std::exchange(other._charged, 0)} {}
+    memory_account& operator=(memory_account&& other) noexcept {
+        if (this != &other) {
+            update(0);
+            _limiter = std::exchange(other._limiter, nullptr);
+            _charged = std::exchange(other._charged, 0);
+        }
+        return *this;
+    }
+    ~memory_account() {
+        update(0);
+    }
+    explicit operator bool() const { return _limiter != nullptr; }
+    size_t charged() const { return _charged; }
+    // Move n bytes (at most all) of the charge to a new account, e.g. to share one admission
+    // among several readers.
+    memory_account split(size_t n) {
+        if (!_limiter) {
+            return memory_account{};
+        }
+        n = std::min(n, _charged);
+        _charged -= n;
+        return memory_account{*_limiter, n};
+    }
+    // Set the charge to n bytes. Never waits.
+    void update(size_t n) {
+        if (!_limiter) {
+            return;
+        }
+        if (n > _charged) {
+            _limiter->_sem.consume(n - _charged);
+        } else if (n < _charged) {
+            _limiter->_sem.signal(_charged - n);
+        }
+        _charged = n;
+    }
+};
+
+inline seastar::future<memory_account> memory_limiter::admit(size_t n) {
+    n = std::min(n, _limit);
+    return _sem.wait(n).then([this, n] {
+        return memory_account{*this, n};
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,149 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <parquet4seastar/parquet_types.h>
+#include <seastar/core/metrics_types.hh>
+#include <array>
+#include <chrono>
+
+/* Optional per-shard read/write instrumentation, exported through seastar::metrics
+ * (and thus Prometheus) under the "parquet4seastar" group.
+ *
+ * Instrumentation is disabled by default. While disabled, every recording function
+ * is a single test of a thread-local flag; no clock is read and no metric is registered.
+ * enable() has to be called on every shard which should report metrics.
+ *
+ * Labels are bounded: physical type, page type and encoding. Column names are not
+ * used as labels, since a wide schema would produce an unbounded number of series.
+ */
+namespace parquet4seastar::metrics {
+
+// Enable instrumentation on this shard and register its metrics with seastar::metrics.
+void enable();
+// Disable instrumentation on this shard and unregister its metrics. The counters are kept.
+void disable();
+
+namespace detail {
+
+extern thread_local bool enabled;
+
+} // namespace detail
+
+inline bool enabled() {
+    return detail::enabled;
+}
+
+// A fixed-bucket latency histogram. Bucket i counts samples shorter than 2^i microseconds,
+// the last bucket counts everything else.
+class latency_histogram {
+public:
+    static constexpr size_t n_buckets = 20;
+private:
+    std::array<uint64_t, n_buckets> _buckets{};
+    uint64_t _count = 0;
+    uint64_t _sum_ns = 0;
+public:
+    void add(std::chrono::nanoseconds latency);
+    seastar::metrics::histogram to_metrics_histogram() const;
+};
+
+enum class page_kind {
+    data,
+    data_v2,
+    dictionary,
+    other,
+};
+constexpr size_t n_page_kinds = 4;
+// Physical types and encodings are indexed by their thrift enum values.
+// Values outside of these ranges (from newer writers) are counted in the last slot.
+constexpr size_t n_physical_types = format::Type::FIXED_LEN_BYTE_ARRAY + 1;
+constexpr size_t n_encodings = format::Encoding::BYTE_STREAM_SPLIT + 2;
+
+struct stats {
+    std::array<uint64_t, n_physical_types> bytes_read{};
+    std::array<uint64_t, n_physical_types> bytes_written{};
+    std::array<uint64_t, n_page_kinds> pages_read{};
+    std::array<uint64_t, n_page_kinds> pages_written{};
+    std::array<uint64_t, n_encodings> pages_read_by_encoding{};
+    std::array<uint64_t, n_encodings> pages_written_by_encoding{};
+    uint64_t pages_skipped = 0;
+    uint64_t dictionary_fallbacks = 0;
+    latency_histogram decompression_latency;
+    latency_histogram compression_latency;
+    latency_histogram decode_latency;
+};
+
+// The counters of this shard.
+stats& local_stats();
+
+// Record a page read by column_chunk_reader (compressed size, excluding the page header).
+void record_page_read(format::Type::type type, const format::PageHeader& header, size_t size);
+// Record a page written by column_chunk_writer (compressed size, excluding the page header).
+void record_page_written(format::Type::type type, const format::PageHeader& header, size_t size);
+
+inline void record_pages_skipped(uint64_t n) {
+    if (enabled()) {
+        local_stats().pages_skipped += n;
+    }
+}
+
+inline void record_dictionary_fallback() {
+    if (enabled()) {
+        ++local_stats().dictionary_fallbacks;
+    }
+}
+
+// For phases which span several tasks: the start time, or a null time point if disabled.
+inline std::chrono::steady_clock::time_point start_timer() {
+    return enabled() ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+}
+
+inline void stop_timer(latency_histogram stats::* histogram, std::chrono::steady_clock::time_point start) {
+    if (enabled() && start != std::chrono::steady_clock::time_point{}) {
+        (local_stats().*histogram).add(std::chrono::steady_clock::now() - start);
+    }
+}
+
+// Adds the time between its construction and destruction to a histogram.
+// Does not read the clock if instrumentation is disabled.
+class scoped_timer {
+    using clock = std::chrono::steady_clock;
+    latency_histogram* _histogram = nullptr;
+    clock::time_point _start;
+public:
+    explicit scoped_timer(latency_histogram stats::* histogram) {
+        if (enabled()) {
+            _histogram = &(local_stats().*histogram);
+            _start = clock::now();
+        }
+    }
+    scoped_timer(const scoped_timer&) = delete;
+    scoped_timer& operator=(const scoped_timer&) = delete;
+    ~scoped_timer() {
+        if (_histogram) {
+            _histogram->add(clock::now() - _start);
+        }
+    }
+};
+
+} // namespace parquet4seastar::metrics
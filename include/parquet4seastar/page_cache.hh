@@ -0,0 +1,137 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <parquet4seastar/bytes.hh>
+#include <parquet4seastar/parquet_types.h>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/memory.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <list>
+#include <unordered_map>
+#include <sys/stat.h>
+
+/* A per-shard LRU cache of decompressed pages, shared by all column chunk readers of the shard.
+ *
+ * Repeated scans of the same files skip the I/O, header parsing and decompression of cached
+ * pages. The cache is bounded by a byte size, and also shrinks under memory pressure through
+ * a seastar::memory::reclaimer. It is disabled by default; enable_page_cache() has to be called
+ * on every shard which should use it. Readers opt out with io_options::use_page_cache.
+ */
+namespace parquet4seastar {
+
+// Identifies the contents of a file. A rewritten file (different mtime or size) is a different file.
+struct file_identity {
+    uint64_t device;
+    uint64_t inode;
+    int64_t mtime_ns;
+    uint64_t size;
+    static file_identity from_stat(const struct stat& st);
+    bool operator==(const file_identity& o) const {
+        return device == o.device && inode == o.inode && mtime_ns == o.mtime_ns && size == o.size;
+    }
+};
+
+// Identifies a column chunk by the offset of its first page.
+struct column_chunk_id {
+    file_identity file;
+    uint64_t offset;
+    bool operator==(const column_chunk_id& o) const {
+        return file == o.file && offset == o.offset;
+    }
+};
+
+struct column_chunk_id_hash {
+    size_t operator()(const column_chunk_id& id) const;
+};
+
+struct page_cache_key {
+    column_chunk_id chunk;
+    uint64_t page_offset; // Relative to the beginning of the chunk.
+    bool operator==(const page_cache_key& o) const {
+        return chunk == o.chunk && page_offset == o.page_offset;
+    }
+};
+
+struct page_cache_key_hash {
+    size_t operator()(const page_cache_key& k) const;
+};
+
+struct cached_page {
+    format::PageHeader header;
+    bytes levels; // Repetition and definition levels of DATA_PAGE_V2 pages. Empty for other pages.
+    bytes values; // Decompressed contents (values, for DATA_PAGE_V2 pages).
+    size_t on_disk_size; // Of the header and compressed contents.
+    size_t memory_usage() const {
+        return sizeof(cached_page) + levels.capacity() + values.capacity();
+    }
+};
+
+class page_cache {
+public:
+    struct stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+    };
+private:
+    struct entry {
+        page_cache_key key;
+        seastar::lw_shared_ptr<const cached_page> page;
+    };
+    using lru_list = std::list<entry>; // Most recently used first.
+    lru_list _lru;
+    std::unordered_map<page_cache_key, lru_list::iterator, page_cache_key_hash> _index;
+    size_t _capacity;
+    size_t _size = 0;
+    stats _stats;
+    seastar::memory::reclaimer _reclaimer;
+    seastar::metrics::metric_groups _metrics;
+private:
+    // Return the bytes actually freed.
+    size_t evict_one();
+    seastar::memory::reclaiming_result reclaim();
+public:
+    explicit page_cache(size_t capacity);
+    page_cache(const page_cache&) = delete;
+    page_cache& operator=(const page_cache&) = delete;
+    // Null on miss. The returned page stays valid after its eviction.
+    seastar::lw_shared_ptr<const cached_page> find(const page_cache_key& key);
+    // Pages bigger than the capacity are not inserted.
+    void insert(const page_cache_key& key, seastar::lw_shared_ptr<const cached_page> page);
+    // Evict least recently used pages until at most `size` bytes remain.
+    void shrink(size_t size);
+    void clear() { shrink(0); }
+    size_t capacity() const { return _capacity; }
+    size_t size_bytes() const { return _size; }
+    size_t entries() const { return _index.size(); }
+    const stats& get_stats() const { return _stats; }
+};
+
+// Create the page cache of this shard (replacing the existing one, if any), with the given size in bytes.
+void enable_page_cache(size_t capacity);
+void disable_page_cache();
+// The page cache of this shard, or null if disabled.
+page_cache* local_page_cache();
+
+} // namespace parquet4seastar
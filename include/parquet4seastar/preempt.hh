@@ -0,0 +1,55 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+  Pages and dictionaries can be arbitrarily big (tens of MiB), so loops over them
+  must not run to completion in a single task. Such loops are split into steps
+  of about preemption_step_size bytes (or values), and the reactor gets control
+  back between steps whenever the task quota is exhausted.
+ */
+
+#pragma once
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/preempt.hh>
+
+namespace parquet4seastar {
+
+constexpr size_t preemption_step_size = 64 * 1024;
+
+// Call step() until it returns stop_iteration::yes.
+// Yields to the reactor between calls when seastar::need_preempt().
+// At least one step runs between yields, since need_preempt() is always true in debug builds.
+template <typename Step>
+seastar::future<> repeat_preemptible(Step step) {
+    return seastar::repeat([step = std::move(step)] () mutable {
+        do {
+            if (step() == seastar::stop_iteration::yes) {
+                return seastar::make_ready_future<seastar::stop_iteration>(seastar::stop_iteration::yes);
+            }
+        } while (!seastar::need_preempt());
+        return seastar::later().then([] {
+            return seastar::stop_iteration::no;
+        });
+    });
+}
+
+} // namespace parquet4seastar
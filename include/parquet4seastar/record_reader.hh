@@ -23,6 +23,7 @@
 
 #include <parquet4seastar/file_reader.hh>
 #include <parquet4seastar/reader_schema.hh>
+#include <deque>
 #include <limits>
 
 namespace parquet4seastar::record {
@@ -66,6 +67,7 @@ public:
         , _rep_levels(batch_size)
         , _def_levels(batch_size)
         , _values(batch_size) {
+        _source.charge_memory(batch_size * (2 * sizeof(int32_t) + sizeof(output_type)));
         if (_def_level > static_cast<uint32_t>(std::numeric_limits<int16_t>::max())
                 || _rep_level > static_cast<uint32_t>(std::numeric_limits<int16_t>::max())) {
             throw parquet_exception(seastar::format(
@@ -77,6 +79,7 @@ public:
     seastar::future<> read_field(Consumer& c);
     seastar::future<> skip_field();
     seastar::future<int, int> current_levels();
+    seastar::future<> prefetch();
     const std::string& name() const { return _name; };
 
 private:
@@ -105,6 +108,7 @@ public:
     seastar::future<> read_field(Consumer& c);
     seastar::future<> skip_field();
     seastar::future<int, int> current_levels();
+    seastar::future<> prefetch();
     const std::string& name() const { return _name; };
 };
 
@@ -126,6 +130,7 @@ public:
     seastar::future<> read_field(Consumer& c);
     seastar::future<> skip_field();
     seastar::future<int, int> current_levels();
+    seastar::future<> prefetch();
     const std::string& name() const { return _name; };
 };
 
@@ -147,6 +152,7 @@ public:
     seastar::future<> read_field(Consumer& c);
     seastar::future<> skip_field();
     seastar::future<int, int> current_levels();
+    seastar::future<> prefetch();
     const std::string& name() const { return _name; };
 };
 
@@ -171,6 +177,7 @@ public:
     seastar::future<> read_field(Consumer& c);
     seastar::future<> skip_field();
     seastar::future<int, int> current_levels();
+    seastar::future<> prefetch();
     const std::string& name() const { return _name; };
 private:
     template <typename Consumer>
@@ -224,11 +231,16 @@ struct field_reader {
     seastar::future<> skip_field() {
         return std::visit([](auto& x) {return x.skip_field();}, _reader);
     }
+    seastar::future<> prefetch() {
+        return std::visit([](auto& x) {return x.prefetch();}, _reader);
+    }
     seastar::future<int, int> current_levels() {
         return std::visit([](auto& x) {return x.current_levels();}, _reader);
     }
+    // The column chunk readers take their memory from the account, admitted beforehand
+    // for all the column chunks of the record reader (see file_reader::admission_size).
     static seastar::future<field_reader>
-    make(file_reader& file, const reader_schema::node& node_variant, int row_group);
+    make(file_reader& file, const reader_schema::node& node_variant, int row_group, memory_account& memory);
 };
 
 class record_reader {
@@ -239,11 +251,44 @@ class record_reader {
             std::vector<field_reader>&& field_readers)
         : _schema(schema), _field_readers(std::move(field_readers)) {
     }
+    static seastar::future<record_reader> make(
+            file_reader& fr, int row_group, std::vector<const reader_schema::node*> field_nodes);
 public:
     template <typename Consumer> seastar::future<> read_one(Consumer& c);
     template <typename Consumer> seastar::future<> read_all(Consumer& c);
     seastar::future<int, int> current_levels();
+    // Load the first page of every column, e.g. while another row group is being read.
+    seastar::future<> prefetch();
     static seastar::future<record_reader> make(file_reader& fr, int row_group);
+    // Reads only the given top-level fields, in the given order.
+    static seastar::future<record_reader> make(file_reader& fr, int row_group, const std::vector<std::string>& columns);
+};
+
+// Reads the records of several row groups in turn. While a row group is read, the readers of
+// the next `lookahead` row groups are opened and prefetched, so that the streams of a row group
+// are warm when it is reached. close() must be called before destruction.
+class multi_record_reader {
+    file_reader& _fr;
+    std::vector<uint32_t> _row_groups;
+    std::vector<std::string> _columns; // All top-level fields if empty.
+    size_t _lookahead;
+    size_t _next_to_open = 0;
+    std::deque<seastar::future<std::unique_ptr<record_reader>>> _opening; // In row group order.
+    void open_ahead(size_t pending);
+public:
+    multi_record_reader(
+            file_reader& fr,
+            std::vector<uint32_t> row_groups,
+            size_t lookahead = 1,
+            std::vector<std::string> columns = {});
+    // All row groups of the file.
+    explicit multi_record_reader(file_reader& fr, size_t lookahead = 1);
+    // If reading fails, the readers opened ahead are closed before the error is returned.
+    template <typename Consumer> seastar::future<> read_all(Consumer& c);
+    // The number of readers opened ahead of the row group being read (at most lookahead).
+    size_t opened_ahead() const { return _opening.size(); }
+    // Wait for the readers opened ahead, which were not read.
+    seastar::future<> close();
 };
 
 template <typename L>
@@ -388,6 +433,35 @@ inline seastar::future<int, int> record_reader::current_levels() {
     return _field_readers[0].current_levels();
 }
 
+inline seastar::future<> struct_reader::prefetch() {
+    return seastar::parallel_for_each(_readers, [] (field_reader& child) {
+        return child.prefetch();
+    });
+}
+
+inline seastar::future<> list_reader::prefetch() {
+    return _reader->prefetch();
+}
+
+inline seastar::future<> optional_reader::prefetch() {
+    return _reader->prefetch();
+}
+
+inline seastar::future<> map_reader::prefetch() {
+    return seastar::when_all_succeed(_key_reader->prefetch(), _value_reader->prefetch());
+}
+
+inline seastar::future<> record_reader::prefetch() {
+    return seastar::parallel_for_each(_field_readers, [] (field_reader& child) {
+        return child.prefetch();
+    });
+}
+
+template <typename L>
+inline seastar::future<> typed_primitive_reader<L>::prefetch() {
+    return refill_when_empty();
+}
+
 
 template <typename L>
 inline seastar::future<> typed_primitive_reader<L>::skip_field() {
@@ -504,4 +578,28 @@ inline seastar::future<> record_reader::read_all(Consumer& c) {
     });
 }
 
+template <typename Consumer>
+inline seastar::future<> multi_record_reader::read_all(Consumer& c) {
+    return seastar::repeat([this, &c] {
+        open_ahead(1);
+        if (_opening.empty()) {
+            return seastar::make_ready_future<seastar::stop_iteration>(seastar::stop_iteration::yes);
+        }
+        seastar::future<std::unique_ptr<record_reader>> current = std::move(_opening.front());
+        _opening.pop_front();
+        open_ahead(_lookahead);
+        return current.then([&c] (std::unique_ptr<record_reader> rr) {
+            record_reader& reader = *rr;
+            return reader.read_all(c).finally([rr = std::move(rr)] {});
+        }).then([] {
+            return seastar::stop_iteration::no;
+        });
+    }).handle_exception([this] (std::exception_ptr eptr) {
+        // Don't leave the readers opened ahead running after a failure.
+        return close().then([eptr = std::move(eptr)] () mutable {
+            return seastar::make_exception_future<>(std::move(eptr));
+        });
+    });
+}
+
 } // namespace parquet4seastar::record
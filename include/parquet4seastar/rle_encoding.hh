@@ -123,6 +123,11 @@ class RleDecoder {
   template <typename T>
   int GetBatch(T* values, int batch_size);
 
+  /// Skips a batch of values and adds the number of them equal to value to *count.
+  /// Repeated runs are counted without being expanded. Returns the number of skipped elements.
+  template <typename T>
+  int CountEqual(T value, int batch_size, int64_t* count);
+
  protected:
   BitUtil::BitReader bit_reader_;
   /// Number of bits needed to encode the value. Must be between 0 and 64.
@@ -314,6 +319,42 @@ inline int RleDecoder::GetBatch(T* values, int batch_size) {
   return values_read;
 }
 
+template <typename T>
+inline int RleDecoder::CountEqual(T value, int batch_size, int64_t* count) {
+  assert(bit_width_ >= 0);
+  constexpr int kBufferSize = 64;
+  T buffer[kBufferSize];
+  int values_read = 0;
+
+  while (values_read < batch_size) {
+    int remaining = batch_size - values_read;
+
+    if (repeat_count_ > 0) {
+      int repeat_batch = std::min(remaining, repeat_count_);
+      if (static_cast<T>(current_value_) == value) {
+        *count += repeat_batch;
+      }
+
+      repeat_count_ -= repeat_batch;
+      values_read += repeat_batch;
+    } else if (literal_count_ > 0) {
+      int literal_batch = std::min(std::min(remaining, literal_count_), kBufferSize);
+      int actual_read = bit_reader_.GetBatch(bit_width_, buffer, literal_batch);
+      if (actual_read != literal_batch) {
+        return values_read;
+      }
+      *count += std::count(buffer, buffer + literal_batch, value);
+
+      literal_count_ -= literal_batch;
+      values_read += literal_batch;
+    } else {
+      if (!NextCounts<T>()) return values_read;
+    }
+  }
+
+  return values_read;
+}
+
 static inline bool IndexInRange(int32_t idx, int32_t dictionary_length) {
   return idx >= 0 && idx < dictionary_length;
 }
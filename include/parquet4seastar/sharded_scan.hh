@@ -0,0 +1,188 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <parquet4seastar/record_reader.hh>
+#include <seastar/core/smp.hh>
+#include <seastar/util/noncopyable_function.hh>
+#include <boost/range/irange.hpp>
+#include <map>
+
+/* Scans of files which use all shards.
+ *
+ * The row groups of the scanned files are distributed across shards, balanced by their
+ * total_byte_size. Every shard opens the files it was given row groups of, and reads its
+ * row groups one at a time with record_reader. The results are sent back to the calling
+ * shard, which merges them either as they come or in the order of the files and row groups.
+ */
+namespace parquet4seastar {
+
+// A row group of one of the scanned files.
+struct row_group_ref {
+    // Index of the file in the scanned list.
+    uint32_t file;
+    uint32_t row_group;
+    // Position of the row group among all row groups of the scan, in file order.
+    uint64_t position;
+    int64_t byte_size;
+};
+
+// Assigns the row groups (given by their sizes, per file) to n_shards shards: largest first,
+// each to the shard with the fewest bytes so far. Row groups of a shard are in file order.
+std::vector<std::vector<row_group_ref>> distribute_row_groups(
+        const std::vector<std::vector<int64_t>>& row_group_sizes, unsigned n_shards);
+// Same, for row groups which were already numbered, e.g. those left after pruning.
+std::vector<std::vector<row_group_ref>> distribute_row_group_refs(std::vector<row_group_ref> row_groups, unsigned n_shards);
+
+enum class scan_order {
+    // Results are merged as soon as they arrive.
+    unordered,
+    // Results are merged in the order of files and row groups. Results which arrive early
+    // are held on the calling shard until all row groups before them are merged.
+    ordered,
+};
+
+struct sharded_scan_options {
+    // Top-level fields to read, by name. Empty means all of them.
+    std::vector<std::string> columns;
+    scan_order order = scan_order::unordered;
+    // Used on every shard. Must not have a memory limiter, since a limiter belongs to one shard.
+    io_options io;
+};
+
+namespace detail {
+
+// Reads the row group sizes of the files (on this shard) and distributes them over all shards.
+seastar::future<std::vector<std::vector<row_group_ref>>>
+plan_sharded_scan(const std::vector<std::string>& paths, const io_options& options);
+
+// Opens the files of the row groups, each once, and calls read() for each row group in turn.
+seastar::future<> scan_row_groups(
+        std::vector<std::string> paths,
+        std::vector<row_group_ref> row_groups,
+        io_options options,
+        seastar::noncopyable_function<seastar::future<> (file_reader&, const row_group_ref&)> read);
+
+template <typename Result, typename Merge>
+class scan_merger {
+    Merge _merge;
+    scan_order _order;
+    uint64_t _next_position = 0;
+    std::map<uint64_t, std::pair<row_group_ref, Result>> _pending;
+public:
+    scan_merger(Merge merge, scan_order order) : _merge(std::move(merge)), _order{order} {}
+    void add(const row_group_ref& ref, Result&& result) {
+        if (_order == scan_order::unordered) {
+            _merge(ref, std::move(result));
+            return;
+        }
+        _pending.emplace(ref.position, std::make_pair(ref, std::move(result)));
+        while (!_pending.empty() && _pending.begin()->first == _next_position) {
+            auto node = _pending.extract(_pending.begin());
+            _merge(node.mapped().first, std::move(node.mapped().second));
+            ++_next_position;
+        }
+    }
+};
+
+} // namespace detail
+
+/* Reads the files on all shards.
+ *
+ * make_consumer(const row_group_ref&) is called on the shard which reads the row group,
+ * and returns a record_reader consumer with an additional finish() method.
+ * Once the row group is read, the result of finish() is moved to the calling shard
+ * and passed to merge(const row_group_ref&, Result&&), which runs on the calling shard only.
+ * Thus make_consumer is copied to other shards and must not refer to shard-local state,
+ * and neither must the results.
+ *
+ * This overload reads the row groups of a precomputed plan (see distribute_row_group_refs),
+ * with one list of row groups per shard. For ordered scans, the positions of the planned
+ * row groups must be 0, 1, 2... The other overload plans the scan of all row groups.
+ */
+template <typename ConsumerFactory, typename Merge>
+seastar::future<> sharded_scan(
+        std::vector<std::string> paths,
+        std::vector<std::vector<row_group_ref>> plan,
+        sharded_scan_options options,
+        ConsumerFactory make_consumer,
+        Merge merge) {
+    using consumer_type = std::invoke_result_t<ConsumerFactory&, const row_group_ref&>;
+    using result_type = decltype(std::declval<consumer_type&>().finish());
+    using merger_type = detail::scan_merger<result_type, Merge>;
+    if (options.io.memory) {
+        return seastar::make_exception_future<>(
+                parquet_exception("sharded_scan cannot use a memory limiter, which belongs to one shard"));
+    }
+    if (plan.size() > seastar::smp::count) {
+        return seastar::make_exception_future<>(parquet_exception(seastar::format(
+                "sharded_scan was planned for {} shards, but there are only {}", plan.size(), seastar::smp::count)));
+    }
+    merger_type merger{std::move(merge), options.order};
+    return seastar::do_with(std::move(paths), std::move(plan), std::move(options), std::move(make_consumer), std::move(merger),
+    [] (std::vector<std::string>& paths, std::vector<std::vector<row_group_ref>>& plan, sharded_scan_options& options,
+            ConsumerFactory& make_consumer, merger_type& merger) {
+        unsigned caller = seastar::this_shard_id();
+        return seastar::parallel_for_each(boost::irange<unsigned>(0, plan.size()),
+        [&paths, &options, &make_consumer, &plan, &merger, caller] (unsigned shard) {
+            if (plan[shard].empty()) {
+                return seastar::make_ready_future<>();
+            }
+            // The captured references are only read on the other shard, to make local copies.
+            return seastar::smp::submit_to(shard, [&paths, &options, &make_consumer, &plan, &merger, caller, shard] {
+                return detail::scan_row_groups(paths, plan[shard], options.io,
+                [columns = options.columns, make_consumer, &merger, caller]
+                (file_reader& fr, const row_group_ref& ref) mutable {
+                    auto make_reader = columns.empty()
+                            ? record::record_reader::make(fr, ref.row_group)
+                            : record::record_reader::make(fr, ref.row_group, columns);
+                    return make_reader.then([&make_consumer, &merger, caller, ref] (record::record_reader rr) {
+                        return seastar::do_with(std::move(rr), make_consumer(ref),
+                        [&merger, caller, ref] (record::record_reader& rr, consumer_type& consumer) {
+                            return rr.read_all(consumer).then([&consumer, &merger, caller, ref] {
+                                return seastar::smp::submit_to(caller,
+                                [&merger, ref, result = consumer.finish()] () mutable {
+                                    merger.add(ref, std::move(result));
+                                });
+                            });
+                        });
+                    });
+                });
+            });
+        });
+    });
+}
+
+template <typename ConsumerFactory, typename Merge>
+seastar::future<> sharded_scan(
+        std::vector<std::string> paths,
+        sharded_scan_options options,
+        ConsumerFactory make_consumer,
+        Merge merge) {
+    return detail::plan_sharded_scan(paths, options.io).then(
+    [paths, options = std::move(options), make_consumer = std::move(make_consumer), merge = std::move(merge)]
+    (std::vector<std::vector<row_group_ref>> plan) mutable {
+        return sharded_scan(std::move(paths), std::move(plan), std::move(options), std::move(make_consumer), std::move(merge));
+    });
+}
+
+} // namespace parquet4seastar
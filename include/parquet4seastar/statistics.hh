@@ -0,0 +1,177 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <parquet4seastar/bytes.hh>
+#include <parquet4seastar/encoding.hh>
+#include <parquet4seastar/logical_type.hh>
+#include <cmath>
+#include <cstring>
+#include <optional>
+#include <variant>
+
+/* Min/max statistics of column chunks, and the pruning of column chunks by predicates.
+ *
+ * Statistics::min_value and max_value are compared in the sort order of the logical type
+ * of the column, and are only trusted if the file declares a TypeDefinedOrder for the column.
+ * The deprecated min and max were compared as signed values by old writers, so they are only
+ * used for types whose order is signed. Columns whose order is undefined (INT96, INTERVAL)
+ * or unsupported (decimals stored as bytes) have no usable min and max.
+ */
+namespace parquet4seastar {
+
+enum class sort_order {
+    SIGNED,
+    UNSIGNED, // Also the lexicographic order of bytes.
+    UNKNOWN,
+};
+
+sort_order column_sort_order(const logical_type::logical_type& type);
+// UNKNOWN if the logical type can't be read.
+sort_order column_sort_order(const format::SchemaElement& leaf);
+
+// A value of a column with the given physical type: bool for BOOLEAN, int32_t for INT32,
+// int64_t for INT64, float for FLOAT, double for DOUBLE and bytes for (FIXED_LEN_)BYTE_ARRAY.
+using scalar = std::variant<bool, int32_t, int64_t, float, double, bytes>;
+
+// A PLAIN-encoded value, as stored in Statistics. Empty if it doesn't fit the type, or is NaN.
+std::optional<scalar> decode_scalar(format::Type::type type, const std::string& plain);
+std::string encode_scalar(const scalar& value);
+
+// Negative, zero or positive as a is less than, equal to or greater than b.
+// The values must be of the same alternative, and the order must be known.
+int compare(const scalar& a, const scalar& b, sort_order order);
+
+struct column_statistics {
+    std::optional<scalar> min;
+    std::optional<scalar> max;
+    std::optional<int64_t> null_count;
+    // Values, nulls included.
+    int64_t num_values = 0;
+    sort_order order = sort_order::UNKNOWN;
+};
+
+// Whether min_value and max_value of the column can be trusted.
+bool has_type_defined_order(const format::FileMetaData& metadata, uint32_t column);
+column_statistics read_statistics(
+        const format::ColumnMetaData& column_metadata, const format::SchemaElement& leaf, bool type_defined_order);
+
+// A condition on the values of a leaf column, given by its index.
+struct predicate {
+    enum class op {
+        eq,
+        lt,
+        le,
+        gt,
+        ge,
+        is_null,
+        is_not_null,
+    };
+    uint32_t column;
+    op cmp;
+    scalar value; // Unused by is_null and is_not_null.
+};
+
+// False if no value described by the statistics satisfies the predicate.
+bool may_match(const column_statistics& stats, const predicate& p);
+
+// Collects the statistics of a column chunk as it is written.
+template <format::Type::type T>
+class statistics_builder {
+public:
+    using input_type = typename value_decoder_traits<T>::input_type;
+private:
+    using stored_type = std::conditional_t<std::is_same_v<input_type, bytes_view>, bytes, input_type>;
+    // Longer bytes values are not kept as min or max, since they would bloat the metadata.
+    static constexpr size_t max_stored_size = 1024;
+    sort_order _order;
+    std::optional<stored_type> _min;
+    std::optional<stored_type> _max;
+    int64_t _null_count = 0;
+    bool _complete = true; // False if a value was left out of min and max.
+
+    bool less(input_type a, input_type b) const {
+        if constexpr (std::is_same_v<input_type, bytes_view>) {
+            return a < b;
+        } else if constexpr (std::is_same_v<input_type, int32_t> || std::is_same_v<input_type, int64_t>) {
+            using unsigned_type = std::make_unsigned_t<input_type>;
+            return _order == sort_order::UNSIGNED
+                   ? static_cast<unsigned_type>(a) < static_cast<unsigned_type>(b)
+                   : a < b;
+        } else {
+            return a < b;
+        }
+    }
+public:
+    explicit statistics_builder(sort_order order) : _order{order} {}
+    void put(const input_type& value) {
+        if (_order == sort_order::UNKNOWN) {
+            return;
+        }
+        if constexpr (std::is_floating_point_v<input_type>) {
+            if (std::isnan(value)) {
+                return;
+            }
+        }
+        if constexpr (std::is_same_v<input_type, bytes_view>) {
+            if (value.size() > max_stored_size) {
+                _complete = false;
+                return;
+            }
+        }
+        if (!_min || less(value, *_min)) {
+            _min = stored_type(value);
+        }
+        if (!_max || less(*_max, value)) {
+            _max = stored_type(value);
+        }
+    }
+    void put_null() {
+        ++_null_count;
+    }
+    // Return the statistics of the values put since the last flush, and start anew.
+    format::Statistics flush() {
+        format::Statistics stats;
+        stats.__set_null_count(_null_count);
+        if (_complete && _min && _max) {
+            stats.__set_min_value(encode(*_min));
+            stats.__set_max_value(encode(*_max));
+        }
+        _min.reset();
+        _max.reset();
+        _null_count = 0;
+        _complete = true;
+        return stats;
+    }
+private:
+    static std::string encode(const stored_type& v) {
+        if constexpr (std::is_same_v<stored_type, bytes>) {
+            return std::string(reinterpret_cast<const char*>(v.data()), v.size());
+        } else {
+            std::string s(sizeof(v), '\0');
+            std::memcpy(s.data(), &v, sizeof(v));
+            return s;
+        }
+    }
+};
+
+} // namespace parquet4seastar
@@ -23,6 +23,7 @@
 
 #include <parquet4seastar/bytes.hh>
 #include <parquet4seastar/exception.hh>
+#include <parquet4seastar/mapped_file.hh>
 #include <seastar/core/fstream.hh>
 #include <seastar/core/print.hh>
 
@@ -48,7 +49,7 @@ public:
         : _size(next_power_of_2(size))
         , _data(new byte[_size]) {}
     byte* data() { return _data.get(); }
-    size_t size() { return _size; }
+    size_t size() const { return _size; }
 };
 
 /* The problem: we need to read a stream of objects of unknown, variable size (page headers)
@@ -62,17 +63,33 @@ class peekable_stream {
     buffer _buffer;
     size_t _buffer_start = 0;
     size_t _buffer_end = 0;
+    uint64_t _position = 0;
+    // Set for streams over a range of a mapped file, which is viewed in place instead of buffered.
+    seastar::lw_shared_ptr<const mapped_file> _mapping;
+    bytes_view _mapped; // The unconsumed part of the range.
 private:
     void ensure_space(size_t n);
     seastar::future<> read_exactly(size_t n);
 public:
     explicit peekable_stream(seastar::input_stream<char>&& source)
         : _source{std::move(source)} {};
+    // A stream over the given range of the mapping. Peeked views point into the mapping.
+    peekable_stream(seastar::lw_shared_ptr<const mapped_file> mapping, bytes_view range)
+        : _mapping{std::move(mapping)}
+        , _mapped{range} {};
 
     // Assuming there is k bytes remaining in stream, view the next unconsumed min(k, n) bytes.
     seastar::future<bytes_view> peek(size_t n);
     // Consume n bytes. If there is less than n bytes in stream, throw.
     seastar::future<> advance(size_t n);
+    size_t buffer_size() const { return _buffer.size(); }
+    // The number of bytes consumed.
+    uint64_t position() const { return _position; }
+    // Whether peeked views stay valid for the lifetime of the stream.
+    bool mapped() const { return bool(_mapping); }
+    // Free the buffer if it has grown beyond max_size, e.g. after a big page.
+    // Invalidates previously peeked views.
+    void shrink(size_t max_size);
 };
 
 // Deserialize a single thrift structure. Return the number of bytes used.
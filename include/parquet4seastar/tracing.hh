@@ -0,0 +1,160 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <seastar/core/future.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <chrono>
+#include <string>
+
+/* Page load tracing.
+ *
+ * file_reader, page_reader and column_chunk_reader report the duration of each phase of
+ * loading a page (header I/O and parsing, contents I/O, decompression, decoding) to the
+ * tracer installed on the current shard. With no tracer installed (the default) the hooks
+ * cost a single thread-local pointer test and the clock is not read.
+ *
+ * chrome_trace_writer is the default tracer. It produces Chrome trace-event JSON,
+ * which can be loaded into chrome://tracing or https://ui.perfetto.dev.
+ */
+namespace parquet4seastar::tracing {
+
+using trace_clock = std::chrono::steady_clock;
+
+enum class phase {
+    open,        // Opening a file and reading its footer.
+    page_header, // Reading and deserializing a page header.
+    page_read,   // Reading the compressed contents of a page.
+    decompress,  // Decompressing a page.
+    decode,      // Decoding a dictionary page, or a batch of values.
+};
+
+const char* phase_name(phase p);
+
+// What is being traced. Created (only while tracing is enabled) by the object
+// which opens the traced file or column chunk, and shared by its readers.
+struct context {
+    std::string file;
+    std::string column; // Dotted column path. Empty for file-level events.
+};
+
+struct event {
+    tracing::phase phase;
+    const context* ctx; // Null if the traced reader was opened without a context.
+    int64_t page_ordinal; // -1 for events not related to a page.
+    uint64_t compressed_size;
+    uint64_t uncompressed_size;
+    trace_clock::time_point start;
+    trace_clock::time_point end;
+};
+
+class tracer {
+public:
+    // Called synchronously at the end of each phase. event::ctx is only valid during the call.
+    virtual void record(const event& e) = 0;
+    virtual ~tracer() = default;
+};
+
+namespace detail {
+
+extern thread_local tracer* current;
+
+} // namespace detail
+
+// Install a tracer on this shard. nullptr disables tracing.
+// The tracer must outlive all readers opened while it was installed.
+void set_tracer(tracer* t);
+
+inline bool enabled() {
+    return detail::current != nullptr;
+}
+
+// The start time of a phase, or a null time point if tracing is disabled.
+inline trace_clock::time_point start() {
+    return enabled() ? trace_clock::now() : trace_clock::time_point{};
+}
+
+// Report a phase which started at `start` and ends now.
+inline void record(
+        phase p,
+        const context* ctx,
+        int64_t page_ordinal,
+        uint64_t compressed_size,
+        uint64_t uncompressed_size,
+        trace_clock::time_point start) {
+    if (enabled()) {
+        detail::current->record(event{p, ctx, page_ordinal, compressed_size, uncompressed_size, start, trace_clock::now()});
+    }
+}
+
+// Reports the phase during which it was alive. For synchronous phases.
+class span {
+    phase _phase;
+    const context* _ctx;
+    int64_t _page_ordinal;
+    uint64_t _compressed_size = 0;
+    uint64_t _uncompressed_size = 0;
+    trace_clock::time_point _start;
+public:
+    span(phase p, const context* ctx, int64_t page_ordinal)
+        : _phase{p}, _ctx{ctx}, _page_ordinal{page_ordinal}, _start{start()} {}
+    span(const span&) = delete;
+    span& operator=(const span&) = delete;
+    void set_sizes(uint64_t compressed_size, uint64_t uncompressed_size) {
+        _compressed_size = compressed_size;
+        _uncompressed_size = uncompressed_size;
+    }
+    ~span() {
+        record(_phase, _ctx, _page_ordinal, _compressed_size, _uncompressed_size, _start);
+    }
+};
+
+inline seastar::lw_shared_ptr<const context> make_context(std::string file, std::string column = {}) {
+    if (!enabled()) {
+        return {};
+    }
+    return seastar::make_lw_shared<context>(context{std::move(file), std::move(column)});
+}
+
+// Append s to out as a JSON string literal.
+void append_json_string(std::string& out, const std::string& s);
+
+// Buffers events in memory in the Chrome trace-event format ("complete" events,
+// one thread per shard). Events past max_events are dropped and counted.
+class chrome_trace_writer : public tracer {
+    std::string _events;
+    size_t _n_events = 0;
+    size_t _max_events;
+    size_t _dropped = 0;
+public:
+    explicit chrome_trace_writer(size_t max_events = 1'000'000) : _max_events{max_events} {}
+    void record(const event& e) override;
+    size_t size() const { return _n_events; }
+    size_t dropped() const { return _dropped; }
+    void clear();
+    // The trace, as a JSON object.
+    std::string json() const;
+    // Write the trace to a file.
+    seastar::future<> write(std::string path) const;
+};
+
+} // namespace parquet4seastar::tracing
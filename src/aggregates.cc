@@ -0,0 +1,274 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/aggregates.hh>
+#include <seastar/core/future-util.hh>
+#include <boost/iterator/counting_iterator.hpp>
+#include <algorithm>
+
+namespace parquet4seastar {
+
+void column_aggregate::merge(const column_aggregate& other) {
+    rows += other.rows;
+    values += other.values;
+    decoded = decoded || other.decoded;
+    if (other.min && (!min || compare(*other.min, *min, order) < 0)) {
+        min = other.min;
+    }
+    if (other.max && (!max || compare(*other.max, *max, order) > 0)) {
+        max = other.max;
+    }
+}
+
+namespace {
+
+template <typename T>
+std::optional<scalar> to_scalar(const T& value) {
+    if constexpr (std::is_same_v<T, seastar::temporary_buffer<uint8_t>>) {
+        return scalar{bytes(value.get(), value.size())};
+    } else if constexpr (std::is_same_v<T, uint8_t>) {
+        return scalar{value != 0};
+    } else if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(value)) {
+            return std::nullopt;
+        }
+        return scalar{value};
+    } else if constexpr (std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t>) {
+        return scalar{value};
+    } else {
+        // INT96, which has no order.
+        return std::nullopt;
+    }
+}
+
+template <typename T>
+void update_min_max(column_aggregate& agg, const T& value) {
+    std::optional<scalar> s = to_scalar(value);
+    if (!s) {
+        return;
+    }
+    if (!agg.min || compare(*s, *agg.min, agg.order) < 0) {
+        agg.min = *s;
+    }
+    if (!agg.max || compare(*s, *agg.max, agg.order) > 0) {
+        agg.max = std::move(*s);
+    }
+}
+
+// Decode all values of the chunk, and count them unless they were counted.
+template <format::Type::type T>
+seastar::future<> decode_min_max(
+        file_reader& fr, uint32_t row_group, uint32_t column, bool counted, column_aggregate& agg) {
+    using reader_type = column_chunk_reader<T>;
+    using output_type = typename reader_type::output_type;
+    constexpr size_t batch_size = 1024;
+    int32_t max_def_level = fr.raw_schema().leaves[column]->def_level;
+    agg.decoded = true;
+    return fr.open_column_chunk_reader<T>(row_group, column).then([&agg, counted, max_def_level] (reader_type reader) {
+        struct decode_state {
+            // Not moved once it has read pages, since values may view its buffers.
+            std::unique_ptr<reader_type> reader;
+            std::vector<int32_t> def = std::vector<int32_t>(batch_size);
+            std::vector<int32_t> rep = std::vector<int32_t>(batch_size);
+            std::vector<output_type> values = std::vector<output_type>(batch_size);
+        };
+        return seastar::do_with(decode_state{std::make_unique<reader_type>(std::move(reader))},
+        [&agg, counted, max_def_level] (decode_state& state) {
+            return seastar::repeat([&agg, &state, counted, max_def_level] {
+                return state.reader->read_batch(batch_size, state.def.data(), state.rep.data(), state.values.data()).then(
+                [&agg, &state, counted, max_def_level] (size_t levels_read) {
+                    if (levels_read == 0) {
+                        return seastar::stop_iteration::yes;
+                    }
+                    // Null values are not read into the value array.
+                    size_t values_read = std::count(state.def.begin(), state.def.begin() + levels_read, max_def_level);
+                    if (!counted) {
+                        agg.values += values_read;
+                    }
+                    for (size_t i = 0; i < values_read; ++i) {
+                        update_min_max(agg, state.values[i]);
+                    }
+                    return seastar::stop_iteration::no;
+                });
+            });
+        });
+    });
+}
+
+// Whether the metadata shows that all data pages hold dictionary indices.
+bool dictionary_encoded(const format::ColumnMetaData& cmd) {
+    auto is_dictionary = [] (format::Encoding::type e) {
+        return e == format::Encoding::PLAIN_DICTIONARY || e == format::Encoding::RLE_DICTIONARY;
+    };
+    if (cmd.__isset.encoding_stats) {
+        return std::all_of(cmd.encoding_stats.begin(), cmd.encoding_stats.end(),
+                [&] (const format::PageEncodingStats& stats) {
+            return stats.page_type == format::PageType::DICTIONARY_PAGE || is_dictionary(stats.encoding);
+        });
+    }
+    // Otherwise, PLAIN may be the encoding of the dictionary page or of data pages.
+    return std::any_of(cmd.encodings.begin(), cmd.encodings.end(), is_dictionary)
+            && std::all_of(cmd.encodings.begin(), cmd.encodings.end(), [&] (format::Encoding::type e) {
+        return is_dictionary(e) || e == format::Encoding::RLE || e == format::Encoding::BIT_PACKED;
+    });
+}
+
+bool same_bound(const std::optional<scalar>& a, const std::optional<scalar>& b, sort_order order) {
+    return a && b && compare(*a, *b, order) == 0;
+}
+
+// Each chunk is read at most once, by one reader at a time, so that a memory_limiter
+// admitting a single reader is enough.
+// The dictionary may hold entries which no value uses, so its min and max are only bounds.
+// They are taken when the statistics of the chunk confirm them, and the values are decoded otherwise.
+template <format::Type::type T>
+seastar::future<> aggregate_chunk(file_reader& fr, uint32_t row_group, uint32_t column, bool counted,
+        bool with_min_max, const column_statistics& stats, column_aggregate& agg) {
+    using reader_type = column_chunk_reader<T>;
+    if (counted && !with_min_max) {
+        return seastar::make_ready_future<>();
+    }
+    if (with_min_max && (!stats.min || !stats.max
+            || !dictionary_encoded(fr.metadata().row_groups[row_group].columns[column].meta_data))) {
+        // The values are decoded anyway, and counted on the way.
+        return decode_min_max<T>(fr, row_group, column, counted, agg);
+    }
+    return fr.open_column_chunk_reader<T>(row_group, column).then(
+    [&fr, row_group, column, counted, with_min_max, &stats, &agg] (reader_type r) {
+        auto reader = std::make_unique<reader_type>(std::move(r));
+        reader_type& counting_reader = *reader;
+        return counting_reader.count_values().then(
+        [&fr, row_group, column, counted, with_min_max, &stats, &agg, reader = std::move(reader)]
+        (chunk_value_counts counts) mutable {
+            if (!counted) {
+                agg.values = counts.values;
+            }
+            if (!with_min_max || agg.values == 0) {
+                return seastar::make_ready_future<>();
+            }
+            if (counts.dictionary_encoded) {
+                column_aggregate bounds;
+                bounds.order = agg.order;
+                for (const auto& value : *reader->dictionary()) {
+                    update_min_max(bounds, value);
+                }
+                if (same_bound(bounds.min, stats.min, agg.order) && same_bound(bounds.max, stats.max, agg.order)) {
+                    agg.min = std::move(bounds.min);
+                    agg.max = std::move(bounds.max);
+                    return seastar::make_ready_future<>();
+                }
+            }
+            // The metadata was wrong, or the dictionary has unused entries past the statistics.
+            // The reader (and its admission) is released before the values are decoded.
+            reader.reset();
+            return decode_min_max<T>(fr, row_group, column, true, agg);
+        });
+    });
+}
+
+} // namespace
+
+seastar::future<column_aggregate> aggregate_column_chunk(
+        file_reader& fr, uint32_t row_group, uint32_t column, bool with_min_max) {
+    return seastar::futurize_invoke([&fr, row_group, column, with_min_max] {
+        if (row_group >= fr.metadata().row_groups.size()) {
+            throw parquet_exception(seastar::format("Row group {} out of range (0 to {})",
+                    row_group, fr.metadata().row_groups.size()));
+        }
+        const format::RowGroup& rg = fr.metadata().row_groups[row_group];
+        if (column >= rg.columns.size() || column >= fr.raw_schema().leaves.size()) {
+            throw parquet_exception(seastar::format("Column {} out of range (0 to {})", column, rg.columns.size()));
+        }
+        const reader_schema::raw_node& leaf = *fr.raw_schema().leaves[column];
+        if (!rg.columns[column].__isset.meta_data) {
+            throw parquet_exception::corrupted_file(seastar::format(
+                    "ColumnMetaData of row group {} column {} not set", row_group, column));
+        }
+        const format::ColumnMetaData& cmd = rg.columns[column].meta_data;
+        column_statistics stats = read_statistics(cmd, leaf.info, has_type_defined_order(fr.metadata(), column));
+
+        column_aggregate agg;
+        agg.rows = rg.num_rows;
+        agg.order = stats.order;
+        // Without repetition, there is one level per row, and the nulls are the levels below the maximum.
+        bool counted = leaf.rep_level == 0 && stats.null_count;
+        if (counted) {
+            agg.values = stats.num_values - *stats.null_count;
+        }
+        bool exact_statistics = stats.min && stats.max
+                && cmd.type != format::Type::BYTE_ARRAY
+                && cmd.type != format::Type::FIXED_LEN_BYTE_ARRAY;
+        bool need_min_max = with_min_max && !exact_statistics && stats.order != sort_order::UNKNOWN
+                && !(counted && agg.values == 0);
+        return seastar::do_with(std::move(agg), std::move(stats),
+        [&fr, row_group, column, counted, need_min_max, exact_statistics, type = cmd.type]
+        (column_aggregate& agg, const column_statistics& stats) {
+            auto chunk = [&] () -> seastar::future<> {
+                switch (type) {
+                case format::Type::BOOLEAN:
+                    return aggregate_chunk<format::Type::BOOLEAN>(fr, row_group, column, counted, need_min_max, stats, agg);
+                case format::Type::INT32:
+                    return aggregate_chunk<format::Type::INT32>(fr, row_group, column, counted, need_min_max, stats, agg);
+                case format::Type::INT64:
+                    return aggregate_chunk<format::Type::INT64>(fr, row_group, column, counted, need_min_max, stats, agg);
+                case format::Type::INT96:
+                    return aggregate_chunk<format::Type::INT96>(fr, row_group, column, counted, false, stats, agg);
+                case format::Type::FLOAT:
+                    return aggregate_chunk<format::Type::FLOAT>(fr, row_group, column, counted, need_min_max, stats, agg);
+                case format::Type::DOUBLE:
+                    return aggregate_chunk<format::Type::DOUBLE>(fr, row_group, column, counted, need_min_max, stats, agg);
+                case format::Type::BYTE_ARRAY:
+                    return aggregate_chunk<format::Type::BYTE_ARRAY>(fr, row_group, column, counted, need_min_max, stats, agg);
+                case format::Type::FIXED_LEN_BYTE_ARRAY:
+                    return aggregate_chunk<format::Type::FIXED_LEN_BYTE_ARRAY>(
+                            fr, row_group, column, counted, need_min_max, stats, agg);
+                default:
+                    throw parquet_exception::corrupted_file(seastar::format("Unknown physical type {}", type));
+                }
+            };
+            return chunk().then([&agg, &stats, exact_statistics] {
+                // Only now that repeated columns are counted too.
+                if (exact_statistics && agg.values > 0) {
+                    agg.min = stats.min;
+                    agg.max = stats.max;
+                }
+                return std::move(agg);
+            });
+        });
+    });
+}
+
+seastar::future<column_aggregate> aggregate_column(file_reader& fr, uint32_t column, bool with_min_max) {
+    return seastar::do_with(column_aggregate{}, [&fr, column, with_min_max] (column_aggregate& total) {
+        using it = boost::counting_iterator<uint32_t>;
+        return seastar::do_for_each(it(0), it(fr.metadata().row_groups.size()),
+        [&fr, column, with_min_max, &total] (uint32_t row_group) {
+            return aggregate_column_chunk(fr, row_group, column, with_min_max).then([&total] (column_aggregate agg) {
+                total.order = agg.order;
+                total.merge(agg);
+            });
+        }).then([&total] {
+            return std::move(total);
+        });
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,195 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+
+#include <parquet4seastar/bloom_filter.hh>
+#include <parquet4seastar/exception.hh>
+#include <seastar/core/bitops.hh>
+#include <seastar/core/print.hh>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace parquet4seastar {
+
+namespace {
+
+constexpr uint64_t prime64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t prime64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t prime64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t prime64_5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+template <typename T>
+inline T read_le(const byte* p) {
+    T x;
+    std::memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+    acc += input * prime64_2;
+    acc = rotl64(acc, 31);
+    return acc * prime64_1;
+}
+
+inline uint64_t xxh64_merge_round(uint64_t acc, uint64_t val) {
+    acc ^= xxh64_round(0, val);
+    return acc * prime64_1 + prime64_4;
+}
+
+constexpr uint32_t salt[8] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c5U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+constexpr size_t words_per_block = bloom_filter::block_size / sizeof(uint32_t);
+
+inline size_t block_index(uint64_t hash, size_t num_blocks) {
+    return ((hash >> 32) * num_blocks) >> 32;
+}
+
+inline uint32_t block_bit(uint32_t key, size_t i) {
+    return uint32_t(1) << ((key * salt[i]) >> 27);
+}
+
+} // namespace
+
+uint64_t xxhash64(bytes_view data, uint64_t seed) {
+    const byte* p = data.data();
+    const byte* end = p + data.size();
+    uint64_t h;
+    if (data.size() >= 32) {
+        uint64_t v1 = seed + prime64_1 + prime64_2;
+        uint64_t v2 = seed + prime64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - prime64_1;
+        for (; end - p >= 32; p += 32) {
+            v1 = xxh64_round(v1, read_le<uint64_t>(p));
+            v2 = xxh64_round(v2, read_le<uint64_t>(p + 8));
+            v3 = xxh64_round(v3, read_le<uint64_t>(p + 16));
+            v4 = xxh64_round(v4, read_le<uint64_t>(p + 24));
+        }
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge_round(h, v1);
+        h = xxh64_merge_round(h, v2);
+        h = xxh64_merge_round(h, v3);
+        h = xxh64_merge_round(h, v4);
+    } else {
+        h = seed + prime64_5;
+    }
+    h += data.size();
+    for (; end - p >= 8; p += 8) {
+        h ^= xxh64_round(0, read_le<uint64_t>(p));
+        h = rotl64(h, 27) * prime64_1 + prime64_4;
+    }
+    if (end - p >= 4) {
+        h ^= uint64_t(read_le<uint32_t>(p)) * prime64_1;
+        h = rotl64(h, 23) * prime64_2 + prime64_3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= *p * prime64_5;
+        h = rotl64(h, 11) * prime64_1;
+    }
+    h ^= h >> 33;
+    h *= prime64_2;
+    h ^= h >> 29;
+    h *= prime64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t bloom_filter_hash(const scalar& value) {
+    std::string plain = encode_scalar(value);
+    return xxhash64(bytes_view{reinterpret_cast<const byte*>(plain.data()), plain.size()});
+}
+
+bloom_filter::bloom_filter(size_t num_bytes) {
+    num_bytes = std::clamp(num_bytes, block_size, max_size);
+    num_bytes = size_t(1) << seastar::log2ceil(num_bytes);
+    _words.resize(num_bytes / sizeof(uint32_t));
+}
+
+bloom_filter::bloom_filter(bytes_view bitset) {
+    if (bitset.empty() || bitset.size() % block_size != 0) {
+        throw parquet_exception::corrupted_file(seastar::format(
+                "Bloom filter size ({}B) is not a positive multiple of {}B", bitset.size(), block_size));
+    }
+    _words.resize(bitset.size() / sizeof(uint32_t));
+    std::memcpy(_words.data(), bitset.data(), bitset.size());
+}
+
+size_t bloom_filter::optimal_size(uint64_t distinct_values, double fpp) {
+    // The number of bits m for n values with k = 8 bits set per value: fpp = (1 - e^(-k*n/m))^k.
+    fpp = std::clamp(fpp, 1e-9, 0.5);
+    double bits = -8.0 * distinct_values / std::log(1 - std::pow(fpp, 1.0 / 8));
+    if (!(bits < max_size * 8.0)) {
+        return max_size;
+    }
+    return std::max<size_t>(block_size, std::ceil(bits / 8));
+}
+
+bool bloom_filter::supported(const format::BloomFilterHeader& header) {
+    return header.algorithm.__isset.BLOCK
+            && header.hash.__isset.XXHASH
+            && header.compression.__isset.UNCOMPRESSED;
+}
+
+void bloom_filter::insert(uint64_t hash) {
+    uint32_t* block = &_words[block_index(hash, _words.size() / words_per_block) * words_per_block];
+    uint32_t key = static_cast<uint32_t>(hash);
+    for (size_t i = 0; i < words_per_block; ++i) {
+        block[i] |= block_bit(key, i);
+    }
+}
+
+bool bloom_filter::find(uint64_t hash) const {
+    const uint32_t* block = &_words[block_index(hash, _words.size() / words_per_block) * words_per_block];
+    uint32_t key = static_cast<uint32_t>(hash);
+    for (size_t i = 0; i < words_per_block; ++i) {
+        if (!(block[i] & block_bit(key, i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+format::BloomFilterHeader bloom_filter::header() const {
+    format::BloomFilterHeader header;
+    header.__set_numBytes(size());
+    format::BloomFilterAlgorithm algorithm;
+    algorithm.__set_BLOCK(format::SplitBlockAlgorithm{});
+    header.__set_algorithm(algorithm);
+    format::BloomFilterHash hash;
+    hash.__set_XXHASH(format::XxHash{});
+    header.__set_hash(hash);
+    format::BloomFilterCompression compression;
+    compression.__set_UNCOMPRESSED(format::Uncompressed{});
+    header.__set_compression(compression);
+    return header;
+}
+
+} // namespace parquet4seastar
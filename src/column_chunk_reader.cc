@@ -21,27 +21,38 @@
 
 #include <parquet4seastar/column_chunk_reader.hh>
 #include <parquet4seastar/compression.hh>
+#include <parquet4seastar/metrics.hh>
+#include <parquet4seastar/page_cache.hh>
+#include <parquet4seastar/preempt.hh>
+#include <seastar/core/do_with.hh>
 
 namespace parquet4seastar {
 
 seastar::future<std::optional<page>> page_reader::next_page() {
+    _source.shrink(max_retained_buffer_size);
     *_latest_header = format::PageHeader{}; // Thrift does not clear the structure by itself before writing to it.
-    return read_thrift_from_stream(_source, *_latest_header).then([this] (bool read) {
+    ++_page_ordinal;
+    auto header_start = tracing::start();
+    return read_thrift_from_stream(_source, *_latest_header).then([this, header_start] (bool read) {
         if (!read) {
             return seastar::make_ready_future<std::optional<page>>();
         }
+        tracing::record(tracing::phase::page_header, trace_context(), _page_ordinal, 0, 0, header_start);
         if (_latest_header->compressed_page_size < 0) {
             throw parquet_exception::corrupted_file(seastar::format(
                     "Negative compressed_page_size in header: {}", *_latest_header));
         }
         size_t compressed_size = static_cast<uint32_t>(_latest_header->compressed_page_size);
+        auto read_start = tracing::start();
         return _source.peek(compressed_size).then(
-        [this, compressed_size] (bytes_view page_contents) {
+        [this, compressed_size, read_start] (bytes_view page_contents) {
             if (page_contents.size() < compressed_size) {
                 throw parquet_exception::corrupted_file(seastar::format(
                         "Unexpected end of column chunk while reading compressed page contents (expected {}B, got {}B)",
                         compressed_size, page_contents.size()));
             }
+            tracing::record(tracing::phase::page_read, trace_context(), _page_ordinal,
+                    compressed_size, _latest_header->uncompressed_page_size, read_start);
             return _source.advance(compressed_size).then([this, page_contents] {
                 return seastar::make_ready_future<std::optional<page>>(page{_latest_header.get(), page_contents});
             });
@@ -49,8 +60,105 @@ seastar::future<std::optional<page>> page_reader::next_page() {
     });
 }
 
-template<format::Type::type T>
-void column_chunk_reader<T>::load_data_page(page p) {
+seastar::future<const format::PageHeader*> page_reader::next_page_header() {
+    *_latest_header = format::PageHeader{};
+    ++_page_ordinal;
+    return read_thrift_from_stream(_source, *_latest_header).then([this] (bool read) {
+        if (!read) {
+            return seastar::make_ready_future<const format::PageHeader*>(nullptr);
+        }
+        if (_latest_header->compressed_page_size < 0) {
+            throw parquet_exception::corrupted_file(seastar::format(
+                    "Negative compressed_page_size in header: {}", *_latest_header));
+        }
+        return _source.advance(static_cast<uint32_t>(_latest_header->compressed_page_size)).then([this] {
+            return static_cast<const format::PageHeader*>(_latest_header.get());
+        });
+    });
+}
+
+// Decompress into _decompression_buffer. Big pages are decompressed in several tasks.
+template<format::Type::type T, typename ValueDecoder>
+seastar::future<> column_chunk_reader<T, ValueDecoder>::decompress(bytes_view compressed, size_t uncompressed_size) {
+    if (_decompression_buffer.capacity() > page_reader::max_retained_buffer_size
+            && _decompression_buffer.capacity() > 2 * uncompressed_size) {
+        // Don't keep the buffer of a big page.
+        _decompression_buffer = bytes();
+    }
+    _decompression_buffer.resize(uncompressed_size);
+    auto timer_start = metrics::start_timer();
+    auto trace_start = tracing::start();
+    return _decompressor->decompress_preemptible(compressed, std::move(_decompression_buffer)).then(
+    [this, compressed_size = compressed.size(), uncompressed_size, timer_start, trace_start] (bytes decompressed) {
+        _decompression_buffer = std::move(decompressed);
+        metrics::stop_timer(&metrics::stats::decompression_latency, timer_start);
+        tracing::record(tracing::phase::decompress, _source.trace_context(), _source.page_ordinal(),
+                compressed_size, uncompressed_size, trace_start);
+    });
+}
+
+template<format::Type::type T, typename ValueDecoder>
+page_cache* column_chunk_reader<T, ValueDecoder>::page_cache_for_reads() const {
+    return _page_cache_chunk ? local_page_cache() : nullptr;
+}
+
+template<format::Type::type T, typename ValueDecoder>
+dictionary_cache* column_chunk_reader<T, ValueDecoder>::dictionary_cache_for_reads() const {
+    return _dictionary_cache_chunk ? local_dictionary_cache() : nullptr;
+}
+
+// With the page cache in use, move the decompressed page into the cache.
+// The page is then decoded from the cached copy, which is held until the next page is loaded.
+template<format::Type::type T, typename ValueDecoder>
+void column_chunk_reader<T, ValueDecoder>::cache_page(const format::PageHeader& header, bytes_view levels) {
+    page_cache* cache = page_cache_for_reads();
+    if (!cache) {
+        return;
+    }
+    _cached_page = seastar::make_lw_shared<const cached_page>(
+            cached_page{header, bytes(levels), std::move(_decompression_buffer), _page_on_disk_size});
+    cache->insert(page_cache_key{*_page_cache_chunk, _page_position}, _cached_page);
+}
+
+template<format::Type::type T, typename ValueDecoder>
+bytes_view column_chunk_reader<T, ValueDecoder>::page_values() const {
+    return _cached_page ? bytes_view(_cached_page->values) : bytes_view(_decompression_buffer);
+}
+
+template<format::Type::type T, typename ValueDecoder>
+void column_chunk_reader<T, ValueDecoder>::init_data_page(const format::DataPageHeader& header, bytes_view contents) {
+    size_t n_read = 0;
+    n_read = _rep_decoder.reset_v1(contents, header.repetition_level_encoding, header.num_values);
+    contents.remove_prefix(n_read);
+    n_read = _def_decoder.reset_v1(contents, header.definition_level_encoding, header.num_values);
+    contents.remove_prefix(n_read);
+    _page_encoding = header.encoding;
+    _page_null_count.reset();
+    if (!_levels_only) {
+        _val_decoder.reset(contents, header.encoding);
+    }
+    _initialized = true;
+}
+
+template<format::Type::type T, typename ValueDecoder>
+void column_chunk_reader<T, ValueDecoder>::init_levels_v2(const format::DataPageHeaderV2& header, bytes_view levels) {
+    _rep_decoder.reset_v2(levels.substr(0, header.repetition_levels_byte_length), header.num_values);
+    levels.remove_prefix(header.repetition_levels_byte_length);
+    _def_decoder.reset_v2(levels.substr(0, header.definition_levels_byte_length), header.num_values);
+    _page_encoding = header.encoding;
+    _page_null_count.reset();
+    _initialized = true;
+}
+
+template<format::Type::type T, typename ValueDecoder>
+void column_chunk_reader<T, ValueDecoder>::init_data_page_v2(
+        const format::DataPageHeaderV2& header, bytes_view levels, bytes_view values) {
+    init_levels_v2(header, levels);
+    _val_decoder.reset(values, header.encoding);
+}
+
+template<format::Type::type T, typename ValueDecoder>
+seastar::future<> column_chunk_reader<T, ValueDecoder>::load_data_page(page p) {
     if (!p.header->__isset.data_page_header) {
         throw parquet_exception::corrupted_file(seastar::format(
                 "DataPageHeader not set for DATA_PAGE header: {}", *p.header));
@@ -65,20 +173,28 @@ void column_chunk_reader<T>::load_data_page(page p) {
                 "Negative uncompressed_page_size in header: {}", *p.header));
     }
 
-    _decompression_buffer.resize(p.header->uncompressed_page_size);
-    _decompression_buffer = _decompressor->decompress(p.contents, std::move(_decompression_buffer));
-    bytes_view contents = _decompression_buffer;
-
-    size_t n_read = 0;
-    n_read = _rep_decoder.reset_v1(contents, header.repetition_level_encoding, header.num_values);
-    contents.remove_prefix(n_read);
-    n_read = _def_decoder.reset_v1(contents, header.definition_level_encoding, header.num_values);
-    contents.remove_prefix(n_read);
-    _val_decoder.reset(contents, header.encoding);
+    if (_levels_only && _rep_level == 0 && (_def_level == 0 || header.statistics.__isset.null_count)) {
+        // Without repetition, the null count of the page statistics is the number of levels below the maximum.
+        _page_num_values = header.num_values;
+        _page_null_count = _def_level == 0 ? 0 : header.statistics.null_count;
+        _page_encoding = header.encoding;
+        _initialized = true;
+        return seastar::make_ready_future<>();
+    }
+    if (_zero_copy && !page_cache_for_reads()) {
+        init_data_page(header, p.contents);
+        return seastar::make_ready_future<>();
+    }
+    return decompress(p.contents, p.header->uncompressed_page_size).then([this, p] {
+        if (!_levels_only) {
+            cache_page(*p.header, {});
+        }
+        init_data_page(p.header->data_page_header, page_values());
+    });
 }
 
-template<format::Type::type T>
-void column_chunk_reader<T>::load_data_page_v2(page p) {
+template<format::Type::type T, typename ValueDecoder>
+seastar::future<> column_chunk_reader<T, ValueDecoder>::load_data_page_v2(page p) {
     if (!p.header->__isset.data_page_header_v2) {
         throw parquet_exception::corrupted_file(seastar::format(
                 "DataPageHeaderV2 not set for DATA_PAGE_V2 header: {}", *p.header));
@@ -96,22 +212,40 @@ void column_chunk_reader<T>::load_data_page_v2(page p) {
         throw parquet_exception::corrupted_file(seastar::format(
                 "Negative uncompressed_page_size in header: {}", *p.header));
     }
-    bytes_view contents = p.contents;
-    _rep_decoder.reset_v2(contents.substr(0, header.repetition_levels_byte_length), header.num_values);
-    contents.remove_prefix(header.repetition_levels_byte_length);
-    _def_decoder.reset_v2(contents.substr(0, header.definition_levels_byte_length), header.num_values);
-    contents.remove_prefix(header.definition_levels_byte_length);
-    if (header.__isset.is_compressed && header.is_compressed) {
-        size_t n_read = header.repetition_levels_byte_length + header.definition_levels_byte_length;
-        size_t uncompressed_values_size = static_cast<size_t>(p.header->uncompressed_page_size) - n_read;
-        _decompression_buffer.resize(uncompressed_values_size);
-        _decompression_buffer = _decompressor->decompress(contents, std::move(_decompression_buffer));
+    size_t levels_size = header.repetition_levels_byte_length + header.definition_levels_byte_length;
+    if (levels_size > p.contents.size()) {
+        throw parquet_exception::corrupted_file(seastar::format(
+                "Levels byte length ({}) greater than page size ({})", levels_size, p.contents.size()));
+    }
+    bytes_view levels = p.contents.substr(0, levels_size);
+    bytes_view values = p.contents.substr(levels_size);
+    if (_levels_only) {
+        // Levels of V2 pages are never compressed, and the header has the null count.
+        _page_num_values = header.num_values;
+        _page_null_count = header.num_nulls;
+        _page_encoding = header.encoding;
+        _initialized = true;
+        return seastar::make_ready_future<>();
+    }
+    if (header.__isset.is_compressed && !header.is_compressed) {
+        if (page_cache_for_reads()) {
+            _decompression_buffer.assign(values.begin(), values.end());
+            cache_page(*p.header, levels);
+            init_data_page_v2(header, _cached_page->levels, _cached_page->values);
+        } else {
+            init_data_page_v2(header, levels, values);
+        }
+        return seastar::make_ready_future<>();
     }
-    _val_decoder.reset(_decompression_buffer, header.encoding);
+    size_t uncompressed_values_size = static_cast<size_t>(p.header->uncompressed_page_size) - levels_size;
+    return decompress(values, uncompressed_values_size).then([this, p, levels] {
+        cache_page(*p.header, levels);
+        init_data_page_v2(p.header->data_page_header_v2, _cached_page ? bytes_view(_cached_page->levels) : levels, page_values());
+    });
 }
 
-template<format::Type::type T>
-void column_chunk_reader<T>::load_dictionary_page(page p) {
+template<format::Type::type T, typename ValueDecoder>
+seastar::future<> column_chunk_reader<T, ValueDecoder>::load_dictionary_page(page p) {
     if (!p.header->__isset.dictionary_page_header) {
         throw parquet_exception::corrupted_file(seastar::format(
                 "DictionaryPageHeader not set for DICTIONARY_PAGE header: {}", *p.header));
@@ -124,41 +258,179 @@ void column_chunk_reader<T>::load_dictionary_page(page p) {
         throw parquet_exception::corrupted_file(
                 seastar::format("Negative uncompressed_page_size in header: {}", *p.header));
     }
-    _dict = std::vector<output_type>(header.num_values);
-    _decompression_buffer.resize(p.header->uncompressed_page_size);
-    _decompression_buffer = _decompressor->decompress(p.contents, std::move(_decompression_buffer));
-    value_decoder<T> vd{_type_length};
-    vd.reset(_decompression_buffer, format::Encoding::PLAIN);
-    size_t n_read = vd.read_batch(_dict->size(), _dict->data());
-    if (n_read < _dict->size()) {
-        throw parquet_exception::corrupted_file(seastar::format(
-                "Unexpected end of dictionary page (expected {} values, got {})", _dict->size(), n_read));
+    return decompress(p.contents, p.header->uncompressed_page_size).then([this, p] {
+        // The decoded dictionary is cached instead, if possible.
+        if (!dictionary_cache_for_reads()) {
+            cache_page(*p.header, {});
+        }
+        return init_dictionary(p.header->dictionary_page_header, p.contents.size());
+    });
+}
+
+template<format::Type::type T, typename ValueDecoder>
+seastar::future<> column_chunk_reader<T, ValueDecoder>::init_dictionary(
+        const format::DictionaryPageHeader& header, size_t compressed_size) {
+    _dict = seastar::make_lw_shared<std::vector<output_type>>(header.num_values);
+    auto trace_start = tracing::start();
+    // Dictionaries can have millions of entries, so they are decoded in several steps.
+    return seastar::do_with(ValueDecoder{_type_length}, size_t(0), [this] (ValueDecoder& vd, size_t& n_read) {
+        vd.reset(page_values(), format::Encoding::PLAIN);
+        return repeat_preemptible([this, &vd, &n_read] {
+            constexpr size_t step = std::max<size_t>(1, preemption_step_size / sizeof(output_type));
+            size_t n = std::min(step, _dict->size() - n_read);
+            size_t n_step = vd.read_batch(n, _dict->data() + n_read);
+            n_read += n_step;
+            if (n_step < n) {
+                throw parquet_exception::corrupted_file(seastar::format(
+                        "Unexpected end of dictionary page (expected {} values, got {})", _dict->size(), n_read));
+            }
+            return n_read == _dict->size() ? seastar::stop_iteration::yes : seastar::stop_iteration::no;
+        });
+    }).then([this, compressed_size, trace_start] {
+        tracing::record(tracing::phase::decode, _source.trace_context(), _source.page_ordinal(),
+                compressed_size, page_values().size(), trace_start);
+        // Decoded values may share a copy of the page.
+        _dict_memory = _dict->size() * sizeof(output_type) + page_values().size();
+        // Only dictionaries at the beginning of the chunk are looked up (see load_next_page).
+        dictionary_cache* cache = dictionary_cache_for_reads();
+        if (cache && _page_position == 0) {
+            auto cached = cache->insert(*_dictionary_cache_chunk,
+                    cached_dictionary<output_type>{std::move(_dict), _page_on_disk_size, _dict_memory});
+            _dict = std::move(cached.values);
+            _dict_memory = cached.memory_usage;
+        }
+        _val_decoder.reset_dict(_dict->data(), _dict->size());
+    });
+}
+
+// Pages in the page cache have already been validated.
+template<format::Type::type T, typename ValueDecoder>
+seastar::future<> column_chunk_reader<T, ValueDecoder>::load_cached_page() {
+    const format::PageHeader& header = _cached_page->header;
+    switch (header.type) {
+    case format::PageType::DATA_PAGE:
+        init_data_page(header.data_page_header, _cached_page->values);
+        return seastar::make_ready_future<>();
+    case format::PageType::DATA_PAGE_V2:
+        init_data_page_v2(header.data_page_header_v2, _cached_page->levels, _cached_page->values);
+        return seastar::make_ready_future<>();
+    case format::PageType::DICTIONARY_PAGE:
+        return init_dictionary(header.dictionary_page_header, header.compressed_page_size);
+    default:
+        return seastar::make_ready_future<>();
     }
-    _val_decoder.reset_dict(_dict->data(), _dict->size());
 }
 
-template<format::Type::type T>
-seastar::future<> column_chunk_reader<T>::load_next_page() {
-    ++_page_ordinal;
+template<format::Type::type T, typename ValueDecoder>
+void column_chunk_reader<T, ValueDecoder>::update_memory() {
+    if (_memory) {
+        _memory.update(_fixed_memory + _source.buffer_size() + _decompression_buffer.capacity() + _dict_memory);
+    }
+}
+
+template<format::Type::type T, typename ValueDecoder>
+seastar::future<> column_chunk_reader<T, ValueDecoder>::load_next_page() {
+    _cached_page = nullptr;
+    _page_position = _source.position();
+    if (_page_position >= _dictionary_page_end && _page_position < _data_pages_begin) {
+        return _source.skip_pages(_data_pages_begin - _page_position).then([this] {
+            return load_next_page();
+        });
+    }
+    // The dictionary page, if any, is the first page of the chunk.
+    // Chunks without a dictionary are counted as misses of the dictionary cache.
+    dictionary_cache* dict_cache = dictionary_cache_for_reads();
+    if (dict_cache && _page_position == 0) {
+        if (auto dict = dict_cache->find<output_type>(*_dictionary_cache_chunk)) {
+            _dict = std::move(dict->values);
+            _dict_memory = dict->memory_usage;
+            _val_decoder.reset_dict(_dict->data(), _dict->size());
+            return _source.skip_page(dict->on_disk_size).then([this] {
+                update_memory();
+            });
+        }
+    }
+    if (page_cache* cache = page_cache_for_reads()) {
+        if (auto cached = cache->find(page_cache_key{*_page_cache_chunk, _page_position})) {
+            size_t on_disk_size = cached->on_disk_size;
+            _page_on_disk_size = on_disk_size;
+            _cached_page = std::move(cached);
+            return _source.skip_page(on_disk_size).then([this] {
+                return load_cached_page();
+            }).then([this] {
+                update_memory();
+            });
+        }
+    }
     return _source.next_page().then([this] (std::optional<page> p) {
         if (!p) {
             _eof = true;
-        } else {
-            switch (p->header->type) {
-            case format::PageType::DATA_PAGE:
-                load_data_page(*p);
-                _initialized = true;
-                return;
-            case format::PageType::DATA_PAGE_V2:
-                load_data_page_v2(*p);
-                _initialized = true;
-                return;
-            case format::PageType::DICTIONARY_PAGE:
-                load_dictionary_page(*p);
-                return;
-            default:; // Unknown page types are to be skipped
-            }
+            return seastar::make_ready_future<>();
+        }
+        _page_on_disk_size = _source.position() - _page_position;
+        metrics::record_page_read(T, *p->header, p->contents.size());
+        switch (p->header->type) {
+        case format::PageType::DATA_PAGE:
+            return load_data_page(*p);
+        case format::PageType::DATA_PAGE_V2:
+            return load_data_page_v2(*p);
+        case format::PageType::DICTIONARY_PAGE:
+            return load_dictionary_page(*p);
+        default: // Unknown page types are to be skipped
+            metrics::record_pages_skipped(1);
+            return seastar::make_ready_future<>();
         }
+    }).then([this] {
+        update_memory();
+    });
+}
+
+template<format::Type::type T, typename ValueDecoder>
+void column_chunk_reader<T, ValueDecoder>::count_page(chunk_value_counts& counts) {
+    if (_page_null_count) {
+        if (*_page_null_count < 0 || *_page_null_count > _page_num_values) {
+            throw parquet_exception::corrupted_file(seastar::format(
+                    "Null count ({}) out of range (0 to {})", *_page_null_count, _page_num_values));
+        }
+        counts.levels += _page_num_values;
+        counts.values += _page_num_values - *_page_null_count;
+    } else {
+        auto [levels, values] = _def_decoder.count_remaining(_def_level);
+        counts.levels += levels;
+        counts.values += values;
+    }
+    bool dictionary_page = _page_encoding == format::Encoding::RLE_DICTIONARY
+            || _page_encoding == format::Encoding::PLAIN_DICTIONARY;
+    if (!dictionary_page) {
+        counts.dictionary_encoded = false;
+    }
+    _initialized = false;
+}
+
+template<format::Type::type T, typename ValueDecoder>
+seastar::future<chunk_value_counts> column_chunk_reader<T, ValueDecoder>::count_values() {
+    _levels_only = true;
+    return seastar::with_scheduling_group(_scheduling_group, [this] {
+        return seastar::do_with(chunk_value_counts{}, [this] (chunk_value_counts& counts) {
+            return seastar::repeat([this, &counts] {
+                if (_eof) {
+                    return seastar::make_ready_future<seastar::stop_iteration>(seastar::stop_iteration::yes);
+                }
+                if (_initialized) {
+                    count_page(counts);
+                    return seastar::make_ready_future<seastar::stop_iteration>(seastar::stop_iteration::no);
+                }
+                return load_next_page().then([] {
+                    return seastar::stop_iteration::no;
+                });
+            }).then([this, &counts] {
+                counts.dictionary_encoded = counts.dictionary_encoded && _dict;
+                return counts;
+            });
+        });
+    }).handle_exception_type([this] (const std::exception& e) {
+        return seastar::make_exception_future<chunk_value_counts>(parquet_exception(seastar::format(
+                "Error while counting page number {}: {}", _source.page_ordinal(), e.what())));
     });
 }
 
@@ -170,5 +442,8 @@ template class column_chunk_reader<format::Type::DOUBLE>;
 template class column_chunk_reader<format::Type::BOOLEAN>;
 template class column_chunk_reader<format::Type::BYTE_ARRAY>;
 template class column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY>;
+template class column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<12>>;
+template class column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<16>>;
+template class column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, decimal128_decoder>;
 
 } // namespace parquet4seastar
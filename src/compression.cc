@@ -21,11 +21,60 @@
 
 #include <parquet4seastar/compression.hh>
 #include <parquet4seastar/exception.hh>
+#include <parquet4seastar/preempt.hh>
+#include <seastar/core/do_with.hh>
 #include <snappy.h>
 #include <zlib.h>
 
 namespace parquet4seastar {
 
+seastar::future<bytes> compressor::decompress_preemptible(bytes_view in, bytes&& out) const {
+    return seastar::futurize_invoke([this, in, &out] {
+        return decompress(in, std::move(out));
+    });
+}
+
+seastar::future<bytes> compressor::compress_preemptible(bytes_view in, bytes&& out) const {
+    return seastar::futurize_invoke([this, in, &out] {
+        return compress(in, std::move(out));
+    });
+}
+
+namespace {
+
+// Copies in to the beginning of out, which must be at least as big as in.
+seastar::future<bytes> copy_preemptible(bytes_view in, bytes&& out) {
+    return seastar::do_with(std::move(out), size_t(0), [in] (bytes& out, size_t& pos) {
+        return repeat_preemptible([in, &out, &pos] {
+            size_t n = std::min(preemption_step_size, in.size() - pos);
+            std::memcpy(out.data() + pos, in.data() + pos, n);
+            pos += n;
+            return seastar::stop_iteration(pos == in.size());
+        }).then([&out] {
+            return std::move(out);
+        });
+    });
+}
+
+// zlib streams keep a pointer to themselves, so they can't be moved.
+// They are kept on the heap when they have to outlive a task.
+struct zlib_stream {
+    z_stream zs;
+    int (*end)(z_streamp);
+    explicit zlib_stream(int (*end)(z_streamp)) : end{end} {
+        zs.zalloc = Z_NULL;
+        zs.zfree = Z_NULL;
+        zs.opaque = Z_NULL;
+        zs.avail_in = 0;
+        zs.next_in = Z_NULL;
+    }
+    ~zlib_stream() {
+        end(&zs);
+    }
+};
+
+} // namespace
+
 class uncompressed_compressor final : public compressor {
     bytes decompress(bytes_view in, bytes&& out) const override {
         if (out.size() < in.size()) {
@@ -41,6 +90,18 @@ class uncompressed_compressor final : public compressor {
         out.insert(out.end(), in.begin(), in.end());
         return std::move(out);
     }
+    seastar::future<bytes> decompress_preemptible(bytes_view in, bytes&& out) const override {
+        if (out.size() < in.size()) {
+            return seastar::make_exception_future<bytes>(
+                    parquet_exception::corrupted_file("Uncompression buffer size too small"));
+        }
+        out.resize(in.size());
+        return copy_preemptible(in, std::move(out));
+    }
+    seastar::future<bytes> compress_preemptible(bytes_view in, bytes&& out) const override {
+        out.resize(in.size());
+        return copy_preemptible(in, std::move(out));
+    }
     format::CompressionCodec::type type() const override {
         return format::CompressionCodec::UNCOMPRESSED;
     }
@@ -140,6 +201,74 @@ class gzip_compressor final : public compressor {
         }
         return std::move(out);
     }
+    // Inflates at most preemption_step_size bytes of output per step.
+    seastar::future<bytes> decompress_preemptible(bytes_view in, bytes&& out) const override {
+        auto stream = std::make_unique<zlib_stream>(inflateEnd);
+        z_stream& zs = stream->zs;
+        constexpr int DETECT_CODEC = 32;
+        constexpr int WINDOW_BITS = 15;
+        if (inflateInit2(&zs, DETECT_CODEC | WINDOW_BITS) != Z_OK) {
+            stream->end = [] (z_streamp) { return Z_OK; };
+            return seastar::make_exception_future<bytes>(parquet_exception("deflate decompression init failure"));
+        }
+        zs.next_in = reinterpret_cast<unsigned char*>(const_cast<byte*>(in.data()));
+        zs.avail_in = in.size();
+        return seastar::do_with(std::move(stream), std::move(out),
+        [] (std::unique_ptr<zlib_stream>& stream, bytes& out) {
+            // Only now that out is in place: moving a short string copies its inline contents.
+            stream->zs.next_out = reinterpret_cast<unsigned char*>(out.data());
+            return repeat_preemptible([&zs = stream->zs, &out] {
+                size_t remaining = out.size() - zs.total_out;
+                zs.avail_out = std::min(preemption_step_size, remaining);
+                auto res = inflate(&zs, Z_NO_FLUSH);
+                if (res == Z_STREAM_END) {
+                    out.resize(zs.total_out);
+                    return seastar::stop_iteration::yes;
+                } else if (res == Z_OK) {
+                    return seastar::stop_iteration::no;
+                } else if (res == Z_BUF_ERROR && remaining == 0) {
+                    throw parquet_exception::corrupted_file("Decompression buffer size too small");
+                } else if (res == Z_BUF_ERROR) {
+                    throw parquet_exception::corrupted_file("Unexpected end of deflate stream");
+                } else {
+                    throw parquet_exception("deflate decompression failure");
+                }
+            }).then([&out] {
+                return std::move(out);
+            });
+        });
+    }
+    // Deflates at most preemption_step_size bytes of input per step.
+    seastar::future<bytes> compress_preemptible(bytes_view in, bytes&& out) const override {
+        auto stream = std::make_unique<zlib_stream>(deflateEnd);
+        z_stream& zs = stream->zs;
+        if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) {
+            stream->end = [] (z_streamp) { return Z_OK; };
+            return seastar::make_exception_future<bytes>(parquet_exception("deflate compression init failure"));
+        }
+        out.resize(deflateBound(&zs, in.size()));
+        return seastar::do_with(std::move(stream), std::move(out), size_t(0),
+        [in] (std::unique_ptr<zlib_stream>& stream, bytes& out, size_t& pos) {
+            // Only now that out is in place: moving a short string copies its inline contents.
+            stream->zs.next_out = reinterpret_cast<unsigned char*>(out.data());
+            stream->zs.avail_out = out.size();
+            return repeat_preemptible([in, &zs = stream->zs, &pos] {
+                size_t n = std::min(preemption_step_size, in.size() - pos);
+                zs.next_in = reinterpret_cast<unsigned char*>(const_cast<byte*>(in.data() + pos));
+                zs.avail_in = n;
+                pos += n;
+                bool last = pos == in.size();
+                auto res = deflate(&zs, last ? Z_FINISH : Z_NO_FLUSH);
+                if ((last && res != Z_STREAM_END) || (!last && (res != Z_OK || zs.avail_in != 0))) {
+                    throw parquet_exception("deflate compression failure");
+                }
+                return seastar::stop_iteration(last);
+            }).then([&stream, &out] {
+                out.resize(stream->zs.total_out);
+                return std::move(out);
+            });
+        });
+    }
     format::CompressionCodec::type type() const override {
         return format::CompressionCodec::GZIP;
     }
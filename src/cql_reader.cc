@@ -21,9 +21,9 @@
 
 #include <parquet4seastar/record_reader.hh>
 #include <parquet4seastar/cql_reader.hh>
+#include <parquet4seastar/logical_type_conversion.hh>
 #include <parquet4seastar/overloaded.hh>
 #include <parquet4seastar/y_combinator.hh>
-#include <boost/iterator/counting_iterator.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
 #include <iomanip>
 
@@ -89,6 +89,18 @@ class cql_consumer {
                 << std::setw(fractional_digits) << fractional_part
                 << '\'';
     }
+    void print_decimal(const seastar::temporary_buffer<uint8_t>& v, uint32_t scale) {
+        if (v.size() <= 8) {
+            _out << decimal_to_int64(bytes_view{v.get(), v.size()}) << "e-" << scale;
+            return;
+        }
+        boost::multiprecision::cpp_int x;
+        import_bits(x, v.begin(), v.end(), 8);
+        if (v[0] & 0b10000000) {
+            x -= boost::multiprecision::cpp_int(1) << 8 * v.size();
+        }
+        _out << x << "e-" << scale;
+    }
 public:
     explicit cql_consumer(std::ostream& out, std::string column_selector)
         : _out{out}
@@ -169,20 +181,10 @@ public:
     void append_value(DECIMAL_INT32 t, int32_t v) { _out << v << "e-" << t.scale; }
     void append_value(DECIMAL_INT64 t, int64_t v) { _out << v << "e-" << t.scale; }
     void append_value(DECIMAL_BYTE_ARRAY t, seastar::temporary_buffer<uint8_t> v) {
-        boost::multiprecision::cpp_int x;
-        import_bits(x, v.begin(), v.end(), 8);
-        if ((v.size() > 0) && (v[0] & 0b10000000)) {
-            x -= boost::multiprecision::cpp_int(1) << 8 * v.size();
-        }
-        _out << x << "e-" << t.scale;
+        print_decimal(v, t.scale);
     }
     void append_value(DECIMAL_FIXED_LEN_BYTE_ARRAY t, seastar::temporary_buffer<uint8_t> v) {
-        boost::multiprecision::cpp_int x;
-        import_bits(x, v.begin(), v.end(), 8);
-        if ((v.size() > 0) && (v[0] & 0b10000000)) {
-            x -= boost::multiprecision::cpp_int(1) << 8 * v.size();
-        }
-        _out << x << "e-" << t.scale;
+        print_decimal(v, t.scale);
     }
     void append_value(DATE, int32_t v) { _out << static_cast<uint32_t>(v) + (1u << 31u); }
     void append_value(TIME_INT32 t, int32_t v) {
@@ -407,18 +409,10 @@ seastar::future<> parquet_to_cql(file_reader& fr, const std::string& table, cons
     cql_schema schema = parquet_schema_to_cql_schema(fr.schema(), table);
     out << cql_schema_to_cql_create(schema, quoted_table, quoted_pk);
     return seastar::do_with(cql_consumer{out, cql_schema_to_cql_column_list(schema, quoted_table, quoted_pk)},
-    [&fr] (cql_consumer& consumer) {
-        return seastar::do_for_each(
-        boost::counting_iterator<int>(0),
-        boost::counting_iterator<int>(fr.metadata().row_groups.size()),
-        [&fr, &consumer] (int row_group) {
-            return record::record_reader::make(fr, row_group).then(
-            [&consumer] (record::record_reader rr) {
-                return seastar::do_with(std::move(rr),
-                [&consumer] (record::record_reader& rr) {
-                    return rr.read_all(consumer);
-                });
-            });
+            record::multi_record_reader{fr},
+    [] (cql_consumer& consumer, record::multi_record_reader& rr) {
+        return rr.read_all(consumer).finally([&rr] {
+            return rr.close();
         });
     });
 }
@@ -0,0 +1,234 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/dataset.hh>
+#include <seastar/core/future-util.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/seastar.hh>
+#include <boost/algorithm/string/join.hpp>
+#include <filesystem>
+#include <map>
+
+namespace parquet4seastar {
+
+namespace {
+
+// The name of the root differs between writers, and is ignored.
+bool same_schema(const std::vector<format::SchemaElement>& a, const std::vector<format::SchemaElement>& b) {
+    return !a.empty()
+            && a.size() == b.size()
+            && a[0].num_children == b[0].num_children
+            && std::equal(a.begin() + 1, a.end(), b.begin() + 1);
+}
+
+// The file storing all column chunks of the row group, relative to the summary file.
+const std::string& row_group_file(const format::RowGroup& rg, size_t index) {
+    if (rg.columns.empty() || rg.columns[0].file_path.empty()) {
+        throw parquet_exception::corrupted_file(seastar::format(
+                "Row group {} of the summary does not refer to a data file", index));
+    }
+    for (const format::ColumnChunk& cc : rg.columns) {
+        if (cc.file_path != rg.columns[0].file_path) {
+            throw parquet_exception::corrupted_file(seastar::format(
+                    "Row group {} of the summary is stored in several files", index));
+        }
+    }
+    return rg.columns[0].file_path;
+}
+
+} // namespace
+
+seastar::future<dataset> dataset::open(std::vector<std::string> paths, dataset_options options) {
+    if (paths.empty()) {
+        return seastar::make_exception_future<dataset>(parquet_exception("A dataset needs at least one file"));
+    }
+    dataset ds;
+    ds._paths = std::move(paths);
+    ds._metadata.resize(ds._paths.size());
+    size_t max_concurrent_reads = std::max<size_t>(options.max_concurrent_reads, 1);
+    auto sem = seastar::make_lw_shared<seastar::semaphore>(max_concurrent_reads);
+    return seastar::do_with(std::move(ds), std::move(options), [sem] (dataset& ds, dataset_options& options) {
+        return seastar::parallel_for_each(boost::irange<size_t>(0, ds._paths.size()), [&ds, &options, sem] (size_t i) {
+            return seastar::get_units(*sem, 1).then([&ds, &options, i] (auto units) {
+                return file_reader::read_metadata(ds._paths[i], options.io).then(
+                [&ds, i, units = std::move(units)] (std::unique_ptr<format::FileMetaData> metadata) {
+                    ds._metadata[i] = std::move(metadata);
+                });
+            });
+        }).then([&ds] {
+            ds.check_schemata();
+            ds.build_raw_schema();
+            return std::move(ds);
+        });
+    });
+}
+
+// The row groups of the summary are split by data file, in the order of their first appearance.
+// Within each file, row groups keep their order, which is their order in the data file.
+seastar::future<dataset> dataset::open_summary(std::string path, dataset_options options) {
+    return file_reader::read_metadata(path, options.io).then([path] (std::unique_ptr<format::FileMetaData> summary) {
+        std::filesystem::path directory = std::filesystem::path(path).parent_path();
+        dataset ds;
+        std::map<std::string, size_t> files;
+        for (size_t i = 0; i < summary->row_groups.size(); ++i) {
+            format::RowGroup& rg = summary->row_groups[i];
+            std::string file_path = row_group_file(rg, i);
+            auto [it, inserted] = files.emplace(file_path, ds._paths.size());
+            if (inserted) {
+                ds._paths.push_back((directory / file_path).string());
+                auto metadata = std::make_unique<format::FileMetaData>();
+                metadata->__set_version(summary->version);
+                metadata->__set_schema(summary->schema);
+                if (summary->__isset.column_orders) {
+                    metadata->__set_column_orders(summary->column_orders);
+                }
+                ds._metadata.push_back(std::move(metadata));
+            }
+            format::FileMetaData& metadata = *ds._metadata[it->second];
+            metadata.num_rows += rg.num_rows;
+            for (format::ColumnChunk& cc : rg.columns) {
+                cc.__isset.file_path = false;
+                cc.file_path.clear();
+            }
+            metadata.row_groups.push_back(std::move(rg));
+        }
+        if (ds._paths.empty()) {
+            throw parquet_exception(seastar::format("The summary file {} has no row groups", path));
+        }
+        ds.build_raw_schema();
+        return ds;
+    });
+}
+
+void dataset::build_raw_schema() {
+    _raw_schema = std::make_unique<reader_schema::raw_schema>(
+            reader_schema::flat_schema_to_raw_schema(_metadata[0]->schema));
+}
+
+void dataset::check_schemata() const {
+    for (size_t i = 1; i < _metadata.size(); ++i) {
+        if (!same_schema(_metadata[i]->schema, _metadata[0]->schema)) {
+            throw parquet_exception(seastar::format(
+                    "The schema of {} differs from the schema of {}", _paths[i], _paths[0]));
+        }
+    }
+}
+
+int64_t dataset::num_rows() const {
+    int64_t rows = 0;
+    for (const auto& metadata : _metadata) {
+        rows += metadata->num_rows;
+    }
+    return rows;
+}
+
+uint32_t dataset::leaf_index(std::string_view path) const {
+    for (uint32_t i = 0; i < _raw_schema->leaves.size(); ++i) {
+        if (boost::algorithm::join(_raw_schema->leaves[i]->path, ".") == path) {
+            return i;
+        }
+    }
+    throw parquet_exception(seastar::format("No leaf column named {}", path));
+}
+
+std::vector<row_group_ref> dataset::select_row_groups(const std::vector<predicate>& predicates) const {
+    for (const predicate& p : predicates) {
+        if (p.column >= _raw_schema->leaves.size()) {
+            throw parquet_exception(seastar::format(
+                    "Predicate on column {}, but there are only {} leaf columns", p.column, _raw_schema->leaves.size()));
+        }
+    }
+    std::vector<row_group_ref> selected;
+    for (uint32_t file = 0; file < _metadata.size(); ++file) {
+        const format::FileMetaData& metadata = *_metadata[file];
+        for (uint32_t row_group = 0; row_group < metadata.row_groups.size(); ++row_group) {
+            const format::RowGroup& rg = metadata.row_groups[row_group];
+            bool may_match_all = std::all_of(predicates.begin(), predicates.end(), [&] (const predicate& p) {
+                if (p.column >= rg.columns.size() || !rg.columns[p.column].__isset.meta_data) {
+                    return true;
+                }
+                column_statistics stats = read_statistics(
+                        rg.columns[p.column].meta_data,
+                        _raw_schema->leaves[p.column]->info,
+                        has_type_defined_order(metadata, p.column));
+                return may_match(stats, p);
+            });
+            if (may_match_all) {
+                selected.push_back(row_group_ref{file, row_group, selected.size(), rg.total_byte_size});
+            }
+        }
+    }
+    return selected;
+}
+
+void summary_builder::add(const std::string& relative_path, const format::FileMetaData& footer) {
+    if (_empty) {
+        _metadata.__set_version(footer.version);
+        _metadata.__set_schema(footer.schema);
+        if (footer.__isset.column_orders) {
+            _metadata.__set_column_orders(footer.column_orders);
+        }
+        _metadata.__set_created_by("parquet4seastar");
+        _empty = false;
+    } else if (!same_schema(footer.schema, _metadata.schema)) {
+        throw parquet_exception(seastar::format(
+                "The schema of {} differs from the schema of the summary", relative_path));
+    }
+    for (const format::RowGroup& rg : footer.row_groups) {
+        _metadata.row_groups.push_back(rg);
+        for (format::ColumnChunk& cc : _metadata.row_groups.back().columns) {
+            cc.__set_file_path(relative_path);
+        }
+    }
+    _metadata.num_rows += footer.num_rows;
+}
+
+seastar::future<> summary_builder::write(std::string path, io_options options) const {
+    if (_empty) {
+        return seastar::make_exception_future<>(parquet_exception("The summary has no files"));
+    }
+    auto sg = options.scheduling_group;
+    return seastar::with_scheduling_group(sg, [this, path = std::move(path), options = std::move(options)] {
+        seastar::open_flags flags = seastar::open_flags::wo | seastar::open_flags::create | seastar::open_flags::truncate;
+        return seastar::open_file_dma(path, flags).then([this, options] (seastar::file file) {
+            auto sink = seastar::make_file_output_stream(file, options.output_stream_options());
+            return seastar::do_with(std::move(sink), thrift_serializer{},
+            [this] (seastar::output_stream<char>& sink, thrift_serializer& serializer) {
+                bytes_view footer = serializer.serialize(_metadata);
+                return sink.write("PAR1", 4).then([&sink, footer] {
+                    return sink.write(reinterpret_cast<const char*>(footer.data()), footer.size());
+                }).then([&sink, footer] {
+                    uint32_t footer_size = footer.size();
+                    return sink.write(reinterpret_cast<const char*>(&footer_size), 4);
+                }).then([&sink] {
+                    return sink.write("PAR1", 4);
+                }).then([&sink] {
+                    return sink.flush();
+                }).finally([&sink] {
+                    return sink.close();
+                });
+            });
+        });
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,123 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/dictionary_cache.hh>
+#include <seastar/core/metrics.hh>
+#include <boost/functional/hash.hpp>
+
+namespace parquet4seastar {
+
+namespace {
+
+thread_local std::unique_ptr<dictionary_cache> shard_dictionary_cache;
+
+} // namespace
+
+size_t dictionary_cache::key_hash::operator()(const key& k) const {
+    size_t h = column_chunk_id_hash{}(k.chunk);
+    boost::hash_combine(h, k.type.hash_code());
+    return h;
+}
+
+dictionary_cache::dictionary_cache(size_t capacity)
+    : _capacity{capacity}
+    , _reclaimer{[this] { return reclaim(); }} {
+    namespace sm = seastar::metrics;
+    _metrics.add_group("parquet4seastar", {
+        sm::make_derive("dictionary_cache_hits", _stats.hits,
+                sm::description("Dictionaries found in the dictionary cache")),
+        sm::make_derive("dictionary_cache_misses", _stats.misses,
+                sm::description("Dictionaries looked up in the dictionary cache and not found")),
+        sm::make_derive("dictionary_cache_insertions", _stats.insertions,
+                sm::description("Dictionaries inserted into the dictionary cache")),
+        sm::make_derive("dictionary_cache_evictions", _stats.evictions,
+                sm::description("Dictionaries evicted from the dictionary cache, because of its capacity or memory pressure")),
+        sm::make_gauge("dictionary_cache_bytes", [this] { return _size; },
+                sm::description("Memory used by the dictionaries in the dictionary cache")),
+        sm::make_gauge("dictionary_cache_entries", [this] { return _index.size(); },
+                sm::description("Dictionaries in the dictionary cache")),
+    });
+}
+
+const std::any* dictionary_cache::find_entry(const key& k) {
+    auto it = _index.find(k);
+    if (it == _index.end()) {
+        ++_stats.misses;
+        return nullptr;
+    }
+    ++_stats.hits;
+    _lru.splice(_lru.begin(), _lru, it->second);
+    return &it->second->dictionary;
+}
+
+const std::any& dictionary_cache::insert_entry(const key& k, std::any dictionary, size_t memory_usage) {
+    auto it = _index.find(k);
+    if (it != _index.end()) {
+        // Inserted concurrently by another reader.
+        _lru.splice(_lru.begin(), _lru, it->second);
+        return it->second->dictionary;
+    }
+    shrink(_capacity - memory_usage);
+    _lru.push_front(entry{k, std::move(dictionary), memory_usage});
+    _index.emplace(k, _lru.begin());
+    _size += memory_usage;
+    ++_stats.insertions;
+    return _lru.front().dictionary;
+}
+
+void dictionary_cache::evict_one() {
+    entry& e = _lru.back();
+    _size -= e.memory_usage;
+    _index.erase(e.k);
+    _lru.pop_back();
+    ++_stats.evictions;
+}
+
+void dictionary_cache::shrink(size_t size) {
+    while (_size > size) {
+        evict_one();
+    }
+}
+
+// Called by the seastar allocator when free memory runs low. Frees an eighth of the cache at a time.
+seastar::memory::reclaiming_result dictionary_cache::reclaim() {
+    if (_lru.empty()) {
+        return seastar::memory::reclaiming_result::reclaimed_nothing;
+    }
+    size_t target = _size - std::max(_size / 8, _lru.back().memory_usage);
+    shrink(target);
+    return seastar::memory::reclaiming_result::reclaimed_something;
+}
+
+void enable_dictionary_cache(size_t capacity) {
+    shard_dictionary_cache.reset();
+    shard_dictionary_cache = std::make_unique<dictionary_cache>(capacity);
+}
+
+void disable_dictionary_cache() {
+    shard_dictionary_cache.reset();
+}
+
+dictionary_cache* local_dictionary_cache() {
+    return shard_dictionary_cache.get();
+}
+
+} // namespace parquet4seastar
@@ -20,6 +20,12 @@
  */
 
 #include <parquet4seastar/encoding.hh>
+#include <parquet4seastar/logical_type_conversion.hh>
+#include <parquet4seastar/metrics.hh>
+#include <parquet4seastar/preempt.hh>
+#include <seastar/core/do_with.hh>
+#include <limits>
+#include <unordered_set>
 
 namespace parquet4seastar {
 
@@ -78,6 +84,41 @@ void level_decoder::reset_v2(bytes_view encoded_levels, uint32_t num_values) {
             static_cast<int>(_bit_width)};
 }
 
+std::pair<uint32_t, uint32_t> level_decoder::count_remaining(uint32_t level) {
+    uint32_t n = _num_values - _values_read;
+    if (_bit_width == 0) {
+        _values_read += n;
+        return {n, level == 0 ? n : 0};
+    }
+    int64_t matching = 0;
+    uint32_t n_read = std::visit(overloaded {
+            [this, n, level, &matching] (BitReader& r) {
+                constexpr uint32_t buffer_size = 64;
+                uint32_t buffer[buffer_size];
+                uint32_t n_read = 0;
+                while (n_read < n) {
+                    uint32_t batch = std::min(n - n_read, buffer_size);
+                    uint32_t batch_read = r.GetBatch(_bit_width, buffer, batch);
+                    matching += std::count(buffer, buffer + batch_read, level);
+                    n_read += batch_read;
+                    if (batch_read < batch) {
+                        break;
+                    }
+                }
+                return n_read;
+            },
+            [n, level, &matching] (RleDecoder& r) {
+                return static_cast<uint32_t>(r.CountEqual(level, n, &matching));
+            },
+    }, _decoder);
+    _values_read += n_read;
+    if (n_read != n) {
+        throw parquet_exception::corrupted_file(seastar::format(
+                "Unexpected end of levels (expected {}, got {})", n, n_read));
+    }
+    return {n, static_cast<uint32_t>(matching)};
+}
+
 template <format::Type::type ParquetType>
 class plain_decoder_trivial final : public decoder<ParquetType> {
     bytes_view _buffer;
@@ -249,115 +290,193 @@ public:
     }
 };
 
+/* Returns the number of bytes occupied by a DELTA_BINARY_PACKED run at the beginning of data.
+ * Only block headers are parsed; the miniblocks themselves are skipped without being unpacked.
+ * This lets us find the boundaries between the consecutive sections of DELTA_BYTE_ARRAY
+ * without decoding them up front.
+ */
+static size_t delta_binary_packed_encoded_size(bytes_view data) {
+    size_t pos = 0;
+    auto read_vlq = [&data, &pos] () {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= data.size()) {
+                throw parquet_exception("Unexpected end of DELTA_BINARY_PACKED header");
+            }
+            byte b = data[pos++];
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) {
+                return v;
+            }
+        }
+        throw parquet_exception("Invalid VLQ int in DELTA_BINARY_PACKED header");
+    };
+    uint64_t values_per_block = read_vlq();
+    uint64_t num_mini_blocks = read_vlq();
+    uint64_t total_values = read_vlq();
+    read_vlq(); // First value.
+    if (num_mini_blocks == 0) {
+        throw parquet_exception("In DELTA_BINARY_PACKED number miniblocks per block is 0");
+    }
+    uint64_t values_per_mini_block = values_per_block / num_mini_blocks;
+    if (values_per_mini_block == 0 || values_per_mini_block % 8 != 0) {
+        throw parquet_exception(seastar::format(
+                "Invalid number of values per miniblock in DELTA_BINARY_PACKED ({})", values_per_mini_block));
+    }
+    uint64_t deltas_remaining = total_values > 0 ? total_values - 1 : 0;
+    while (deltas_remaining > 0) {
+        read_vlq(); // Min delta.
+        if (data.size() - pos < num_mini_blocks) {
+            throw parquet_exception("Unexpected end of DELTA_BINARY_PACKED block header");
+        }
+        const byte* bit_widths = data.data() + pos;
+        pos += num_mini_blocks;
+        for (uint64_t i = 0; i < num_mini_blocks && deltas_remaining > 0; ++i) {
+            uint64_t mini_block_size = bit_widths[i] * values_per_mini_block / 8;
+            if (data.size() - pos < mini_block_size) {
+                throw parquet_exception("Unexpected end of data in DELTA_BINARY_PACKED");
+            }
+            pos += mini_block_size;
+            deltas_remaining -= std::min(deltas_remaining, values_per_mini_block);
+        }
+    }
+    return pos;
+}
+
+/* DELTA_LENGTH_BYTE_ARRAY is decoded lazily, like DELTA_BYTE_ARRAY below. reset() only locates
+ * the value bytes after the lengths, and read_batch() decodes lengths for at most BATCH_SIZE values
+ * at a time, so that a huge page is never decoded in one go. The values of a batch are contiguous
+ * in the page, so each batch copies them out of the page with one allocation and one copy,
+ * and the output buffers are shares of that batch buffer.
+ */
 class delta_length_byte_array_decoder final : public decoder<format::Type::BYTE_ARRAY> {
-    seastar::temporary_buffer<byte> _values;
-    std::vector<int32_t> _lengths;
-    size_t _current_idx;
+    delta_binary_packed_decoder<format::Type::INT32> _len_decoder;
+    bytes_view _values;
     static constexpr size_t BATCH_SIZE = 1000;
 public:
     using typename decoder<format::Type::BYTE_ARRAY>::output_type;
     size_t read_batch(size_t n, output_type out[]) override {
-        n = std::min(n, _lengths.size() - _current_idx);
-        for (size_t i = 0; i < n; ++i) {
-            uint32_t len = _lengths[_current_idx];
-            if (len > _values.size()) {
-                throw parquet_exception(
-                        "Unexpected end of values in DELTA_LENGTH_BYTE_ARRAY");
+        std::array<int32_t, BATCH_SIZE> lengths;
+        size_t completed = 0;
+        while (completed < n) {
+            size_t n_to_read = std::min(n - completed, BATCH_SIZE);
+            size_t n_read = _len_decoder.read_batch(n_to_read, lengths.data());
+            size_t batch_bytes = 0;
+            for (size_t i = 0; i < n_read; ++i) {
+                if (lengths[i] < 0) {
+                    throw parquet_exception("Negative length in DELTA_LENGTH_BYTE_ARRAY");
+                }
+                batch_bytes += static_cast<size_t>(lengths[i]);
+            }
+            if (batch_bytes > _values.size()) {
+                throw parquet_exception("Unexpected end of values in DELTA_LENGTH_BYTE_ARRAY");
+            }
+            seastar::temporary_buffer<byte> batch(_values.data(), batch_bytes);
+            _values.remove_prefix(batch_bytes);
+            size_t pos = 0;
+            for (size_t i = 0; i < n_read; ++i) {
+                out[completed + i] = batch.share(pos, lengths[i]);
+                pos += lengths[i];
+            }
+            completed += n_read;
+            if (n_read < n_to_read) {
+                break;
             }
-            out[i] = _values.share(0, len);
-            _values.trim_front(len);
-            ++_current_idx;
         }
-        return n;
+        return completed;
     }
     void reset(bytes_view data) override {
-        delta_binary_packed_decoder<format::Type::INT32> _len_decoder;
         _len_decoder.reset(data);
-
-        size_t lengths_read = 0;
-        while (true) {
-            _lengths.resize(lengths_read + BATCH_SIZE);
-            int32_t* output = _lengths.data() + _lengths.size() - BATCH_SIZE;
-            size_t n_read = _len_decoder.read_batch(BATCH_SIZE, output);
-            if (n_read == 0) {
-                break;
-            }
-            lengths_read += n_read;
-        }
-        _lengths.resize(lengths_read);
-
-        size_t len_bytes = data.size() - _len_decoder.bytes_left();
-        data.remove_prefix(len_bytes);
-        _values = seastar::temporary_buffer<byte>(data.data(), data.size());
-        _current_idx = 0;
+        data.remove_prefix(delta_binary_packed_encoded_size(data));
+        _values = data;
     }
 };
 
+/* DELTA_BYTE_ARRAY is decoded lazily, batch by batch. reset() only locates the three sections
+ * of the page (prefix lengths, suffix lengths, suffix bytes). read_batch() decodes prefix
+ * and suffix lengths for at most BATCH_SIZE values at a time into stack buffers and reconstructs
+ * the values into a shared arena. The output buffers are views (shares) of the arena,
+ * so there is no allocation per value, and the arena is reused across pages while it has space.
+ */
 class delta_byte_array_decoder final : public decoder<format::Type::BYTE_ARRAY> {
     using tb = seastar::temporary_buffer<byte>;
-    std::vector<tb> _suffixes;
-    std::vector<int32_t> _lengths;
-    bytes _last_string;
-    size_t _current_idx;
+    delta_binary_packed_decoder<format::Type::INT32> _prefix_len_decoder;
+    delta_binary_packed_decoder<format::Type::INT32> _suffix_len_decoder;
+    bytes_view _suffixes;
+    tb _arena;
+    size_t _arena_used = 0;
+    // The previously decoded value. Always points into _arena.
+    bytes_view _last_value;
     static constexpr size_t BATCH_SIZE = 1000;
+    static constexpr size_t MIN_ARENA_SIZE = 4096;
+private:
+    // Ensure that there is at least n bytes of free space in the arena.
+    // When a new arena has to be allocated, the last value is carried over to it,
+    // because the next value may need its prefix.
+    // The arena is sized after the remaining suffixes of the page, so that usually
+    // only one arena is needed per page.
+    void reserve_arena(size_t n) {
+        if (_arena.size() - _arena_used >= n) {
+            return;
+        }
+        size_t new_size = std::max({n + _last_value.size(), _suffixes.size(), MIN_ARENA_SIZE});
+        tb new_arena(new_size);
+        std::copy(_last_value.begin(), _last_value.end(), new_arena.get_write());
+        _last_value = bytes_view(new_arena.get(), _last_value.size());
+        _arena_used = _last_value.size();
+        _arena = std::move(new_arena);
+    }
 public:
     using typename decoder<format::Type::BYTE_ARRAY>::output_type;
     size_t read_batch(size_t n, output_type out[]) override {
-        n = std::min(n, _suffixes.size() - _current_idx);
-        for (size_t i = 0; i < n; ++i) {
-            uint32_t prefix_len = _lengths[i];
-            const tb& suffix = _suffixes[i];
-            if (prefix_len > _last_string.size()) {
-                throw parquet_exception("Invalid prefix length in DELTA_BYTE_ARRAY");
+        std::array<int32_t, BATCH_SIZE> prefix_lengths;
+        std::array<int32_t, BATCH_SIZE> suffix_lengths;
+        size_t completed = 0;
+        while (completed < n) {
+            size_t n_to_read = std::min(n - completed, BATCH_SIZE);
+            size_t n_read = _prefix_len_decoder.read_batch(n_to_read, prefix_lengths.data());
+            if (_suffix_len_decoder.read_batch(n_read, suffix_lengths.data()) != n_read) {
+                throw parquet_exception("Fewer suffixes than prefixes in DELTA_BYTE_ARRAY");
             }
-            out[i] = tb(prefix_len + suffix.size());
-            std::copy_n(
-                    _last_string.begin(),
-                    prefix_len,
-                    out[i].get_write());
-            std::copy(
-                    suffix.begin(),
-                    suffix.end(),
-                    out[i].get_write() + prefix_len);
-            _last_string.resize(prefix_len);
-            _last_string.insert(_last_string.end(), suffix.begin(), suffix.end());
-        }
-        return n;
-    }
-    void reset(bytes_view data) override {
-        delta_binary_packed_decoder<format::Type::INT32> _len_decoder;
-        delta_length_byte_array_decoder _suffix_decoder;
-
-        _len_decoder.reset(data);
-        size_t lengths_read = 0;
-        while (true) {
-            _lengths.resize(lengths_read + BATCH_SIZE);
-            int32_t* output = _lengths.data() + _lengths.size() - BATCH_SIZE;
-            size_t n_read = _len_decoder.read_batch(BATCH_SIZE, output);
-            if (n_read == 0) {
-                break;
+            size_t batch_bytes = 0;
+            for (size_t i = 0; i < n_read; ++i) {
+                if (prefix_lengths[i] < 0 || suffix_lengths[i] < 0) {
+                    throw parquet_exception("Negative length in DELTA_BYTE_ARRAY");
+                }
+                batch_bytes += static_cast<size_t>(prefix_lengths[i]) + static_cast<size_t>(suffix_lengths[i]);
             }
-            lengths_read += n_read;
-        }
-        _lengths.resize(lengths_read);
-
-        size_t len_bytes = data.size() - _len_decoder.bytes_left();
-        data.remove_prefix(len_bytes);
-
-        _suffix_decoder.reset(data);
-        size_t suffixes_read = 0;
-        while (true) {
-            _suffixes.resize(suffixes_read + BATCH_SIZE);
-            tb* output = _suffixes.data() + _suffixes.size() - BATCH_SIZE;
-            size_t n_read = _suffix_decoder.read_batch(BATCH_SIZE, output);
-            if (n_read == 0) {
+            reserve_arena(batch_bytes);
+            for (size_t i = 0; i < n_read; ++i) {
+                size_t prefix_len = prefix_lengths[i];
+                size_t suffix_len = suffix_lengths[i];
+                if (prefix_len > _last_value.size()) {
+                    throw parquet_exception("Invalid prefix length in DELTA_BYTE_ARRAY");
+                }
+                if (suffix_len > _suffixes.size()) {
+                    throw parquet_exception("Unexpected end of suffixes in DELTA_BYTE_ARRAY");
+                }
+                byte* value = _arena.get_write() + _arena_used;
+                std::copy_n(_last_value.data(), prefix_len, value);
+                std::copy_n(_suffixes.data(), suffix_len, value + prefix_len);
+                _suffixes.remove_prefix(suffix_len);
+                out[completed + i] = _arena.share(_arena_used, prefix_len + suffix_len);
+                _last_value = bytes_view(value, prefix_len + suffix_len);
+                _arena_used += prefix_len + suffix_len;
+            }
+            completed += n_read;
+            if (n_read < n_to_read) {
                 break;
             }
-            suffixes_read += n_read;
         }
-        _suffixes.resize(suffixes_read);
-
-        _current_idx = 0;
+        return completed;
+    }
+    void reset(bytes_view data) override {
+        _prefix_len_decoder.reset(data);
+        data.remove_prefix(delta_binary_packed_encoded_size(data));
+        _suffix_len_decoder.reset(data);
+        data.remove_prefix(delta_binary_packed_encoded_size(data));
+        _suffixes = data;
+        _last_value = bytes_view();
     }
 };
 
@@ -486,7 +605,7 @@ size_t dict_decoder<ParquetType>::read_batch(size_t n, output_type out[]) {
         size_t n_to_read = std::min(n - completed, buf.size());
         size_t n_read = _rle_decoder.GetBatch(buf.data(), n_to_read);
         for (size_t i = 0; i < n_read; ++i) {
-            if (buf[i] > _dict_size) {
+            if (buf[i] >= _dict_size) {
                 throw parquet_exception::corrupted_file(seastar::format(
                         "Dict index exceeds dict size (dict size = {}, index = {})", _dict_size, buf[i]));
             }
@@ -615,6 +734,126 @@ template class value_decoder<format::Type::BOOLEAN>;
 template class value_decoder<format::Type::BYTE_ARRAY>;
 template class value_decoder<format::Type::FIXED_LEN_BYTE_ARRAY>;
 
+namespace {
+
+template<typename OutputType>
+struct fixed_len_value_traits;
+
+template<size_t N>
+struct fixed_len_value_traits<std::array<byte, N>> {
+    static bool valid_length(uint32_t type_length) { return type_length == N; }
+    static void convert(const byte in[], size_t n_values, uint32_t type_length, std::array<byte, N> out[]) {
+        static_assert(sizeof(std::array<byte, N>) == N);
+        std::memcpy(out, in, n_values * N);
+    }
+};
+
+template<>
+struct fixed_len_value_traits<__int128> {
+    static bool valid_length(uint32_t type_length) { return type_length >= 1 && type_length <= 16; }
+    static void convert(const byte in[], size_t n_values, uint32_t type_length, __int128 out[]) {
+        logical_type::decimal_to_int128(in, type_length, n_values, out);
+    }
+};
+
+} // namespace
+
+template<typename OutputType>
+fixed_len_value_decoder<OutputType>::fixed_len_value_decoder(std::optional<uint32_t> type_length) {
+    if (!type_length) {
+        throw parquet_exception::corrupted_file("type_length not set for FIXED_LEN_BYTE_ARRAY");
+    }
+    if (!fixed_len_value_traits<OutputType>::valid_length(*type_length)) {
+        throw parquet_exception(seastar::format(
+                "type_length {} of FIXED_LEN_BYTE_ARRAY is not supported by this decoder", *type_length));
+    }
+    _type_length = *type_length;
+}
+
+template<typename OutputType>
+void fixed_len_value_decoder<OutputType>::reset_dict(output_type dictionary[], size_t dictionary_size) {
+    _dict = dictionary;
+    _dict_size = dictionary_size;
+    _dict_set = true;
+}
+
+template<typename OutputType>
+void fixed_len_value_decoder<OutputType>::reset(bytes_view buf, format::Encoding::type encoding) {
+    switch (encoding) {
+        case format::Encoding::PLAIN:
+            _dict_encoded = false;
+            _buffer = buf;
+            break;
+        case format::Encoding::RLE_DICTIONARY:
+        case format::Encoding::PLAIN_DICTIONARY: {
+            if (!_dict_set) {
+                throw parquet_exception::corrupted_file("No dictionary page found before a dictionary-encoded page");
+            }
+            _dict_encoded = true;
+            if (buf.size() == 0) {
+                _rle_decoder.Reset(buf.data(), 0, 0);
+                break;
+            }
+            int bit_width = buf[0];
+            if (bit_width > 32) {
+                throw parquet_exception::corrupted_file(seastar::format(
+                        "Illegal dictionary index bit width (should be 0 <= bit width <= 32, got {})", bit_width));
+            }
+            _rle_decoder.Reset(buf.data() + 1, buf.size() - 1, bit_width);
+            break;
+        }
+        default:
+            throw parquet_exception(seastar::format(
+                    "Encoding {} not implemented for fixed-width FIXED_LEN_BYTE_ARRAY", encoding));
+    }
+}
+
+template<typename OutputType>
+size_t fixed_len_value_decoder<OutputType>::read_plain(size_t n, output_type out[]) {
+    size_t n_to_read = std::min(n, _buffer.size() / _type_length);
+    if (n_to_read < n && _buffer.size() % _type_length != 0) {
+        throw parquet_exception::corrupted_file(seastar::format(
+                "End of page while reading FIXED_LEN_BYTE_ARRAY (needed {}B, got {}B)",
+                _type_length, _buffer.size() % _type_length));
+    }
+    fixed_len_value_traits<OutputType>::convert(_buffer.data(), n_to_read, _type_length, out);
+    _buffer.remove_prefix(n_to_read * _type_length);
+    return n_to_read;
+}
+
+template<typename OutputType>
+size_t fixed_len_value_decoder<OutputType>::read_dict(size_t n, output_type out[]) {
+    std::array<uint32_t, 1000> buf;
+    size_t completed = 0;
+    while (completed < n) {
+        size_t n_to_read = std::min(n - completed, buf.size());
+        size_t n_read = _rle_decoder.GetBatch(buf.data(), n_to_read);
+        for (size_t i = 0; i < n_read; ++i) {
+            if (buf[i] >= _dict_size) {
+                throw parquet_exception::corrupted_file(seastar::format(
+                        "Dict index exceeds dict size (dict size = {}, index = {})", _dict_size, buf[i]));
+            }
+        }
+        for (size_t i = 0; i < n_read; ++i) {
+            out[completed + i] = _dict[buf[i]];
+        }
+        completed += n_read;
+        if (n_read < n_to_read) {
+            return completed;
+        }
+    }
+    return n;
+}
+
+template<typename OutputType>
+size_t fixed_len_value_decoder<OutputType>::read_batch(size_t n, output_type out[]) {
+    return _dict_encoded ? read_dict(n, out) : read_plain(n, out);
+}
+
+template class fixed_len_value_decoder<std::array<byte, 12>>;
+template class fixed_len_value_decoder<std::array<byte, 16>>;
+template class fixed_len_value_decoder<__int128>;
+
 template <format::Type::type ParquetType>
 class plain_encoder : public value_encoder<ParquetType> {
 public:
@@ -726,40 +965,67 @@ public:
     bytes_view view() const { return _dict.view(); }
 };
 
-template <>
-class dict_builder<format::Type::BYTE_ARRAY> {
+/* The dictionary of BYTE_ARRAY or FIXED_LEN_BYTE_ARRAY keys. Each key is stored once,
+ * in the PLAIN-encoded dictionary page. The hash set holds key indices, and hashes and
+ * compares the keys which they locate in the page, so that looking up a known key doesn't
+ * allocate. C++17 sets have no heterogeneous lookup, so the index `probe` stands for
+ * the key being looked up.
+ */
+template <format::Type::type ParquetType>
+class byte_array_dict_builder {
+    struct key_location {
+        uint32_t offset; // In the dictionary page.
+        uint32_t size;
+    };
+    struct key_hash {
+        const byte_array_dict_builder* builder;
+        size_t operator()(uint32_t index) const { return bytes_view_hasher{}(builder->key(index)); }
+    };
+    struct key_equal {
+        const byte_array_dict_builder* builder;
+        bool operator()(uint32_t a, uint32_t b) const { return builder->key(a) == builder->key(b); }
+    };
+    static constexpr uint32_t probe = std::numeric_limits<uint32_t>::max();
+    plain_encoder<ParquetType> _dict;
+    std::vector<key_location> _keys;
+    bytes_view _probe_key;
+    std::unordered_set<uint32_t, key_hash, key_equal> _indices{0, key_hash{this}, key_equal{this}};
 private:
-    std::unordered_map<bytes, uint32_t, bytes_hasher> _accumulator;
-    plain_encoder<format::Type::BYTE_ARRAY> _dict;
-public:
-    uint32_t put(bytes_view key) {
-        auto [it, was_new_key] = _accumulator.try_emplace(bytes{key}, _accumulator.size());
-        if (was_new_key) {
-            _dict.put_batch(&key, 1);
+    bytes_view key(uint32_t index) const {
+        if (index == probe) {
+            return _probe_key;
         }
-        return it->second;
+        return _dict.view().substr(_keys[index].offset, _keys[index].size);
     }
-    size_t cardinality() const { return _accumulator.size(); }
-    bytes_view view() const { return _dict.view(); }
-};
-
-template <>
-class dict_builder<format::Type::FIXED_LEN_BYTE_ARRAY> {
-private:
-    std::unordered_map<bytes, uint32_t, bytes_hasher> _accumulator;
-    plain_encoder<format::Type::FIXED_LEN_BYTE_ARRAY> _dict;
 public:
+    byte_array_dict_builder() = default;
+    // The hash set points back to the builder.
+    byte_array_dict_builder(const byte_array_dict_builder&) = delete;
+    byte_array_dict_builder& operator=(const byte_array_dict_builder&) = delete;
     uint32_t put(bytes_view key) {
-        auto [it, was_new_key] = _accumulator.try_emplace(bytes{key}, _accumulator.size());
-        if (was_new_key) {
-            _dict.put_batch(&key, 1);
+        _probe_key = key;
+        auto it = _indices.find(probe);
+        if (it != _indices.end()) {
+            return *it;
         }
-        return it->second;
+        _dict.put_batch(&key, 1);
+        uint32_t index = _keys.size();
+        _keys.push_back(key_location{static_cast<uint32_t>(_dict.view().size() - key.size()),
+                static_cast<uint32_t>(key.size())});
+        _indices.insert(index);
+        return index;
     }
-    size_t cardinality() const { return _accumulator.size(); }
+    size_t cardinality() const { return _keys.size(); }
     bytes_view view() const { return _dict.view(); }
 };
 
+template <>
+class dict_builder<format::Type::BYTE_ARRAY> : public byte_array_dict_builder<format::Type::BYTE_ARRAY> {};
+
+template <>
+class dict_builder<format::Type::FIXED_LEN_BYTE_ARRAY>
+        : public byte_array_dict_builder<format::Type::FIXED_LEN_BYTE_ARRAY> {};
+
 template <format::Type::type ParquetType>
 class dict_encoder : public value_encoder<ParquetType> {
 private:
@@ -773,7 +1039,6 @@ public:
     using typename value_encoder<ParquetType>::input_type;
     using typename value_encoder<ParquetType>::flush_result;
     void put_batch(const input_type data[], size_t size) override {
-        _indices.reserve(_indices.size() + size);
         for (size_t i = 0; i < size; ++i) {
             _indices.push_back(_values.put(data[i]));
         }
@@ -794,6 +1059,26 @@ public:
         size_t size = 1 + encoder.len();
         return {size, format::Encoding::RLE_DICTIONARY};
     }
+    seastar::future<flush_result> flush_preemptible(byte sink[]) override {
+        *sink = static_cast<byte>(index_bit_width());
+        auto encoder = std::make_unique<RleEncoder>(
+                sink + 1, static_cast<int>(max_encoded_size() - 1), index_bit_width());
+        return seastar::do_with(std::move(encoder), size_t(0),
+        [this] (std::unique_ptr<RleEncoder>& encoder, size_t& pos) {
+            return repeat_preemptible([this, &encoder, &pos] {
+                size_t end = std::min(pos + preemption_step_size, _indices.size());
+                for (; pos < end; ++pos) {
+                    encoder->Put(_indices[pos]);
+                }
+                return seastar::stop_iteration(pos == _indices.size());
+            }).then([this, &encoder] {
+                encoder->Flush();
+                _indices.clear();
+                size_t size = 1 + encoder->len();
+                return flush_result{size, format::Encoding::RLE_DICTIONARY};
+            });
+        });
+    }
     std::optional<bytes_view> view_dict() override { return _values.view(); }
     uint64_t cardinality() override { return _values.cardinality(); }
 };
@@ -806,6 +1091,15 @@ private:
     dict_encoder<ParquetType> _dict_encoder;
     plain_encoder<ParquetType> _plain_encoder;
     bool fallen_back = false; // Have we fallen back to plain yet?
+private:
+    // The values of the page being flushed are already in the dictionary,
+    // so the fallback takes effect from the next page on.
+    void check_fallback() {
+        if (_dict_encoder.view_dict()->size() > fallback_threshold) {
+            fallen_back = true;
+            metrics::record_dictionary_fallback();
+        }
+    }
 public:
     using typename value_encoder<ParquetType>::input_type;
     using typename value_encoder<ParquetType>::flush_result;
@@ -830,12 +1124,18 @@ public:
         if (fallen_back) {
             return _plain_encoder.flush(sink);
         } else {
-            if (_dict_encoder.view_dict()->size() > fallback_threshold) {
-                fallen_back = true;
-            }
+            check_fallback();
             return _dict_encoder.flush(sink);
         }
     }
+    seastar::future<flush_result> flush_preemptible(byte sink[]) override {
+        if (fallen_back) {
+            return _plain_encoder.flush_preemptible(sink);
+        } else {
+            check_fallback();
+            return _dict_encoder.flush_preemptible(sink);
+        }
+    }
     std::optional<bytes_view> view_dict() override {
         return _dict_encoder.view_dict();
     }
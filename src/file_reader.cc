@@ -21,58 +21,106 @@
 
 #include <parquet4seastar/file_reader.hh>
 #include <parquet4seastar/exception.hh>
+#include <parquet4seastar/filter.hh>
 #include <seastar/core/seastar.hh>
+#include <boost/iterator/counting_iterator.hpp>
+#include <filesystem>
 
 namespace parquet4seastar {
 
-seastar::future<std::unique_ptr<format::FileMetaData>> file_reader::read_file_metadata(seastar::file file) {
-    return file.size().then([file] (uint64_t size) mutable {
-        if (size < 8) {
-            throw parquet_exception::corrupted_file(seastar::format(
-                    "File too small ({}B) to be a parquet file", size));
-        }
-
-        // Parquet file structure:
-        // ...
-        // File Metadata (serialized with thrift compact protocol)
-        // 4-byte length in bytes of file metadata (little endian)
-        // 4-byte magic number "PAR1"
-        // EOF
-        return file.dma_read_exactly<uint8_t>(size - 8, 8).then(
-        [file, size] (seastar::temporary_buffer<uint8_t> footer) mutable {
-            if (std::memcmp(footer.get() + 4, "PARE", 4) == 0) {
-                throw parquet_exception("Parquet encryption is currently unsupported");
-            } else if (std::memcmp(footer.get() + 4, "PAR1", 4) != 0) {
-                throw parquet_exception::corrupted_file("Magic bytes not found in footer");
-            }
+namespace {
 
-            uint32_t metadata_len;
-            std::memcpy(&metadata_len, footer.get(), 4);
-            if (metadata_len + 8 > size) {
-                throw parquet_exception::corrupted_file(seastar::format(
-                        "Metadata size reported by footer ({}B) greater than file size ({}B)",
-                        metadata_len + 8, size));
-            }
+void check_file_size(uint64_t size) {
+    if (size < 8) {
+        throw parquet_exception::corrupted_file(seastar::format(
+                "File too small ({}B) to be a parquet file", size));
+    }
+}
+
+// Parquet file structure:
+// ...
+// File Metadata (serialized with thrift compact protocol)
+// 4-byte length in bytes of file metadata (little endian)
+// 4-byte magic number "PAR1"
+// EOF
+// Check the 8-byte footer and return the length of the file metadata.
+uint32_t parse_footer(const uint8_t* footer, uint64_t size) {
+    if (std::memcmp(footer + 4, "PARE", 4) == 0) {
+        throw parquet_exception("Parquet encryption is currently unsupported");
+    } else if (std::memcmp(footer + 4, "PAR1", 4) != 0) {
+        throw parquet_exception::corrupted_file("Magic bytes not found in footer");
+    }
+
+    uint32_t metadata_len;
+    std::memcpy(&metadata_len, footer, 4);
+    // In 64 bits, since a corrupted length near 2^32 would wrap around in 32.
+    if (uint64_t(metadata_len) + 8 > size) {
+        throw parquet_exception::corrupted_file(seastar::format(
+                "Metadata size reported by footer ({}B) greater than file size ({}B)",
+                uint64_t(metadata_len) + 8, size));
+    }
+    return metadata_len;
+}
+
+std::unique_ptr<format::FileMetaData> deserialize_file_metadata(const uint8_t* data, uint32_t size) {
+    auto deserialized_metadata = std::make_unique<format::FileMetaData>();
+    deserialize_thrift_msg(data, size, *deserialized_metadata);
+    return deserialized_metadata;
+}
+
+} // namespace
 
-            return file.dma_read_exactly<uint8_t>(size - 8 - metadata_len, metadata_len);
+seastar::future<std::unique_ptr<format::FileMetaData>> file_reader::read_file_metadata(
+        seastar::file file, seastar::io_priority_class pc) {
+    return file.size().then([file, pc] (uint64_t size) mutable {
+        check_file_size(size);
+        return file.dma_read_exactly<uint8_t>(size - 8, 8, pc).then(
+        [file, size, pc] (seastar::temporary_buffer<uint8_t> footer) mutable {
+            uint32_t metadata_len = parse_footer(footer.get(), size);
+            return file.dma_read_exactly<uint8_t>(size - 8 - metadata_len, metadata_len, pc);
         }).then([file] (seastar::temporary_buffer<uint8_t> serialized_metadata) {
-            auto deserialized_metadata = std::make_unique<format::FileMetaData>();
-            deserialize_thrift_msg(serialized_metadata.get(), serialized_metadata.size(), *deserialized_metadata);
-            return deserialized_metadata;
+            return deserialize_file_metadata(serialized_metadata.get(), serialized_metadata.size());
         });
     });
 }
 
-seastar::future<file_reader> file_reader::open(std::string path) {
-    return seastar::open_file_dma(path, seastar::open_flags::ro).then(
-    [path] (seastar::file file) {
-        return read_file_metadata(file).then(
-        [path = std::move(path), file] (std::unique_ptr<format::FileMetaData> metadata) {
-            file_reader fr;
-            fr._path = std::move(path);
-            fr._file = std::move(file);
-            fr._metadata = std::move(metadata);
-            return fr;
+// The metadata of a mapped file is deserialized in place.
+std::unique_ptr<format::FileMetaData> file_reader::read_file_metadata(bytes_view file) {
+    check_file_size(file.size());
+    uint32_t metadata_len = parse_footer(file.data() + file.size() - 8, file.size());
+    return deserialize_file_metadata(file.data() + file.size() - 8 - metadata_len, metadata_len);
+}
+
+seastar::future<file_reader> file_reader::open(std::string path, io_options options) {
+    auto open_start = tracing::start();
+    auto sg = options.scheduling_group;
+    return seastar::with_scheduling_group(sg, [path, options = std::move(options), open_start] () mutable {
+        return seastar::open_file_dma(path, seastar::open_flags::ro).then(
+        [path = std::move(path), options = std::move(options), open_start] (seastar::file file) mutable {
+            return should_map(path, options.mmap).then(
+            [path = std::move(path), options = std::move(options), file, open_start] (bool map) mutable {
+                seastar::lw_shared_ptr<const mapped_file> mapping = map ? mapped_file::map(path) : nullptr;
+                auto metadata = mapping
+                        ? seastar::make_ready_future<std::unique_ptr<format::FileMetaData>>(
+                                read_file_metadata(mapping->contents()))
+                        : read_file_metadata(file, options.io_priority_class);
+                return seastar::when_all_succeed(file.stat(), std::move(metadata)).then(
+                [path = std::move(path), options = std::move(options), file, mapping = std::move(mapping), open_start]
+                (struct stat st, std::unique_ptr<format::FileMetaData> metadata) mutable {
+                    if (tracing::enabled()) {
+                        tracing::context ctx{path};
+                        tracing::record(tracing::phase::open, &ctx, -1, 0, 0, open_start);
+                    }
+                    file_reader fr;
+                    fr._path = std::move(path);
+                    fr._file = std::move(file);
+                    fr._mapping = std::move(mapping);
+                    fr._metadata = std::move(metadata);
+                    fr._options = std::move(options);
+                    fr._identity = file_identity::from_stat(st);
+                    return fr;
+                });
+            });
         });
     }).handle_exception([path = std::move(path)] (std::exception_ptr eptr) {
         try {
@@ -84,11 +132,120 @@ seastar::future<file_reader> file_reader::open(std::string path) {
     });
 }
 
+seastar::future<file_reader> file_reader::open(seastar::temporary_buffer<char> contents, io_options options) {
+    auto open_start = tracing::start();
+    auto sg = options.scheduling_group;
+    return seastar::with_scheduling_group(sg, [contents = std::move(contents), options = std::move(options), open_start] () mutable {
+        file_reader fr;
+        fr._mapping = mapped_file::from_buffer(std::move(contents));
+        fr._in_memory = true;
+        fr._metadata = read_file_metadata(fr._mapping->contents());
+        fr._options = std::move(options);
+        if (tracing::enabled()) {
+            tracing::context ctx;
+            tracing::record(tracing::phase::open, &ctx, -1, 0, 0, open_start);
+        }
+        return fr;
+    }).handle_exception([] (std::exception_ptr eptr) {
+        try {
+            std::rethrow_exception(eptr);
+        } catch (const std::exception& e) {
+            return seastar::make_exception_future<file_reader>(parquet_exception(seastar::format(
+                    "Could not open in-memory parquet file for reading: {}", e.what())));
+        }
+    });
+}
+
+seastar::future<file_reader> file_reader::open(std::vector<seastar::temporary_buffer<char>> fragments, io_options options) {
+    if (fragments.size() == 1) {
+        return open(std::move(fragments[0]), std::move(options));
+    }
+    size_t size = 0;
+    for (const seastar::temporary_buffer<char>& f : fragments) {
+        size += f.size();
+    }
+    seastar::temporary_buffer<char> contents(size);
+    size_t offset = 0;
+    for (const seastar::temporary_buffer<char>& f : fragments) {
+        std::memcpy(contents.get_write() + offset, f.get(), f.size());
+        offset += f.size();
+    }
+    return open(std::move(contents), std::move(options));
+}
+
+seastar::future<std::unique_ptr<format::FileMetaData>> file_reader::read_metadata(std::string path, io_options options) {
+    auto sg = options.scheduling_group;
+    auto pc = options.io_priority_class;
+    return seastar::with_scheduling_group(sg, [path, pc] {
+        return seastar::open_file_dma(path, seastar::open_flags::ro).then([pc] (seastar::file file) {
+            return read_file_metadata(file, pc).finally([file] () mutable {
+                return file.close();
+            });
+        });
+    }).handle_exception([path = std::move(path)] (std::exception_ptr eptr) {
+        try {
+            std::rethrow_exception(eptr);
+        } catch (const std::exception& e) {
+            return seastar::make_exception_future<std::unique_ptr<format::FileMetaData>>(parquet_exception(seastar::format(
+                    "Could not read the metadata of parquet file {}: {}", path, e.what())));
+        }
+    });
+}
+
+seastar::future<> file_reader::close() {
+    auto external_files = std::move(_external_files);
+    _external_files.clear();
+    _chunk_indexes.clear();
+    return seastar::do_with(std::move(external_files), [] (auto& external_files) {
+        return seastar::parallel_for_each(external_files, [] (auto& entry) {
+            return entry.second.get_future().then([] (chunk_file f) {
+                return f.file.close();
+            }).handle_exception([] (std::exception_ptr) {
+                // The file failed to open, or to close. Either way, there is nothing left to do.
+            });
+        });
+    }).then([this] {
+        return _in_memory ? seastar::make_ready_future<>() : _file.close();
+    });
+}
+
+// File paths of column chunks are relative to the directory of this file.
+// Each referenced file is opened (and stat'ed, for the caches) only once.
+seastar::future<file_reader::chunk_file> file_reader::open_chunk_file(const format::ColumnChunk& column_chunk) {
+    if (!column_chunk.__isset.file_path) {
+        return seastar::make_ready_future<chunk_file>(chunk_file{_file, _identity});
+    }
+    auto it = _external_files.find(column_chunk.file_path);
+    if (it != _external_files.end() && it->second.available() && it->second.failed()) {
+        // Retry failed opens.
+        _external_files.erase(it);
+        it = _external_files.end();
+    }
+    if (it == _external_files.end()) {
+        std::string path = (std::filesystem::path(_path).parent_path() / column_chunk.file_path).string();
+        seastar::future<chunk_file> f = seastar::open_file_dma(path, seastar::open_flags::ro).then(
+        [] (seastar::file file) {
+            return file.stat().then([file] (struct stat st) {
+                return chunk_file{file, file_identity::from_stat(st)};
+            });
+        }).handle_exception([path] (std::exception_ptr eptr) {
+            try {
+                std::rethrow_exception(eptr);
+            } catch (const std::exception& e) {
+                return seastar::make_exception_future<chunk_file>(parquet_exception(seastar::format(
+                        "Could not open column chunk file {}: {}", path, e.what())));
+            }
+        });
+        it = _external_files.emplace(column_chunk.file_path, std::move(f)).first;
+    }
+    return it->second.get_future();
+}
+
 namespace {
 
-seastar::future<std::unique_ptr<format::ColumnMetaData>> read_chunk_metadata(seastar::input_stream<char> &&s) {
+seastar::future<std::unique_ptr<format::ColumnMetaData>> read_chunk_metadata(peekable_stream&& s) {
     using return_type = seastar::future<std::unique_ptr<format::ColumnMetaData>>;
-    return seastar::do_with(peekable_stream{std::move(s)}, [](peekable_stream &stream) -> return_type {
+    return seastar::do_with(std::move(s), [](peekable_stream &stream) -> return_type {
         auto column_metadata = std::make_unique<format::ColumnMetaData>();
         return read_thrift_from_stream(stream, *column_metadata).then(
         [column_metadata = std::move(column_metadata)](bool read) mutable {
@@ -101,8 +258,66 @@ seastar::future<std::unique_ptr<format::ColumnMetaData>> read_chunk_metadata(sea
     });
 }
 
+// A column chunk reader is admitted with the size of its input stream buffers (none for mapped files).
+// Its other buffers are charged as they are allocated.
+size_t column_chunk_admission_size(const io_options& options, bool mapped) {
+    return mapped ? 0 : options.read_buffer_size * (options.read_ahead + 1);
+}
+
+seastar::future<memory_account> admit_column_chunk_reader(
+        const io_options& options, bool mapped, std::optional<memory_account> admitted) {
+    if (admitted) {
+        return seastar::make_ready_future<memory_account>(std::move(*admitted));
+    }
+    if (!options.memory) {
+        return seastar::make_ready_future<memory_account>();
+    }
+    return options.memory->admit(column_chunk_admission_size(options, mapped));
+}
+
 } // namespace
 
+// A stream over `length` bytes of the file, from `offset`. Views the mapping of the file, if any.
+peekable_stream file_reader::open_stream(seastar::file f, bool mapped, uint64_t offset, uint64_t length,
+        const io_options& options) const {
+    if (mapped) {
+        if (offset > _mapping->size() || length > _mapping->size() - offset) {
+            throw parquet_exception::corrupted_file(seastar::format(
+                    "Column chunk range ({}B at offset {}) exceeds file size ({}B)", length, offset, _mapping->size()));
+        }
+        return peekable_stream{_mapping, _mapping->contents().substr(offset, length)};
+    }
+    return peekable_stream{seastar::make_file_input_stream(f, offset, length, options.input_stream_options())};
+}
+
+seastar::future<seastar::temporary_buffer<uint8_t>> file_reader::read_bytes(
+        seastar::file f, bool mapped, uint64_t offset, uint64_t length, const io_options& options) const {
+    if (mapped) {
+        if (offset > _mapping->size() || length > _mapping->size() - offset) {
+            return seastar::make_exception_future<seastar::temporary_buffer<uint8_t>>(
+                    parquet_exception::corrupted_file(seastar::format(
+                            "Range of {}B at offset {} exceeds file size ({}B)", length, offset, _mapping->size())));
+        }
+        return seastar::make_ready_future<seastar::temporary_buffer<uint8_t>>(
+                seastar::temporary_buffer<uint8_t>(_mapping->contents().data() + offset, length));
+    }
+    return f.dma_read_exactly<uint8_t>(offset, length, options.io_priority_class);
+}
+
+seastar::lw_shared_ptr<const tracing::context> file_reader::trace_context(const reader_schema::raw_node& leaf) const {
+    if (!tracing::enabled()) {
+        return {};
+    }
+    std::string column;
+    for (const std::string& part : leaf.path) {
+        if (!column.empty()) {
+            column += '.';
+        }
+        column += part;
+    }
+    return tracing::make_context(_path, std::move(column));
+}
+
 /* ColumnMetaData is a structure that has to be read in order to find the beginning of a column chunk.
  * It is written directly after the chunk it describes, and its offset is saved to the FileMetaData.
  * Optionally, the entire ColumnMetaData might be embedded in the FileMetaData.
@@ -111,77 +326,981 @@ seastar::future<std::unique_ptr<format::ColumnMetaData>> read_chunk_metadata(sea
  * One of the tests in parquet-testing also gets this wrong (the offset saved in FileMetaData points to something
  * different than ColumnMetaData), so I'm not sure whether this entire function is needed.
  */
-template <format::Type::type T>
-seastar::future<column_chunk_reader<T>>
-file_reader::open_column_chunk_reader_internal(uint32_t row_group, uint32_t column) {
+seastar::future<std::unique_ptr<format::ColumnMetaData>> file_reader::read_column_metadata(
+        const format::ColumnChunk& column_chunk, seastar::file f, bool mapped, const io_options& options) const {
+    if (column_chunk.__isset.meta_data) {
+        return seastar::make_ready_future<std::unique_ptr<format::ColumnMetaData>>(
+                std::make_unique<format::ColumnMetaData>(column_chunk.meta_data));
+    } else if (mapped) {
+        uint64_t length = _mapping->size() - std::min<uint64_t>(column_chunk.file_offset, _mapping->size());
+        return read_chunk_metadata(open_stream(f, mapped, column_chunk.file_offset, length, options));
+    } else {
+        return read_chunk_metadata(peekable_stream{
+                seastar::make_file_input_stream(f, column_chunk.file_offset, options.input_stream_options())});
+    }
+}
+
+template <format::Type::type T, typename ValueDecoder>
+seastar::future<column_chunk_reader<T, ValueDecoder>> file_reader::open_column_chunk_reader_internal(
+        uint32_t row_group, uint32_t column, const io_options& options, std::optional<page_range> range,
+        std::optional<memory_account> admitted) {
     assert(column < raw_schema().leaves.size());
     assert(row_group < metadata().row_groups.size());
     if (column >= metadata().row_groups[row_group].columns.size()) {
-        return seastar::make_exception_future<column_chunk_reader<T>>(
+        return seastar::make_exception_future<column_chunk_reader<T, ValueDecoder>>(
                 parquet_exception::corrupted_file(seastar::format(
                         "Selected column metadata is missing from row group metadata: {}",
                         metadata().row_groups[row_group])));
     }
     const format::ColumnChunk& column_chunk = metadata().row_groups[row_group].columns[column];
     const reader_schema::raw_node& leaf = *raw_schema().leaves[column];
-    return [this, &column_chunk] {
-        if (!column_chunk.__isset.file_path) {
-            return seastar::make_ready_future<seastar::file>(file());
-        } else {
-            return seastar::open_file_dma(path() + column_chunk.file_path, seastar::open_flags::ro);
-        }
-    }().then([&column_chunk, &leaf] (seastar::file f) {
-        return [&column_chunk, f] {
-            if (column_chunk.__isset.meta_data) {
-                return seastar::make_ready_future<std::unique_ptr<format::ColumnMetaData>>(
-                        std::make_unique<format::ColumnMetaData>(column_chunk.meta_data));
-            } else {
-                return read_chunk_metadata(seastar::make_file_input_stream(f, column_chunk.file_offset, {8192, 16}));
-            }
-        }().then([f, &leaf] (std::unique_ptr<format::ColumnMetaData> column_metadata) {
-            size_t file_offset = column_metadata->__isset.dictionary_page_offset
-                                 ? column_metadata->dictionary_page_offset
-                                 : column_metadata->data_page_offset;
+    if (_in_memory && column_chunk.__isset.file_path) {
+        return seastar::make_exception_future<column_chunk_reader<T, ValueDecoder>>(parquet_exception(seastar::format(
+                "Column chunk {} in row group {} is stored in file {}, which cannot be read from an in-memory file",
+                column, row_group, column_chunk.file_path)));
+    }
+    // Chunks in other files are read through DMA streams.
+    bool mapped = _mapping && !column_chunk.__isset.file_path;
+    return admit_column_chunk_reader(options, mapped, std::move(admitted)).then(
+    [this, &column_chunk, &leaf, options, mapped, range] (memory_account memory) mutable {
+        return open_chunk_file(column_chunk).then(
+        [this, &column_chunk, &leaf, options, mapped, range, memory = std::move(memory)] (chunk_file cf) mutable {
+            seastar::file f = cf.file;
+            return read_column_metadata(column_chunk, f, mapped, options).then(
+            [this, f, identity = cf.identity, &leaf, options, mapped, range, memory = std::move(memory)]
+            (std::unique_ptr<format::ColumnMetaData> column_metadata) mutable {
+                size_t file_offset = column_metadata->__isset.dictionary_page_offset
+                                     ? column_metadata->dictionary_page_offset
+                                     : column_metadata->data_page_offset;
+                uint64_t length = column_metadata->total_compressed_size;
+                if (range) {
+                    if (range->begin > range->end || range->end > length) {
+                        throw parquet_exception(seastar::format(
+                                "Page range [{}, {}) exceeds the column chunk ({}B)", range->begin, range->end, length));
+                    }
+                    length = range->end;
+                }
 
-            return column_chunk_reader<T>{
-                    page_reader{seastar::make_file_input_stream(f, file_offset, column_metadata->total_compressed_size, {8192, 16})},
-                    column_metadata->codec,
-                    leaf.def_level,
-                    leaf.rep_level,
-                    (leaf.info.__isset.type_length ? std::optional<uint32_t>(leaf.info.type_length) : std::optional<uint32_t>{})};
+                column_chunk_reader<T, ValueDecoder> reader{
+                        page_reader{
+                                open_stream(f, mapped, file_offset, length, options),
+                                trace_context(leaf)},
+                        column_metadata->codec,
+                        leaf.def_level,
+                        leaf.rep_level,
+                        (leaf.info.__isset.type_length ? std::optional<uint32_t>(leaf.info.type_length) : std::optional<uint32_t>{}),
+                        options.scheduling_group,
+                        std::move(memory)};
+                if (range) {
+                    reader.skip_to(range->begin, range->dictionary_size);
+                }
+                if (identity) {
+                    if (options.use_page_cache) {
+                        reader.use_page_cache(column_chunk_id{*identity, file_offset});
+                    }
+                    if (options.use_dictionary_cache) {
+                        reader.use_dictionary_cache(column_chunk_id{*identity, file_offset});
+                    }
+                }
+                return reader;
+            });
         });
     });
 }
 
-template <format::Type::type T>
-seastar::future<column_chunk_reader<T>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column) {
-    return open_column_chunk_reader_internal<T>(row_group, column).handle_exception(
+template <format::Type::type T, typename ValueDecoder>
+seastar::future<column_chunk_reader<T, ValueDecoder>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options) {
+    return open_column_chunk_reader_internal<T, ValueDecoder>(row_group, column, options, std::nullopt).handle_exception(
     [column, row_group] (std::exception_ptr eptr) {
         try {
             std::rethrow_exception(eptr);
         } catch (const std::exception& e) {
-            return seastar::make_exception_future<column_chunk_reader<T>>(parquet_exception(seastar::format(
+            return seastar::make_exception_future<column_chunk_reader<T, ValueDecoder>>(parquet_exception(seastar::format(
+                    "Could not open column chunk {} in row group {}: {}", column, row_group, e.what())));
+        }
+    });
+}
+
+template <format::Type::type T, typename ValueDecoder>
+seastar::future<column_chunk_reader<T, ValueDecoder>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory) {
+    return open_column_chunk_reader_internal<T, ValueDecoder>(row_group, column, options, std::nullopt, std::move(memory))
+    .handle_exception([column, row_group] (std::exception_ptr eptr) {
+        try {
+            std::rethrow_exception(eptr);
+        } catch (const std::exception& e) {
+            return seastar::make_exception_future<column_chunk_reader<T, ValueDecoder>>(parquet_exception(seastar::format(
                     "Could not open column chunk {} in row group {}: {}", column, row_group, e.what())));
         }
     });
 }
 
+size_t file_reader::admission_size(uint32_t row_group, uint32_t column, const io_options& options) const {
+    bool external = row_group < metadata().row_groups.size()
+            && column < metadata().row_groups[row_group].columns.size()
+            && metadata().row_groups[row_group].columns[column].__isset.file_path;
+    return column_chunk_admission_size(options, _mapping && !external);
+}
+
+template <format::Type::type T, typename ValueDecoder>
+seastar::future<column_chunk_reader<T, ValueDecoder>>
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options) {
+    return open_column_chunk_reader_internal<T, ValueDecoder>(range.row_group, range.column, options, range).handle_exception(
+    [range] (std::exception_ptr eptr) {
+        try {
+            std::rethrow_exception(eptr);
+        } catch (const std::exception& e) {
+            return seastar::make_exception_future<column_chunk_reader<T, ValueDecoder>>(parquet_exception(seastar::format(
+                    "Could not open page range [{}, {}) of column chunk {} in row group {}: {}",
+                    range.begin, range.end, range.column, range.row_group, e.what())));
+        }
+    });
+}
+
+namespace {
+
+// A data page of a column chunk.
+struct page_location {
+    uint64_t offset; // Relative to the beginning of the chunk.
+    int64_t first_row;
+};
+
+std::vector<page_location> deserialize_offset_index(
+        const uint8_t* data, uint32_t size, uint64_t chunk_offset, uint64_t chunk_size) {
+    format::OffsetIndex index;
+    deserialize_thrift_msg(data, size, index);
+    std::vector<page_location> pages;
+    for (const format::PageLocation& location : index.page_locations) {
+        if (location.offset < 0
+                || static_cast<uint64_t>(location.offset) < chunk_offset
+                || static_cast<uint64_t>(location.offset) - chunk_offset >= chunk_size) {
+            throw parquet_exception::corrupted_file(seastar::format(
+                    "Page location outside of its column chunk in OffsetIndex: {}", location));
+        }
+        page_location page{static_cast<uint64_t>(location.offset) - chunk_offset, location.first_row_index};
+        if (!pages.empty() && (page.offset <= pages.back().offset || page.first_row < pages.back().first_row)) {
+            throw parquet_exception::corrupted_file(seastar::format("Unordered page locations in OffsetIndex: {}", index));
+        }
+        pages.push_back(page);
+    }
+    return pages;
+}
+
+// Finds the data pages by reading only their headers.
+seastar::future<std::vector<page_location>> skim_page_headers(peekable_stream&& stream, uint64_t chunk_size) {
+    return seastar::do_with(page_reader{std::move(stream)}, std::vector<page_location>(), int64_t(0),
+    [chunk_size] (page_reader& pages_source, std::vector<page_location>& pages, int64_t& rows) {
+        return seastar::repeat([&pages_source, &pages, &rows, chunk_size] {
+            uint64_t position = pages_source.position();
+            return pages_source.next_page_header().then(
+            [&pages_source, &pages, &rows, chunk_size, position] (const format::PageHeader* header) {
+                if (!header) {
+                    return seastar::stop_iteration::yes;
+                }
+                if (pages_source.position() > chunk_size) {
+                    throw parquet_exception::corrupted_file(seastar::format(
+                            "Page at offset {} ends beyond its column chunk ({}B)", position, chunk_size));
+                }
+                if (header->type == format::PageType::DATA_PAGE) {
+                    pages.push_back(page_location{position, rows});
+                    rows += header->data_page_header.num_values;
+                } else if (header->type == format::PageType::DATA_PAGE_V2) {
+                    pages.push_back(page_location{position, rows});
+                    rows += header->data_page_header_v2.num_rows;
+                }
+                return seastar::stop_iteration::no;
+            });
+        }).then([&pages] {
+            return std::move(pages);
+        });
+    });
+}
+
+// The size of the dictionary page at the beginning of the chunk, i.e. of everything before the
+// first data page. Some writers don't set dictionary_page_offset, so the metadata is only used
+// when the data pages are unknown.
+uint64_t dictionary_page_size(const format::ColumnMetaData& column_metadata, const std::vector<page_location>& pages) {
+    if (!pages.empty()) {
+        return pages.front().offset;
+    }
+    return column_metadata.__isset.dictionary_page_offset
+           ? column_metadata.data_page_offset - column_metadata.dictionary_page_offset
+           : 0;
+}
+
+// Cuts the chunk at the pages closest to equal shares of its data pages.
+std::vector<page_range> make_page_ranges(uint32_t row_group, uint32_t column, const std::vector<page_location>& pages,
+        uint64_t dictionary_size, uint64_t chunk_size, int64_t num_rows, size_t max_ranges) {
+    if (pages.empty()) {
+        return {page_range{row_group, column, dictionary_size, chunk_size, dictionary_size, 0, num_rows}};
+    }
+    size_t n_ranges = std::clamp<size_t>(max_ranges, 1, pages.size());
+    uint64_t data_begin = pages.front().offset;
+    uint64_t data_size = chunk_size - data_begin;
+    std::vector<page_range> ranges;
+    size_t first = 0;
+    size_t next = 1;
+    for (size_t k = 1; k < n_ranges; ++k) {
+        uint64_t target = data_begin + data_size * k / n_ranges;
+        while (next < pages.size() && pages[next].offset < target) {
+            ++next;
+        }
+        if (next == pages.size()) {
+            break;
+        }
+        ranges.push_back(page_range{row_group, column, pages[first].offset, pages[next].offset, dictionary_size,
+                pages[first].first_row, pages[next].first_row - pages[first].first_row});
+        first = next++;
+    }
+    ranges.push_back(page_range{row_group, column, pages[first].offset, chunk_size, dictionary_size,
+            pages[first].first_row, num_rows - pages[first].first_row});
+    return ranges;
+}
+
+// One range per page.
+std::vector<page_range> make_single_page_ranges(uint32_t row_group, uint32_t column,
+        const std::vector<page_location>& pages, uint64_t dictionary_size, uint64_t chunk_size, int64_t num_rows) {
+    std::vector<page_range> ranges;
+    ranges.reserve(pages.size());
+    for (size_t i = 0; i < pages.size(); ++i) {
+        uint64_t end = i + 1 < pages.size() ? pages[i + 1].offset : chunk_size;
+        int64_t next_row = i + 1 < pages.size() ? pages[i + 1].first_row : num_rows;
+        ranges.push_back(page_range{row_group, column, pages[i].offset, end, dictionary_size,
+                pages[i].first_row, next_row - pages[i].first_row});
+    }
+    return ranges;
+}
+
+seastar::future<std::optional<bloom_filter>> read_bloom_filter(peekable_stream&& s) {
+    return seastar::do_with(std::move(s), format::BloomFilterHeader{},
+    [] (peekable_stream& stream, format::BloomFilterHeader& header) {
+        return read_thrift_from_stream(stream, header).then([&stream, &header] (bool read) {
+            if (!read) {
+                throw parquet_exception::corrupted_file("Could not deserialize BloomFilterHeader: empty stream");
+            }
+            if (!bloom_filter::supported(header)) {
+                return seastar::make_ready_future<std::optional<bloom_filter>>();
+            }
+            if (header.numBytes <= 0 || static_cast<size_t>(header.numBytes) > bloom_filter::max_size) {
+                throw parquet_exception::corrupted_file(seastar::format(
+                        "Bloom filter size out of range: {}B", header.numBytes));
+            }
+            return stream.peek(header.numBytes).then([&header] (bytes_view bitset) {
+                if (bitset.size() < static_cast<size_t>(header.numBytes)) {
+                    throw parquet_exception::corrupted_file(seastar::format(
+                            "Bloom filter ({}B) ends beyond the end of file", header.numBytes));
+                }
+                return std::optional<bloom_filter>(bloom_filter{bitset});
+            });
+        });
+    });
+}
+
+void check_column_index(const format::ColumnIndex& index) {
+    size_t n_pages = index.null_pages.size();
+    if (index.min_values.size() != n_pages || index.max_values.size() != n_pages
+            || (index.__isset.null_counts && index.null_counts.size() != n_pages)) {
+        throw parquet_exception::corrupted_file(seastar::format(
+                "Lists of different lengths in ColumnIndex: {}", index));
+    }
+}
+
+// Whether the key is a value of the physical type (see scalar).
+bool key_fits(format::Type::type type, const scalar& key) {
+    switch (type) {
+    case format::Type::BOOLEAN: return std::holds_alternative<bool>(key);
+    case format::Type::INT32: return std::holds_alternative<int32_t>(key);
+    case format::Type::INT64: return std::holds_alternative<int64_t>(key);
+    case format::Type::FLOAT: return std::holds_alternative<float>(key);
+    case format::Type::DOUBLE: return std::holds_alternative<double>(key);
+    case format::Type::BYTE_ARRAY: return std::holds_alternative<bytes>(key);
+    case format::Type::FIXED_LEN_BYTE_ARRAY: return std::holds_alternative<bytes>(key);
+    default: return false;
+    }
+}
+
+// The key as compared by filter::compare_values with values of the physical type.
+template <format::Type::type T>
+auto filter_key(const scalar& key) {
+    if constexpr (T == format::Type::BOOLEAN) {
+        return uint8_t(std::get<bool>(key));
+    } else if constexpr (T == format::Type::INT32) {
+        return std::get<int32_t>(key);
+    } else if constexpr (T == format::Type::INT64) {
+        return std::get<int64_t>(key);
+    } else if constexpr (T == format::Type::FLOAT) {
+        return std::get<float>(key);
+    } else if constexpr (T == format::Type::DOUBLE) {
+        return std::get<double>(key);
+    } else {
+        return bytes_view{std::get<bytes>(key)};
+    }
+}
+
+// Negative, zero or positive as a decoded value is less than, equal to or greater than a key given by filter_key.
+template <typename Value, typename Key>
+int compare_value(const Value& value, const Key& key, sort_order order) {
+    if constexpr (std::is_same_v<Value, seastar::temporary_buffer<uint8_t>>) {
+        int c = bytes_view{value.get(), value.size()}.compare(key);
+        return (c > 0) - (c < 0);
+    } else if constexpr (std::is_same_v<Value, int32_t> || std::is_same_v<Value, int64_t>) {
+        if (order == sort_order::UNSIGNED) {
+            using unsigned_type = std::make_unsigned_t<Value>;
+            unsigned_type a = value;
+            unsigned_type b = key;
+            return (a > b) - (a < b);
+        }
+        return (value > key) - (value < key);
+    } else {
+        return (value > key) - (value < key);
+    }
+}
+
+// Whether a comparison result puts the value before the key in the given direction.
+bool ordered_before(int comparison, sort_direction direction) {
+    return direction == sort_direction::ascending ? comparison < 0 : comparison > 0;
+}
+
+// The Bloom filter hashes of the values equal to the key. -0.0 and 0.0 are equal,
+// but the PLAIN encodings which are hashed differ, so both are probed.
+std::vector<uint64_t> bloom_filter_hashes(const scalar& key) {
+    if (const float* x = std::get_if<float>(&key); x && *x == 0) {
+        return {bloom_filter_hash(scalar{0.0f}), bloom_filter_hash(scalar{-0.0f})};
+    }
+    if (const double* x = std::get_if<double>(&key); x && *x == 0) {
+        return {bloom_filter_hash(scalar{0.0}), bloom_filter_hash(scalar{-0.0})};
+    }
+    return {bloom_filter_hash(key)};
+}
+
+// The pages whose ColumnIndex bounds admit the key, with adjacent pages merged into one range.
+std::vector<page_range> prune_pages(const chunk_index& index, format::Type::type type, sort_order order,
+        const scalar& key) {
+    const std::vector<page_range>& pages = index.pages;
+    const format::ColumnIndex* column_index = index.column_index ? &*index.column_index : nullptr;
+    if (column_index && column_index->null_pages.size() != pages.size()) {
+        // The chunk has no OffsetIndex, so the pages of the ColumnIndex can't be located.
+        column_index = nullptr;
+    }
+    std::vector<page_range> ranges;
+    for (size_t i = 0; i < pages.size(); ++i) {
+        if (column_index) {
+            if (column_index->null_pages[i]) {
+                continue;
+            }
+            if (order != sort_order::UNKNOWN) {
+                std::optional<scalar> min = decode_scalar(type, column_index->min_values[i]);
+                std::optional<scalar> max = decode_scalar(type, column_index->max_values[i]);
+                if ((min && compare(key, *min, order) < 0) || (max && compare(key, *max, order) > 0)) {
+                    continue;
+                }
+            }
+        }
+        if (!ranges.empty() && ranges.back().end == pages[i].begin) {
+            ranges.back().end = pages[i].end;
+            ranges.back().num_rows += pages[i].num_rows;
+        } else {
+            ranges.push_back(pages[i]);
+        }
+    }
+    return ranges;
+}
+
+} // namespace
+
+seastar::future<std::vector<page_range>>
+file_reader::split_column_chunk(uint32_t row_group, uint32_t column, size_t max_ranges, const io_options& options) {
+    if (row_group >= metadata().row_groups.size() || column >= raw_schema().leaves.size()
+            || column >= metadata().row_groups[row_group].columns.size()) {
+        return seastar::make_exception_future<std::vector<page_range>>(parquet_exception(seastar::format(
+                "No column chunk {} in row group {}", column, row_group)));
+    }
+    const format::ColumnChunk& column_chunk = metadata().row_groups[row_group].columns[column];
+    if (_in_memory && column_chunk.__isset.file_path) {
+        return seastar::make_exception_future<std::vector<page_range>>(parquet_exception(seastar::format(
+                "Column chunk {} in row group {} is stored in file {}, which cannot be read from an in-memory file",
+                column, row_group, column_chunk.file_path)));
+    }
+    bool repeated = raw_schema().leaves[column]->rep_level > 0;
+    int64_t num_rows = metadata().row_groups[row_group].num_rows;
+    bool mapped = _mapping && !column_chunk.__isset.file_path;
+    return open_chunk_file(column_chunk).then(
+    [this, &column_chunk, row_group, column, max_ranges, repeated, num_rows, mapped, options] (chunk_file cf) {
+        seastar::file f = cf.file;
+        return read_column_metadata(column_chunk, f, mapped, options).then(
+        [this, &column_chunk, f, row_group, column, max_ranges, repeated, num_rows, mapped, options]
+        (std::unique_ptr<format::ColumnMetaData> column_metadata) mutable {
+            uint64_t chunk_offset = column_metadata->__isset.dictionary_page_offset
+                                    ? column_metadata->dictionary_page_offset
+                                    : column_metadata->data_page_offset;
+            uint64_t chunk_size = column_metadata->total_compressed_size;
+            auto pages = [&] {
+                using return_type = seastar::future<std::vector<page_location>>;
+                if (column_chunk.__isset.offset_index_offset && column_chunk.__isset.offset_index_length) {
+                    return read_bytes(f, mapped, column_chunk.offset_index_offset, column_chunk.offset_index_length, options).then(
+                    [chunk_offset, chunk_size] (seastar::temporary_buffer<uint8_t> serialized) {
+                        return deserialize_offset_index(serialized.get(), serialized.size(), chunk_offset, chunk_size);
+                    });
+                } else if (repeated) {
+                    return return_type(seastar::make_ready_future<std::vector<page_location>>());
+                } else {
+                    return skim_page_headers(open_stream(f, mapped, chunk_offset, chunk_size, options), chunk_size);
+                }
+            }();
+            return pages.then([row_group, column, chunk_size, num_rows, max_ranges,
+                    column_metadata = std::move(column_metadata)] (std::vector<page_location> pages) {
+                uint64_t dictionary_size = dictionary_page_size(*column_metadata, pages);
+                return make_page_ranges(row_group, column, pages, dictionary_size, chunk_size, num_rows, max_ranges);
+            });
+        });
+    });
+}
+
+seastar::future<chunk_index> file_reader::load_chunk_index(uint32_t row_group, uint32_t column, const io_options& options) {
+    const format::ColumnChunk& column_chunk = metadata().row_groups[row_group].columns[column];
+    if (_in_memory && column_chunk.__isset.file_path) {
+        return seastar::make_exception_future<chunk_index>(parquet_exception(seastar::format(
+                "Column chunk {} in row group {} is stored in file {}, which cannot be read from an in-memory file",
+                column, row_group, column_chunk.file_path)));
+    }
+    int64_t num_rows = metadata().row_groups[row_group].num_rows;
+    bool mapped = _mapping && !column_chunk.__isset.file_path;
+    return open_chunk_file(column_chunk).then([this, &column_chunk, row_group, column, num_rows, mapped, options] (chunk_file cf) {
+        seastar::file f = cf.file;
+        return read_column_metadata(column_chunk, f, mapped, options).then(
+        [this, &column_chunk, f, row_group, column, num_rows, mapped, options]
+        (std::unique_ptr<format::ColumnMetaData> column_metadata) {
+            uint64_t chunk_offset = column_metadata->__isset.dictionary_page_offset
+                                    ? column_metadata->dictionary_page_offset
+                                    : column_metadata->data_page_offset;
+            uint64_t chunk_size = column_metadata->total_compressed_size;
+            // Without an OffsetIndex, the single range starts at the beginning of the chunk when
+            // dictionary_page_offset is unset, so a dictionary page is still read.
+            uint64_t dictionary_size = dictionary_page_size(*column_metadata, {});
+            std::optional<uint64_t> filter_offset;
+            if (column_metadata->__isset.bloom_filter_offset) {
+                filter_offset = column_metadata->bloom_filter_offset;
+            }
+            return seastar::do_with(chunk_index{}, [this, &column_chunk, f, row_group, column, num_rows, mapped, options,
+                    chunk_offset, chunk_size, dictionary_size, filter_offset] (chunk_index& index) {
+                auto read_filter = [&] {
+                    if (!filter_offset) {
+                        return seastar::make_ready_future<>();
+                    }
+                    peekable_stream stream = mapped
+                            ? open_stream(f, mapped, *filter_offset,
+                                    _mapping->size() - std::min<uint64_t>(*filter_offset, _mapping->size()), options)
+                            : peekable_stream{seastar::make_file_input_stream(
+                                    f, *filter_offset, options.input_stream_options())};
+                    return read_bloom_filter(std::move(stream)).then([&index] (std::optional<bloom_filter> filter) {
+                        index.filter = std::move(filter);
+                    });
+                };
+                auto read_column_index = [this, &column_chunk, &index, f, mapped, options] {
+                    if (!column_chunk.__isset.column_index_offset || !column_chunk.__isset.column_index_length) {
+                        return seastar::make_ready_future<>();
+                    }
+                    return read_bytes(f, mapped, column_chunk.column_index_offset, column_chunk.column_index_length, options).then(
+                    [&index] (seastar::temporary_buffer<uint8_t> serialized) {
+                        format::ColumnIndex column_index;
+                        deserialize_thrift_msg(serialized.get(), serialized.size(), column_index);
+                        check_column_index(column_index);
+                        index.column_index = std::move(column_index);
+                    });
+                };
+                auto read_offset_index = [this, &column_chunk, &index, f, row_group, column, num_rows, mapped, options,
+                        chunk_offset, chunk_size, dictionary_size] {
+                    if (!column_chunk.__isset.offset_index_offset || !column_chunk.__isset.offset_index_length) {
+                        index.pages = {page_range{row_group, column, dictionary_size, chunk_size, dictionary_size, 0, num_rows}};
+                        return seastar::make_ready_future<>();
+                    }
+                    return read_bytes(f, mapped, column_chunk.offset_index_offset, column_chunk.offset_index_length, options).then(
+                    [&index, row_group, column, num_rows, chunk_offset, chunk_size, dictionary_size]
+                    (seastar::temporary_buffer<uint8_t> serialized) {
+                        std::vector<page_location> pages = deserialize_offset_index(
+                                serialized.get(), serialized.size(), chunk_offset, chunk_size);
+                        if (index.column_index && index.column_index->null_pages.size() != pages.size()) {
+                            throw parquet_exception::corrupted_file(seastar::format(
+                                    "ColumnIndex lists {} pages, and OffsetIndex {}",
+                                    index.column_index->null_pages.size(), pages.size()));
+                        }
+                        // Everything before the first data page is the dictionary page (see dictionary_page_size).
+                        index.pages = pages.empty()
+                                ? std::vector<page_range>{page_range{
+                                        row_group, column, dictionary_size, chunk_size, dictionary_size, 0, num_rows}}
+                                : make_single_page_ranges(row_group, column, pages, pages.front().offset,
+                                        chunk_size, num_rows);
+                    });
+                };
+                return read_filter().then(read_column_index).then(read_offset_index).then([&index] {
+                    return std::move(index);
+                });
+            });
+        });
+    });
+}
+
+seastar::future<seastar::lw_shared_ptr<const chunk_index>>
+file_reader::read_chunk_index(uint32_t row_group, uint32_t column, const io_options& options) {
+    if (row_group >= metadata().row_groups.size() || column >= raw_schema().leaves.size()
+            || column >= metadata().row_groups[row_group].columns.size()) {
+        return seastar::make_exception_future<seastar::lw_shared_ptr<const chunk_index>>(parquet_exception(seastar::format(
+                "No column chunk {} in row group {}", column, row_group)));
+    }
+    auto it = _chunk_indexes.find({row_group, column});
+    if (it != _chunk_indexes.end() && it->second.available() && it->second.failed()) {
+        // Retry failed reads.
+        _chunk_indexes.erase(it);
+        it = _chunk_indexes.end();
+    }
+    if (it == _chunk_indexes.end()) {
+        seastar::future<seastar::lw_shared_ptr<const chunk_index>> f = load_chunk_index(row_group, column, options).then(
+        [] (chunk_index index) {
+            return seastar::make_lw_shared<const chunk_index>(std::move(index));
+        }).handle_exception([row_group, column] (std::exception_ptr eptr) {
+            try {
+                std::rethrow_exception(eptr);
+            } catch (const std::exception& e) {
+                return seastar::make_exception_future<seastar::lw_shared_ptr<const chunk_index>>(parquet_exception(
+                        seastar::format("Could not read the indexes of column chunk {} in row group {}: {}",
+                                column, row_group, e.what())));
+            }
+        });
+        it = _chunk_indexes.emplace(std::make_pair(row_group, column), std::move(f)).first;
+    }
+    return it->second.get_future();
+}
+
+template <format::Type::type T>
+seastar::future<> file_reader::find_in_pages(uint32_t row_group, uint32_t column, std::vector<page_range> ranges,
+        const scalar& key, std::vector<row_position>& found) {
+    using reader_type = column_chunk_reader<T>;
+    using output_type = typename reader_type::output_type;
+    constexpr size_t batch_size = 1024;
+    uint32_t max_def_level = raw_schema().leaves[column]->def_level;
+    return seastar::do_with(std::move(ranges), [this, row_group, &key, &found, max_def_level]
+    (std::vector<page_range>& ranges) {
+        return seastar::do_for_each(ranges, [this, row_group, &key, &found, max_def_level] (const page_range& range) {
+            return open_column_chunk_reader<T>(range).then([row_group, &key, &found, max_def_level, &range]
+            (reader_type reader) {
+                struct scan_state {
+                    // Not moved once it has read pages, since values may view its buffers.
+                    std::unique_ptr<reader_type> reader;
+                    int64_t row;
+                    std::vector<int16_t> def = std::vector<int16_t>(batch_size);
+                    std::vector<int16_t> rep = std::vector<int16_t>(batch_size);
+                    std::vector<output_type> values = std::vector<output_type>(batch_size);
+                };
+                return seastar::do_with(scan_state{std::make_unique<reader_type>(std::move(reader)), range.first_row},
+                [row_group, &key, &found, max_def_level] (scan_state& state) {
+                    return seastar::repeat([row_group, &key, &found, max_def_level, &state] {
+                        return state.reader->read_batch(batch_size, state.def.data(), state.rep.data(), state.values.data()).then(
+                        [row_group, &key, &found, max_def_level, &state] (size_t levels_read) {
+                            if (levels_read == 0) {
+                                return seastar::stop_iteration::yes;
+                            }
+                            // Each level is a row, since the column is not repeated.
+                            filter::selection matches = filter::compare_batch(state.values.data(), state.def.data(),
+                                    levels_read, max_def_level, filter::compare_op::eq, filter_key<T>(key));
+                            matches.for_each([&] (size_t i) {
+                                found.push_back(row_position{row_group, state.row + static_cast<int64_t>(i)});
+                            });
+                            state.row += levels_read;
+                            return seastar::stop_iteration::no;
+                        });
+                    });
+                });
+            });
+        });
+    });
+}
+
+seastar::future<std::vector<row_position>> file_reader::lookup(uint32_t column, const scalar& key) {
+    return seastar::futurize_invoke([this, column, key] {
+        if (column >= raw_schema().leaves.size()) {
+            throw parquet_exception(seastar::format("Column {} out of range (0 to {})", column, raw_schema().leaves.size()));
+        }
+        const reader_schema::raw_node& leaf = *raw_schema().leaves[column];
+        if (leaf.rep_level > 0) {
+            throw parquet_exception(seastar::format("Lookups in repeated column {} are unsupported", column));
+        }
+        format::Type::type type = leaf.info.type;
+        if (!key_fits(type, key)) {
+            throw parquet_exception(seastar::format(
+                    "The lookup key does not match the physical type of column {} ({})", column, type));
+        }
+        if (!decode_scalar(type, encode_scalar(key))) {
+            // NaN, which equals nothing.
+            return seastar::make_ready_future<std::vector<row_position>>();
+        }
+        struct lookup_state {
+            scalar key;
+            std::vector<uint64_t> hashes;
+            bool type_defined_order;
+            std::vector<row_position> found;
+        };
+        return seastar::do_with(lookup_state{key, bloom_filter_hashes(key), has_type_defined_order(metadata(), column)},
+        [this, column, &leaf, type] (lookup_state& state) {
+            using it = boost::counting_iterator<uint32_t>;
+            return seastar::do_for_each(it(0), it(metadata().row_groups.size()),
+            [this, column, &leaf, type, &state] (uint32_t row_group) {
+                if (column >= metadata().row_groups[row_group].columns.size()) {
+                    throw parquet_exception::corrupted_file(seastar::format(
+                            "Selected column metadata is missing from row group metadata: {}",
+                            metadata().row_groups[row_group]));
+                }
+                const format::ColumnChunk& column_chunk = metadata().row_groups[row_group].columns[column];
+                sort_order order = column_sort_order(leaf.info);
+                if (column_chunk.__isset.meta_data) {
+                    column_statistics stats = read_statistics(column_chunk.meta_data, leaf.info, state.type_defined_order);
+                    if (!may_match(stats, predicate{column, predicate::op::eq, state.key})) {
+                        return seastar::make_ready_future<>();
+                    }
+                }
+                return read_chunk_index(row_group, column).then(
+                [this, row_group, column, type, order, &state] (seastar::lw_shared_ptr<const chunk_index> index) {
+                    if (index->filter && std::none_of(state.hashes.begin(), state.hashes.end(),
+                            [&index] (uint64_t hash) { return index->filter->find(hash); })) {
+                        return seastar::make_ready_future<>();
+                    }
+                    std::vector<page_range> ranges = prune_pages(*index, type, order, state.key);
+                    switch (type) {
+                    case format::Type::BOOLEAN:
+                        return find_in_pages<format::Type::BOOLEAN>(row_group, column, std::move(ranges), state.key, state.found);
+                    case format::Type::INT32:
+                        return find_in_pages<format::Type::INT32>(row_group, column, std::move(ranges), state.key, state.found);
+                    case format::Type::INT64:
+                        return find_in_pages<format::Type::INT64>(row_group, column, std::move(ranges), state.key, state.found);
+                    case format::Type::FLOAT:
+                        return find_in_pages<format::Type::FLOAT>(row_group, column, std::move(ranges), state.key, state.found);
+                    case format::Type::DOUBLE:
+                        return find_in_pages<format::Type::DOUBLE>(row_group, column, std::move(ranges), state.key, state.found);
+                    case format::Type::BYTE_ARRAY:
+                        return find_in_pages<format::Type::BYTE_ARRAY>(
+                                row_group, column, std::move(ranges), state.key, state.found);
+                    default:
+                        return find_in_pages<format::Type::FIXED_LEN_BYTE_ARRAY>(
+                                row_group, column, std::move(ranges), state.key, state.found);
+                    }
+                });
+            }).then([&state] {
+                return std::move(state.found);
+            });
+        });
+    });
+}
+
+seastar::future<page_range> file_reader::find_row(uint32_t row_group, uint32_t column, int64_t row) {
+    return read_chunk_index(row_group, column).then(
+    [row_group, column, row] (seastar::lw_shared_ptr<const chunk_index> index) {
+        const std::vector<page_range>& pages = index->pages;
+        auto it = std::upper_bound(pages.begin(), pages.end(), row, [] (int64_t row, const page_range& page) {
+            return row < page.first_row;
+        });
+        if (it == pages.begin() || row >= std::prev(it)->first_row + std::prev(it)->num_rows) {
+            throw parquet_exception(seastar::format("No row {} in column chunk {} of row group {}", row, column, row_group));
+        }
+        return *std::prev(it);
+    });
+}
+
+std::optional<sort_direction> file_reader::sorted(uint32_t column) {
+    if (column >= raw_schema().leaves.size()) {
+        throw parquet_exception(seastar::format("Column {} out of range (0 to {})", column, raw_schema().leaves.size()));
+    }
+    auto cached = _sortedness.find(column);
+    if (cached != _sortedness.end()) {
+        return cached->second;
+    }
+    auto compute = [&] () -> std::optional<sort_direction> {
+        const reader_schema::raw_node& leaf = *raw_schema().leaves[column];
+        sort_order order = column_sort_order(leaf.info);
+        if (leaf.rep_level > 0 || order == sort_order::UNKNOWN) {
+            return std::nullopt;
+        }
+        bool type_defined_order = has_type_defined_order(metadata(), column);
+        std::optional<sort_direction> declared;
+        std::vector<column_statistics> stats;
+        for (const format::RowGroup& row_group : metadata().row_groups) {
+            if (column >= row_group.columns.size() || !row_group.columns[column].__isset.meta_data) {
+                return std::nullopt;
+            }
+            stats.push_back(read_statistics(row_group.columns[column].meta_data, leaf.info, type_defined_order));
+            if (!stats.back().min || !stats.back().max) {
+                return std::nullopt;
+            }
+            if (!row_group.sorting_columns.empty() && row_group.sorting_columns[0].column_idx == static_cast<int32_t>(column)) {
+                sort_direction d = row_group.sorting_columns[0].descending
+                                   ? sort_direction::descending
+                                   : sort_direction::ascending;
+                if (declared && *declared != d) {
+                    return std::nullopt;
+                }
+                declared = d;
+            } else if (compare(*stats.back().min, *stats.back().max, order) != 0) {
+                return std::nullopt;
+            }
+        }
+        auto monotone = [&] (sort_direction d) {
+            for (size_t i = 1; i < stats.size(); ++i) {
+                bool overlap = d == sort_direction::ascending
+                               ? compare(*stats[i - 1].max, *stats[i].min, order) > 0
+                               : compare(*stats[i - 1].min, *stats[i].max, order) < 0;
+                if (overlap) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        if (declared) {
+            return monotone(*declared) ? declared : std::nullopt;
+        }
+        // Every row group holds a single value.
+        if (monotone(sort_direction::ascending)) {
+            return sort_direction::ascending;
+        } else if (monotone(sort_direction::descending)) {
+            return sort_direction::descending;
+        }
+        return std::nullopt;
+    };
+    return _sortedness.emplace(column, compute()).first->second;
+}
+
+template <format::Type::type T>
+seastar::future<std::optional<int64_t>> file_reader::seek_in_range(page_range range,
+        const scalar& key, sort_order order, sort_direction direction) {
+    using reader_type = column_chunk_reader<T>;
+    using output_type = typename reader_type::output_type;
+    constexpr size_t batch_size = 1024;
+    uint32_t max_def_level = raw_schema().leaves[range.column]->def_level;
+    return open_column_chunk_reader<T>(range).then([&key, order, direction, max_def_level, range] (reader_type reader) {
+        struct seek_state {
+            // Not moved once it has read pages, since values may view its buffers.
+            std::unique_ptr<reader_type> reader;
+            int64_t row;
+            std::optional<int64_t> found;
+            std::vector<int16_t> def = std::vector<int16_t>(batch_size);
+            std::vector<int16_t> rep = std::vector<int16_t>(batch_size);
+            std::vector<output_type> values = std::vector<output_type>(batch_size);
+        };
+        return seastar::do_with(seek_state{std::make_unique<reader_type>(std::move(reader)), range.first_row},
+        [&key, order, direction, max_def_level] (seek_state& state) {
+            return seastar::repeat([&key, order, direction, max_def_level, &state] {
+                return state.reader->read_batch(batch_size, state.def.data(), state.rep.data(), state.values.data()).then(
+                [&key, order, direction, max_def_level, &state] (size_t levels_read) {
+                    if (levels_read == 0) {
+                        return seastar::stop_iteration::yes;
+                    }
+                    auto typed_key = filter_key<T>(key);
+                    auto before = [&] (const output_type& value) {
+                        return ordered_before(compare_value(value, typed_key, order), direction);
+                    };
+                    // Null values are not read into the value array.
+                    size_t values_read = std::count(state.def.begin(), state.def.begin() + levels_read, max_def_level);
+                    if (values_read == 0 || before(state.values[values_read - 1])) {
+                        state.row += levels_read;
+                        return seastar::stop_iteration::no;
+                    }
+                    size_t value_index = std::partition_point(
+                            state.values.begin(), state.values.begin() + values_read, before) - state.values.begin();
+                    for (size_t i = 0; i < levels_read; ++i) {
+                        if (state.def[i] == static_cast<int16_t>(max_def_level) && value_index-- == 0) {
+                            state.found = state.row + i;
+                            break;
+                        }
+                    }
+                    return seastar::stop_iteration::yes;
+                });
+            }).then([&state] {
+                return state.found;
+            });
+        });
+    });
+}
+
+seastar::future<std::optional<int64_t>> file_reader::seek_in_row_group(uint32_t row_group, uint32_t column,
+        const scalar& key, sort_order order, sort_direction direction) {
+    return read_chunk_index(row_group, column).then(
+    [this, &key, order, direction, column] (seastar::lw_shared_ptr<const chunk_index> index) {
+        format::Type::type type = raw_schema().leaves[column]->info.type;
+        const std::vector<page_range>& pages = index->pages;
+        size_t first = 0;
+        if (index->column_index && index->column_index->null_pages.size() == pages.size()) {
+            // The pages are sorted like their row group, so their last values are monotone.
+            const format::ColumnIndex& column_index = *index->column_index;
+            const std::vector<std::string>& last_values = direction == sort_direction::ascending
+                                                          ? column_index.max_values
+                                                          : column_index.min_values;
+            std::vector<size_t> valued_pages;
+            for (size_t i = 0; i < pages.size(); ++i) {
+                if (!column_index.null_pages[i]) {
+                    valued_pages.push_back(i);
+                }
+            }
+            auto it = std::partition_point(valued_pages.begin(), valued_pages.end(), [&] (size_t i) {
+                std::optional<scalar> last = decode_scalar(type, last_values[i]);
+                return last && ordered_before(compare(*last, key, order), direction);
+            });
+            if (it == valued_pages.end()) {
+                return seastar::make_ready_future<std::optional<int64_t>>();
+            }
+            first = *it;
+        }
+        // The pages from the first candidate on, read until the key is passed.
+        page_range range = pages[first];
+        range.end = pages.back().end;
+        range.num_rows = pages.back().first_row + pages.back().num_rows - range.first_row;
+        switch (type) {
+        case format::Type::BOOLEAN:
+            return seek_in_range<format::Type::BOOLEAN>(range, key, order, direction);
+        case format::Type::INT32:
+            return seek_in_range<format::Type::INT32>(range, key, order, direction);
+        case format::Type::INT64:
+            return seek_in_range<format::Type::INT64>(range, key, order, direction);
+        case format::Type::FLOAT:
+            return seek_in_range<format::Type::FLOAT>(range, key, order, direction);
+        case format::Type::DOUBLE:
+            return seek_in_range<format::Type::DOUBLE>(range, key, order, direction);
+        case format::Type::BYTE_ARRAY:
+            return seek_in_range<format::Type::BYTE_ARRAY>(range, key, order, direction);
+        default:
+            return seek_in_range<format::Type::FIXED_LEN_BYTE_ARRAY>(range, key, order, direction);
+        }
+    });
+}
+
+seastar::future<row_position> file_reader::seek_to_key(uint32_t column, const scalar& key) {
+    return seastar::futurize_invoke([this, column, key] {
+        std::optional<sort_direction> direction = sorted(column);
+        if (!direction) {
+            throw parquet_exception(seastar::format("Column {} is not known to be sorted", column));
+        }
+        const reader_schema::raw_node& leaf = *raw_schema().leaves[column];
+        format::Type::type type = leaf.info.type;
+        if (!key_fits(type, key)) {
+            throw parquet_exception(seastar::format(
+                    "The seek key does not match the physical type of column {} ({})", column, type));
+        }
+        if (!decode_scalar(type, encode_scalar(key))) {
+            throw parquet_exception("Cannot seek to NaN");
+        }
+        sort_order order = column_sort_order(leaf.info);
+        bool type_defined_order = has_type_defined_order(metadata(), column);
+        // The row groups whose last value is ordered before the key come first.
+        using it = boost::counting_iterator<uint32_t>;
+        uint32_t first = *std::partition_point(it(0), it(metadata().row_groups.size()), [&] (uint32_t row_group) {
+            column_statistics stats = read_statistics(
+                    metadata().row_groups[row_group].columns[column].meta_data, leaf.info, type_defined_order);
+            const scalar& last = *direction == sort_direction::ascending ? *stats.max : *stats.min;
+            return ordered_before(compare(last, key, order), *direction);
+        });
+        struct seek_state {
+            scalar key;
+            uint32_t row_group;
+            std::optional<int64_t> row;
+        };
+        return seastar::do_with(seek_state{key, first}, [this, column, order, direction = *direction] (seek_state& state) {
+            return seastar::repeat([this, column, order, direction, &state] {
+                if (state.row_group >= metadata().row_groups.size()) {
+                    return seastar::make_ready_future<seastar::stop_iteration>(seastar::stop_iteration::yes);
+                }
+                // Truncated byte array statistics may admit a row group whose values all come before the key.
+                return seek_in_row_group(state.row_group, column, state.key, order, direction).then(
+                [&state] (std::optional<int64_t> row) {
+                    if (row) {
+                        state.row = row;
+                        return seastar::stop_iteration::yes;
+                    }
+                    ++state.row_group;
+                    return seastar::stop_iteration::no;
+                });
+            }).then([&state] {
+                return row_position{state.row_group, state.row.value_or(0)};
+            });
+        });
+    });
+}
+
+template seastar::future<column_chunk_reader<format::Type::INT32>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::INT64>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::INT96>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::FLOAT>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::DOUBLE>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::BOOLEAN>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::BYTE_ARRAY>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<12>>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<16>>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, decimal128_decoder>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options);
+
+template seastar::future<column_chunk_reader<format::Type::INT32>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+template seastar::future<column_chunk_reader<format::Type::INT64>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+template seastar::future<column_chunk_reader<format::Type::INT96>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+template seastar::future<column_chunk_reader<format::Type::FLOAT>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+template seastar::future<column_chunk_reader<format::Type::DOUBLE>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+template seastar::future<column_chunk_reader<format::Type::BOOLEAN>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+template seastar::future<column_chunk_reader<format::Type::BYTE_ARRAY>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<12>>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<16>>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, decimal128_decoder>>
+file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column, const io_options& options,
+        memory_account memory);
+
 template seastar::future<column_chunk_reader<format::Type::INT32>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 template seastar::future<column_chunk_reader<format::Type::INT64>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 template seastar::future<column_chunk_reader<format::Type::INT96>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 template seastar::future<column_chunk_reader<format::Type::FLOAT>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 template seastar::future<column_chunk_reader<format::Type::DOUBLE>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 template seastar::future<column_chunk_reader<format::Type::BOOLEAN>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 template seastar::future<column_chunk_reader<format::Type::BYTE_ARRAY>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY>>
-file_reader::open_column_chunk_reader(uint32_t row_group, uint32_t column);
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<12>>>
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, fixed_len_bytes_decoder<16>>>
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
+template seastar::future<column_chunk_reader<format::Type::FIXED_LEN_BYTE_ARRAY, decimal128_decoder>>
+file_reader::open_column_chunk_reader(const page_range& range, const io_options& options);
 
 } // namespace parquet4seastar
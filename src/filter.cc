@@ -0,0 +1,462 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/filter.hh>
+#include <parquet4seastar/exception.hh>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+// The AVX2 and BMI2 kernels are compiled with target options of their own,
+// and chosen at run time by the features of the CPU.
+#if defined(__x86_64__)
+#define PARQUET4SEASTAR_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace parquet4seastar::filter {
+
+size_t selection::count() const {
+    size_t n = 0;
+    for (uint64_t word : _words) {
+        n += __builtin_popcountll(word);
+    }
+    return n;
+}
+
+selection& selection::operator&=(const selection& other) {
+    if (other._size != _size) {
+        throw parquet_exception(seastar::format("Intersection of selections of sizes {} and {}", _size, other._size));
+    }
+    for (size_t i = 0; i < _words.size(); ++i) {
+        _words[i] &= other._words[i];
+    }
+    return *this;
+}
+
+selection& selection::operator|=(const selection& other) {
+    if (other._size != _size) {
+        throw parquet_exception(seastar::format("Union of selections of sizes {} and {}", _size, other._size));
+    }
+    for (size_t i = 0; i < _words.size(); ++i) {
+        _words[i] |= other._words[i];
+    }
+    return *this;
+}
+
+void selection::flip() {
+    for (uint64_t& word : _words) {
+        word = ~word;
+    }
+    clear_padding();
+}
+
+namespace {
+
+#if defined(PARQUET4SEASTAR_X86_KERNELS)
+struct cpu_features {
+    bool avx2;
+    bool bmi2;
+    cpu_features() {
+        __builtin_cpu_init();
+        avx2 = __builtin_cpu_supports("avx2");
+        bmi2 = __builtin_cpu_supports("bmi2");
+    }
+};
+
+const cpu_features cpu;
+#endif
+
+thread_local bool simd_enabled = true;
+
+void check_size(const selection& out, size_t n) {
+    if (out.size() != n) {
+        throw parquet_exception(seastar::format("Selection of size {} for {} values", out.size(), n));
+    }
+}
+
+// Fill the words of values [begin, n) with the results of pred(i). begin is a multiple of 64.
+// Full words have a fixed trip count and no branches, so that the loop can be vectorized.
+template <typename Pred>
+void fill_words(size_t begin, size_t n, uint64_t* words, Pred pred) {
+    size_t w = begin / 64;
+    for (; (w + 1) * 64 <= n; ++w) {
+        uint64_t word = 0;
+        for (size_t i = 0; i < 64; ++i) {
+            word |= uint64_t(pred(w * 64 + i)) << i;
+        }
+        words[w] = word;
+    }
+    if (w * 64 < n) {
+        uint64_t word = 0;
+        for (size_t i = 0; w * 64 + i < n; ++i) {
+            word |= uint64_t(pred(w * 64 + i)) << i;
+        }
+        words[w] = word;
+    }
+}
+
+template <typename T, typename Cmp>
+void compare_with(const T* values, size_t begin, size_t n, const T& key, Cmp cmp, uint64_t* words) {
+    fill_words(begin, n, words, [values, &key, cmp] (size_t i) { return cmp(values[i], key); });
+}
+
+template <typename T>
+void compare_scalar(const T* values, size_t begin, size_t n, compare_op op, const T& key, uint64_t* words) {
+    switch (op) {
+    case compare_op::eq: return compare_with(values, begin, n, key, std::equal_to<T>{}, words);
+    case compare_op::ne: return compare_with(values, begin, n, key, std::not_equal_to<T>{}, words);
+    case compare_op::lt: return compare_with(values, begin, n, key, std::less<T>{}, words);
+    case compare_op::le: return compare_with(values, begin, n, key, std::less_equal<T>{}, words);
+    case compare_op::gt: return compare_with(values, begin, n, key, std::greater<T>{}, words);
+    case compare_op::ge: return compare_with(values, begin, n, key, std::greater_equal<T>{}, words);
+    }
+}
+
+#if defined(PARQUET4SEASTAR_X86_KERNELS)
+
+// Everything up to the matching pop, lambdas included, may use AVX2.
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+// Fill the full words of n values from blocks of lanes values. Returns the number of values done.
+template <typename Block>
+size_t fill_words_avx2(size_t n, size_t lanes, uint64_t* words, Block block) {
+    size_t full_words = n / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += lanes) {
+            word |= uint64_t(block(w * 64 + j)) << j;
+        }
+        words[w] = word;
+    }
+    return full_words * 64;
+}
+
+// Unsigned values are compared as signed, with their sign bits flipped.
+template <bool Unsigned>
+size_t compare_epi32(const void* values, size_t n, compare_op op, uint32_t key, uint64_t* words) {
+    const __m256i bias = _mm256_set1_epi32(Unsigned ? INT32_MIN : 0);
+    const __m256i k = _mm256_xor_si256(_mm256_set1_epi32(key), bias);
+    const int32_t* v = static_cast<const int32_t*>(values);
+    auto load = [v, bias] (size_t i) {
+        return _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i)), bias);
+    };
+    auto mask = [] (__m256i x) { return uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(x))); };
+    switch (op) {
+    case compare_op::eq:
+        return fill_words_avx2(n, 8, words, [&] (size_t i) { return mask(_mm256_cmpeq_epi32(load(i), k)); });
+    case compare_op::ne:
+        return fill_words_avx2(n, 8, words, [&] (size_t i) { return ~mask(_mm256_cmpeq_epi32(load(i), k)) & 0xff; });
+    case compare_op::lt:
+        return fill_words_avx2(n, 8, words, [&] (size_t i) { return mask(_mm256_cmpgt_epi32(k, load(i))); });
+    case compare_op::le:
+        return fill_words_avx2(n, 8, words, [&] (size_t i) { return ~mask(_mm256_cmpgt_epi32(load(i), k)) & 0xff; });
+    case compare_op::gt:
+        return fill_words_avx2(n, 8, words, [&] (size_t i) { return mask(_mm256_cmpgt_epi32(load(i), k)); });
+    case compare_op::ge:
+        return fill_words_avx2(n, 8, words, [&] (size_t i) { return ~mask(_mm256_cmpgt_epi32(k, load(i))) & 0xff; });
+    }
+    return 0;
+}
+
+template <bool Unsigned>
+size_t compare_epi64(const void* values, size_t n, compare_op op, uint64_t key, uint64_t* words) {
+    const __m256i bias = _mm256_set1_epi64x(Unsigned ? INT64_MIN : 0);
+    const __m256i k = _mm256_xor_si256(_mm256_set1_epi64x(key), bias);
+    const int64_t* v = static_cast<const int64_t*>(values);
+    auto load = [v, bias] (size_t i) {
+        return _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i)), bias);
+    };
+    auto mask = [] (__m256i x) { return uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(x))); };
+    switch (op) {
+    case compare_op::eq:
+        return fill_words_avx2(n, 4, words, [&] (size_t i) { return mask(_mm256_cmpeq_epi64(load(i), k)); });
+    case compare_op::ne:
+        return fill_words_avx2(n, 4, words, [&] (size_t i) { return ~mask(_mm256_cmpeq_epi64(load(i), k)) & 0xf; });
+    case compare_op::lt:
+        return fill_words_avx2(n, 4, words, [&] (size_t i) { return mask(_mm256_cmpgt_epi64(k, load(i))); });
+    case compare_op::le:
+        return fill_words_avx2(n, 4, words, [&] (size_t i) { return ~mask(_mm256_cmpgt_epi64(load(i), k)) & 0xf; });
+    case compare_op::gt:
+        return fill_words_avx2(n, 4, words, [&] (size_t i) { return mask(_mm256_cmpgt_epi64(load(i), k)); });
+    case compare_op::ge:
+        return fill_words_avx2(n, 4, words, [&] (size_t i) { return ~mask(_mm256_cmpgt_epi64(k, load(i))) & 0xf; });
+    }
+    return 0;
+}
+
+// The ordered predicates, and unordered ne, agree with the C++ operators on NaN.
+template <int Pred>
+size_t compare_ps(const float* v, size_t n, float key, uint64_t* words) {
+    const __m256 k = _mm256_set1_ps(key);
+    return fill_words_avx2(n, 8, words, [v, k] (size_t i) {
+        return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(v + i), k, Pred)));
+    });
+}
+
+template <int Pred>
+size_t compare_pd(const double* v, size_t n, double key, uint64_t* words) {
+    const __m256d k = _mm256_set1_pd(key);
+    return fill_words_avx2(n, 4, words, [v, k] (size_t i) {
+        return uint32_t(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(v + i), k, Pred)));
+    });
+}
+
+size_t compare_avx2(const float* v, size_t n, compare_op op, float key, uint64_t* words) {
+    switch (op) {
+    case compare_op::eq: return compare_ps<_CMP_EQ_OQ>(v, n, key, words);
+    case compare_op::ne: return compare_ps<_CMP_NEQ_UQ>(v, n, key, words);
+    case compare_op::lt: return compare_ps<_CMP_LT_OQ>(v, n, key, words);
+    case compare_op::le: return compare_ps<_CMP_LE_OQ>(v, n, key, words);
+    case compare_op::gt: return compare_ps<_CMP_GT_OQ>(v, n, key, words);
+    case compare_op::ge: return compare_ps<_CMP_GE_OQ>(v, n, key, words);
+    }
+    return 0;
+}
+
+size_t compare_avx2(const double* v, size_t n, compare_op op, double key, uint64_t* words) {
+    switch (op) {
+    case compare_op::eq: return compare_pd<_CMP_EQ_OQ>(v, n, key, words);
+    case compare_op::ne: return compare_pd<_CMP_NEQ_UQ>(v, n, key, words);
+    case compare_op::lt: return compare_pd<_CMP_LT_OQ>(v, n, key, words);
+    case compare_op::le: return compare_pd<_CMP_LE_OQ>(v, n, key, words);
+    case compare_op::gt: return compare_pd<_CMP_GT_OQ>(v, n, key, words);
+    case compare_op::ge: return compare_pd<_CMP_GE_OQ>(v, n, key, words);
+    }
+    return 0;
+}
+
+size_t compare_avx2(const int32_t* v, size_t n, compare_op op, int32_t key, uint64_t* words) {
+    return compare_epi32<false>(v, n, op, key, words);
+}
+
+size_t compare_avx2(const uint32_t* v, size_t n, compare_op op, uint32_t key, uint64_t* words) {
+    return compare_epi32<true>(v, n, op, key, words);
+}
+
+size_t compare_avx2(const int64_t* v, size_t n, compare_op op, int64_t key, uint64_t* words) {
+    return compare_epi64<false>(v, n, op, key, words);
+}
+
+size_t compare_avx2(const uint64_t* v, size_t n, compare_op op, uint64_t key, uint64_t* words) {
+    return compare_epi64<true>(v, n, op, key, words);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif
+
+template <typename T>
+void compare_numbers(const T* values, size_t n, compare_op op, T key, selection& out) {
+    check_size(out, n);
+    size_t done = 0;
+#if defined(PARQUET4SEASTAR_X86_KERNELS)
+    if (avx2_enabled()) {
+        done = compare_avx2(values, n, op, key, out.words());
+    }
+#endif
+    compare_scalar(values, done, n, op, key, out.words());
+    out.clear_padding();
+}
+
+template <typename LevelT>
+selection validity_of(const LevelT* def, size_t n, uint32_t max_def_level) {
+    selection out(n);
+    LevelT max = static_cast<LevelT>(max_def_level);
+    fill_words(0, n, out.words(), [def, max] (size_t i) { return def[i] == max; });
+    return out;
+}
+
+// count bits of words, starting at bit offset.
+uint64_t extract_bits(const uint64_t* words, size_t offset, unsigned count) {
+    if (count == 0) {
+        return 0;
+    }
+    size_t shift = offset % 64;
+    uint64_t bits = words[offset / 64] >> shift;
+    if (shift + count > 64) {
+        bits |= words[offset / 64 + 1] << (64 - shift);
+    }
+    return count == 64 ? bits : bits & ((uint64_t(1) << count) - 1);
+}
+
+// Put the low bits of bits at the positions of the set bits of mask.
+uint64_t deposit_bits(uint64_t bits, uint64_t mask) {
+    uint64_t result = 0;
+    for (; mask; mask &= mask - 1, bits >>= 1) {
+        result |= (bits & 1) ? mask & -mask : 0;
+    }
+    return result;
+}
+
+// Deposit the bits of values, in order, at the set bits of the words of valid.
+void spread_words(const selection& values, const selection& valid, selection& out) {
+    size_t offset = 0;
+    for (size_t w = 0; w < valid.word_count(); ++w) {
+        uint64_t mask = valid.words()[w];
+        unsigned count = __builtin_popcountll(mask);
+        out.words()[w] = deposit_bits(extract_bits(values.words(), offset, count), mask);
+        offset += count;
+    }
+}
+
+#if defined(PARQUET4SEASTAR_X86_KERNELS)
+__attribute__((target("bmi2")))
+void spread_words_bmi2(const selection& values, const selection& valid, selection& out) {
+    size_t offset = 0;
+    for (size_t w = 0; w < valid.word_count(); ++w) {
+        uint64_t mask = valid.words()[w];
+        unsigned count = __builtin_popcountll(mask);
+        out.words()[w] = _pdep_u64(extract_bits(values.words(), offset, count), mask);
+        offset += count;
+    }
+}
+#endif
+
+} // namespace
+
+void compare_values(const int32_t* values, size_t n, compare_op op, int32_t key, selection& out) {
+    compare_numbers(values, n, op, key, out);
+}
+
+void compare_values(const uint32_t* values, size_t n, compare_op op, uint32_t key, selection& out) {
+    compare_numbers(values, n, op, key, out);
+}
+
+void compare_values(const int64_t* values, size_t n, compare_op op, int64_t key, selection& out) {
+    compare_numbers(values, n, op, key, out);
+}
+
+void compare_values(const uint64_t* values, size_t n, compare_op op, uint64_t key, selection& out) {
+    compare_numbers(values, n, op, key, out);
+}
+
+void compare_values(const float* values, size_t n, compare_op op, float key, selection& out) {
+    compare_numbers(values, n, op, key, out);
+}
+
+void compare_values(const double* values, size_t n, compare_op op, double key, selection& out) {
+    compare_numbers(values, n, op, key, out);
+}
+
+void compare_values(const uint8_t* values, size_t n, compare_op op, uint8_t key, selection& out) {
+    check_size(out, n);
+    compare_scalar(values, 0, n, op, key, out.words());
+    out.clear_padding();
+}
+
+void compare_values(const std::array<int32_t, 3>* values, size_t n, compare_op op,
+        const std::array<int32_t, 3>& key, selection& out) {
+    check_size(out, n);
+    if (op != compare_op::eq && op != compare_op::ne) {
+        throw parquet_exception("INT96 values have no order, and can only be compared for equality");
+    }
+    compare_scalar(values, 0, n, op, key, out.words());
+    out.clear_padding();
+}
+
+void compare_values(const seastar::temporary_buffer<uint8_t>* values, size_t n, compare_op op,
+        bytes_view key, selection& out) {
+    check_size(out, n);
+    auto view = [values] (size_t i) { return bytes_view(values[i].get(), values[i].size()); };
+    switch (op) {
+    case compare_op::eq:
+        // Lengths are compared first, so most values are rejected without looking at their contents.
+        fill_words(0, n, out.words(), [&] (size_t i) {
+            return values[i].size() == key.size() && std::memcmp(values[i].get(), key.data(), key.size()) == 0;
+        });
+        break;
+    case compare_op::ne:
+        fill_words(0, n, out.words(), [&] (size_t i) {
+            return values[i].size() != key.size() || std::memcmp(values[i].get(), key.data(), key.size()) != 0;
+        });
+        break;
+    case compare_op::lt: fill_words(0, n, out.words(), [&] (size_t i) { return view(i) < key; }); break;
+    case compare_op::le: fill_words(0, n, out.words(), [&] (size_t i) { return view(i) <= key; }); break;
+    case compare_op::gt: fill_words(0, n, out.words(), [&] (size_t i) { return view(i) > key; }); break;
+    case compare_op::ge: fill_words(0, n, out.words(), [&] (size_t i) { return view(i) >= key; }); break;
+    }
+    out.clear_padding();
+}
+
+void starts_with(const seastar::temporary_buffer<uint8_t>* values, size_t n, bytes_view prefix, selection& out) {
+    check_size(out, n);
+    fill_words(0, n, out.words(), [&] (size_t i) {
+        return values[i].size() >= prefix.size() && std::memcmp(values[i].get(), prefix.data(), prefix.size()) == 0;
+    });
+    out.clear_padding();
+}
+
+selection validity(const int16_t* def, size_t n, uint32_t max_def_level) {
+    return validity_of(def, n, max_def_level);
+}
+
+selection validity(const int32_t* def, size_t n, uint32_t max_def_level) {
+    return validity_of(def, n, max_def_level);
+}
+
+selection spread(const selection& values, const selection& valid) {
+    size_t n_valid = valid.count();
+    if (values.size() != n_valid) {
+        throw parquet_exception(seastar::format(
+                "Selection of {} values spread over {} positions with values", values.size(), n_valid));
+    }
+    selection out(valid.size());
+#if defined(PARQUET4SEASTAR_X86_KERNELS)
+    if (bmi2_enabled()) {
+        spread_words_bmi2(values, valid, out);
+        return out;
+    }
+#endif
+    spread_words(values, valid, out);
+    return out;
+}
+
+void enable_simd(bool enabled) {
+    simd_enabled = enabled;
+}
+
+bool avx2_enabled() {
+#if defined(PARQUET4SEASTAR_X86_KERNELS)
+    return simd_enabled && cpu.avx2;
+#else
+    return false;
+#endif
+}
+
+bool bmi2_enabled() {
+#if defined(PARQUET4SEASTAR_X86_KERNELS)
+    return simd_enabled && cpu.bmi2;
+#else
+    return false;
+#endif
+}
+
+} // namespace parquet4seastar::filter
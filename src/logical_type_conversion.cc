@@ -0,0 +1,112 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/logical_type_conversion.hh>
+#include <seastar/core/print.hh>
+
+namespace parquet4seastar::logical_type {
+
+void throw_decimal_too_wide(size_t size, size_t max_size) {
+    throw parquet_exception(seastar::format(
+            "DECIMAL value of {} bytes does not fit in {} bytes", size, max_size));
+}
+
+namespace {
+
+constexpr int64_t pow1000(int exponent) {
+    int64_t result = 1;
+    for (int i = 0; i < exponent; ++i) {
+        result *= 1000;
+    }
+    return result;
+}
+
+void scale_up(const int64_t in[], size_t n, int64_t factor, int64_t out[]) {
+    bool overflow = false;
+    for (size_t i = 0; i < n; ++i) {
+        overflow |= __builtin_mul_overflow(in[i], factor, &out[i]);
+    }
+    if (overflow) {
+        throw parquet_exception(seastar::format("Timestamp overflow while scaling by {}", factor));
+    }
+}
+
+void scale_down(const int64_t in[], size_t n, int64_t factor, int64_t out[]) {
+    for (size_t i = 0; i < n; ++i) {
+        int64_t q = in[i] / factor;
+        out[i] = q - ((in[i] % factor) < 0);
+    }
+}
+
+} // namespace
+
+void int96_to_nanoseconds(const std::array<int32_t, 3> in[], size_t n, int64_t out[]) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = int96_to_nanoseconds(in[i]);
+    }
+}
+
+void rescale_timestamps(const int64_t in[], size_t n, time_unit from, time_unit to, int64_t out[]) {
+    if (from == to) {
+        std::copy(in, in + n, out);
+    } else if (from < to) {
+        scale_up(in, n, pow1000(to - from), out);
+    } else {
+        scale_down(in, n, pow1000(from - to), out);
+    }
+}
+
+void dates_to_timestamps(const int32_t in[], size_t n, time_unit unit, int64_t out[]) {
+    int64_t factor = SECONDS_PER_DAY * pow1000(unit + 1);
+    std::array<int64_t, 1024> days;
+    for (size_t done = 0; done < n;) {
+        size_t batch = std::min(n - done, days.size());
+        std::copy(in + done, in + done + batch, days.data());
+        scale_up(days.data(), batch, factor, out + done);
+        done += batch;
+    }
+}
+
+void decimal_to_int128(const seastar::temporary_buffer<uint8_t> in[], size_t n, __int128 out[]) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = decimal_to_int128(bytes_view{in[i].get(), in[i].size()});
+    }
+}
+
+void decimal_to_int64(const seastar::temporary_buffer<uint8_t> in[], size_t n, int64_t out[]) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = decimal_to_int64(bytes_view{in[i].get(), in[i].size()});
+    }
+}
+
+void decimal_to_int128(const byte in[], size_t type_length, size_t n, __int128 out[]) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = decimal_to_int128(bytes_view{in + i * type_length, type_length});
+    }
+}
+
+void decimal_to_int64(const byte in[], size_t type_length, size_t n, int64_t out[]) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = decimal_to_int64(bytes_view{in + i * type_length, type_length});
+    }
+}
+
+} // namespace parquet4seastar::logical_type
@@ -0,0 +1,78 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/mapped_file.hh>
+#include <seastar/core/seastar.hh>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace parquet4seastar {
+
+seastar::lw_shared_ptr<const mapped_file> mapped_file::map(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "open");
+    }
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+        int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::system_category(), "fstat");
+    }
+    size_t size = st.st_size;
+    if (size == 0) {
+        ::close(fd);
+        return seastar::make_lw_shared<const mapped_file>(nullptr, 0, seastar::deleter{});
+    }
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw std::system_error(error, std::system_category(), "mmap");
+    }
+    return seastar::make_lw_shared<const mapped_file>(static_cast<const byte*>(data), size,
+            seastar::make_deleter([data, size] { ::munmap(data, size); }));
+}
+
+seastar::lw_shared_ptr<const mapped_file> mapped_file::from_buffer(seastar::temporary_buffer<char> contents) {
+    const byte* data = reinterpret_cast<const byte*>(contents.get());
+    size_t size = contents.size();
+    return seastar::make_lw_shared<const mapped_file>(data, size, contents.release());
+}
+
+seastar::future<bool> should_map(const std::string& path, mmap_policy policy) {
+    switch (policy) {
+    case mmap_policy::never:
+        return seastar::make_ready_future<bool>(false);
+    case mmap_policy::always:
+        return seastar::make_ready_future<bool>(true);
+    case mmap_policy::in_memory:
+        return seastar::file_system_at(path).then([] (seastar::fs_type fs) {
+            return fs == seastar::fs_type::tmpfs;
+        });
+    }
+    return seastar::make_ready_future<bool>(false);
+}
+
+} // namespace parquet4seastar
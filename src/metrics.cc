@@ -0,0 +1,212 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/metrics.hh>
+#include <seastar/core/metrics.hh>
+#include <seastar/core/bitops.hh>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace parquet4seastar::metrics {
+
+namespace detail {
+
+thread_local bool enabled = false;
+
+} // namespace detail
+
+namespace {
+
+thread_local stats shard_stats;
+thread_local std::unique_ptr<seastar::metrics::metric_groups> registered_metrics;
+
+const char* physical_type_name(size_t type) {
+    static const char* names[n_physical_types] = {
+        "boolean", "int32", "int64", "int96", "float", "double", "byte_array", "fixed_len_byte_array",
+    };
+    return names[type];
+}
+
+const char* page_kind_name(size_t kind) {
+    static const char* names[n_page_kinds] = {"data", "data_v2", "dictionary", "other"};
+    return names[kind];
+}
+
+const char* encoding_name(size_t encoding) {
+    static const char* names[n_encodings] = {
+        "plain", "group_var_int", "plain_dictionary", "rle", "bit_packed",
+        "delta_binary_packed", "delta_length_byte_array", "delta_byte_array",
+        "rle_dictionary", "byte_stream_split", "other",
+    };
+    return names[encoding];
+}
+
+size_t physical_type_index(format::Type::type type) {
+    size_t i = static_cast<size_t>(type);
+    return i < n_physical_types ? i : n_physical_types - 1;
+}
+
+size_t encoding_index(format::Encoding::type encoding) {
+    size_t i = static_cast<size_t>(encoding);
+    return i < n_encodings - 1 ? i : n_encodings - 1;
+}
+
+page_kind kind_of(const format::PageHeader& header) {
+    switch (header.type) {
+    case format::PageType::DATA_PAGE: return page_kind::data;
+    case format::PageType::DATA_PAGE_V2: return page_kind::data_v2;
+    case format::PageType::DICTIONARY_PAGE: return page_kind::dictionary;
+    default: return page_kind::other;
+    }
+}
+
+std::optional<format::Encoding::type> encoding_of(const format::PageHeader& header) {
+    if (header.type == format::PageType::DATA_PAGE && header.__isset.data_page_header) {
+        return header.data_page_header.encoding;
+    } else if (header.type == format::PageType::DATA_PAGE_V2 && header.__isset.data_page_header_v2) {
+        return header.data_page_header_v2.encoding;
+    } else if (header.type == format::PageType::DICTIONARY_PAGE && header.__isset.dictionary_page_header) {
+        return header.dictionary_page_header.encoding;
+    }
+    return std::nullopt;
+}
+
+void record_page(
+        const format::PageHeader& header,
+        std::array<uint64_t, n_page_kinds>& pages,
+        std::array<uint64_t, n_encodings>& pages_by_encoding) {
+    ++pages[static_cast<size_t>(kind_of(header))];
+    if (auto encoding = encoding_of(header)) {
+        ++pages_by_encoding[encoding_index(*encoding)];
+    }
+}
+
+void register_metrics() {
+    namespace sm = seastar::metrics;
+    sm::label type_label("type");
+    sm::label page_type_label("page_type");
+    sm::label encoding_label("encoding");
+    sm::label direction_label("direction");
+
+    std::vector<sm::metric_definition> defs;
+    for (size_t i = 0; i < n_physical_types; ++i) {
+        defs.push_back(sm::make_counter("bytes_read", shard_stats.bytes_read[i],
+                sm::description("Compressed bytes of pages read, excluding page headers"),
+                {type_label(physical_type_name(i))}));
+        defs.push_back(sm::make_counter("bytes_written", shard_stats.bytes_written[i],
+                sm::description("Compressed bytes of pages written, excluding page headers"),
+                {type_label(physical_type_name(i))}));
+    }
+    for (size_t i = 0; i < n_page_kinds; ++i) {
+        defs.push_back(sm::make_counter("pages_read", shard_stats.pages_read[i],
+                sm::description("Pages read, by page type"),
+                {page_type_label(page_kind_name(i))}));
+        defs.push_back(sm::make_counter("pages_written", shard_stats.pages_written[i],
+                sm::description("Pages written, by page type"),
+                {page_type_label(page_kind_name(i))}));
+    }
+    for (size_t i = 0; i < n_encodings; ++i) {
+        defs.push_back(sm::make_counter("pages_read_by_encoding", shard_stats.pages_read_by_encoding[i],
+                sm::description("Pages read, by encoding"),
+                {encoding_label(encoding_name(i))}));
+        defs.push_back(sm::make_counter("pages_written_by_encoding", shard_stats.pages_written_by_encoding[i],
+                sm::description("Pages written, by encoding"),
+                {encoding_label(encoding_name(i))}));
+    }
+    defs.push_back(sm::make_counter("pages_skipped", shard_stats.pages_skipped,
+            sm::description("Pages skipped without decoding")));
+    defs.push_back(sm::make_counter("dictionary_fallbacks", shard_stats.dictionary_fallbacks,
+            sm::description("Column chunks which fell back from dictionary to plain encoding")));
+    defs.push_back(sm::make_histogram("compression_latency",
+            [] { return shard_stats.decompression_latency.to_metrics_histogram(); },
+            sm::description("Time spent decompressing pages, in microseconds"),
+            {direction_label("decompress")}));
+    defs.push_back(sm::make_histogram("compression_latency",
+            [] { return shard_stats.compression_latency.to_metrics_histogram(); },
+            sm::description("Time spent compressing pages, in microseconds"),
+            {direction_label("compress")}));
+    defs.push_back(sm::make_histogram("decode_latency",
+            [] { return shard_stats.decode_latency.to_metrics_histogram(); },
+            sm::description("Time spent decoding batches of values, in microseconds")));
+
+    registered_metrics = std::make_unique<sm::metric_groups>();
+    registered_metrics->add_group("parquet4seastar", defs);
+}
+
+} // namespace
+
+void latency_histogram::add(std::chrono::nanoseconds latency) {
+    uint64_t ns = latency.count() > 0 ? latency.count() : 0;
+    uint64_t us = ns / 1000;
+    size_t bucket = us == 0 ? 0 : seastar::log2floor(us) + 1;
+    ++_buckets[std::min(bucket, n_buckets - 1)];
+    ++_count;
+    _sum_ns += ns;
+}
+
+seastar::metrics::histogram latency_histogram::to_metrics_histogram() const {
+    seastar::metrics::histogram h;
+    h.sample_count = _count;
+    h.sample_sum = _sum_ns / 1000.0;
+    h.buckets.resize(n_buckets - 1);
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < n_buckets - 1; ++i) {
+        cumulative += _buckets[i];
+        h.buckets[i].count = cumulative;
+        h.buckets[i].upper_bound = static_cast<double>(uint64_t(1) << i);
+    }
+    return h;
+}
+
+void enable() {
+    if (!detail::enabled) {
+        register_metrics();
+        detail::enabled = true;
+    }
+}
+
+void disable() {
+    detail::enabled = false;
+    registered_metrics.reset();
+}
+
+stats& local_stats() {
+    return shard_stats;
+}
+
+void record_page_read(format::Type::type type, const format::PageHeader& header, size_t size) {
+    if (!enabled()) {
+        return;
+    }
+    shard_stats.bytes_read[physical_type_index(type)] += size;
+    record_page(header, shard_stats.pages_read, shard_stats.pages_read_by_encoding);
+}
+
+void record_page_written(format::Type::type type, const format::PageHeader& header, size_t size) {
+    if (!enabled()) {
+        return;
+    }
+    shard_stats.bytes_written[physical_type_index(type)] += size;
+    record_page(header, shard_stats.pages_written, shard_stats.pages_written_by_encoding);
+}
+
+} // namespace parquet4seastar::metrics
@@ -0,0 +1,153 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/page_cache.hh>
+#include <seastar/core/metrics.hh>
+#include <boost/functional/hash.hpp>
+
+namespace parquet4seastar {
+
+namespace {
+
+thread_local std::unique_ptr<page_cache> shard_page_cache;
+
+} // namespace
+
+file_identity file_identity::from_stat(const struct stat& st) {
+    return file_identity{
+        static_cast<uint64_t>(st.st_dev),
+        static_cast<uint64_t>(st.st_ino),
+        static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec,
+        static_cast<uint64_t>(st.st_size)};
+}
+
+size_t column_chunk_id_hash::operator()(const column_chunk_id& id) const {
+    size_t h = 0;
+    boost::hash_combine(h, id.file.device);
+    boost::hash_combine(h, id.file.inode);
+    boost::hash_combine(h, id.file.mtime_ns);
+    boost::hash_combine(h, id.offset);
+    return h;
+}
+
+size_t page_cache_key_hash::operator()(const page_cache_key& k) const {
+    size_t h = column_chunk_id_hash{}(k.chunk);
+    boost::hash_combine(h, k.page_offset);
+    return h;
+}
+
+page_cache::page_cache(size_t capacity)
+    : _capacity{capacity}
+    , _reclaimer{[this] { return reclaim(); }} {
+    namespace sm = seastar::metrics;
+    _metrics.add_group("parquet4seastar", {
+        sm::make_derive("page_cache_hits", _stats.hits,
+                sm::description("Pages found in the page cache")),
+        sm::make_derive("page_cache_misses", _stats.misses,
+                sm::description("Pages looked up in the page cache and not found")),
+        sm::make_derive("page_cache_insertions", _stats.insertions,
+                sm::description("Pages inserted into the page cache")),
+        sm::make_derive("page_cache_evictions", _stats.evictions,
+                sm::description("Pages evicted from the page cache, because of its capacity or memory pressure")),
+        sm::make_gauge("page_cache_bytes", [this] { return _size; },
+                sm::description("Memory used by the pages in the page cache")),
+        sm::make_gauge("page_cache_entries", [this] { return _index.size(); },
+                sm::description("Pages in the page cache")),
+    });
+}
+
+seastar::lw_shared_ptr<const cached_page> page_cache::find(const page_cache_key& key) {
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        ++_stats.misses;
+        return {};
+    }
+    ++_stats.hits;
+    _lru.splice(_lru.begin(), _lru, it->second);
+    return it->second->page;
+}
+
+void page_cache::insert(const page_cache_key& key, seastar::lw_shared_ptr<const cached_page> page) {
+    size_t page_size = page->memory_usage();
+    if (page_size > _capacity) {
+        return;
+    }
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        // Inserted concurrently by another reader.
+        _lru.splice(_lru.begin(), _lru, it->second);
+        return;
+    }
+    shrink(_capacity - page_size);
+    _lru.push_front(entry{key, std::move(page)});
+    _index.emplace(key, _lru.begin());
+    _size += page_size;
+    ++_stats.insertions;
+}
+
+size_t page_cache::evict_one() {
+    entry& e = _lru.back();
+    size_t page_size = e.page->memory_usage();
+    // A page still held by a reader is only freed when the reader drops it.
+    size_t freed = e.page.use_count() == 1 ? page_size : 0;
+    _size -= page_size;
+    _index.erase(e.key);
+    _lru.pop_back();
+    ++_stats.evictions;
+    return freed;
+}
+
+void page_cache::shrink(size_t size) {
+    while (_size > size) {
+        evict_one();
+    }
+}
+
+// Called by the seastar allocator when free memory runs low. Frees an eighth of the cache at a time.
+// Pages held by readers are evicted on the way, but free nothing yet, so they don't count.
+seastar::memory::reclaiming_result page_cache::reclaim() {
+    if (_lru.empty()) {
+        return seastar::memory::reclaiming_result::reclaimed_nothing;
+    }
+    size_t target = std::max(_size / 8, _lru.back().page->memory_usage());
+    size_t freed = 0;
+    while (freed < target && !_lru.empty()) {
+        freed += evict_one();
+    }
+    return freed > 0
+            ? seastar::memory::reclaiming_result::reclaimed_something
+            : seastar::memory::reclaiming_result::reclaimed_nothing;
+}
+
+void enable_page_cache(size_t capacity) {
+    shard_page_cache.reset();
+    shard_page_cache = std::make_unique<page_cache>(capacity);
+}
+
+void disable_page_cache() {
+    shard_page_cache.reset();
+}
+
+page_cache* local_page_cache() {
+    return shard_page_cache.get();
+}
+
+} // namespace parquet4seastar
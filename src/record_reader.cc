@@ -22,33 +22,37 @@
 #include <parquet4seastar/record_reader.hh>
 #include <parquet4seastar/file_reader.hh>
 #include <parquet4seastar/overloaded.hh>
+#include <numeric>
 
 namespace parquet4seastar::record {
 
-seastar::future<field_reader> field_reader::make(file_reader& fr, const reader_schema::node& node_variant, int row_group) {
+seastar::future<field_reader> field_reader::make(
+        file_reader& fr, const reader_schema::node& node_variant, int row_group, memory_account& memory) {
     return std::visit(overloaded {
         [&] (const reader_schema::primitive_node& node) -> seastar::future<field_reader> {
             return std::visit([&] (auto lt) {
-                return fr.open_column_chunk_reader<lt.physical_type>(row_group, node.column_index).then(
+                memory_account chunk_memory = memory.split(fr.admission_size(row_group, node.column_index, fr.options()));
+                return fr.open_column_chunk_reader<lt.physical_type>(
+                        row_group, node.column_index, fr.options(), std::move(chunk_memory)).then(
                 [&node] (column_chunk_reader<lt.physical_type> ccr) {
                     return field_reader{typed_primitive_reader<decltype(lt)>{node, std::move(ccr)}};
                 });
             }, node.logical_type);
         },
         [&] (const reader_schema::list_node& node) {
-            return field_reader::make(fr, *node.element, row_group).then([&node] (field_reader child) {
+            return field_reader::make(fr, *node.element, row_group, memory).then([&node] (field_reader child) {
                 return field_reader{list_reader{node, std::make_unique<field_reader>(std::move(child))}};
             });
         },
         [&] (const reader_schema::optional_node& node) {
-            return field_reader::make(fr, *node.child, row_group).then([&node] (field_reader child) {
+            return field_reader::make(fr, *node.child, row_group, memory).then([&node] (field_reader child) {
                 return field_reader{optional_reader{node, std::make_unique<field_reader>(std::move(child))}};
             });
         },
         [&] (const reader_schema::map_node& node) {
             return seastar::when_all_succeed(
-                    field_reader::make(fr, *node.key, row_group),
-                    field_reader::make(fr, *node.value, row_group)
+                    field_reader::make(fr, *node.key, row_group, memory),
+                    field_reader::make(fr, *node.value, row_group, memory)
             ).then([&node] (field_reader key, field_reader value) {
                 return field_reader{map_reader{
                         node,
@@ -60,7 +64,7 @@ seastar::future<field_reader> field_reader::make(file_reader& fr, const reader_s
             std::vector<seastar::future<field_reader>> field_readers;
             field_readers.reserve(node.fields.size());
             for (const reader_schema::node& child : node.fields) {
-                field_readers.push_back(field_reader::make(fr, child, row_group));
+                field_readers.push_back(field_reader::make(fr, child, row_group, memory));
             }
             return seastar::when_all_succeed(field_readers.begin(), field_readers.end()).then(
             [&node] (std::vector<field_reader> field_readers) {
@@ -70,14 +74,128 @@ seastar::future<field_reader> field_reader::make(file_reader& fr, const reader_s
     }, node_variant);
 }
 
+namespace {
+
+// The summed admission of the column chunks under a node.
+size_t admission_size(file_reader& fr, const reader_schema::node& node_variant, int row_group) {
+    return std::visit(overloaded {
+        [&] (const reader_schema::primitive_node& node) {
+            return fr.admission_size(row_group, node.column_index, fr.options());
+        },
+        [&] (const reader_schema::list_node& node) {
+            return admission_size(fr, *node.element, row_group);
+        },
+        [&] (const reader_schema::optional_node& node) {
+            return admission_size(fr, *node.child, row_group);
+        },
+        [&] (const reader_schema::map_node& node) {
+            return admission_size(fr, *node.key, row_group) + admission_size(fr, *node.value, row_group);
+        },
+        [&] (const reader_schema::struct_node& node) {
+            size_t size = 0;
+            for (const reader_schema::node& child : node.fields) {
+                size += admission_size(fr, child, row_group);
+            }
+            return size;
+        }
+    }, node_variant);
+}
+
+} // namespace
+
+// All column chunks are admitted at once. Admitting them one by one would let concurrent
+// record readers (or a schema wider than the limit) each hold part of the budget and wait
+// for the rest forever.
+seastar::future<record_reader> record_reader::make(
+        file_reader& fr, int row_group, std::vector<const reader_schema::node*> field_nodes) {
+    size_t size = 0;
+    for (const reader_schema::node* field_node : field_nodes) {
+        size += admission_size(fr, *field_node, row_group);
+    }
+    memory_limiter* limiter = fr.options().memory;
+    auto admitted = limiter ? limiter->admit(size) : seastar::make_ready_future<memory_account>();
+    return admitted.then([&fr, row_group, field_nodes = std::move(field_nodes)] (memory_account memory) {
+        std::vector<seastar::future<field_reader>> field_readers;
+        for (const reader_schema::node* field_node : field_nodes) {
+            field_readers.push_back(field_reader::make(fr, *field_node, row_group, memory));
+        }
+        return seastar::when_all_succeed(field_readers.begin(), field_readers.end()).then(
+        [&fr] (std::vector<field_reader> field_readers) {
+            return record_reader{fr.schema(), std::move(field_readers)};
+        });
+    });
+}
+
 seastar::future<record_reader> record_reader::make(file_reader& fr, int row_group) {
-    std::vector<seastar::future<field_reader>> field_readers;
+    std::vector<const reader_schema::node*> field_nodes;
     for (const reader_schema::node& field_node : fr.schema().fields) {
-        field_readers.push_back(field_reader::make(fr, field_node, row_group));
+        field_nodes.push_back(&field_node);
+    }
+    return make(fr, row_group, std::move(field_nodes));
+}
+
+seastar::future<record_reader>
+record_reader::make(file_reader& fr, int row_group, const std::vector<std::string>& columns) {
+    std::vector<const reader_schema::node*> field_nodes;
+    for (const std::string& column : columns) {
+        const reader_schema::node* field_node = nullptr;
+        for (const reader_schema::node& candidate : fr.schema().fields) {
+            if (std::visit([] (const auto& x) -> const std::string& { return x.info.name; }, candidate) == column) {
+                field_node = &candidate;
+                break;
+            }
+        }
+        if (!field_node) {
+            return seastar::make_exception_future<record_reader>(
+                    parquet_exception(seastar::format("No column named {} in {}", column, fr.path())));
+        }
+        field_nodes.push_back(field_node);
     }
-    return seastar::when_all_succeed(field_readers.begin(), field_readers.end()).then(
-    [&fr] (std::vector<field_reader> field_readers) {
-        return record_reader{fr.schema(), std::move(field_readers)};
+    return make(fr, row_group, std::move(field_nodes));
+}
+
+multi_record_reader::multi_record_reader(
+        file_reader& fr,
+        std::vector<uint32_t> row_groups,
+        size_t lookahead,
+        std::vector<std::string> columns)
+    : _fr{fr}
+    , _row_groups(std::move(row_groups))
+    , _columns(std::move(columns))
+    , _lookahead{lookahead} {
+}
+
+multi_record_reader::multi_record_reader(file_reader& fr, size_t lookahead)
+    : multi_record_reader{fr, {}, lookahead} {
+    _row_groups.resize(fr.metadata().row_groups.size());
+    std::iota(_row_groups.begin(), _row_groups.end(), 0);
+}
+
+// Opens the next row groups until `pending` readers are open, besides the one being read.
+void multi_record_reader::open_ahead(size_t pending) {
+    while (_opening.size() < pending && _next_to_open < _row_groups.size()) {
+        uint32_t row_group = _row_groups[_next_to_open++];
+        auto reader = _columns.empty()
+                ? record_reader::make(_fr, row_group)
+                : record_reader::make(_fr, row_group, _columns);
+        // Readers are not moved once they have loaded pages, which may be viewed by their decoders.
+        _opening.push_back(reader.then([] (record_reader rr) {
+            auto prefetched = std::make_unique<record_reader>(std::move(rr));
+            return prefetched->prefetch().then([prefetched = std::move(prefetched)] () mutable {
+                return std::move(prefetched);
+            });
+        }));
+    }
+}
+
+seastar::future<> multi_record_reader::close() {
+    _next_to_open = _row_groups.size();
+    return seastar::parallel_for_each(_opening, [] (seastar::future<std::unique_ptr<record_reader>>& f) {
+        return std::move(f).then([] (std::unique_ptr<record_reader>) {}).handle_exception([] (std::exception_ptr) {
+            // The reader was not going to be read anyway.
+        });
+    }).then([this] {
+        _opening.clear();
     });
 }
 
@@ -0,0 +1,126 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/sharded_scan.hh>
+#include <seastar/core/future-util.hh>
+#include <algorithm>
+#include <queue>
+
+namespace parquet4seastar {
+
+std::vector<std::vector<row_group_ref>> distribute_row_groups(
+        const std::vector<std::vector<int64_t>>& row_group_sizes, unsigned n_shards) {
+    std::vector<row_group_ref> row_groups;
+    uint64_t position = 0;
+    for (uint32_t file = 0; file < row_group_sizes.size(); ++file) {
+        for (uint32_t rg = 0; rg < row_group_sizes[file].size(); ++rg) {
+            row_groups.push_back(row_group_ref{file, rg, position++, row_group_sizes[file][rg]});
+        }
+    }
+    return distribute_row_group_refs(std::move(row_groups), n_shards);
+}
+
+std::vector<std::vector<row_group_ref>> distribute_row_group_refs(std::vector<row_group_ref> row_groups, unsigned n_shards) {
+    std::stable_sort(row_groups.begin(), row_groups.end(), [] (const row_group_ref& a, const row_group_ref& b) {
+        return a.byte_size > b.byte_size;
+    });
+
+    std::vector<std::vector<row_group_ref>> plan(n_shards);
+    // (bytes assigned, shard), least loaded first; ties go to the lower shard.
+    using load = std::pair<int64_t, unsigned>;
+    std::priority_queue<load, std::vector<load>, std::greater<load>> shards;
+    for (unsigned shard = 0; shard < n_shards; ++shard) {
+        shards.push({0, shard});
+    }
+    for (const row_group_ref& ref : row_groups) {
+        load least_loaded = shards.top();
+        shards.pop();
+        plan[least_loaded.second].push_back(ref);
+        // Row groups without a size still have to be spread.
+        shards.push({least_loaded.first + std::max<int64_t>(ref.byte_size, 1), least_loaded.second});
+    }
+    for (std::vector<row_group_ref>& shard_row_groups : plan) {
+        std::sort(shard_row_groups.begin(), shard_row_groups.end(), [] (const row_group_ref& a, const row_group_ref& b) {
+            return a.position < b.position;
+        });
+    }
+    return plan;
+}
+
+namespace detail {
+
+seastar::future<std::vector<std::vector<row_group_ref>>>
+plan_sharded_scan(const std::vector<std::string>& paths, const io_options& options) {
+    return seastar::do_with(std::vector<std::vector<int64_t>>(paths.size()),
+    [&paths, &options] (std::vector<std::vector<int64_t>>& row_group_sizes) {
+        return seastar::parallel_for_each(boost::irange<size_t>(0, paths.size()),
+        [&paths, &options, &row_group_sizes] (size_t i) {
+            return file_reader::read_metadata(paths[i], options).then(
+            [&row_group_sizes, i] (std::unique_ptr<format::FileMetaData> metadata) {
+                for (const format::RowGroup& rg : metadata->row_groups) {
+                    row_group_sizes[i].push_back(rg.total_byte_size);
+                }
+            });
+        }).then([&row_group_sizes] {
+            return distribute_row_groups(row_group_sizes, seastar::smp::count);
+        });
+    });
+}
+
+namespace {
+
+struct shard_scan_state {
+    std::vector<std::string> paths;
+    std::vector<row_group_ref> row_groups;
+    io_options options;
+    seastar::noncopyable_function<seastar::future<> (file_reader&, const row_group_ref&)> read;
+    std::map<uint32_t, file_reader> files;
+};
+
+} // namespace
+
+seastar::future<> scan_row_groups(
+        std::vector<std::string> paths,
+        std::vector<row_group_ref> row_groups,
+        io_options options,
+        seastar::noncopyable_function<seastar::future<> (file_reader&, const row_group_ref&)> read) {
+    return seastar::do_with(shard_scan_state{std::move(paths), std::move(row_groups), std::move(options), std::move(read)},
+    [] (shard_scan_state& state) {
+        return seastar::do_for_each(state.row_groups, [&state] (const row_group_ref& ref) {
+            auto it = state.files.find(ref.file);
+            if (it != state.files.end()) {
+                return state.read(it->second, ref);
+            }
+            return file_reader::open(state.paths[ref.file], state.options).then([&state, ref] (file_reader fr) {
+                file_reader& opened = state.files.emplace(ref.file, std::move(fr)).first->second;
+                return state.read(opened, ref);
+            });
+        }).finally([&state] {
+            return seastar::parallel_for_each(state.files, [] (std::pair<const uint32_t, file_reader>& file) {
+                return file.second.close();
+            });
+        });
+    });
+}
+
+} // namespace detail
+
+} // namespace parquet4seastar
@@ -0,0 +1,228 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/statistics.hh>
+#include <parquet4seastar/exception.hh>
+#include <parquet4seastar/overloaded.hh>
+
+namespace parquet4seastar {
+
+sort_order column_sort_order(const logical_type::logical_type& type) {
+    using namespace logical_type;
+    return std::visit(overloaded {
+        [] (const BOOLEAN&) { return sort_order::SIGNED; },
+        [] (const INT32&) { return sort_order::SIGNED; },
+        [] (const INT64&) { return sort_order::SIGNED; },
+        [] (const FLOAT&) { return sort_order::SIGNED; },
+        [] (const DOUBLE&) { return sort_order::SIGNED; },
+        [] (const INT8&) { return sort_order::SIGNED; },
+        [] (const INT16&) { return sort_order::SIGNED; },
+        [] (const DECIMAL_INT32&) { return sort_order::SIGNED; },
+        [] (const DECIMAL_INT64&) { return sort_order::SIGNED; },
+        [] (const DATE&) { return sort_order::SIGNED; },
+        [] (const TIME_INT32&) { return sort_order::SIGNED; },
+        [] (const TIME_INT64&) { return sort_order::SIGNED; },
+        [] (const TIMESTAMP&) { return sort_order::SIGNED; },
+        [] (const UINT8&) { return sort_order::UNSIGNED; },
+        [] (const UINT16&) { return sort_order::UNSIGNED; },
+        [] (const UINT32&) { return sort_order::UNSIGNED; },
+        [] (const UINT64&) { return sort_order::UNSIGNED; },
+        [] (const BYTE_ARRAY&) { return sort_order::UNSIGNED; },
+        [] (const FIXED_LEN_BYTE_ARRAY&) { return sort_order::UNSIGNED; },
+        [] (const STRING&) { return sort_order::UNSIGNED; },
+        [] (const ENUM&) { return sort_order::UNSIGNED; },
+        [] (const UUID&) { return sort_order::UNSIGNED; },
+        [] (const JSON&) { return sort_order::UNSIGNED; },
+        [] (const BSON&) { return sort_order::UNSIGNED; },
+        [] (const auto&) { return sort_order::UNKNOWN; },
+    }, type);
+}
+
+sort_order column_sort_order(const format::SchemaElement& leaf) {
+    try {
+        return column_sort_order(logical_type::read_logical_type(leaf));
+    } catch (const parquet_exception&) {
+        return sort_order::UNKNOWN;
+    }
+}
+
+namespace {
+
+template <typename T>
+std::optional<scalar> decode_fixed(const std::string& plain) {
+    if (plain.size() != sizeof(T)) {
+        return std::nullopt;
+    }
+    T value;
+    std::memcpy(&value, plain.data(), sizeof(T));
+    if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(value)) {
+            return std::nullopt;
+        }
+    }
+    return scalar{value};
+}
+
+} // namespace
+
+std::optional<scalar> decode_scalar(format::Type::type type, const std::string& plain) {
+    switch (type) {
+    case format::Type::BOOLEAN:
+        if (plain.size() != 1) {
+            return std::nullopt;
+        }
+        return scalar{plain[0] != 0};
+    case format::Type::INT32:
+        return decode_fixed<int32_t>(plain);
+    case format::Type::INT64:
+        return decode_fixed<int64_t>(plain);
+    case format::Type::FLOAT:
+        return decode_fixed<float>(plain);
+    case format::Type::DOUBLE:
+        return decode_fixed<double>(plain);
+    case format::Type::BYTE_ARRAY:
+    case format::Type::FIXED_LEN_BYTE_ARRAY:
+        return scalar{bytes(reinterpret_cast<const uint8_t*>(plain.data()), plain.size())};
+    default:
+        return std::nullopt;
+    }
+}
+
+std::string encode_scalar(const scalar& value) {
+    return std::visit(overloaded {
+        [] (bool x) { return std::string(1, x ? '\1' : '\0'); },
+        [] (const bytes& x) { return std::string(reinterpret_cast<const char*>(x.data()), x.size()); },
+        [] (auto x) {
+            std::string s(sizeof(x), '\0');
+            std::memcpy(s.data(), &x, sizeof(x));
+            return s;
+        },
+    }, value);
+}
+
+int compare(const scalar& a, const scalar& b, sort_order order) {
+    if (a.index() != b.index()) {
+        throw parquet_exception("Comparison of values of different types");
+    }
+    return std::visit(overloaded {
+        [&] (const bytes& x) {
+            int c = bytes_view{x}.compare(std::get<bytes>(b));
+            return c < 0 ? -1 : c > 0 ? 1 : 0;
+        },
+        [&] (auto x) {
+            using T = decltype(x);
+            T y = std::get<T>(b);
+            if constexpr (std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t>) {
+                if (order == sort_order::UNSIGNED) {
+                    using U = std::make_unsigned_t<T>;
+                    return static_cast<U>(x) < static_cast<U>(y) ? -1 : static_cast<U>(x) > static_cast<U>(y) ? 1 : 0;
+                }
+            }
+            return x < y ? -1 : y < x ? 1 : 0;
+        },
+    }, a);
+}
+
+bool has_type_defined_order(const format::FileMetaData& metadata, uint32_t column) {
+    return metadata.__isset.column_orders
+           && column < metadata.column_orders.size()
+           && metadata.column_orders[column].__isset.TYPE_ORDER;
+}
+
+column_statistics read_statistics(
+        const format::ColumnMetaData& column_metadata, const format::SchemaElement& leaf, bool type_defined_order) {
+    column_statistics result;
+    result.num_values = column_metadata.num_values;
+    result.order = column_sort_order(leaf);
+    if (!column_metadata.__isset.statistics) {
+        return result;
+    }
+    const format::Statistics& stats = column_metadata.statistics;
+    if (stats.__isset.null_count) {
+        result.null_count = stats.null_count;
+    }
+    if (result.order == sort_order::UNKNOWN) {
+        return result;
+    }
+    if (type_defined_order && stats.__isset.min_value && stats.__isset.max_value) {
+        result.min = decode_scalar(column_metadata.type, stats.min_value);
+        result.max = decode_scalar(column_metadata.type, stats.max_value);
+    } else if (stats.__isset.min && stats.__isset.max
+               && result.order == sort_order::SIGNED
+               && column_metadata.type != format::Type::BYTE_ARRAY
+               && column_metadata.type != format::Type::FIXED_LEN_BYTE_ARRAY) {
+        // The deprecated fields were compared as signed values, which is only right for signed types.
+        result.min = decode_scalar(column_metadata.type, stats.min);
+        result.max = decode_scalar(column_metadata.type, stats.max);
+    }
+    if (!result.min || !result.max) {
+        result.min.reset();
+        result.max.reset();
+    }
+    return result;
+}
+
+bool may_match(const column_statistics& stats, const predicate& p) {
+    bool all_null = stats.null_count && *stats.null_count >= stats.num_values;
+    switch (p.cmp) {
+    case predicate::op::is_null:
+        return !stats.null_count || *stats.null_count > 0;
+    case predicate::op::is_not_null:
+        return !all_null;
+    default:
+        break;
+    }
+    if (all_null) {
+        return false;
+    }
+    if (!stats.min || !stats.max) {
+        return true;
+    }
+    if (p.value.index() != stats.min->index()) {
+        throw parquet_exception(seastar::format(
+                "Predicate on column {} compares it with a value of a different type", p.column));
+    }
+    if (std::visit([] (auto x) {
+            if constexpr (std::is_floating_point_v<decltype(x)>) {
+                return std::isnan(x);
+            } else {
+                return false;
+            }
+        }, p.value)) {
+        return true;
+    }
+    switch (p.cmp) {
+    case predicate::op::eq:
+        return compare(*stats.min, p.value, stats.order) <= 0 && compare(p.value, *stats.max, stats.order) <= 0;
+    case predicate::op::lt:
+        return compare(*stats.min, p.value, stats.order) < 0;
+    case predicate::op::le:
+        return compare(*stats.min, p.value, stats.order) <= 0;
+    case predicate::op::gt:
+        return compare(*stats.max, p.value, stats.order) > 0;
+    case predicate::op::ge:
+        return compare(*stats.max, p.value, stats.order) >= 0;
+    default:
+        return true;
+    }
+}
+
+} // namespace parquet4seastar
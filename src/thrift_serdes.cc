@@ -77,7 +77,9 @@ void peekable_stream::ensure_space(size_t n) {
 
 // Assuming there is k bytes remaining in stream, view the next unconsumed min(k, n) bytes.
 seastar::future<bytes_view> peekable_stream::peek(size_t n) {
-    if (n == 0) {
+    if (_mapping) {
+        return seastar::make_ready_future<bytes_view>(_mapped.substr(0, n));
+    } else if (n == 0) {
         return seastar::make_ready_future<bytes_view>();
     } else if (_buffer_end - _buffer_start >= n) {
         return seastar::make_ready_future<bytes_view>(
@@ -93,6 +95,16 @@ seastar::future<bytes_view> peekable_stream::peek(size_t n) {
 
 // Consume n bytes. If there is less than n bytes in stream, throw.
 seastar::future<> peekable_stream::advance(size_t n) {
+    if (_mapping) {
+        if (n > _mapped.size()) {
+            return seastar::make_exception_future<>(parquet_exception::corrupted_file(seastar::format(
+                    "Unexpected end of column chunk while skipping {}B ({}B left)", n, _mapped.size())));
+        }
+        _position += n;
+        _mapped.remove_prefix(n);
+        return seastar::make_ready_future<>();
+    }
+    _position += n;
     if (_buffer_end - _buffer_start > n) {
         _buffer_start += n;
         return seastar::make_ready_future<>();
@@ -105,4 +117,18 @@ seastar::future<> peekable_stream::advance(size_t n) {
     }
 }
 
+void peekable_stream::shrink(size_t max_size) {
+    size_t unconsumed = _buffer_end - _buffer_start;
+    if (_buffer.size() <= max_size || unconsumed > max_size) {
+        return;
+    }
+    buffer b{unconsumed};
+    if (unconsumed > 0) {
+        std::memcpy(b.data(), _buffer.data() + _buffer_start, unconsumed);
+    }
+    _buffer = std::move(b);
+    _buffer_start = 0;
+    _buffer_end = unconsumed;
+}
+
 } // namespace parquet4seastar
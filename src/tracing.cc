@@ -0,0 +1,131 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/tracing.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/smp.hh>
+#include <seastar/core/do_with.hh>
+#include <unistd.h>
+
+namespace parquet4seastar::tracing {
+
+namespace detail {
+
+thread_local tracer* current = nullptr;
+
+} // namespace detail
+
+void set_tracer(tracer* t) {
+    detail::current = t;
+}
+
+const char* phase_name(phase p) {
+    switch (p) {
+    case phase::open: return "open";
+    case phase::page_header: return "page_header";
+    case phase::page_read: return "page_read";
+    case phase::decompress: return "decompress";
+    case phase::decode: return "decode";
+    }
+    return "unknown";
+}
+
+void append_json_string(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out += seastar::format("\\u{:04x}", static_cast<unsigned>(c));
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+namespace {
+
+int64_t to_microseconds(trace_clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+} // namespace
+
+void chrome_trace_writer::record(const event& e) {
+    if (_n_events >= _max_events) {
+        ++_dropped;
+        return;
+    }
+    if (_n_events > 0) {
+        _events += ",\n";
+    }
+    ++_n_events;
+    _events += "{\"name\":\"";
+    _events += phase_name(e.phase);
+    _events += seastar::format("\",\"cat\":\"parquet4seastar\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":{},\"tid\":{},\"args\":{{",
+            to_microseconds(e.start.time_since_epoch()), to_microseconds(e.end - e.start),
+            ::getpid(), seastar::this_shard_id());
+    if (e.ctx) {
+        _events += "\"file\":";
+        append_json_string(_events, e.ctx->file);
+        if (!e.ctx->column.empty()) {
+            _events += ",\"column\":";
+            append_json_string(_events, e.ctx->column);
+        }
+        _events += ',';
+    }
+    _events += seastar::format("\"page\":{},\"compressed_size\":{},\"uncompressed_size\":{}}}}}",
+            e.page_ordinal, e.compressed_size, e.uncompressed_size);
+}
+
+void chrome_trace_writer::clear() {
+    _events.clear();
+    _n_events = 0;
+    _dropped = 0;
+}
+
+std::string chrome_trace_writer::json() const {
+    return seastar::format("{{\"traceEvents\":[\n{}\n],\"displayTimeUnit\":\"ms\",\"otherData\":{{\"dropped_events\":{}}}}}\n",
+            _events, _dropped);
+}
+
+seastar::future<> chrome_trace_writer::write(std::string path) const {
+    auto flags = seastar::open_flags::wo | seastar::open_flags::create | seastar::open_flags::truncate;
+    return seastar::open_file_dma(path, flags).then([trace = json()] (seastar::file f) mutable {
+        return seastar::do_with(seastar::make_file_output_stream(std::move(f)), std::move(trace),
+        [] (seastar::output_stream<char>& out, const std::string& trace) {
+            return out.write(trace.data(), trace.size()).then([&out] {
+                return out.flush();
+            }).finally([&out] {
+                return out.close();
+            });
+        });
+    });
+}
+
+} // namespace parquet4seastar::tracing
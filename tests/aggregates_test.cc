@@ -0,0 +1,171 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <parquet4seastar/aggregates.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <parquet4seastar/memory_limiter.hh>
+
+namespace parquet4seastar {
+
+namespace {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_aggregates_test.parquet";
+constexpr int32_t rows_per_row_group = 200;
+constexpr int32_t n_rows = 2 * rows_per_row_group;
+
+bytes to_bytes(const std::string& s) {
+    return bytes(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+}
+
+// Row i has: a = i, or null if i % 3 == 0; s = "v{i % 10}", dictionary-encoded, or null if i % 5 == 0;
+// p = "w{i:03}", plain-encoded; l = a list of i % 3 copies of i.
+void write_test_file() {
+    using namespace writer_schema;
+    schema schema;
+    schema.fields.push_back(primitive_node{"a", true, logical_type::INT32{}});
+    schema.fields.push_back(primitive_node{"s", true, logical_type::STRING{}, {}, format::Encoding::RLE_DICTIONARY});
+    schema.fields.push_back(primitive_node{"p", false, logical_type::STRING{}});
+    schema.fields.push_back(list_node{"l", true, std::make_unique<node>(primitive_node{"element", false, logical_type::INT32{}})});
+    std::unique_ptr<file_writer> fw = file_writer::open(std::string(test_file_name), schema).get0();
+    for (int32_t i = 0; i < n_rows; ++i) {
+        fw->column<format::Type::INT32>(0).put(i % 3 ? 1 : 0, 0, i);
+        bytes s = to_bytes(seastar::format("v{}", i % 10));
+        fw->column<format::Type::BYTE_ARRAY>(1).put(i % 5 ? 1 : 0, 0, s);
+        bytes p = to_bytes(seastar::format("w{:03}", i));
+        fw->column<format::Type::BYTE_ARRAY>(2).put(0, 0, p);
+        if (i % 3 == 0) {
+            fw->column<format::Type::INT32>(3).put(1, 0, 0);
+        }
+        for (int32_t j = 0; j < i % 3; ++j) {
+            fw->column<format::Type::INT32>(3).put(2, j ? 1 : 0, i);
+        }
+        if (i % rows_per_row_group == rows_per_row_group - 1) {
+            fw->flush_row_group().get();
+        }
+    }
+    fw->close().get();
+}
+
+} // namespace
+
+SEASTAR_TEST_CASE(aggregates) {
+    return seastar::async([] {
+        write_test_file();
+        file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+
+        // From statistics only.
+        column_aggregate a = aggregate_column(fr, 0).get0();
+        BOOST_CHECK_EQUAL(a.rows, n_rows);
+        BOOST_CHECK_EQUAL(a.values, 266);
+        BOOST_CHECK(a.min == scalar{int32_t(1)});
+        BOOST_CHECK(a.max == scalar{int32_t(398)});
+        BOOST_CHECK(!a.decoded);
+
+        a = aggregate_column_chunk(fr, 1, 0).get0();
+        BOOST_CHECK_EQUAL(a.rows, rows_per_row_group);
+        BOOST_CHECK_EQUAL(a.values, 133);
+        BOOST_CHECK(a.min == scalar{int32_t(200)});
+
+        // From the dictionary.
+        column_aggregate s = aggregate_column(fr, 1).get0();
+        BOOST_CHECK_EQUAL(s.values, 320);
+        BOOST_CHECK(s.min == scalar{to_bytes("v1")});
+        BOOST_CHECK(s.max == scalar{to_bytes("v9")});
+        BOOST_CHECK(!s.decoded);
+
+        // By decoding the values.
+        column_aggregate p = aggregate_column(fr, 2).get0();
+        BOOST_CHECK_EQUAL(p.values, n_rows);
+        BOOST_CHECK(p.min == scalar{to_bytes("w000")});
+        BOOST_CHECK(p.max == scalar{to_bytes("w399")});
+        BOOST_CHECK(p.decoded);
+        p = aggregate_column(fr, 2, false).get0();
+        BOOST_CHECK(!p.min && !p.decoded);
+
+        // By counting definition levels.
+        column_aggregate l = aggregate_column(fr, 3).get0();
+        BOOST_CHECK_EQUAL(l.rows, n_rows);
+        BOOST_CHECK_EQUAL(l.values, 399);
+        BOOST_CHECK(l.min == scalar{int32_t(1)});
+        BOOST_CHECK(l.max == scalar{int32_t(398)});
+        BOOST_CHECK(!l.decoded);
+
+        BOOST_CHECK_THROW(aggregate_column(fr, 4).get(), parquet_exception);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(values_are_counted_from_levels) {
+    return seastar::async([] {
+        write_test_file();
+        file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+
+        auto a = fr.open_column_chunk_reader<format::Type::INT32>(0, 0).get0();
+        chunk_value_counts counts = a.count_values().get0();
+        BOOST_CHECK_EQUAL(counts.levels, rows_per_row_group);
+        BOOST_CHECK_EQUAL(counts.values, 133);
+        BOOST_CHECK(!counts.dictionary_encoded);
+
+        auto s = fr.open_column_chunk_reader<format::Type::BYTE_ARRAY>(0, 1).get0();
+        counts = s.count_values().get0();
+        BOOST_CHECK_EQUAL(counts.levels, rows_per_row_group);
+        BOOST_CHECK_EQUAL(counts.values, 160);
+        BOOST_CHECK(counts.dictionary_encoded);
+        // "v0" and "v5" are only in null rows.
+        BOOST_CHECK_EQUAL(s.dictionary()->size(), 8);
+
+        // 67 empty lists, 67 lists of one element and 66 lists of two.
+        auto l = fr.open_column_chunk_reader<format::Type::INT32>(0, 3).get0();
+        counts = l.count_values().get0();
+        BOOST_CHECK_EQUAL(counts.levels, 67 + 67 + 132);
+        BOOST_CHECK_EQUAL(counts.values, 67 + 132);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(aggregates_under_a_one_reader_limit) {
+    return seastar::async([] {
+        write_test_file();
+        io_options options;
+        options.read_buffer_size = 4096;
+        options.read_ahead = 1;
+        // The stream buffers of a single column chunk reader.
+        memory_limiter limiter{8192};
+        options.memory = &limiter;
+        file_reader fr = file_reader::open(std::string(test_file_name), options).get0();
+
+        column_aggregate s = aggregate_column(fr, 1).get0();
+        BOOST_CHECK_EQUAL(s.values, 320);
+        BOOST_CHECK(s.max == scalar{to_bytes("v9")});
+        column_aggregate p = aggregate_column(fr, 2).get0();
+        BOOST_CHECK_EQUAL(p.values, n_rows);
+        BOOST_CHECK(p.max == scalar{to_bytes("w399")});
+        BOOST_CHECK(p.decoded);
+        column_aggregate l = aggregate_column(fr, 3).get0();
+        BOOST_CHECK_EQUAL(l.values, 399);
+        BOOST_CHECK_EQUAL(limiter.used(), 0);
+        fr.close().get();
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,321 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/* Steady-state allocation budgets of the reader and writer hot paths.
+ * Allocations are counted with seastar::memory::stats(), after a warmup
+ * which lets buffers and dictionaries reach their final size.
+ * After the warmup, nothing allocates per value or per record: the budgets are per page,
+ * and each is the sum of the allocations listed for it. Lower them as the paths stop
+ * allocating, so that regressions fail the test.
+ * The file is read mapped, so that the allocations of the I/O layer are not counted.
+ */
+
+#include <parquet4seastar/file_writer.hh>
+#include <parquet4seastar/record_reader.hh>
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/core/memory.hh>
+
+using namespace parquet4seastar;
+
+namespace {
+
+// value_decoder::read_batch, within a page.
+constexpr uint64_t decoder_mallocs_per_batch = 0;
+// value_decoder::reset and the first batch: the decoder itself, and either the copy of a PLAIN
+// BYTE_ARRAY page and the deleter shared by its values, or the block buffers of DELTA_BINARY_PACKED.
+constexpr uint64_t decoder_mallocs_per_page = 3;
+// deserialize_thrift_msg of a page header: the transport (and its configuration, in newer Thrift),
+// the protocol and its control block, and the field id stack of the protocol.
+constexpr uint64_t page_header_mallocs = 6;
+// GZIP decompression: the zlib stream, its inflate state and window, and the do_with state.
+// SNAPPY decompresses into the reused buffer of the reader, and uncompressed mapped pages are read in place.
+constexpr uint64_t gzip_mallocs_per_page = 4;
+// column_chunk_reader, per page: page_reader::next_page, decompression and decoder reset.
+constexpr uint64_t reader_mallocs_per_page(format::CompressionCodec::type codec) {
+    return page_header_mallocs + decoder_mallocs_per_page
+            + (codec == format::CompressionCodec::GZIP ? gzip_mallocs_per_page : 0);
+}
+// record_reader::read_one with a consumer which doesn't allocate.
+constexpr uint64_t record_reader_mallocs_per_record = 0;
+// column_chunk_writer::put, amortized over a page.
+constexpr uint64_t writer_mallocs_per_value = 0;
+// column_chunk_writer::flush_page (compression and page buffers).
+constexpr uint64_t writer_mallocs_per_page = 16;
+
+constexpr size_t batch_size = 1024;
+constexpr size_t values_per_page = 16 * batch_size;
+constexpr size_t pages = 8;
+
+class malloc_counter {
+    uint64_t _start = seastar::memory::stats().mallocs();
+public:
+    uint64_t count() const { return seastar::memory::stats().mallocs() - _start; }
+};
+
+// In builds which use the system allocator (e.g. debug), seastar doesn't count allocations.
+bool mallocs_are_counted() {
+    static void* volatile sink;
+    malloc_counter counter;
+    sink = std::malloc(16);
+    std::free(sink);
+    return counter.count() > 0;
+}
+
+template <format::Type::type T>
+void check_decoder_steady_state(
+        format::Encoding::type encoding,
+        const std::vector<typename value_decoder_traits<T>::input_type>& values) {
+    auto encoder = make_value_encoder<T>(encoding);
+    encoder->put_batch(values.data(), values.size());
+    bytes page(encoder->max_encoded_size(), 0);
+    auto flush_result = encoder->flush(page.data());
+    page.resize(flush_result.size);
+
+    using output_type = typename value_decoder_traits<T>::output_type;
+    std::vector<output_type> dict;
+    value_decoder<T> decoder{{}};
+    if (auto dict_page = encoder->view_dict()) {
+        value_decoder<T> dict_decoder{{}};
+        dict_decoder.reset(*dict_page, format::Encoding::PLAIN);
+        dict.resize(encoder->cardinality());
+        dict_decoder.read_batch(dict.size(), dict.data());
+        decoder.reset_dict(dict.data(), dict.size());
+    }
+    std::vector<output_type> out(batch_size);
+
+    for (size_t i = 0; i < pages; ++i) {
+        malloc_counter page_counter;
+        decoder.reset(page, flush_result.encoding);
+        BOOST_REQUIRE_EQUAL(decoder.read_batch(batch_size, out.data()), batch_size);
+        uint64_t reset_mallocs = page_counter.count();
+        BOOST_CHECK_LE(reset_mallocs, decoder_mallocs_per_page);
+
+        malloc_counter batch_counter;
+        size_t batches = 0;
+        while (decoder.read_batch(batch_size, out.data()) > 0) {
+            ++batches;
+        }
+        BOOST_REQUIRE_EQUAL(batches, values.size() / batch_size - 1);
+        BOOST_CHECK_LE(batch_counter.count(), batches * decoder_mallocs_per_batch);
+    }
+}
+
+std::vector<int32_t> int32_values(size_t cardinality) {
+    std::vector<int32_t> v;
+    for (size_t i = 0; i < values_per_page; ++i) {
+        v.push_back((i * 7919) % cardinality);
+    }
+    return v;
+}
+
+struct string_values {
+    std::vector<bytes> storage;
+    std::vector<bytes_view> views;
+    explicit string_values(size_t cardinality) {
+        for (size_t i = 0; i < cardinality; ++i) {
+            storage.push_back(bytes(8 + i % 16, 'a' + i % 26));
+        }
+        for (size_t i = 0; i < values_per_page; ++i) {
+            views.push_back(storage[(i * 7919) % cardinality]);
+        }
+    }
+};
+
+const std::string test_file_name = "/tmp/parquet4seastar_allocation_test.parquet";
+
+writer_schema::schema test_schema() {
+    using namespace writer_schema;
+    schema root;
+    root.fields.push_back(primitive_node{
+            "int64", false, logical_type::INT64{}, {}, format::Encoding::PLAIN, format::CompressionCodec::UNCOMPRESSED});
+    root.fields.push_back(primitive_node{
+            "string", false, logical_type::STRING{}, {}, format::Encoding::RLE_DICTIONARY, format::CompressionCodec::SNAPPY});
+    root.fields.push_back(primitive_node{
+            "double", true, logical_type::DOUBLE{}, {}, format::Encoding::PLAIN, format::CompressionCodec::GZIP});
+    return root;
+}
+
+// Writes `pages` pages of values_per_page rows to test_file_name, in one row group.
+void write_test_file() {
+    string_values strings{100};
+    std::unique_ptr<file_writer> fw = file_writer::open(test_file_name, test_schema()).get0();
+    auto& int64_column = fw->column<format::Type::INT64>(0);
+    auto& string_column = fw->column<format::Type::BYTE_ARRAY>(1);
+    auto& double_column = fw->column<format::Type::DOUBLE>(2);
+
+    uint64_t put_mallocs = 0;
+    uint64_t flush_mallocs = 0;
+    for (size_t page = 0; page < pages; ++page) {
+        malloc_counter put_counter;
+        for (size_t i = 0; i < values_per_page; ++i) {
+            int64_column.put(0, 0, i);
+            string_column.put(0, 0, strings.views[i]);
+            double_column.put(i % 10 != 0, 0, i * 0.5);
+        }
+        // The first page is the warmup: it sizes the encoders' buffers and fills the dictionary.
+        if (page > 0) {
+            put_mallocs += put_counter.count();
+        }
+        malloc_counter flush_counter;
+        int64_column.flush_page();
+        string_column.flush_page();
+        double_column.flush_page();
+        if (page > 0) {
+            flush_mallocs += flush_counter.count();
+        }
+    }
+    if (mallocs_are_counted()) {
+        BOOST_CHECK_LE(put_mallocs, (pages - 1) * values_per_page * 3 * writer_mallocs_per_value);
+        BOOST_CHECK_LE(flush_mallocs, (pages - 1) * 3 * writer_mallocs_per_page);
+    }
+    fw->close().get();
+}
+
+io_options mapped() {
+    io_options options;
+    options.mmap = mmap_policy::always;
+    return options;
+}
+
+format::CompressionCodec::type codec(const file_reader& fr, uint32_t column) {
+    return fr.metadata().row_groups[0].columns[column].meta_data.codec;
+}
+
+template <format::Type::type T>
+void check_column_chunk_reader_steady_state(file_reader& fr, uint32_t column) {
+    using output_type = typename value_decoder_traits<T>::output_type;
+    column_chunk_reader<T> reader = fr.open_column_chunk_reader<T>(0, column).get0();
+    std::vector<output_type> values(batch_size);
+    std::vector<int16_t> def(batch_size);
+    std::vector<int16_t> rep(batch_size);
+
+    // Warmup: the first page, including the dictionary page, if any.
+    for (size_t i = 0; i < values_per_page / batch_size; ++i) {
+        BOOST_REQUIRE_EQUAL(reader.read_batch(batch_size, def.data(), rep.data(), values.data()).get0(), batch_size);
+    }
+    malloc_counter counter;
+    size_t levels = 0;
+    while (size_t n = reader.read_batch(batch_size, def.data(), rep.data(), values.data()).get0()) {
+        levels += n;
+    }
+    uint64_t mallocs = counter.count();
+    BOOST_REQUIRE_EQUAL(levels, (pages - 1) * values_per_page);
+    BOOST_CHECK_LE(mallocs, (pages - 1) * reader_mallocs_per_page(codec(fr, column)));
+}
+
+struct counting_consumer {
+    uint64_t values = 0;
+    void start_record() {}
+    void end_record() {}
+    void start_column(const std::string&) {}
+    void start_struct() {}
+    void end_struct() {}
+    void start_field(const std::string&) {}
+    void start_list() {}
+    void end_list() {}
+    void start_map() {}
+    void end_map() {}
+    void separate_key_value() {}
+    void separate_list_values() {}
+    void separate_map_values() {}
+    void append_null() { ++values; }
+    template <typename LogicalType, typename Value>
+    void append_value(LogicalType, Value&&) { ++values; }
+};
+
+} // namespace
+
+SEASTAR_TEST_CASE(value_decoders) {
+    return seastar::async([] {
+        if (!mallocs_are_counted()) {
+            return;
+        }
+        check_decoder_steady_state<format::Type::INT32>(format::Encoding::PLAIN, int32_values(1 << 30));
+        check_decoder_steady_state<format::Type::INT32>(format::Encoding::RLE_DICTIONARY, int32_values(100));
+        check_decoder_steady_state<format::Type::INT32>(format::Encoding::DELTA_BINARY_PACKED, int32_values(1 << 30));
+        string_values strings{100};
+        check_decoder_steady_state<format::Type::BYTE_ARRAY>(format::Encoding::PLAIN, strings.views);
+        check_decoder_steady_state<format::Type::BYTE_ARRAY>(format::Encoding::RLE_DICTIONARY, strings.views);
+    });
+}
+
+SEASTAR_TEST_CASE(page_header_deserialization) {
+    return seastar::async([] {
+        if (!mallocs_are_counted()) {
+            return;
+        }
+        format::DataPageHeader data_page_header;
+        data_page_header.__set_num_values(values_per_page);
+        data_page_header.__set_encoding(format::Encoding::RLE_DICTIONARY);
+        data_page_header.__set_definition_level_encoding(format::Encoding::RLE);
+        data_page_header.__set_repetition_level_encoding(format::Encoding::RLE);
+        format::PageHeader header;
+        header.__set_type(format::PageType::DATA_PAGE);
+        header.__set_uncompressed_page_size(values_per_page * 8);
+        header.__set_compressed_page_size(values_per_page * 4);
+        header.__set_data_page_header(data_page_header);
+        thrift_serializer serializer;
+        bytes serialized{serializer.serialize(header)};
+
+        format::PageHeader deserialized;
+        for (size_t i = 0; i < pages; ++i) {
+            malloc_counter counter;
+            BOOST_REQUIRE_EQUAL(deserialize_thrift_msg(serialized.data(), serialized.size(), deserialized),
+                    serialized.size());
+            BOOST_CHECK_LE(counter.count(), page_header_mallocs);
+        }
+        BOOST_CHECK(deserialized == header);
+    });
+}
+
+SEASTAR_TEST_CASE(writer_and_readers) {
+    return seastar::async([] {
+        write_test_file();
+        if (!mallocs_are_counted()) {
+            return;
+        }
+        file_reader fr = file_reader::open(test_file_name, mapped()).get0();
+        BOOST_REQUIRE(fr.mapped());
+        check_column_chunk_reader_steady_state<format::Type::INT64>(fr, 0);
+        check_column_chunk_reader_steady_state<format::Type::BYTE_ARRAY>(fr, 1);
+        check_column_chunk_reader_steady_state<format::Type::DOUBLE>(fr, 2);
+
+        record::record_reader rr = record::record_reader::make(fr, 0).get0();
+        counting_consumer consumer;
+        for (size_t i = 0; i < values_per_page; ++i) {
+            rr.read_one(consumer).get();
+        }
+        malloc_counter counter;
+        size_t records = values_per_page;
+        for (; records < pages * values_per_page; ++records) {
+            rr.read_one(consumer).get();
+        }
+        uint64_t mallocs = counter.count();
+        // The pages after the first of each column.
+        uint64_t page_mallocs = 0;
+        for (uint32_t column = 0; column < 3; ++column) {
+            page_mallocs += (pages - 1) * reader_mallocs_per_page(codec(fr, column));
+        }
+        BOOST_CHECK_LE(mallocs, page_mallocs + (records - values_per_page) * record_reader_mallocs_per_record);
+        fr.close().get();
+    });
+}
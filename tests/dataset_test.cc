@@ -0,0 +1,252 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <parquet4seastar/dataset.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <filesystem>
+#include <limits>
+
+namespace parquet4seastar {
+
+namespace {
+
+constexpr int32_t rows_per_row_group = 100;
+constexpr int row_groups_per_file = 3;
+
+// Column a holds the row number within the dataset. Column s is "x", except in the last
+// row group of every file, where it is null.
+void write_file(const std::string& path, int32_t first_row) {
+    writer_schema::schema schema;
+    schema.fields.push_back(writer_schema::primitive_node{"a", false, logical_type::INT32{}});
+    schema.fields.push_back(writer_schema::primitive_node{"s", true, logical_type::STRING{}});
+    std::unique_ptr<file_writer> fw = file_writer::open(path, schema).get0();
+    int32_t row = first_row;
+    const uint8_t x = 'x';
+    for (int rg = 0; rg < row_groups_per_file; ++rg) {
+        for (int32_t i = 0; i < rows_per_row_group; ++i, ++row) {
+            fw->column<format::Type::INT32>(0).put(0, 0, row);
+            if (rg + 1 < row_groups_per_file) {
+                fw->column<format::Type::BYTE_ARRAY>(1).put(1, 0, bytes_view{&x, 1});
+            } else {
+                fw->column<format::Type::BYTE_ARRAY>(1).put(0, 0, bytes_view{});
+            }
+        }
+        fw->flush_row_group().get();
+    }
+    fw->close().get();
+}
+
+std::vector<std::string> write_files() {
+    std::vector<std::string> paths = {
+        "/tmp/parquet4seastar_dataset_test_1.parquet",
+        "/tmp/parquet4seastar_dataset_test_2.parquet",
+        "/tmp/parquet4seastar_dataset_test_3.parquet"};
+    for (size_t i = 0; i < paths.size(); ++i) {
+        write_file(paths[i], i * row_groups_per_file * rows_per_row_group);
+    }
+    return paths;
+}
+
+struct summing_consumer {
+    int64_t records = 0;
+    int64_t sum = 0;
+    void start_record() {}
+    void end_record() { ++records; }
+    void start_column(const std::string&) {}
+    void start_struct() {}
+    void end_struct() {}
+    void start_field(const std::string&) {}
+    void start_list() {}
+    void end_list() {}
+    void start_map() {}
+    void end_map() {}
+    void separate_key_value() {}
+    void separate_list_values() {}
+    void separate_map_values() {}
+    void append_null() {}
+    void append_value(logical_type::INT32, int32_t v) { sum += v; }
+    template <typename LogicalType, typename Value>
+    void append_value(LogicalType, Value&&) {}
+    std::pair<int64_t, int64_t> finish() { return {records, sum}; }
+};
+
+} // namespace
+
+SEASTAR_TEST_CASE(statistics_are_compared_in_column_order) {
+    statistics_builder<format::Type::INT32> unsigned_builder{sort_order::UNSIGNED};
+    unsigned_builder.put(-1);
+    unsigned_builder.put(1);
+    unsigned_builder.put_null();
+    format::Statistics stats = unsigned_builder.flush();
+    BOOST_CHECK_EQUAL(stats.null_count, 1);
+    BOOST_CHECK(*decode_scalar(format::Type::INT32, stats.min_value) == scalar{int32_t(1)});
+    BOOST_CHECK(*decode_scalar(format::Type::INT32, stats.max_value) == scalar{int32_t(-1)});
+
+    statistics_builder<format::Type::DOUBLE> double_builder{sort_order::SIGNED};
+    double_builder.put(std::numeric_limits<double>::quiet_NaN());
+    double_builder.put(2.0);
+    double_builder.put(-3.0);
+    stats = double_builder.flush();
+    BOOST_CHECK(*decode_scalar(format::Type::DOUBLE, stats.min_value) == scalar{-3.0});
+    BOOST_CHECK(*decode_scalar(format::Type::DOUBLE, stats.max_value) == scalar{2.0});
+
+    statistics_builder<format::Type::BYTE_ARRAY> bytes_builder{sort_order::UNSIGNED};
+    const uint8_t b[] = {0x80, 0x01};
+    bytes_builder.put(bytes_view{b, 1});
+    bytes_builder.put(bytes_view{b + 1, 1});
+    stats = bytes_builder.flush();
+    BOOST_CHECK(stats.min_value == "\x01");
+    BOOST_CHECK(stats.max_value == "\x80");
+
+    column_statistics cs;
+    cs.min = scalar{int32_t(10)};
+    cs.max = scalar{int32_t(20)};
+    cs.null_count = 0;
+    cs.num_values = 11;
+    cs.order = sort_order::SIGNED;
+    BOOST_CHECK(may_match(cs, {0, predicate::op::eq, int32_t(15)}));
+    BOOST_CHECK(!may_match(cs, {0, predicate::op::lt, int32_t(10)}));
+    BOOST_CHECK(may_match(cs, {0, predicate::op::le, int32_t(10)}));
+    BOOST_CHECK(!may_match(cs, {0, predicate::op::gt, int32_t(20)}));
+    BOOST_CHECK(!may_match(cs, {0, predicate::op::is_null, int32_t(0)}));
+    BOOST_CHECK_THROW(may_match(cs, {0, predicate::op::eq, int64_t(15)}), parquet_exception);
+    return seastar::make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(row_groups_are_selected_by_statistics) {
+    return seastar::async([] {
+        dataset ds = dataset::open(write_files(), dataset_options{io_options{}, 2}).get0();
+        BOOST_CHECK_EQUAL(ds.num_rows(), 900);
+        uint32_t a = ds.leaf_index("a");
+        uint32_t s = ds.leaf_index("s");
+        BOOST_CHECK_THROW(ds.leaf_index("b"), parquet_exception);
+
+        column_statistics stats = read_statistics(
+                ds.metadata(1).row_groups[0].columns[a].meta_data, ds.raw_schema().leaves[a]->info,
+                has_type_defined_order(ds.metadata(1), a));
+        BOOST_CHECK(stats.min == scalar{int32_t(300)});
+        BOOST_CHECK(stats.max == scalar{int32_t(399)});
+
+        std::vector<row_group_ref> selected = ds.select_row_groups({
+                {a, predicate::op::ge, int32_t(250)},
+                {a, predicate::op::lt, int32_t(400)}});
+        BOOST_REQUIRE_EQUAL(selected.size(), 2);
+        BOOST_CHECK_EQUAL(selected[0].file, 0);
+        BOOST_CHECK_EQUAL(selected[0].row_group, 2);
+        BOOST_CHECK_EQUAL(selected[0].position, 0);
+        BOOST_CHECK_EQUAL(selected[1].file, 1);
+        BOOST_CHECK_EQUAL(selected[1].row_group, 0);
+        BOOST_CHECK_EQUAL(selected[1].position, 1);
+
+        BOOST_CHECK(ds.select_row_groups({{a, predicate::op::gt, int32_t(1000)}}).empty());
+        BOOST_CHECK_EQUAL(ds.select_row_groups({{s, predicate::op::is_null, int32_t(0)}}).size(), 3);
+        BOOST_CHECK_EQUAL(ds.select_row_groups({{s, predicate::op::is_not_null, int32_t(0)}}).size(), 6);
+        BOOST_CHECK_EQUAL(ds.select_row_groups({{s, predicate::op::eq, bytes{'y'}}}).size(), 0);
+        BOOST_CHECK_THROW(ds.select_row_groups({{7, predicate::op::is_null, int32_t(0)}}), parquet_exception);
+    });
+}
+
+SEASTAR_TEST_CASE(dataset_scan) {
+    return seastar::async([] {
+        dataset ds = dataset::open(write_files()).get0();
+        sharded_scan_options options;
+        options.order = scan_order::ordered;
+        std::vector<uint64_t> positions;
+        int64_t records = 0;
+        int64_t sum = 0;
+        ds.scan({{ds.leaf_index("a"), predicate::op::ge, int32_t(550)}}, options,
+                [] (const row_group_ref&) { return summing_consumer{}; },
+                [&] (const row_group_ref& ref, std::pair<int64_t, int64_t> result) {
+                    positions.push_back(ref.position);
+                    records += result.first;
+                    sum += result.second;
+                }).get();
+        // The row groups of 500..599, 600..699, 700..799 and 800..899.
+        BOOST_CHECK(positions == (std::vector<uint64_t>{0, 1, 2, 3}));
+        BOOST_CHECK_EQUAL(records, 400);
+        BOOST_CHECK_EQUAL(sum, (500 + 899) * 400 / 2);
+    });
+}
+
+SEASTAR_TEST_CASE(summary_file) {
+    return seastar::async([] {
+        std::vector<std::string> paths = write_files();
+        summary_builder summary;
+        for (const std::string& path : paths) {
+            file_reader fr = file_reader::open(path).get0();
+            summary.add(std::filesystem::path(path).filename().string(), fr.metadata());
+            fr.close().get();
+        }
+        std::string summary_path = "/tmp/parquet4seastar_dataset_test_metadata";
+        summary.write(summary_path).get();
+
+        dataset ds = dataset::open_summary(summary_path).get0();
+        BOOST_CHECK(ds.paths() == paths);
+        BOOST_CHECK_EQUAL(ds.num_rows(), 900);
+        std::vector<row_group_ref> selected = ds.select_row_groups({{ds.leaf_index("a"), predicate::op::eq, int32_t(450)}});
+        BOOST_REQUIRE_EQUAL(selected.size(), 1);
+        BOOST_CHECK_EQUAL(selected[0].file, 1);
+        BOOST_CHECK_EQUAL(selected[0].row_group, 1);
+
+        int64_t records = 0;
+        ds.scan({}, sharded_scan_options{},
+                [] (const row_group_ref&) { return summing_consumer{}; },
+                [&] (const row_group_ref&, std::pair<int64_t, int64_t> result) { records += result.first; }).get();
+        BOOST_CHECK_EQUAL(records, 900);
+
+        // The summary file can also be read directly, through the file paths of its column chunks.
+        file_reader fr = file_reader::open(summary_path).get0();
+        BOOST_CHECK_EQUAL(fr.metadata().row_groups.size(), 9);
+        summing_consumer consumer;
+        for (uint32_t rg = 0; rg < fr.metadata().row_groups.size(); ++rg) {
+            record::record_reader rr = record::record_reader::make(fr, rg).get0();
+            rr.read_all(consumer).get();
+        }
+        fr.close().get();
+        BOOST_CHECK_EQUAL(consumer.records, 900);
+        BOOST_CHECK_EQUAL(consumer.sum, 899 * 900 / 2);
+    });
+}
+
+SEASTAR_TEST_CASE(mismatched_schemata_are_rejected) {
+    return seastar::async([] {
+        std::vector<std::string> paths = write_files();
+        std::string other = "/tmp/parquet4seastar_dataset_test_other.parquet";
+        writer_schema::schema schema;
+        schema.fields.push_back(writer_schema::primitive_node{"a", false, logical_type::INT64{}});
+        std::unique_ptr<file_writer> fw = file_writer::open(other, schema).get0();
+        fw->column<format::Type::INT64>(0).put(0, 0, 1);
+        fw->close().get();
+        paths.push_back(other);
+        BOOST_CHECK_THROW(dataset::open(paths).get(), parquet_exception);
+        BOOST_CHECK_THROW(dataset::open({}).get(), parquet_exception);
+
+        summary_builder summary;
+        file_reader fr = file_reader::open(paths[0]).get0();
+        summary.add("1.parquet", fr.metadata());
+        fr.close().get();
+        BOOST_CHECK_THROW(summary.add("other.parquet", fw->metadata()), parquet_exception);
+    });
+}
+
+} // namespace parquet4seastar
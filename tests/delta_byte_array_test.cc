@@ -124,3 +124,63 @@ BOOST_AUTO_TEST_CASE(happy) {
             std::begin(out), std::end(out),
             std::begin(expected), std::end(expected)));
 }
+
+namespace {
+
+parquet4seastar::bytes encode_delta_binary_packed(const std::vector<int32_t>& values) {
+    using namespace parquet4seastar;
+    auto encoder = make_value_encoder<format::Type::INT32>(format::Encoding::DELTA_BINARY_PACKED);
+    encoder->put_batch(values.data(), values.size());
+    bytes out(encoder->max_encoded_size(), 0);
+    auto flush_result = encoder->flush(out.data());
+    out.resize(flush_result.size);
+    return out;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(sorted_strings_in_small_batches) {
+    using namespace parquet4seastar;
+
+    std::vector<std::string> strings;
+    for (int i = 0; i < 5000; ++i) {
+        strings.push_back("some_common_key_prefix_" + std::to_string(1000000 + i * 7));
+    }
+
+    std::vector<int32_t> prefix_lengths;
+    std::vector<int32_t> suffix_lengths;
+    bytes suffixes;
+    std::string last;
+    for (const std::string& s : strings) {
+        size_t prefix = 0;
+        while (prefix < last.size() && prefix < s.size() && last[prefix] == s[prefix]) {
+            ++prefix;
+        }
+        prefix_lengths.push_back(prefix);
+        suffix_lengths.push_back(s.size() - prefix);
+        suffixes.insert(suffixes.end(), s.begin() + prefix, s.end());
+        last = s;
+    }
+    bytes test_data
+            = encode_delta_binary_packed(prefix_lengths)
+            + encode_delta_binary_packed(suffix_lengths)
+            + suffixes;
+
+    auto decoder = value_decoder<format::Type::BYTE_ARRAY>({});
+    decoder.reset(test_data, format::Encoding::DELTA_BYTE_ARRAY);
+
+    using output_type = decltype(decoder)::output_type;
+    std::vector<output_type> out;
+    std::array<output_type, 7> batch;
+    while (size_t n_read = decoder.read_batch(batch.size(), batch.data())) {
+        for (size_t i = 0; i < n_read; ++i) {
+            out.push_back(std::move(batch[i]));
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL(out.size(), strings.size());
+    for (size_t i = 0; i < strings.size(); ++i) {
+        std::string value(reinterpret_cast<const char*>(out[i].get()), out[i].size());
+        BOOST_CHECK_EQUAL(value, strings[i]);
+    }
+}
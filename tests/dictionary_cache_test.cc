@@ -0,0 +1,170 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <parquet4seastar/dictionary_cache.hh>
+#include <parquet4seastar/file_reader.hh>
+#include <parquet4seastar/file_writer.hh>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_dictionary_cache_test.parquet";
+
+namespace {
+
+constexpr int32_t n_rows = 10000;
+constexpr int32_t n_distinct = 1000;
+
+std::string value_of(int32_t i) {
+    return seastar::format("value_{:06}", i % n_distinct);
+}
+
+void write_test_file() {
+    writer_schema::schema schema;
+    schema.fields.push_back(writer_schema::primitive_node{
+            "s",
+            false,
+            logical_type::STRING{},
+            {},
+            format::Encoding::RLE_DICTIONARY,
+            format::CompressionCodec::GZIP});
+    schema.fields.push_back(writer_schema::primitive_node{
+            "i",
+            false,
+            logical_type::INT32{},
+            {},
+            format::Encoding::PLAIN,
+            format::CompressionCodec::UNCOMPRESSED});
+    std::unique_ptr<file_writer> fw = file_writer::open(std::string(test_file_name), schema).get0();
+    for (int32_t i = 0; i < n_rows; ++i) {
+        std::string s = value_of(i);
+        fw->column<format::Type::BYTE_ARRAY>(0).put(0, 0, bytes_view(reinterpret_cast<const uint8_t*>(s.data()), s.size()));
+        fw->column<format::Type::INT32>(1).put(0, 0, i);
+    }
+    fw->close().get();
+}
+
+// Read the rest of the string column, from the given row, checking its values.
+void check_strings(column_chunk_reader<format::Type::BYTE_ARRAY>& r, int32_t row = 0) {
+    int32_t def[1000];
+    int32_t rep[1000];
+    seastar::temporary_buffer<uint8_t> val[1000];
+    while (size_t n = r.read_batch(1000, def, rep, val).get0()) {
+        for (size_t i = 0; i < n; ++i, ++row) {
+            std::string expected = value_of(row);
+            BOOST_REQUIRE_EQUAL(std::string(reinterpret_cast<const char*>(val[i].get()), val[i].size()), expected);
+        }
+    }
+    BOOST_CHECK_EQUAL(row, n_rows);
+}
+
+} // namespace
+
+SEASTAR_TEST_CASE(dictionaries_are_decoded_once) {
+    return seastar::async([] {
+        write_test_file();
+        enable_dictionary_cache(16 * 1024 * 1024);
+        dictionary_cache& cache = *local_dictionary_cache();
+
+        file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+        {
+            auto r = fr.open_column_chunk_reader<format::Type::BYTE_ARRAY>(0, 0).get0();
+            check_strings(r);
+        }
+        BOOST_CHECK_EQUAL(cache.get_stats().hits, 0);
+        BOOST_CHECK_EQUAL(cache.get_stats().insertions, 1);
+        BOOST_CHECK_EQUAL(cache.entries(), 1);
+        BOOST_CHECK_GT(cache.size_bytes(), n_distinct * sizeof(seastar::temporary_buffer<uint8_t>));
+
+        // Concurrent readers share the cached dictionary, and outlive its eviction.
+        auto r1 = fr.open_column_chunk_reader<format::Type::BYTE_ARRAY>(0, 0).get0();
+        auto r2 = fr.open_column_chunk_reader<format::Type::BYTE_ARRAY>(0, 0).get0();
+        int32_t def[1];
+        int32_t rep[1];
+        seastar::temporary_buffer<uint8_t> val[1];
+        BOOST_CHECK_EQUAL(r1.read_batch(1, def, rep, val).get0(), 1);
+        BOOST_CHECK_EQUAL(r2.read_batch(1, def, rep, val).get0(), 1);
+        BOOST_CHECK_EQUAL(cache.get_stats().hits, 2);
+        cache.clear();
+        BOOST_CHECK_EQUAL(cache.get_stats().evictions, 1);
+        r1 = fr.open_column_chunk_reader<format::Type::BYTE_ARRAY>(0, 0).get0();
+        check_strings(r1);
+        check_strings(r2, 1);
+
+        // The plain-encoded column has no dictionary.
+        uint64_t misses = cache.get_stats().misses;
+        {
+            auto r = fr.open_column_chunk_reader<format::Type::INT32>(0, 1).get0();
+            int32_t ival[1000];
+            int32_t idef[1000];
+            int32_t irep[1000];
+            int32_t row = 0;
+            while (size_t n = r.read_batch(1000, idef, irep, ival).get0()) {
+                for (size_t i = 0; i < n; ++i, ++row) {
+                    BOOST_REQUIRE_EQUAL(ival[i], row);
+                }
+            }
+        }
+        BOOST_CHECK_EQUAL(cache.get_stats().misses, misses + 1);
+        BOOST_CHECK_EQUAL(cache.entries(), 1);
+        fr.close().get();
+        disable_dictionary_cache();
+    });
+}
+
+SEASTAR_TEST_CASE(dictionary_cache_hits_count_the_dictionary_page_once) {
+    return seastar::async([] {
+        write_test_file();
+        enable_dictionary_cache(16 * 1024 * 1024);
+        file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+        int32_t def[1];
+        int32_t rep[1];
+        seastar::temporary_buffer<uint8_t> val[1];
+        for (int scan = 0; scan < 2; ++scan) {
+            auto r = fr.open_column_chunk_reader<format::Type::BYTE_ARRAY>(0, 0).get0();
+            BOOST_CHECK_EQUAL(r.read_batch(1, def, rep, val).get0(), 1);
+            // The dictionary page is page 0, whether it was read or found in the cache.
+            BOOST_CHECK_EQUAL(r.page_ordinal(), 1);
+        }
+        BOOST_CHECK_EQUAL(local_dictionary_cache()->get_stats().hits, 1);
+        fr.close().get();
+        disable_dictionary_cache();
+    });
+}
+
+SEASTAR_TEST_CASE(readers_can_bypass_the_dictionary_cache) {
+    return seastar::async([] {
+        write_test_file();
+        enable_dictionary_cache(16 * 1024 * 1024);
+        io_options options;
+        options.use_dictionary_cache = false;
+        file_reader fr = file_reader::open(std::string(test_file_name), options).get0();
+        auto r = fr.open_column_chunk_reader<format::Type::BYTE_ARRAY>(0, 0).get0();
+        check_strings(r);
+        fr.close().get();
+        BOOST_CHECK_EQUAL(local_dictionary_cache()->get_stats().misses, 0);
+        BOOST_CHECK_EQUAL(local_dictionary_cache()->entries(), 0);
+        disable_dictionary_cache();
+    });
+}
+
+} // namespace parquet4seastar
@@ -151,3 +151,15 @@ BOOST_AUTO_TEST_CASE(dict_encoder_byte_array_happy) {
         BOOST_CHECK_EQUAL_COLLECTIONS(std::begin(dict), std::end(dict), std::begin(expected_dict), std::end(expected_dict));
     }
 }
+
+BOOST_AUTO_TEST_CASE(dict_decoder_rejects_index_equal_to_dict_size) {
+    using namespace parquet4seastar;
+    int32_t dict[] = {10, 11, 12};
+    value_decoder<format::Type::INT32> decoder{std::nullopt};
+    decoder.reset_dict(std::data(dict), std::size(dict));
+    // Bit width 2, then an RLE run of 8 times index 3.
+    bytes encoded = {0x02, 0x10, 0x03};
+    decoder.reset(encoded, format::Encoding::RLE_DICTIONARY);
+    int32_t out[8];
+    BOOST_CHECK_THROW(decoder.read_batch(std::size(out), std::data(out)), parquet_exception);
+}
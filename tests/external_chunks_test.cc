@@ -0,0 +1,131 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <parquet4seastar/file_reader.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <filesystem>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_dir = "/tmp/parquet4seastar_external_chunks_test";
+
+namespace {
+
+void write_data_file(const std::string& path) {
+    writer_schema::schema schema;
+    schema.fields.push_back(writer_schema::primitive_node{"a", false, logical_type::INT32{}});
+    schema.fields.push_back(writer_schema::primitive_node{"b", false, logical_type::INT64{}});
+    std::unique_ptr<file_writer> fw = file_writer::open(path, schema).get0();
+    for (int32_t row_group = 0; row_group < 3; ++row_group) {
+        for (int32_t i = 0; i < 100; ++i) {
+            fw->column<format::Type::INT32>(0).put(0, 0, i);
+            fw->column<format::Type::INT64>(1).put(0, 0, -i);
+        }
+        fw->flush_row_group().get();
+    }
+    fw->close().get();
+}
+
+// A file with no data of its own, whose column chunks all point to the data file.
+void write_summary_file(const std::string& path, const std::string& data_file_name, format::FileMetaData metadata) {
+    for (format::RowGroup& rg : metadata.row_groups) {
+        for (format::ColumnChunk& cc : rg.columns) {
+            cc.__set_file_path(data_file_name);
+        }
+    }
+    thrift_serializer serializer;
+    bytes_view serialized = serializer.serialize(metadata);
+    uint32_t size = serialized.size();
+    seastar::file f = seastar::open_file_dma(
+            path, seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create).get0();
+    seastar::output_stream<char> out = seastar::make_file_output_stream(f);
+    out.write("PAR1", 4).get();
+    out.write(reinterpret_cast<const char*>(serialized.data()), serialized.size()).get();
+    out.write(reinterpret_cast<const char*>(&size), 4).get();
+    out.write("PAR1", 4).get();
+    out.close().get();
+}
+
+template <format::Type::type T>
+int64_t sum_column_chunk(file_reader& fr, uint32_t row_group, uint32_t column) {
+    auto r = fr.open_column_chunk_reader<T>(row_group, column).get0();
+    int16_t def[128];
+    int16_t rep[128];
+    typename column_chunk_reader<T>::output_type val[128];
+    int64_t sum = 0;
+    while (size_t n = r.read_batch(128, def, rep, val).get0()) {
+        for (size_t i = 0; i < n; ++i) {
+            sum += val[i];
+        }
+    }
+    return sum;
+}
+
+} // namespace
+
+SEASTAR_TEST_CASE(external_chunks_are_read_through_one_handle) {
+    return seastar::async([] {
+        std::filesystem::create_directories(std::string(test_dir));
+        std::string data_path = std::string(test_dir) + "/data.parquet";
+        std::string summary_path = std::string(test_dir) + "/summary.parquet";
+        write_data_file(data_path);
+        {
+            file_reader data = file_reader::open(data_path).get0();
+            write_summary_file(summary_path, "data.parquet", data.metadata());
+            data.close().get();
+        }
+
+        file_reader fr = file_reader::open(summary_path).get0();
+        BOOST_REQUIRE_EQUAL(fr.metadata().row_groups.size(), 3);
+        BOOST_CHECK_EQUAL(sum_column_chunk<format::Type::INT32>(fr, 0, 0), 4950);
+        // The data file stays open: it can be unlinked while the summary is read.
+        std::filesystem::remove(data_path);
+        for (uint32_t rg = 0; rg < 3; ++rg) {
+            BOOST_CHECK_EQUAL(sum_column_chunk<format::Type::INT32>(fr, rg, 0), 4950);
+            BOOST_CHECK_EQUAL(sum_column_chunk<format::Type::INT64>(fr, rg, 1), -4950);
+        }
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(missing_external_file_is_reported) {
+    return seastar::async([] {
+        std::filesystem::create_directories(std::string(test_dir));
+        std::string data_path = std::string(test_dir) + "/data.parquet";
+        std::string summary_path = std::string(test_dir) + "/summary.parquet";
+        write_data_file(data_path);
+        {
+            file_reader data = file_reader::open(data_path).get0();
+            write_summary_file(summary_path, "missing.parquet", data.metadata());
+            data.close().get();
+        }
+        file_reader fr = file_reader::open(summary_path).get0();
+        BOOST_CHECK_THROW(fr.open_column_chunk_reader<format::Type::INT32>(0, 0).get0(), parquet_exception);
+        // Failed opens are retried.
+        std::filesystem::rename(data_path, std::string(test_dir) + "/missing.parquet");
+        BOOST_CHECK_EQUAL(sum_column_chunk<format::Type::INT32>(fr, 0, 0), 4950);
+        fr.close().get();
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,180 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#define BOOST_TEST_MODULE parquet
+
+#include <parquet4seastar/filter.hh>
+#include <parquet4seastar/exception.hh>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace parquet4seastar;
+using namespace parquet4seastar::filter;
+
+namespace {
+
+constexpr compare_op all_ops[] = {
+    compare_op::eq, compare_op::ne, compare_op::lt, compare_op::le, compare_op::gt, compare_op::ge};
+
+template <typename T>
+bool reference(const T& a, compare_op op, const T& b) {
+    switch (op) {
+    case compare_op::eq: return a == b;
+    case compare_op::ne: return a != b;
+    case compare_op::lt: return a < b;
+    case compare_op::le: return a <= b;
+    case compare_op::gt: return a > b;
+    case compare_op::ge: return a >= b;
+    }
+    return false;
+}
+
+// Sizes around the 64-bit words of selections and the vector widths of the kernels.
+constexpr size_t sizes[] = {0, 1, 7, 63, 64, 65, 200, 1000};
+
+template <typename T>
+void check_kernel(T key) {
+    std::mt19937 gen(0);
+    for (size_t n : sizes) {
+        std::vector<T> values(n);
+        for (T& v : values) {
+            v = static_cast<T>(static_cast<int64_t>(gen() % 16) - 8);
+        }
+        if constexpr (std::is_floating_point_v<T>) {
+            if (n > 5) {
+                values[5] = NAN;
+            }
+        }
+        for (compare_op op : all_ops) {
+            selection s(n);
+            compare_values(values.data(), n, op, key, s);
+            for (size_t i = 0; i < n; ++i) {
+                BOOST_REQUIRE_EQUAL(s.test(i), reference(values[i], op, key));
+            }
+        }
+    }
+}
+
+// Run a test with the AVX2 and BMI2 kernels (if the CPU has them), and with the portable ones.
+template <typename Test>
+void with_and_without_simd(Test test) {
+    for (bool simd : {true, false}) {
+        enable_simd(simd);
+        BOOST_TEST_MESSAGE("AVX2: " << avx2_enabled() << ", BMI2: " << bmi2_enabled());
+        if (!simd) {
+            BOOST_REQUIRE(!avx2_enabled() && !bmi2_enabled());
+        }
+        test();
+    }
+    enable_simd(true);
+}
+
+void check_numeric_kernels() {
+    check_kernel<int32_t>(3);
+    check_kernel<int32_t>(-3);
+    // Negative values are big when unsigned.
+    check_kernel<uint32_t>(3);
+    check_kernel<int64_t>(-1);
+    check_kernel<uint64_t>(5);
+    check_kernel<float>(0.0f);
+    check_kernel<double>(-2.0);
+    check_kernel<uint8_t>(1);
+}
+
+void check_batches_with_nulls() {
+    std::mt19937 gen(1);
+    for (size_t n : sizes) {
+        // As returned by read_batch: levels for every position, values for the non-null ones.
+        std::vector<int16_t> def(n);
+        std::vector<int32_t> values;
+        std::vector<int32_t> expanded(n);
+        for (size_t i = 0; i < n; ++i) {
+            def[i] = gen() % 3;
+            expanded[i] = gen() % 10;
+            if (def[i] == 2) {
+                values.push_back(expanded[i]);
+            }
+        }
+        selection s = compare_batch(values.data(), def.data(), n, 2, compare_op::lt, int32_t(5));
+        BOOST_REQUIRE_EQUAL(s.size(), n);
+        size_t expected_count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            bool expected = def[i] == 2 && expanded[i] < 5;
+            expected_count += expected;
+            BOOST_REQUIRE_EQUAL(s.test(i), expected);
+        }
+        BOOST_CHECK_EQUAL(s.count(), expected_count);
+
+        std::vector<size_t> positions;
+        s.for_each([&] (size_t i) { positions.push_back(i); });
+        BOOST_CHECK_EQUAL(positions.size(), expected_count);
+        BOOST_CHECK(std::is_sorted(positions.begin(), positions.end()));
+
+        // Null positions are in neither a selection nor its complement.
+        selection valid = validity(def.data(), n, 2);
+        selection complement = s;
+        complement.flip();
+        complement &= valid;
+        BOOST_CHECK_EQUAL(complement.count() + s.count(), valid.count());
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(numeric_kernels) {
+    with_and_without_simd(check_numeric_kernels);
+}
+
+BOOST_AUTO_TEST_CASE(byte_array_kernels) {
+    std::vector<std::string> strings = {"", "a", "ab", "abc", "b", "\x80", "abd"};
+    std::vector<seastar::temporary_buffer<uint8_t>> values;
+    for (const std::string& s : strings) {
+        values.emplace_back(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+    bytes key{'a', 'b'};
+    for (compare_op op : all_ops) {
+        selection s(values.size());
+        compare_values(values.data(), values.size(), op, key, s);
+        for (size_t i = 0; i < values.size(); ++i) {
+            bytes_view v(values[i].get(), values[i].size());
+            BOOST_REQUIRE_EQUAL(s.test(i), reference(v, op, bytes_view(key)));
+        }
+    }
+    selection prefixed(values.size());
+    starts_with(values.data(), values.size(), key, prefixed);
+    BOOST_CHECK_EQUAL(prefixed.count(), 3);
+    BOOST_CHECK(prefixed.test(2) && prefixed.test(3) && prefixed.test(6));
+
+    std::vector<std::array<int32_t, 3>> int96 = {{1, 2, 3}, {1, 2, 4}};
+    selection s(int96.size());
+    compare_values(int96.data(), int96.size(), compare_op::eq, std::array<int32_t, 3>{1, 2, 4}, s);
+    BOOST_CHECK(!s.test(0) && s.test(1));
+    BOOST_CHECK_THROW(compare_values(int96.data(), int96.size(), compare_op::lt, int96[0], s), parquet_exception);
+}
+
+BOOST_AUTO_TEST_CASE(batches_with_nulls) {
+    with_and_without_simd(check_batches_with_nulls);
+    BOOST_CHECK_THROW(spread(selection(3), selection(3)), parquet_exception);
+}
@@ -0,0 +1,133 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#define BOOST_TEST_MODULE parquet
+
+#include <parquet4seastar/encoding.hh>
+#include <boost/test/included/unit_test.hpp>
+#include <vector>
+#include <array>
+
+BOOST_AUTO_TEST_CASE(plain_uuid) {
+    using namespace parquet4seastar;
+    bytes encoded;
+    for (int i = 0; i < 40; ++i) {
+        for (int j = 0; j < 16; ++j) {
+            encoded.push_back(static_cast<byte>(i * 16 + j));
+        }
+    }
+    auto decoder = fixed_len_bytes_decoder<16>(16);
+    decoder.reset(encoded, format::Encoding::PLAIN);
+
+    std::vector<std::array<byte, 16>> out(100);
+    size_t n_read = 0;
+    n_read += decoder.read_batch(17, out.data());
+    BOOST_CHECK_EQUAL(n_read, 17);
+    n_read += decoder.read_batch(100, out.data() + n_read);
+    BOOST_CHECK_EQUAL(n_read, 40);
+    for (int i = 0; i < 40; ++i) {
+        for (int j = 0; j < 16; ++j) {
+            BOOST_CHECK_EQUAL(out[i][j], static_cast<byte>(i * 16 + j));
+        }
+    }
+    BOOST_CHECK_EQUAL(decoder.read_batch(100, out.data()), 0);
+}
+
+BOOST_AUTO_TEST_CASE(plain_truncated) {
+    using namespace parquet4seastar;
+    bytes encoded(16 + 5, 0);
+    auto decoder = fixed_len_bytes_decoder<16>(16);
+    decoder.reset(encoded, format::Encoding::PLAIN);
+    std::array<byte, 16> out[2];
+    BOOST_CHECK_THROW(decoder.read_batch(2, out), parquet_exception);
+}
+
+BOOST_AUTO_TEST_CASE(wrong_type_length) {
+    using namespace parquet4seastar;
+    BOOST_CHECK_THROW(fixed_len_bytes_decoder<12>(16), parquet_exception);
+    BOOST_CHECK_THROW(fixed_len_bytes_decoder<12>({}), parquet_exception);
+    BOOST_CHECK_THROW(decimal128_decoder(17), parquet_exception);
+}
+
+BOOST_AUTO_TEST_CASE(dictionary_interval) {
+    using namespace parquet4seastar;
+    std::array<byte, 12> dict[3];
+    for (int i = 0; i < 3; ++i) {
+        dict[i].fill(static_cast<byte>(i + 1));
+    }
+    // Bit width 2, one bit-packed run of 8 values: 0 1 2 0 1 2 0 1
+    bytes encoded = {0x02, 0x03, 0b00'10'01'00, 0b01'00'10'01};
+
+    auto decoder = fixed_len_bytes_decoder<12>(12);
+    decoder.reset_dict(dict, 3);
+    decoder.reset(encoded, format::Encoding::RLE_DICTIONARY);
+    std::array<byte, 12> out[8];
+    BOOST_CHECK_EQUAL(decoder.read_batch(8, out), 8);
+    int expected[] = {0, 1, 2, 0, 1, 2, 0, 1};
+    for (int i = 0; i < 8; ++i) {
+        BOOST_CHECK(out[i] == dict[expected[i]]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dictionary_index_out_of_range) {
+    using namespace parquet4seastar;
+    std::array<byte, 12> dict[3] = {};
+    // Bit width 2, one RLE run of 8 values equal to 3.
+    bytes encoded = {0x02, 0x10, 0x03};
+    auto decoder = fixed_len_bytes_decoder<12>(12);
+    decoder.reset_dict(dict, 3);
+    decoder.reset(encoded, format::Encoding::RLE_DICTIONARY);
+    std::array<byte, 12> out[8];
+    BOOST_CHECK_THROW(decoder.read_batch(8, out), parquet_exception);
+}
+
+BOOST_AUTO_TEST_CASE(decimal) {
+    using namespace parquet4seastar;
+    bytes encoded = {
+        0x00, 0x00, 0x01, // 1
+        0xff, 0xff, 0xff, // -1
+        0x7f, 0xff, 0xff, // 8388607
+        0x80, 0x00, 0x00, // -8388608
+        0xff, 0x00, 0x00, // -65536
+    };
+    auto decoder = decimal128_decoder(3);
+    decoder.reset(encoded, format::Encoding::PLAIN);
+    __int128 out[5];
+    BOOST_REQUIRE_EQUAL(decoder.read_batch(5, out), 5);
+    BOOST_CHECK(out[0] == 1);
+    BOOST_CHECK(out[1] == -1);
+    BOOST_CHECK(out[2] == 8388607);
+    BOOST_CHECK(out[3] == -8388608);
+    BOOST_CHECK(out[4] == -65536);
+}
+
+BOOST_AUTO_TEST_CASE(decimal_full_width) {
+    using namespace parquet4seastar;
+    bytes encoded(32, 0x00);
+    encoded[0] = 0x80; // -2^127
+    encoded[31] = 0x2a; // 42
+    auto decoder = decimal128_decoder(16);
+    decoder.reset(encoded, format::Encoding::PLAIN);
+    __int128 out[2];
+    BOOST_REQUIRE_EQUAL(decoder.read_batch(2, out), 2);
+    BOOST_CHECK(out[0] == static_cast<__int128>(static_cast<unsigned __int128>(1) << 127));
+    BOOST_CHECK(out[1] == 42);
+}
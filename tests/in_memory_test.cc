@@ -0,0 +1,140 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/net/packet.hh>
+#include <parquet4seastar/cql_reader.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <sstream>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_in_memory_test.parquet";
+
+namespace {
+
+// Collects everything written to it.
+class buffer_sink_impl final : public seastar::data_sink_impl {
+    std::vector<seastar::temporary_buffer<char>>& _buffers;
+public:
+    explicit buffer_sink_impl(std::vector<seastar::temporary_buffer<char>>& buffers) : _buffers{buffers} {}
+    seastar::future<> put(seastar::net::packet data) override {
+        for (seastar::temporary_buffer<char>& b : data.release()) {
+            _buffers.push_back(std::move(b));
+        }
+        return seastar::make_ready_future<>();
+    }
+    seastar::future<> close() override {
+        return seastar::make_ready_future<>();
+    }
+};
+
+writer_schema::schema test_schema() {
+    using namespace writer_schema;
+    schema root;
+    root.fields.push_back(primitive_node{
+            "id", false, logical_type::INT64{}, {}, format::Encoding::PLAIN, format::CompressionCodec::UNCOMPRESSED});
+    root.fields.push_back(primitive_node{
+            "name", true, logical_type::STRING{}, {}, format::Encoding::RLE_DICTIONARY, format::CompressionCodec::SNAPPY});
+    return root;
+}
+
+void write_rows(file_writer& fw) {
+    for (int64_t i = 0; i < 1000; ++i) {
+        fw.column<format::Type::INT64>(0).put(0, 0, i);
+        if (i % 5 == 0) {
+            fw.column<format::Type::BYTE_ARRAY>(1).put(0, 0, {});
+        } else {
+            std::string s = seastar::format("name_{}", i % 17);
+            fw.column<format::Type::BYTE_ARRAY>(1).put(1, 0, bytes_view(reinterpret_cast<const uint8_t*>(s.data()), s.size()));
+        }
+        if (i == 499) {
+            fw.flush_row_group().get();
+        }
+    }
+    fw.close().get();
+}
+
+std::string to_cql(file_reader& fr) {
+    std::ostringstream out;
+    cql::parquet_to_cql(fr, "t", "row_number", out).get();
+    return out.str();
+}
+
+} // namespace
+
+SEASTAR_TEST_CASE(in_memory_round_trip) {
+    return seastar::async([] {
+        std::unique_ptr<file_writer> fw = file_writer::open(std::string(test_file_name), test_schema()).get0();
+        write_rows(*fw);
+        file_reader on_disk = file_reader::open(std::string(test_file_name)).get0();
+        std::string expected = to_cql(on_disk);
+        on_disk.close().get();
+
+        std::vector<seastar::temporary_buffer<char>> buffers;
+        fw = file_writer::open(seastar::data_sink(std::make_unique<buffer_sink_impl>(buffers)), test_schema()).get0();
+        write_rows(*fw);
+        BOOST_REQUIRE_GT(buffers.size(), 1);
+
+        size_t size = 0;
+        for (const auto& b : buffers) {
+            size += b.size();
+        }
+        BOOST_CHECK_EQUAL(size, seastar::file_size(std::string(test_file_name)).get0());
+
+        // In several fragments.
+        std::vector<seastar::temporary_buffer<char>> fragments;
+        for (auto& b : buffers) {
+            fragments.push_back(b.share());
+        }
+        file_reader fr = file_reader::open(std::move(fragments)).get0();
+        BOOST_CHECK(fr.mapped());
+        BOOST_CHECK_EQUAL(fr.metadata().num_rows, 1000);
+        BOOST_CHECK_EQUAL(to_cql(fr), expected);
+        fr.close().get();
+
+        // In one buffer.
+        seastar::temporary_buffer<char> contents(size);
+        size_t offset = 0;
+        for (const auto& b : buffers) {
+            std::memcpy(contents.get_write() + offset, b.get(), b.size());
+            offset += b.size();
+        }
+        fr = file_reader::open(std::move(contents)).get0();
+        BOOST_CHECK_EQUAL(to_cql(fr), expected);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(in_memory_garbage_is_rejected) {
+    return seastar::async([] {
+        seastar::temporary_buffer<char> garbage(100);
+        std::memset(garbage.get_write(), 'x', garbage.size());
+        BOOST_CHECK_THROW(file_reader::open(std::move(garbage)).get0(), parquet_exception);
+        BOOST_CHECK_THROW(file_reader::open(seastar::temporary_buffer<char>(4)).get0(), parquet_exception);
+        // A metadata length for which metadata_len + 8 wraps around in 32 bits.
+        BOOST_CHECK_THROW(file_reader::open(
+                seastar::temporary_buffer<char>("PAR1\0\0\0\0\xfc\xff\xff\xffPAR1", 16)).get0(), parquet_exception);
+    });
+}
+
+} // namespace parquet4seastar
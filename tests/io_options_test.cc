@@ -0,0 +1,133 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/core/reactor.hh>
+#include <seastar/core/scheduling.hh>
+#include <parquet4seastar/file_reader.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <parquet4seastar/tracing.hh>
+#include <numeric>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_io_options_test.parquet";
+
+namespace {
+
+// Remembers the scheduling group of each traced phase.
+class scheduling_group_tracer : public tracing::tracer {
+public:
+    std::vector<seastar::scheduling_group> groups;
+    void record(const tracing::event& e) override {
+        groups.push_back(seastar::current_scheduling_group());
+    }
+};
+
+} // namespace
+
+SEASTAR_TEST_CASE(reads_and_writes_run_in_the_given_groups) {
+    return seastar::async([] {
+        io_options options;
+        options.scheduling_group = seastar::create_scheduling_group("parquet_background", 100).get0();
+        options.io_priority_class = seastar::engine().register_one_priority_class("parquet_background", 100);
+        options.read_buffer_size = 4096;
+        options.read_ahead = 2;
+
+        writer_schema::schema schema;
+        schema.fields.push_back(writer_schema::primitive_node{
+                "a",
+                false,
+                logical_type::INT32{},
+                {},
+                format::Encoding::RLE_DICTIONARY,
+                format::CompressionCodec::GZIP});
+        std::unique_ptr<file_writer> fw = file_writer::open(std::string(test_file_name), schema, options).get0();
+        for (int32_t i = 0; i < 10000; ++i) {
+            fw->column<format::Type::INT32>(0).put(0, 0, i % 100);
+        }
+        fw->flush_row_group().get();
+        for (int32_t i = 0; i < 10000; ++i) {
+            fw->column<format::Type::INT32>(0).put(0, 0, i % 10);
+        }
+        fw->close().get();
+
+        scheduling_group_tracer tracer;
+        tracing::set_tracer(&tracer);
+        file_reader fr = file_reader::open(std::string(test_file_name), options).get0();
+        BOOST_CHECK(fr.options().scheduling_group == options.scheduling_group);
+        BOOST_REQUIRE_EQUAL(fr.metadata().row_groups.size(), 2);
+        int64_t sum = 0;
+        for (uint32_t row_group = 0; row_group < 2; ++row_group) {
+            column_chunk_reader<format::Type::INT32> r = fr.open_column_chunk_reader<format::Type::INT32>(row_group, 0).get0();
+            int32_t def[1024];
+            int32_t rep[1024];
+            int32_t val[1024];
+            while (size_t n = r.read_batch(1024, def, rep, val).get0()) {
+                sum += std::accumulate(val, val + n, int64_t(0));
+            }
+        }
+        tracing::set_tracer(nullptr);
+        fr.close().get();
+        BOOST_CHECK_EQUAL(sum, 100 * (99 * 100 / 2) + 1000 * (9 * 10 / 2));
+
+        BOOST_CHECK(!tracer.groups.empty());
+        for (const seastar::scheduling_group& sg : tracer.groups) {
+            BOOST_CHECK(sg == options.scheduling_group);
+        }
+    });
+}
+
+SEASTAR_TEST_CASE(column_chunk_options_override_file_options) {
+    return seastar::async([] {
+        io_options options;
+        options.scheduling_group = seastar::create_scheduling_group("parquet_column", 200).get0();
+
+        writer_schema::schema schema;
+        schema.fields.push_back(writer_schema::primitive_node{"a", false, logical_type::INT32{}});
+        std::unique_ptr<file_writer> fw = file_writer::open(std::string(test_file_name), schema).get0();
+        for (int32_t i = 0; i < 100; ++i) {
+            fw->column<format::Type::INT32>(0).put(0, 0, i);
+        }
+        fw->close().get();
+
+        scheduling_group_tracer tracer;
+        tracing::set_tracer(&tracer);
+        file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+        tracer.groups.clear();
+        column_chunk_reader<format::Type::INT32> r =
+                fr.open_column_chunk_reader<format::Type::INT32>(0, 0, options).get0();
+        int32_t def[128];
+        int32_t rep[128];
+        int32_t val[128];
+        BOOST_CHECK_EQUAL(r.read_batch(128, def, rep, val).get0(), 100);
+        tracing::set_tracer(nullptr);
+        fr.close().get();
+
+        BOOST_CHECK(!tracer.groups.empty());
+        for (const seastar::scheduling_group& sg : tracer.groups) {
+            BOOST_CHECK(sg == options.scheduling_group);
+        }
+    });
+}
+
+} // namespace parquet4seastar
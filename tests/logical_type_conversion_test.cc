@@ -0,0 +1,133 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#define BOOST_TEST_MODULE parquet
+
+#include <parquet4seastar/logical_type_conversion.hh>
+#include <boost/test/included/unit_test.hpp>
+#include <vector>
+#include <array>
+
+using namespace parquet4seastar;
+using namespace parquet4seastar::logical_type;
+
+BOOST_AUTO_TEST_CASE(int96) {
+    int64_t nanos_of_day = 3'600'000'000'123;
+    std::array<int32_t, 3> in[2];
+    in[0] = {static_cast<int32_t>(nanos_of_day), static_cast<int32_t>(nanos_of_day >> 32), 2440588}; // epoch
+    in[1] = {0, 0, 2440587}; // a day before the epoch
+    int64_t out[2];
+    int96_to_nanoseconds(in, 2, out);
+    BOOST_CHECK_EQUAL(out[0], nanos_of_day);
+    BOOST_CHECK_EQUAL(out[1], -NANOS_PER_DAY);
+}
+
+BOOST_AUTO_TEST_CASE(timestamp_rescaling) {
+    int64_t in[] = {1'500, -1'500, 0, 7};
+    int64_t out[4];
+
+    rescale_timestamps(in, 4, TIMESTAMP::MILLIS, TIMESTAMP::NANOS, out);
+    BOOST_CHECK_EQUAL(out[0], 1'500'000'000);
+    BOOST_CHECK_EQUAL(out[1], -1'500'000'000);
+    BOOST_CHECK_EQUAL(out[3], 7'000'000);
+
+    rescale_timestamps(in, 4, TIMESTAMP::MICROS, TIMESTAMP::MILLIS, out);
+    BOOST_CHECK_EQUAL(out[0], 1);
+    BOOST_CHECK_EQUAL(out[1], -2);
+    BOOST_CHECK_EQUAL(out[2], 0);
+    BOOST_CHECK_EQUAL(out[3], 0);
+
+    int64_t huge[] = {INT64_MAX / 10};
+    BOOST_CHECK_THROW(rescale_timestamps(huge, 1, TIMESTAMP::MILLIS, TIMESTAMP::MICROS, out), parquet_exception);
+}
+
+BOOST_AUTO_TEST_CASE(dates) {
+    int32_t in[] = {0, 1, -1, 19000};
+    int64_t out[4];
+    dates_to_timestamps(in, 4, TIMESTAMP::MILLIS, out);
+    BOOST_CHECK_EQUAL(out[0], 0);
+    BOOST_CHECK_EQUAL(out[1], 86'400'000);
+    BOOST_CHECK_EQUAL(out[2], -86'400'000);
+    BOOST_CHECK_EQUAL(out[3], 19000LL * 86'400'000);
+
+    int32_t far[] = {INT32_MAX};
+    BOOST_CHECK_THROW(dates_to_timestamps(far, 1, TIMESTAMP::NANOS, out), parquet_exception);
+}
+
+BOOST_AUTO_TEST_CASE(decimals) {
+    std::vector<seastar::temporary_buffer<uint8_t>> in;
+    auto add = [&] (std::initializer_list<uint8_t> bytes) {
+        in.emplace_back(bytes.size());
+        std::copy(bytes.begin(), bytes.end(), in.back().get_write());
+    };
+    add({});
+    add({0x7f});
+    add({0x80});
+    add({0xff, 0x00});
+    add({0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff});
+
+    int64_t out64[5];
+    decimal_to_int64(in.data(), in.size(), out64);
+    BOOST_CHECK_EQUAL(out64[0], 0);
+    BOOST_CHECK_EQUAL(out64[1], 127);
+    BOOST_CHECK_EQUAL(out64[2], -128);
+    BOOST_CHECK_EQUAL(out64[3], -256);
+    BOOST_CHECK_EQUAL(out64[4], 0x00ff'ffff'ffff'ffffLL);
+
+    __int128 out128[5];
+    decimal_to_int128(in.data(), in.size(), out128);
+    for (size_t i = 0; i < in.size(); ++i) {
+        BOOST_CHECK(out128[i] == out64[i]);
+    }
+
+    add({0x01, 0, 0, 0, 0, 0, 0, 0, 0});
+    BOOST_CHECK_THROW(decimal_to_int64(in.data(), in.size(), out64), parquet_exception);
+}
+
+BOOST_AUTO_TEST_CASE(fixed_len_decimals) {
+    bytes in = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, // -2
+        0x00, 0x00, 0x00, 0x01, 0x00, 0x00, // 65536
+    };
+    __int128 out128[2];
+    decimal_to_int128(in.data(), 6, 2, out128);
+    BOOST_CHECK(out128[0] == -2);
+    BOOST_CHECK(out128[1] == 65536);
+    int64_t out64[2];
+    decimal_to_int64(in.data(), 6, 2, out64);
+    BOOST_CHECK_EQUAL(out64[0], -2);
+    BOOST_CHECK_EQUAL(out64[1], 65536);
+}
+
+BOOST_AUTO_TEST_CASE(narrowing) {
+    int32_t in[] = {-1, 255, 256, -129};
+    int8_t out8[4];
+    narrow(in, 4, out8);
+    BOOST_CHECK_EQUAL(out8[0], -1);
+    BOOST_CHECK_EQUAL(out8[3], 127);
+    uint8_t outu8[4];
+    narrow(in, 4, outu8);
+    BOOST_CHECK_EQUAL(outu8[1], 255);
+    BOOST_CHECK_EQUAL(outu8[2], 0);
+    uint32_t outu32[4];
+    narrow(in, 4, outu32);
+    BOOST_CHECK_EQUAL(outu32[0], UINT32_MAX);
+}
@@ -0,0 +1,459 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <parquet4seastar/bloom_filter.hh>
+#include <parquet4seastar/file_reader.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <parquet4seastar/metrics.hh>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_lookup_test.parquet";
+constexpr std::string_view indexed_file_name = "/tmp/parquet4seastar_lookup_test_indexed.parquet";
+constexpr std::string_view zeros_file_name = "/tmp/parquet4seastar_lookup_test_zeros.parquet";
+constexpr std::string_view indexed_zeros_file_name = "/tmp/parquet4seastar_lookup_test_zeros_indexed.parquet";
+constexpr int32_t n_row_groups = 3;
+constexpr int32_t rows_per_row_group = 1000;
+constexpr int32_t rows_per_page = 100;
+
+namespace {
+
+std::string name_of(int32_t row) {
+    return seastar::format("k{:05d}", 2 * (row % rows_per_row_group));
+}
+
+bytes to_bytes(std::string_view s) {
+    return bytes(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+}
+
+// Row i has id = 2 * i, and name = name_of(i), which is null in every tenth row.
+// Both columns are sorted within each row group.
+void write_file() {
+    using namespace writer_schema;
+    schema root;
+    root.fields.push_back(primitive_node{
+            "id", false, logical_type::INT64{}, {}, format::Encoding::PLAIN, format::CompressionCodec::UNCOMPRESSED});
+    root.fields.push_back(primitive_node{
+            "name", true, logical_type::STRING{}, {}, format::Encoding::PLAIN, format::CompressionCodec::SNAPPY});
+    std::unique_ptr<file_writer> fw = file_writer::open(std::string(test_file_name), root).get0();
+    for (int32_t i = 0; i < n_row_groups * rows_per_row_group; ++i) {
+        fw->column<format::Type::INT64>(0).put(0, 0, 2 * i);
+        if (i % 10 == 9) {
+            fw->column<format::Type::BYTE_ARRAY>(1).put(0, 0, {});
+        } else {
+            std::string name = name_of(i);
+            fw->column<format::Type::BYTE_ARRAY>(1).put(1, 0, bytes_view{to_bytes(name)});
+        }
+        if ((i + 1) % rows_per_page == 0) {
+            fw->column<format::Type::INT64>(0).flush_page();
+            fw->column<format::Type::BYTE_ARRAY>(1).flush_page();
+        }
+        if ((i + 1) % rows_per_row_group == 0) {
+            fw->flush_row_group().get();
+        }
+    }
+    fw->close().get();
+}
+
+std::string to_string(const seastar::temporary_buffer<uint8_t>& b) {
+    return std::string(reinterpret_cast<const char*>(b.get()), b.size());
+}
+
+std::string to_string(int64_t x) {
+    return encode_scalar(x);
+}
+
+// The indexes of a column chunk, computed by reading its pages one by one.
+template <format::Type::type T>
+void index_chunk(file_reader& fr, uint32_t row_group, uint32_t column,
+        format::ColumnIndex& column_index, format::OffsetIndex& offset_index, bloom_filter& filter) {
+    using output_type = typename column_chunk_reader<T>::output_type;
+    std::vector<page_range> pages = fr.split_column_chunk(row_group, column, rows_per_row_group).get0();
+    BOOST_REQUIRE_EQUAL(pages.size(), rows_per_row_group / rows_per_page);
+    const format::ColumnMetaData& cmd = fr.metadata().row_groups[row_group].columns[column].meta_data;
+    int64_t chunk_offset = cmd.__isset.dictionary_page_offset ? cmd.dictionary_page_offset : cmd.data_page_offset;
+    uint32_t max_def_level = fr.raw_schema().leaves[column]->def_level;
+    for (const page_range& page : pages) {
+        column_chunk_reader<T> r = fr.open_column_chunk_reader<T>(page).get0();
+        int16_t def[rows_per_page];
+        int16_t rep[rows_per_page];
+        output_type values[rows_per_page];
+        size_t n = r.read_batch(rows_per_page, def, rep, values).get0();
+        BOOST_REQUIRE_EQUAL(n, page.num_rows);
+        size_t n_values = std::count(def, def + n, max_def_level);
+        std::vector<std::string> encoded;
+        for (size_t i = 0; i < n_values; ++i) {
+            encoded.push_back(to_string(values[i]));
+            filter.insert(bloom_filter_hash(*decode_scalar(T, encoded.back())));
+        }
+        // The values of each page are sorted.
+        column_index.null_pages.push_back(encoded.empty());
+        column_index.min_values.push_back(encoded.empty() ? "" : encoded.front());
+        column_index.max_values.push_back(encoded.empty() ? "" : encoded.back());
+        column_index.null_counts.push_back(n - n_values);
+
+        format::PageLocation location;
+        location.__set_offset(chunk_offset + page.begin);
+        location.__set_compressed_page_size(page.end - page.begin);
+        location.__set_first_row_index(page.first_row);
+        offset_index.page_locations.push_back(location);
+    }
+    column_index.__set_boundary_order(format::BoundaryOrder::ASCENDING);
+    column_index.__isset.null_counts = true;
+}
+
+// Copies the test file, adding a Bloom filter, a ColumnIndex and an OffsetIndex to every column chunk,
+// and declaring the row groups sorted by id.
+void write_indexed_file(file_reader& fr) {
+    seastar::file input = seastar::open_file_dma(test_file_name.data(), seastar::open_flags::ro).get0();
+    uint64_t size = input.size().get0();
+    auto contents = input.dma_read_exactly<char>(0, size).get0();
+    input.close().get();
+    uint32_t metadata_len;
+    std::memcpy(&metadata_len, contents.get() + size - 8, 4);
+    uint64_t data_size = size - 8 - metadata_len;
+
+    seastar::file output_file = seastar::open_file_dma(
+            indexed_file_name.data(), seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create).get0();
+    seastar::output_stream<char> output = seastar::make_file_output_stream(output_file);
+    output.write(contents.get(), data_size).get();
+    uint64_t offset = data_size;
+    auto append = [&] (bytes_view data) {
+        output.write(reinterpret_cast<const char*>(data.data()), data.size()).get();
+        offset += data.size();
+    };
+
+    format::FileMetaData metadata = fr.metadata();
+    thrift_serializer serializer;
+    for (uint32_t row_group = 0; row_group < n_row_groups; ++row_group) {
+        format::SortingColumn sorting_column;
+        sorting_column.__set_column_idx(0);
+        sorting_column.__set_descending(false);
+        sorting_column.__set_nulls_first(false);
+        metadata.row_groups[row_group].__set_sorting_columns({sorting_column});
+        for (uint32_t column = 0; column < 2; ++column) {
+            format::ColumnIndex column_index;
+            format::OffsetIndex offset_index;
+            bloom_filter filter{bloom_filter::optimal_size(rows_per_row_group, 0.001)};
+            if (column == 0) {
+                index_chunk<format::Type::INT64>(fr, row_group, column, column_index, offset_index, filter);
+            } else {
+                index_chunk<format::Type::BYTE_ARRAY>(fr, row_group, column, column_index, offset_index, filter);
+            }
+            format::ColumnChunk& column_chunk = metadata.row_groups[row_group].columns[column];
+            column_chunk.meta_data.__set_bloom_filter_offset(offset);
+            append(serializer.serialize(filter.header()));
+            append(filter.bitset());
+            column_chunk.__set_column_index_offset(offset);
+            bytes_view serialized_column_index = serializer.serialize(column_index);
+            column_chunk.__set_column_index_length(serialized_column_index.size());
+            append(serialized_column_index);
+            column_chunk.__set_offset_index_offset(offset);
+            bytes_view serialized_offset_index = serializer.serialize(offset_index);
+            column_chunk.__set_offset_index_length(serialized_offset_index.size());
+            append(serialized_offset_index);
+        }
+    }
+    bytes_view serialized_metadata = serializer.serialize(metadata);
+    uint32_t new_metadata_len = serialized_metadata.size();
+    append(serialized_metadata);
+    output.write(reinterpret_cast<const char*>(&new_metadata_len), 4).get();
+    output.write("PAR1", 4).get();
+    output.close().get();
+}
+
+double zeros_value(int32_t row) {
+    return row % 10 == 0 ? -0.0 : row;
+}
+
+// One row group of a dictionary-encoded DOUBLE column, which holds -0.0 in every tenth row.
+void write_zeros_file() {
+    using namespace writer_schema;
+    schema root;
+    root.fields.push_back(primitive_node{
+            "x", false, logical_type::DOUBLE{}, {}, format::Encoding::RLE_DICTIONARY, format::CompressionCodec::SNAPPY});
+    std::unique_ptr<file_writer> fw = file_writer::open(std::string(zeros_file_name), root).get0();
+    for (int32_t i = 0; i < rows_per_row_group; ++i) {
+        fw->column<format::Type::DOUBLE>(0).put(0, 0, zeros_value(i));
+        if ((i + 1) % rows_per_page == 0) {
+            fw->column<format::Type::DOUBLE>(0).flush_page();
+        }
+    }
+    fw->close().get();
+}
+
+// Copies the zeros file, adding a Bloom filter of the values and an OffsetIndex, and locating
+// the dictionary page only by data_page_offset, as some writers do.
+void write_indexed_zeros_file(file_reader& fr) {
+    std::vector<page_range> pages = fr.split_column_chunk(0, 0, rows_per_row_group).get0();
+    BOOST_REQUIRE_EQUAL(pages.size(), rows_per_row_group / rows_per_page);
+    format::FileMetaData metadata = fr.metadata();
+    format::ColumnChunk& column_chunk = metadata.row_groups[0].columns[0];
+    BOOST_REQUIRE(column_chunk.meta_data.__isset.dictionary_page_offset);
+    int64_t chunk_offset = column_chunk.meta_data.dictionary_page_offset;
+    column_chunk.meta_data.data_page_offset = chunk_offset;
+    column_chunk.meta_data.__isset.dictionary_page_offset = false;
+    format::OffsetIndex offset_index;
+    for (const page_range& page : pages) {
+        format::PageLocation location;
+        location.__set_offset(chunk_offset + page.begin);
+        location.__set_compressed_page_size(page.end - page.begin);
+        location.__set_first_row_index(page.first_row);
+        offset_index.page_locations.push_back(location);
+    }
+    bloom_filter filter{bloom_filter::optimal_size(rows_per_row_group, 0.001)};
+    for (int32_t i = 0; i < rows_per_row_group; ++i) {
+        filter.insert(bloom_filter_hash(zeros_value(i)));
+    }
+
+    seastar::file input = seastar::open_file_dma(zeros_file_name.data(), seastar::open_flags::ro).get0();
+    uint64_t size = input.size().get0();
+    auto contents = input.dma_read_exactly<char>(0, size).get0();
+    input.close().get();
+    uint32_t metadata_len;
+    std::memcpy(&metadata_len, contents.get() + size - 8, 4);
+    uint64_t data_size = size - 8 - metadata_len;
+
+    seastar::file output_file = seastar::open_file_dma(
+            indexed_zeros_file_name.data(),
+            seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create).get0();
+    seastar::output_stream<char> output = seastar::make_file_output_stream(output_file);
+    output.write(contents.get(), data_size).get();
+    uint64_t offset = data_size;
+    auto append = [&] (bytes_view data) {
+        output.write(reinterpret_cast<const char*>(data.data()), data.size()).get();
+        offset += data.size();
+    };
+    thrift_serializer serializer;
+    column_chunk.meta_data.__set_bloom_filter_offset(offset);
+    append(serializer.serialize(filter.header()));
+    append(filter.bitset());
+    column_chunk.__set_offset_index_offset(offset);
+    bytes_view serialized_offset_index = serializer.serialize(offset_index);
+    column_chunk.__set_offset_index_length(serialized_offset_index.size());
+    append(serialized_offset_index);
+    bytes_view serialized_metadata = serializer.serialize(metadata);
+    uint32_t new_metadata_len = serialized_metadata.size();
+    append(serialized_metadata);
+    output.write(reinterpret_cast<const char*>(&new_metadata_len), 4).get();
+    output.write("PAR1", 4).get();
+    output.close().get();
+}
+
+uint64_t data_pages_read() {
+    return metrics::local_stats().pages_read[static_cast<size_t>(metrics::page_kind::data)];
+}
+
+struct lookup_result {
+    std::vector<std::pair<uint32_t, int64_t>> rows;
+    uint64_t pages_read;
+};
+
+lookup_result lookup(file_reader& fr, uint32_t column, const scalar& key) {
+    uint64_t pages_before = data_pages_read();
+    std::vector<row_position> found = fr.lookup(column, key).get0();
+    lookup_result result{{}, data_pages_read() - pages_before};
+    for (const row_position& r : found) {
+        result.rows.emplace_back(r.row_group, r.row);
+    }
+    return result;
+}
+
+using rows = std::vector<std::pair<uint32_t, int64_t>>;
+
+} // namespace
+
+SEASTAR_TEST_CASE(bloom_filter_has_no_false_negatives) {
+    return seastar::async([] {
+        bloom_filter filter{bloom_filter::optimal_size(1000, 0.01)};
+        BOOST_CHECK_EQUAL(filter.size() % bloom_filter::block_size, 0);
+        for (int64_t i = 0; i < 1000; ++i) {
+            filter.insert(bloom_filter_hash(i * 2));
+        }
+        size_t false_positives = 0;
+        for (int64_t i = 0; i < 1000; ++i) {
+            BOOST_CHECK(filter.find(bloom_filter_hash(i * 2)));
+            false_positives += filter.find(bloom_filter_hash(i * 2 + 1));
+        }
+        BOOST_CHECK_LT(false_positives, 50);
+        // XXH64 with seed 0.
+        BOOST_CHECK_EQUAL(xxhash64(bytes_view{}), 0xef46db3751d8e999ULL);
+        BOOST_CHECK_EQUAL(xxhash64(to_bytes("abc")), 0x44bc2cf5ad770999ULL);
+        BOOST_CHECK_EQUAL(xxhash64(to_bytes("Nobody inspects the spammish repetition")), 0xfbcea83c8a378bf1ULL);
+    });
+}
+
+SEASTAR_TEST_CASE(lookup_with_indexes) {
+    return seastar::async([] {
+        metrics::enable();
+        write_file();
+        {
+            file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+            write_indexed_file(fr);
+            fr.close().get();
+        }
+        file_reader fr = file_reader::open(std::string(indexed_file_name)).get0();
+
+        // Only the page of the row is read.
+        lookup_result found = lookup(fr, 0, int64_t(2 * 1234));
+        BOOST_CHECK(found.rows == (rows{{1, 234}}));
+        BOOST_CHECK_EQUAL(found.pages_read, 1);
+
+        // Absent keys: within the bounds of a row group and a page, but not in the Bloom filter,
+        // and beyond all bounds.
+        found = lookup(fr, 0, int64_t(2 * 1234 + 1));
+        BOOST_CHECK(found.rows.empty());
+        BOOST_CHECK_EQUAL(found.pages_read, 0);
+        found = lookup(fr, 0, int64_t(-2));
+        BOOST_CHECK(found.rows.empty());
+        BOOST_CHECK_EQUAL(found.pages_read, 0);
+
+        // A name in every row group.
+        found = lookup(fr, 1, to_bytes(name_of(234)));
+        BOOST_CHECK(found.rows == (rows{{0, 234}, {1, 234}, {2, 234}}));
+        BOOST_CHECK_EQUAL(found.pages_read, 3);
+        found = lookup(fr, 1, to_bytes("k00001"));
+        BOOST_CHECK(found.rows.empty());
+
+        // The name of the row found by id.
+        page_range page = fr.find_row(1, 1, 234).get0();
+        BOOST_CHECK_EQUAL(page.first_row, 200);
+        BOOST_CHECK_EQUAL(page.num_rows, rows_per_page);
+        column_chunk_reader<format::Type::BYTE_ARRAY> r = fr.open_column_chunk_reader<format::Type::BYTE_ARRAY>(page).get0();
+        int16_t def[rows_per_page];
+        int16_t rep[rows_per_page];
+        seastar::temporary_buffer<uint8_t> values[rows_per_page];
+        size_t n = r.read_batch(rows_per_page, def, rep, values).get0();
+        BOOST_REQUIRE_EQUAL(n, rows_per_page);
+        size_t value_index = std::count(def, def + 234 - 200, 1);
+        BOOST_REQUIRE_EQUAL(def[234 - 200], 1);
+        BOOST_CHECK_EQUAL(to_string(values[value_index]), name_of(234));
+
+        seastar::lw_shared_ptr<const chunk_index> index = fr.read_chunk_index(0, 1).get0();
+        BOOST_CHECK(index->filter);
+        BOOST_REQUIRE(index->column_index);
+        BOOST_CHECK_EQUAL(index->pages.size(), rows_per_row_group / rows_per_page);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(seek_in_sorted_column) {
+    return seastar::async([] {
+        metrics::enable();
+        write_file();
+        {
+            file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+            // Not declared sorted, and the row groups hold many values.
+            BOOST_CHECK(!fr.sorted(0));
+            BOOST_CHECK_THROW(fr.seek_to_key(0, int64_t(0)).get(), parquet_exception);
+            write_indexed_file(fr);
+            fr.close().get();
+        }
+        file_reader fr = file_reader::open(std::string(indexed_file_name)).get0();
+        BOOST_CHECK(fr.sorted(0) == sort_direction::ascending);
+        BOOST_CHECK(!fr.sorted(1));
+
+        auto seek = [&] (int64_t key) {
+            uint64_t pages_before = data_pages_read();
+            row_position found = fr.seek_to_key(0, key).get0();
+            // Only the page of the row is read.
+            BOOST_CHECK_LE(data_pages_read() - pages_before, 1);
+            return std::make_pair(found.row_group, found.row);
+        };
+        using position = std::pair<uint32_t, int64_t>;
+        BOOST_CHECK(seek(2 * 1234) == position(1, 234));
+        BOOST_CHECK(seek(2 * 1234 + 1) == position(1, 235));
+        BOOST_CHECK(seek(-5) == position(0, 0));
+        // Between two row groups, and between two pages.
+        BOOST_CHECK(seek(2 * rows_per_row_group - 1) == position(1, 0));
+        BOOST_CHECK(seek(2 * (rows_per_row_group + rows_per_page) - 1) == position(1, rows_per_page));
+        // Past the end.
+        BOOST_CHECK(seek(2 * n_row_groups * rows_per_row_group) == position(n_row_groups, 0));
+
+        BOOST_CHECK_THROW(fr.seek_to_key(0, int32_t(0)).get(), parquet_exception);
+        BOOST_CHECK_THROW(fr.seek_to_key(1, to_bytes("k00000")).get(), parquet_exception);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(lookup_without_indexes) {
+    return seastar::async([] {
+        metrics::enable();
+        write_file();
+        file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+
+        // The row groups are pruned by their statistics, but their pages are not.
+        lookup_result found = lookup(fr, 0, int64_t(2 * 1234));
+        BOOST_CHECK(found.rows == (rows{{1, 234}}));
+        BOOST_CHECK_EQUAL(found.pages_read, rows_per_row_group / rows_per_page);
+        found = lookup(fr, 0, int64_t(-2));
+        BOOST_CHECK(found.rows.empty());
+        BOOST_CHECK_EQUAL(found.pages_read, 0);
+
+        found = lookup(fr, 1, to_bytes(name_of(999)));
+        BOOST_CHECK(found.rows.empty()); // Row 999 is null.
+        found = lookup(fr, 1, to_bytes(name_of(998)));
+        BOOST_CHECK(found.rows == (rows{{0, 998}, {1, 998}, {2, 998}}));
+
+        // Without an OffsetIndex, a row is found in the whole chunk.
+        page_range page = fr.find_row(2, 0, 500).get0();
+        BOOST_CHECK_EQUAL(page.first_row, 0);
+        BOOST_CHECK_EQUAL(page.num_rows, rows_per_row_group);
+
+        BOOST_CHECK_THROW(fr.lookup(0, int32_t(4)).get(), parquet_exception);
+        BOOST_CHECK_THROW(fr.find_row(0, 0, rows_per_row_group).get(), parquet_exception);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(lookup_of_signed_zeros) {
+    return seastar::async([] {
+        write_zeros_file();
+        {
+            file_reader fr = file_reader::open(std::string(zeros_file_name)).get0();
+            write_indexed_zeros_file(fr);
+            fr.close().get();
+        }
+        file_reader fr = file_reader::open(std::string(indexed_zeros_file_name)).get0();
+        seastar::lw_shared_ptr<const chunk_index> index = fr.read_chunk_index(0, 0).get0();
+        BOOST_REQUIRE(index->filter);
+        // The dictionary page is found from the first data page.
+        BOOST_REQUIRE_EQUAL(index->pages.size(), rows_per_row_group / rows_per_page);
+        BOOST_CHECK_GT(index->pages.front().dictionary_size, 0);
+        BOOST_CHECK_EQUAL(index->pages.front().begin, index->pages.front().dictionary_size);
+
+        rows zeros;
+        for (int32_t i = 0; i < rows_per_row_group; i += 10) {
+            zeros.emplace_back(0, i);
+        }
+        // 0.0 equals the -0.0 in the file, although only -0.0 is in the Bloom filter.
+        BOOST_CHECK(lookup(fr, 0, 0.0).rows == zeros);
+        BOOST_CHECK(lookup(fr, 0, -0.0).rows == zeros);
+        BOOST_CHECK(lookup(fr, 0, 11.0).rows == (rows{{0, 11}}));
+        BOOST_CHECK(lookup(fr, 0, 10.0).rows.empty());
+        fr.close().get();
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,219 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <parquet4seastar/record_reader.hh>
+#include <parquet4seastar/memory_limiter.hh>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_memory_limiter_test.parquet";
+constexpr std::string_view wide_test_file_name = "/tmp/parquet4seastar_memory_limiter_wide_test.parquet";
+
+namespace {
+
+constexpr size_t big_page_values = 1024 * 1024;
+constexpr size_t small_page_values = 1024;
+constexpr size_t small_pages = 4;
+
+// One INT32 column: a 4 MiB page, followed by small pages.
+void write_test_file() {
+    writer_schema::schema schema;
+    schema.fields.push_back(writer_schema::primitive_node{
+            "a", false, logical_type::INT32{}, {}, format::Encoding::PLAIN, format::CompressionCodec::UNCOMPRESSED});
+    std::unique_ptr<file_writer> fw = file_writer::open(std::string(test_file_name), schema).get0();
+    auto& column = fw->column<format::Type::INT32>(0);
+    for (size_t i = 0; i < big_page_values; ++i) {
+        column.put(0, 0, i);
+    }
+    column.flush_page();
+    for (size_t page = 0; page < small_pages; ++page) {
+        for (size_t i = 0; i < small_page_values; ++i) {
+            column.put(0, 0, i);
+        }
+        column.flush_page();
+    }
+    fw->close().get();
+}
+
+constexpr size_t wide_columns = 8;
+constexpr size_t wide_values = 100;
+
+// Many INT32 columns, whose stream buffers together exceed a small limit.
+void write_wide_test_file() {
+    writer_schema::schema schema;
+    for (size_t i = 0; i < wide_columns; ++i) {
+        schema.fields.push_back(writer_schema::primitive_node{
+                seastar::format("c{}", i), false, logical_type::INT32{}, {},
+                format::Encoding::PLAIN, format::CompressionCodec::UNCOMPRESSED});
+    }
+    std::unique_ptr<file_writer> fw = file_writer::open(std::string(wide_test_file_name), schema).get0();
+    for (size_t i = 0; i < wide_columns; ++i) {
+        auto& column = fw->column<format::Type::INT32>(i);
+        for (size_t j = 0; j < wide_values; ++j) {
+            column.put(0, 0, j);
+        }
+    }
+    fw->close().get();
+}
+
+io_options limited_options(memory_limiter& limiter) {
+    io_options options;
+    options.read_buffer_size = 4096;
+    options.read_ahead = 1;
+    options.memory = &limiter;
+    return options;
+}
+
+struct null_consumer {
+    size_t records = 0;
+    void start_record() { ++records; }
+    void end_record() {}
+    void start_column(const std::string&) {}
+    void start_struct() {}
+    void end_struct() {}
+    void start_field(const std::string&) {}
+    void start_list() {}
+    void end_list() {}
+    void start_map() {}
+    void end_map() {}
+    void separate_key_value() {}
+    void separate_list_values() {}
+    void separate_map_values() {}
+    void append_null() {}
+    template <typename LogicalType, typename Value>
+    void append_value(LogicalType, Value&&) {}
+};
+
+} // namespace
+
+SEASTAR_TEST_CASE(readers_wait_for_admission) {
+    return seastar::async([] {
+        write_test_file();
+        // Enough for one reader's stream buffers, but not for two.
+        memory_limiter limiter{12 * 1024};
+        file_reader fr = file_reader::open(std::string(test_file_name), limited_options(limiter)).get0();
+
+        auto first = std::make_unique<column_chunk_reader<format::Type::INT32>>(
+                fr.open_column_chunk_reader<format::Type::INT32>(0, 0).get0());
+        BOOST_CHECK_EQUAL(limiter.used(), 8192);
+        auto second = fr.open_column_chunk_reader<format::Type::INT32>(0, 0);
+        for (int i = 0; i < 10; ++i) {
+            seastar::later().get();
+        }
+        BOOST_CHECK(!second.available());
+        BOOST_CHECK_EQUAL(limiter.waiters(), 1);
+
+        first.reset();
+        column_chunk_reader<format::Type::INT32> r = second.get0();
+        BOOST_CHECK_EQUAL(limiter.used(), 8192);
+        BOOST_CHECK_EQUAL(r.memory_charged(), 8192);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(buffers_are_charged_and_shrunk_after_big_pages) {
+    return seastar::async([] {
+        memory_limiter limiter{64 * 1024 * 1024};
+        file_reader fr = file_reader::open(std::string(test_file_name), limited_options(limiter)).get0();
+        column_chunk_reader<format::Type::INT32> r = fr.open_column_chunk_reader<format::Type::INT32>(0, 0).get0();
+
+        std::vector<int32_t> def(small_page_values);
+        std::vector<int32_t> rep(small_page_values);
+        std::vector<int32_t> val(small_page_values);
+        size_t peak = 0;
+        size_t read = 0;
+        while (size_t n = r.read_batch(small_page_values, def.data(), rep.data(), val.data()).get0()) {
+            read += n;
+            peak = std::max(peak, limiter.used());
+            BOOST_CHECK_EQUAL(limiter.used(), r.memory_charged());
+        }
+        BOOST_CHECK_EQUAL(read, big_page_values + small_pages * small_page_values);
+        // The decompression buffer and the stream buffer each held the big page.
+        BOOST_CHECK_GE(peak, 2 * big_page_values * sizeof(int32_t));
+        // Both were freed when the small pages were loaded.
+        BOOST_CHECK_LT(limiter.used(), 2 * page_reader::max_retained_buffer_size);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(record_reader_buffers_are_charged) {
+    return seastar::async([] {
+        memory_limiter limiter{64 * 1024 * 1024};
+        file_reader fr = file_reader::open(std::string(test_file_name), limited_options(limiter)).get0();
+        {
+            record::record_reader rr = record::record_reader::make(fr, 0).get0();
+            // Stream buffers and the level and value batches.
+            BOOST_CHECK_EQUAL(limiter.used(), 8192 + record::typed_primitive_reader<logical_type::INT32>::DEFAULT_BATCH_SIZE * 12);
+            null_consumer consumer;
+            rr.read_all(consumer).get();
+        }
+        BOOST_CHECK_EQUAL(limiter.used(), 0);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(wide_record_reader_is_admitted_under_a_small_limit) {
+    return seastar::async([] {
+        write_wide_test_file();
+        // Less than the stream buffers of two columns.
+        memory_limiter limiter{12 * 1024};
+        file_reader fr = file_reader::open(std::string(wide_test_file_name), limited_options(limiter)).get0();
+        {
+            record::record_reader rr = record::record_reader::make(fr, 0).get0();
+            null_consumer consumer;
+            rr.read_all(consumer).get();
+            BOOST_CHECK_EQUAL(consumer.records, wide_values);
+        }
+        BOOST_CHECK_EQUAL(limiter.used(), 0);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(concurrent_record_readers_are_admitted_in_turn) {
+    return seastar::async([] {
+        // Enough for the stream buffers of three of the columns.
+        memory_limiter limiter{3 * 8192};
+        file_reader fr = file_reader::open(std::string(wide_test_file_name), limited_options(limiter)).get0();
+
+        auto first = record::record_reader::make(fr, 0);
+        auto second = record::record_reader::make(fr, 0);
+        auto first_reader = std::make_unique<record::record_reader>(first.get0());
+        for (int i = 0; i < 10; ++i) {
+            seastar::later().get();
+        }
+        // The second reader waits for all of its memory, without holding part of it.
+        BOOST_CHECK(!second.available());
+        BOOST_CHECK_EQUAL(limiter.waiters(), 1);
+
+        null_consumer consumer;
+        first_reader->read_all(consumer).get();
+        first_reader.reset();
+        record::record_reader second_reader = second.get0();
+        second_reader.read_all(consumer).get();
+        BOOST_CHECK_EQUAL(consumer.records, 2 * wide_values);
+        fr.close().get();
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,163 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/core/seastar.hh>
+#include <parquet4seastar/column_chunk_reader.hh>
+#include <parquet4seastar/column_chunk_writer.hh>
+#include <parquet4seastar/metrics.hh>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_metrics_test.bin";
+
+namespace {
+
+size_t page_index(metrics::page_kind kind) {
+    return static_cast<size_t>(kind);
+}
+
+column_chunk_writer<format::Type::INT32> make_writer(format::Encoding::type encoding) {
+    return column_chunk_writer<format::Type::INT32>{
+        0,
+        0,
+        make_value_encoder<format::Type::INT32>(encoding),
+        compressor::make(format::CompressionCodec::SNAPPY)};
+}
+
+} // namespace
+
+SEASTAR_TEST_CASE(latency_histogram_is_cumulative) {
+    metrics::latency_histogram h;
+    h.add(std::chrono::nanoseconds(500));
+    h.add(std::chrono::microseconds(3));
+    h.add(std::chrono::seconds(100));
+    seastar::metrics::histogram mh = h.to_metrics_histogram();
+    BOOST_CHECK_EQUAL(mh.sample_count, 3);
+    BOOST_REQUIRE_EQUAL(mh.buckets.size(), metrics::latency_histogram::n_buckets - 1);
+    BOOST_CHECK_EQUAL(mh.buckets[0].upper_bound, 1);
+    BOOST_CHECK_EQUAL(mh.buckets[0].count, 1);
+    BOOST_CHECK_EQUAL(mh.buckets[1].count, 1);
+    BOOST_CHECK_EQUAL(mh.buckets[2].count, 2);
+    // The 100s sample only shows up in sample_count (the implicit +Inf bucket).
+    BOOST_CHECK_EQUAL(mh.buckets.back().count, 2);
+    return seastar::make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(disabled_metrics_are_not_recorded) {
+    metrics::disable();
+    metrics::stats before = metrics::local_stats();
+    auto w = make_writer(format::Encoding::PLAIN);
+    w.put(0, 0, 42);
+    w.flush_page();
+    const metrics::stats& after = metrics::local_stats();
+    BOOST_CHECK(before.pages_written == after.pages_written);
+    BOOST_CHECK(before.bytes_written == after.bytes_written);
+    BOOST_CHECK_EQUAL(after.compression_latency.to_metrics_histogram().sample_count,
+            before.compression_latency.to_metrics_histogram().sample_count);
+    return seastar::make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(write_and_read_metrics) {
+    return seastar::async([] {
+        metrics::enable();
+        metrics::stats before = metrics::local_stats();
+
+        // Write a dictionary page and two data pages.
+        seastar::file output_file = seastar::open_file_dma(
+                test_file_name.data(), seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create).get0();
+        seastar::output_stream<char> output = seastar::make_file_output_stream(output_file);
+        auto w = make_writer(format::Encoding::RLE_DICTIONARY);
+        for (int32_t i = 0; i < 100; ++i) {
+            w.put(0, 0, i % 7);
+        }
+        w.flush_page();
+        for (int32_t i = 0; i < 100; ++i) {
+            w.put(0, 0, i % 5);
+        }
+        w.flush_chunk(output).get0();
+        output.flush().get();
+        output.close().get();
+
+        const metrics::stats& written = metrics::local_stats();
+        BOOST_CHECK_EQUAL(written.pages_written[page_index(metrics::page_kind::data)]
+                - before.pages_written[page_index(metrics::page_kind::data)], 2);
+        BOOST_CHECK_EQUAL(written.pages_written[page_index(metrics::page_kind::dictionary)]
+                - before.pages_written[page_index(metrics::page_kind::dictionary)], 1);
+        BOOST_CHECK_EQUAL(written.pages_written_by_encoding[format::Encoding::RLE_DICTIONARY]
+                - before.pages_written_by_encoding[format::Encoding::RLE_DICTIONARY], 2);
+        BOOST_CHECK_GT(written.bytes_written[format::Type::INT32], before.bytes_written[format::Type::INT32]);
+        BOOST_CHECK_EQUAL(written.compression_latency.to_metrics_histogram().sample_count
+                - before.compression_latency.to_metrics_histogram().sample_count, 3);
+
+        // Read it back.
+        seastar::file input_file = seastar::open_file_dma(test_file_name.data(), seastar::open_flags::ro).get0();
+        column_chunk_reader<format::Type::INT32> r{
+            page_reader{seastar::make_file_input_stream(std::move(input_file))},
+            format::CompressionCodec::SNAPPY,
+            0,
+            0,
+            std::nullopt};
+        int32_t def[64];
+        int32_t rep[64];
+        int32_t val[64];
+        size_t total = 0;
+        while (size_t n = r.read_batch(64, def, rep, val).get0()) {
+            total += n;
+        }
+        BOOST_CHECK_EQUAL(total, 200);
+
+        const metrics::stats& read = metrics::local_stats();
+        BOOST_CHECK_EQUAL(read.pages_read[page_index(metrics::page_kind::data)]
+                - before.pages_read[page_index(metrics::page_kind::data)], 2);
+        BOOST_CHECK_EQUAL(read.pages_read[page_index(metrics::page_kind::dictionary)]
+                - before.pages_read[page_index(metrics::page_kind::dictionary)], 1);
+        BOOST_CHECK_EQUAL(read.pages_read_by_encoding[format::Encoding::RLE_DICTIONARY]
+                - before.pages_read_by_encoding[format::Encoding::RLE_DICTIONARY], 2);
+        BOOST_CHECK_EQUAL(read.bytes_read[format::Type::INT32] - before.bytes_read[format::Type::INT32],
+                read.bytes_written[format::Type::INT32] - before.bytes_written[format::Type::INT32]);
+        BOOST_CHECK_EQUAL(read.decompression_latency.to_metrics_histogram().sample_count
+                - before.decompression_latency.to_metrics_histogram().sample_count, 3);
+        BOOST_CHECK_GT(read.decode_latency.to_metrics_histogram().sample_count,
+                before.decode_latency.to_metrics_histogram().sample_count);
+
+        metrics::disable();
+    });
+}
+
+SEASTAR_TEST_CASE(dictionary_fallback_is_counted) {
+    metrics::enable();
+    uint64_t before = metrics::local_stats().dictionary_fallbacks;
+    auto w = make_writer(format::Encoding::RLE_DICTIONARY);
+    // 8192 distinct INT32 values make a 32KiB dictionary, past the 16KiB fallback threshold.
+    for (int32_t i = 0; i < 8192; ++i) {
+        w.put(0, 0, i);
+    }
+    w.flush_page();
+    w.put(0, 0, 0);
+    w.flush_page();
+    BOOST_CHECK_EQUAL(metrics::local_stats().dictionary_fallbacks - before, 1);
+    metrics::disable();
+    return seastar::make_ready_future<>();
+}
+
+} // namespace parquet4seastar
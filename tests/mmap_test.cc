@@ -0,0 +1,163 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/core/seastar.hh>
+#include <parquet4seastar/file_reader.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <algorithm>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_mmap_test.parquet";
+
+namespace {
+
+void write_test_file() {
+    writer_schema::schema schema;
+    schema.fields.push_back(writer_schema::primitive_node{
+            "plain",
+            true,
+            logical_type::INT64{},
+            {},
+            format::Encoding::PLAIN,
+            format::CompressionCodec::UNCOMPRESSED});
+    schema.fields.push_back(writer_schema::primitive_node{
+            "dict",
+            false,
+            logical_type::STRING{},
+            {},
+            format::Encoding::RLE_DICTIONARY,
+            format::CompressionCodec::GZIP});
+    std::unique_ptr<file_writer> fw = file_writer::open(std::string(test_file_name), schema).get0();
+    for (int32_t row_group = 0; row_group < 2; ++row_group) {
+        for (int32_t i = 0; i < 10000; ++i) {
+            fw->column<format::Type::INT64>(0).put(i % 3 != 0, 0, i);
+            std::string s = seastar::format("value_{}", i % 100);
+            fw->column<format::Type::BYTE_ARRAY>(1).put(0, 0, bytes_view(reinterpret_cast<const uint8_t*>(s.data()), s.size()));
+        }
+        fw->flush_row_group().get();
+    }
+    fw->close().get();
+}
+
+struct column_contents {
+    std::vector<int16_t> def;
+    std::vector<std::string> values;
+};
+
+template <format::Type::type T>
+column_contents read_column(file_reader& fr, uint32_t column) {
+    column_contents contents;
+    for (uint32_t row_group = 0; row_group < fr.metadata().row_groups.size(); ++row_group) {
+        auto r = fr.open_column_chunk_reader<T>(row_group, column).get0();
+        int16_t def[1000];
+        int16_t rep[1000];
+        typename column_chunk_reader<T>::output_type val[1000];
+        while (size_t n = r.read_batch(1000, def, rep, val).get0()) {
+            contents.def.insert(contents.def.end(), def, def + n);
+            size_t n_values = std::count(def, def + n, fr.raw_schema().leaves[column]->def_level);
+            for (size_t i = 0; i < n_values; ++i) {
+                if constexpr (T == format::Type::BYTE_ARRAY) {
+                    contents.values.emplace_back(reinterpret_cast<const char*>(val[i].get()), val[i].size());
+                } else {
+                    contents.values.push_back(std::to_string(val[i]));
+                }
+            }
+        }
+    }
+    return contents;
+}
+
+void check_same_contents(file_reader& mapped, file_reader& dma) {
+    for (auto [a, b] : {
+            std::pair{read_column<format::Type::INT64>(mapped, 0), read_column<format::Type::INT64>(dma, 0)},
+            std::pair{read_column<format::Type::BYTE_ARRAY>(mapped, 1), read_column<format::Type::BYTE_ARRAY>(dma, 1)}}) {
+        BOOST_CHECK_EQUAL(a.def.size(), 20000);
+        BOOST_CHECK(a.def == b.def);
+        BOOST_CHECK(a.values == b.values);
+    }
+}
+
+} // namespace
+
+SEASTAR_TEST_CASE(mapped_file_reads_like_dma) {
+    return seastar::async([] {
+        write_test_file();
+        io_options options;
+        options.mmap = mmap_policy::always;
+        file_reader mapped = file_reader::open(std::string(test_file_name), options).get0();
+        file_reader dma = file_reader::open(std::string(test_file_name)).get0();
+        BOOST_CHECK(mapped.mapped());
+        BOOST_CHECK(!dma.mapped());
+        BOOST_CHECK(mapped.metadata() == dma.metadata());
+        check_same_contents(mapped, dma);
+        mapped.close().get();
+        dma.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(in_memory_policy_maps_only_tmpfs) {
+    return seastar::async([] {
+        write_test_file();
+        io_options options;
+        options.mmap = mmap_policy::in_memory;
+        file_reader fr = file_reader::open(std::string(test_file_name), options).get0();
+        bool tmpfs = seastar::file_system_at(std::string(test_file_name)).get0() == seastar::fs_type::tmpfs;
+        BOOST_CHECK_EQUAL(fr.mapped(), tmpfs);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(mapped_stream_does_not_advance_past_its_end) {
+    return seastar::async([] {
+        auto mapping = mapped_file::from_buffer(seastar::temporary_buffer<char>("0123456789", 10));
+        peekable_stream s{mapping, mapping->contents().substr(2, 4)};
+        s.advance(3).get();
+        BOOST_CHECK_EQUAL(s.position(), 3);
+        BOOST_CHECK_THROW(s.advance(2).get(), parquet_exception);
+        BOOST_CHECK_EQUAL(s.position(), 3);
+        s.advance(1).get();
+        BOOST_CHECK_EQUAL(s.peek(1).get0().size(), 0);
+    });
+}
+
+SEASTAR_TEST_CASE(mapped_footer_is_validated) {
+    return seastar::async([] {
+        auto write_file = [] (const char* contents, size_t size) {
+            seastar::file f = seastar::open_file_dma(test_file_name.data(),
+                    seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create).get0();
+            seastar::output_stream<char> out = seastar::make_file_output_stream(f);
+            out.write(contents, size).get();
+            out.close().get();
+        };
+        io_options options;
+        options.mmap = mmap_policy::always;
+        write_file("\xff\xff\x00\x00PAR1", 8);
+        BOOST_CHECK_THROW(file_reader::open(std::string(test_file_name), options).get0(), parquet_exception);
+        // A metadata length for which metadata_len + 8 wraps around in 32 bits.
+        write_file("PAR1\0\0\0\0\xfc\xff\xff\xffPAR1", 16);
+        BOOST_CHECK_THROW(file_reader::open(std::string(test_file_name), options).get0(), parquet_exception);
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,204 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <parquet4seastar/record_reader.hh>
+#include <numeric>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_multi_record_reader_test.parquet";
+constexpr int32_t n_row_groups = 50;
+constexpr int32_t rows_per_row_group = 20;
+
+namespace {
+
+// Column a holds the row number, optional column b a string on even rows.
+void write_file() {
+    writer_schema::schema schema;
+    schema.fields.push_back(writer_schema::primitive_node{"a", false, logical_type::INT32{}});
+    schema.fields.push_back(writer_schema::primitive_node{"b", true, logical_type::STRING{}});
+    std::unique_ptr<file_writer> fw = file_writer::open(std::string(test_file_name), schema).get0();
+    int32_t row = 0;
+    for (int32_t rg = 0; rg < n_row_groups; ++rg) {
+        for (int32_t i = 0; i < rows_per_row_group; ++i, ++row) {
+            fw->column<format::Type::INT32>(0).put(0, 0, row);
+            if (row % 2 == 0) {
+                std::string s = std::to_string(row);
+                fw->column<format::Type::BYTE_ARRAY>(1).put(1, 0, bytes_view{reinterpret_cast<const uint8_t*>(s.data()), s.size()});
+            } else {
+                fw->column<format::Type::BYTE_ARRAY>(1).put(0, 0, {});
+            }
+        }
+        fw->flush_row_group().get();
+    }
+    fw->close().get();
+}
+
+// Records the order of rows, by column a, and the number of non-null strings.
+struct checking_consumer {
+    std::vector<int32_t> rows;
+    int64_t strings = 0;
+    int64_t nulls = 0;
+    void start_record() {}
+    void end_record() {}
+    void start_column(const std::string&) {}
+    void start_struct() {}
+    void end_struct() {}
+    void start_field(const std::string&) {}
+    void start_list() {}
+    void end_list() {}
+    void start_map() {}
+    void end_map() {}
+    void separate_key_value() {}
+    void separate_list_values() {}
+    void separate_map_values() {}
+    void append_null() { ++nulls; }
+    void append_value(logical_type::INT32, int32_t v) { rows.push_back(v); }
+    template <typename LogicalType, typename Value>
+    void append_value(LogicalType, Value&&) { ++strings; }
+};
+
+// Records the number of readers opened ahead at the first record of each row group.
+struct lookahead_consumer : checking_consumer {
+    const record::multi_record_reader* reader = nullptr;
+    std::vector<size_t> opened_ahead;
+    void append_value(logical_type::INT32, int32_t v) {
+        if (v % rows_per_row_group == 0) {
+            opened_ahead.push_back(reader->opened_ahead());
+        }
+        checking_consumer::append_value(logical_type::INT32{}, v);
+    }
+    template <typename LogicalType, typename Value>
+    void append_value(LogicalType lt, Value&& v) {
+        checking_consumer::append_value(lt, std::forward<Value>(v));
+    }
+};
+
+// Fails at the first row of the second row group.
+struct failing_consumer : checking_consumer {
+    void append_value(logical_type::INT32, int32_t v) {
+        if (v == rows_per_row_group) {
+            throw std::runtime_error("consumer failed");
+        }
+        checking_consumer::append_value(logical_type::INT32{}, v);
+    }
+    template <typename LogicalType, typename Value>
+    void append_value(LogicalType lt, Value&& v) {
+        checking_consumer::append_value(lt, std::forward<Value>(v));
+    }
+};
+
+} // namespace
+
+SEASTAR_TEST_CASE(row_groups_are_read_in_order) {
+    return seastar::async([] {
+        write_file();
+        file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+        BOOST_REQUIRE_EQUAL(fr.metadata().row_groups.size(), n_row_groups);
+        std::vector<int32_t> expected_rows(n_row_groups * rows_per_row_group);
+        std::iota(expected_rows.begin(), expected_rows.end(), 0);
+        for (size_t lookahead : {0, 1, 4, 100}) {
+            checking_consumer consumer;
+            record::multi_record_reader rr{fr, lookahead};
+            rr.read_all(consumer).get();
+            rr.close().get();
+            BOOST_CHECK(consumer.rows == expected_rows);
+            BOOST_CHECK_EQUAL(consumer.strings, n_row_groups * rows_per_row_group / 2);
+            BOOST_CHECK_EQUAL(consumer.nulls, n_row_groups * rows_per_row_group / 2);
+        }
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(selected_row_groups_and_columns) {
+    return seastar::async([] {
+        write_file();
+        file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+        checking_consumer consumer;
+        record::multi_record_reader rr{fr, {7, 3, 49}, 2, {"a"}};
+        rr.read_all(consumer).get();
+        rr.close().get();
+        std::vector<int32_t> expected_rows;
+        for (int32_t rg : {7, 3, 49}) {
+            for (int32_t i = 0; i < rows_per_row_group; ++i) {
+                expected_rows.push_back(rg * rows_per_row_group + i);
+            }
+        }
+        BOOST_CHECK(consumer.rows == expected_rows);
+        BOOST_CHECK_EQUAL(consumer.strings, 0);
+        BOOST_CHECK_EQUAL(consumer.nulls, 0);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(close_without_reading) {
+    return seastar::async([] {
+        write_file();
+        file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+        {
+            record::multi_record_reader rr{fr, 8};
+            rr.close().get();
+        }
+        {
+            // Opening ahead fails on the missing column; the error is reported when it is read,
+            // and the readers opened ahead are closed by read_all.
+            record::multi_record_reader rr{fr, {0, 1, 2}, 2, {"c"}};
+            checking_consumer consumer;
+            BOOST_CHECK_THROW(rr.read_all(consumer).get(), parquet_exception);
+            BOOST_CHECK_EQUAL(rr.opened_ahead(), 0);
+            rr.close().get();
+        }
+        {
+            // The consumer fails in the second row group, while the next ones are opened ahead.
+            record::multi_record_reader rr{fr, 4};
+            failing_consumer consumer;
+            BOOST_CHECK_THROW(rr.read_all(consumer).get(), std::runtime_error);
+            BOOST_CHECK_EQUAL(rr.opened_ahead(), 0);
+            rr.close().get();
+        }
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(lookahead_bounds_the_readers_opened_ahead) {
+    return seastar::async([] {
+        write_file();
+        file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+        for (size_t lookahead : {0, 1, 4}) {
+            record::multi_record_reader rr{fr, lookahead};
+            lookahead_consumer consumer;
+            consumer.reader = &rr;
+            rr.read_all(consumer).get();
+            rr.close().get();
+            BOOST_REQUIRE_EQUAL(consumer.opened_ahead.size(), n_row_groups);
+            for (size_t rg = 0; rg < n_row_groups; ++rg) {
+                size_t expected = std::min<size_t>(lookahead, n_row_groups - rg - 1);
+                BOOST_CHECK_EQUAL(consumer.opened_ahead[rg], expected);
+            }
+        }
+        fr.close().get();
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,204 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <parquet4seastar/file_reader.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <parquet4seastar/page_cache.hh>
+#include <algorithm>
+#include <numeric>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_page_cache_test.parquet";
+
+namespace {
+
+// n_rows must be a multiple of 100.
+void write_test_file(int32_t n_rows = 10000) {
+    writer_schema::schema schema;
+    schema.fields.push_back(writer_schema::primitive_node{
+            "a",
+            false,
+            logical_type::INT32{},
+            {},
+            format::Encoding::RLE_DICTIONARY,
+            format::CompressionCodec::GZIP});
+    schema.fields.push_back(writer_schema::primitive_node{
+            "b",
+            true,
+            logical_type::INT64{},
+            {},
+            format::Encoding::PLAIN,
+            format::CompressionCodec::SNAPPY});
+    std::unique_ptr<file_writer> fw = file_writer::open(std::string(test_file_name), schema).get0();
+    for (int32_t i = 0; i < n_rows; ++i) {
+        fw->column<format::Type::INT32>(0).put(0, 0, i % 100);
+        fw->column<format::Type::INT64>(1).put(i % 2, 0, i);
+    }
+    fw->close().get();
+}
+
+// The sum of both columns, read with column chunk readers.
+int64_t read_test_file(const io_options& options = {}) {
+    file_reader fr = file_reader::open(std::string(test_file_name), options).get0();
+    int64_t sum = 0;
+    int32_t def[1024];
+    int32_t rep[1024];
+    {
+        column_chunk_reader<format::Type::INT32> r = fr.open_column_chunk_reader<format::Type::INT32>(0, 0).get0();
+        int32_t val[1024];
+        while (size_t n = r.read_batch(1024, def, rep, val).get0()) {
+            sum += std::accumulate(val, val + n, int64_t(0));
+        }
+    }
+    {
+        column_chunk_reader<format::Type::INT64> r = fr.open_column_chunk_reader<format::Type::INT64>(0, 1).get0();
+        int64_t val[1024];
+        while (size_t n = r.read_batch(1024, def, rep, val).get0()) {
+            size_t n_values = std::count(def, def + n, 1);
+            sum += std::accumulate(val, val + n_values, int64_t(0));
+        }
+    }
+    fr.close().get();
+    return sum;
+}
+
+int64_t expected_sum(int64_t n_rows = 10000) {
+    return n_rows / 100 * (99 * 100 / 2) + (n_rows / 2) * (n_rows / 2);
+}
+
+} // namespace
+
+SEASTAR_TEST_CASE(second_scan_hits_the_cache) {
+    return seastar::async([] {
+        write_test_file();
+        enable_page_cache(16 * 1024 * 1024);
+        page_cache& cache = *local_page_cache();
+
+        BOOST_CHECK_EQUAL(read_test_file(), expected_sum());
+        BOOST_CHECK_EQUAL(cache.get_stats().hits, 0);
+        uint64_t misses = cache.get_stats().misses;
+        BOOST_CHECK_GT(misses, 0);
+        BOOST_CHECK_EQUAL(cache.get_stats().insertions, misses);
+        BOOST_CHECK_EQUAL(cache.entries(), misses);
+        BOOST_CHECK_GT(cache.size_bytes(), 0);
+
+        BOOST_CHECK_EQUAL(read_test_file(), expected_sum());
+        BOOST_CHECK_EQUAL(cache.get_stats().hits, misses);
+        BOOST_CHECK_EQUAL(cache.get_stats().misses, misses);
+
+        // A rewritten file must not be served from the cache.
+        write_test_file(20000);
+        BOOST_CHECK_EQUAL(read_test_file(), expected_sum(20000));
+        BOOST_CHECK_EQUAL(cache.get_stats().hits, misses);
+        BOOST_CHECK_GT(cache.get_stats().misses, misses);
+
+        disable_page_cache();
+    });
+}
+
+namespace {
+
+// The page ordinal of the reader after each batch of the first column.
+std::vector<int64_t> page_ordinals() {
+    file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+    std::vector<int64_t> ordinals;
+    {
+        column_chunk_reader<format::Type::INT32> r = fr.open_column_chunk_reader<format::Type::INT32>(0, 0).get0();
+        int32_t def[1024];
+        int32_t rep[1024];
+        int32_t val[1024];
+        while (r.read_batch(1024, def, rep, val).get0()) {
+            ordinals.push_back(r.page_ordinal());
+        }
+    }
+    fr.close().get();
+    return ordinals;
+}
+
+} // namespace
+
+SEASTAR_TEST_CASE(cache_hits_count_pages_once) {
+    return seastar::async([] {
+        write_test_file();
+        enable_page_cache(16 * 1024 * 1024);
+        std::vector<int64_t> cold = page_ordinals();
+        BOOST_CHECK_EQUAL(local_page_cache()->get_stats().hits, 0);
+        std::vector<int64_t> warm = page_ordinals();
+        BOOST_CHECK_GT(local_page_cache()->get_stats().hits, 0);
+        BOOST_CHECK(!cold.empty());
+        BOOST_CHECK(cold == warm);
+        // The dictionary page is page 0.
+        BOOST_CHECK_EQUAL(cold.front(), 1);
+        disable_page_cache();
+    });
+}
+
+SEASTAR_TEST_CASE(readers_can_bypass_the_cache) {
+    return seastar::async([] {
+        write_test_file();
+        enable_page_cache(16 * 1024 * 1024);
+        io_options options;
+        options.use_page_cache = false;
+        BOOST_CHECK_EQUAL(read_test_file(options), expected_sum());
+        BOOST_CHECK_EQUAL(local_page_cache()->get_stats().misses, 0);
+        BOOST_CHECK_EQUAL(local_page_cache()->entries(), 0);
+        disable_page_cache();
+    });
+}
+
+SEASTAR_TEST_CASE(cache_is_bounded) {
+    return seastar::async([] {
+        write_test_file();
+        enable_page_cache(16 * 1024 * 1024);
+        page_cache& cache = *local_page_cache();
+        BOOST_CHECK_EQUAL(read_test_file(), expected_sum());
+        size_t entries = cache.entries();
+        size_t size = cache.size_bytes();
+        BOOST_REQUIRE_GT(entries, 1);
+
+        cache.shrink(size - 1);
+        BOOST_CHECK_LT(cache.entries(), entries);
+        BOOST_CHECK_LT(cache.size_bytes(), size);
+        BOOST_CHECK_EQUAL(cache.get_stats().evictions, entries - cache.entries());
+
+        // Evicted pages are read again, the others are hits.
+        uint64_t hits = cache.get_stats().hits;
+        BOOST_CHECK_EQUAL(read_test_file(), expected_sum());
+        BOOST_CHECK_GT(cache.get_stats().hits, hits);
+        BOOST_CHECK_EQUAL(cache.entries(), entries);
+
+        cache.clear();
+        BOOST_CHECK_EQUAL(cache.entries(), 0);
+        BOOST_CHECK_EQUAL(cache.size_bytes(), 0);
+
+        // Pages bigger than the capacity are not cached.
+        enable_page_cache(1);
+        BOOST_CHECK_EQUAL(read_test_file(), expected_sum());
+        BOOST_CHECK_EQUAL(local_page_cache()->entries(), 0);
+        BOOST_CHECK_EQUAL(local_page_cache()->size_bytes(), 0);
+        disable_page_cache();
+    });
+}
+
+} // namespace parquet4seastar
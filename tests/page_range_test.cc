@@ -0,0 +1,279 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/core/future-util.hh>
+#include <parquet4seastar/file_reader.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <boost/range/irange.hpp>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_page_range_test.parquet";
+constexpr std::string_view indexed_file_name = "/tmp/parquet4seastar_page_range_test_indexed.parquet";
+constexpr std::string_view no_dictionary_offset_file_name =
+        "/tmp/parquet4seastar_page_range_test_no_dictionary_offset.parquet";
+constexpr int32_t n_rows = 10000;
+constexpr int32_t rows_per_page = 250;
+
+namespace {
+
+template <typename T>
+std::unique_ptr<T> box(T&& x) {
+    return std::make_unique<T>(std::forward<T>(x));
+}
+
+// One row group of 40 pages per column:
+// a: required INT64, b: optional INT32 with a dictionary, c: list of INT32.
+void write_file() {
+    using namespace writer_schema;
+    schema root;
+    root.fields.push_back(primitive_node{
+            "a", false, logical_type::INT64{}, {}, format::Encoding::PLAIN, format::CompressionCodec::SNAPPY});
+    root.fields.push_back(primitive_node{
+            "b", true, logical_type::INT32{}, {}, format::Encoding::RLE_DICTIONARY, format::CompressionCodec::GZIP});
+    root.fields.push_back(list_node{"c", false, box<node>(primitive_node{
+            "element", false, logical_type::INT32{}, {}, format::Encoding::PLAIN, format::CompressionCodec::UNCOMPRESSED})});
+    std::unique_ptr<file_writer> fw = file_writer::open(std::string(test_file_name), root).get0();
+    for (int32_t i = 0; i < n_rows; ++i) {
+        fw->column<format::Type::INT64>(0).put(0, 0, i);
+        if (i % 5 == 0) {
+            fw->column<format::Type::INT32>(1).put(0, 0, {});
+        } else {
+            fw->column<format::Type::INT32>(1).put(1, 0, i % 7);
+        }
+        for (int32_t j = 0; j <= i % 3; ++j) {
+            fw->column<format::Type::INT32>(2).put(1, j > 0, i + j);
+        }
+        if ((i + 1) % rows_per_page == 0) {
+            fw->column<format::Type::INT64>(0).flush_page();
+            fw->column<format::Type::INT32>(1).flush_page();
+            fw->column<format::Type::INT32>(2).flush_page();
+        }
+    }
+    fw->close().get();
+}
+
+template <typename T>
+struct column_values {
+    std::vector<int16_t> def;
+    std::vector<int16_t> rep;
+    std::vector<T> values;
+};
+
+template <format::Type::type T>
+column_values<typename column_chunk_reader<T>::output_type> read_values(column_chunk_reader<T>& r, int16_t max_def_level) {
+    column_values<typename column_chunk_reader<T>::output_type> result;
+    int16_t def[128];
+    int16_t rep[128];
+    typename column_chunk_reader<T>::output_type val[128];
+    while (size_t n = r.read_batch(128, def, rep, val).get0()) {
+        size_t n_values = 0;
+        for (size_t i = 0; i < n; ++i) {
+            result.def.push_back(def[i]);
+            result.rep.push_back(rep[i]);
+            n_values += def[i] == max_def_level;
+        }
+        result.values.insert(result.values.end(), val, val + n_values);
+    }
+    return result;
+}
+
+// Reads the ranges concurrently, and concatenates their values in order.
+template <format::Type::type T>
+column_values<typename column_chunk_reader<T>::output_type> read_ranges(
+        file_reader& fr, const std::vector<page_range>& ranges, int16_t max_def_level) {
+    using values_type = column_values<typename column_chunk_reader<T>::output_type>;
+    std::vector<values_type> parts(ranges.size());
+    seastar::parallel_for_each(boost::irange<size_t>(0, ranges.size()), [&] (size_t i) {
+        return seastar::async([&, i] {
+            column_chunk_reader<T> r = fr.open_column_chunk_reader<T>(ranges[i]).get0();
+            parts[i] = read_values(r, max_def_level);
+            int64_t records = std::count(parts[i].rep.begin(), parts[i].rep.end(), 0);
+            BOOST_CHECK_EQUAL(records, ranges[i].num_rows);
+        });
+    }).get();
+    values_type result;
+    for (values_type& part : parts) {
+        result.def.insert(result.def.end(), part.def.begin(), part.def.end());
+        result.rep.insert(result.rep.end(), part.rep.begin(), part.rep.end());
+        result.values.insert(result.values.end(), part.values.begin(), part.values.end());
+    }
+    return result;
+}
+
+template <format::Type::type T>
+void check_ranges(file_reader& fr, uint32_t column, size_t max_ranges, size_t expected_ranges) {
+    std::vector<page_range> ranges = fr.split_column_chunk(0, column, max_ranges).get0();
+    BOOST_REQUIRE_EQUAL(ranges.size(), expected_ranges);
+    int64_t rows = 0;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        BOOST_CHECK_EQUAL(ranges[i].first_row, rows);
+        BOOST_CHECK_LT(ranges[i].begin, ranges[i].end);
+        if (i > 0) {
+            BOOST_CHECK_EQUAL(ranges[i - 1].end, ranges[i].begin);
+        }
+        rows += ranges[i].num_rows;
+    }
+    BOOST_CHECK_EQUAL(rows, n_rows);
+    BOOST_CHECK_EQUAL(ranges.back().end, fr.metadata().row_groups[0].columns[column].meta_data.total_compressed_size);
+
+    int16_t max_def_level = fr.raw_schema().leaves[column]->def_level;
+    column_chunk_reader<T> whole = fr.open_column_chunk_reader<T>(0, column).get0();
+    auto expected = read_values(whole, max_def_level);
+    auto actual = read_ranges<T>(fr, ranges, max_def_level);
+    BOOST_CHECK(actual.def == expected.def);
+    BOOST_CHECK(actual.rep == expected.rep);
+    BOOST_CHECK(actual.values == expected.values);
+}
+
+// Copies the test file, adding an OffsetIndex to column a which lists only every other page.
+void write_indexed_file(file_reader& fr) {
+    std::vector<page_range> pages = fr.split_column_chunk(0, 0, n_rows).get0();
+    BOOST_REQUIRE_EQUAL(pages.size(), n_rows / rows_per_page);
+    format::FileMetaData metadata = fr.metadata();
+    format::ColumnChunk& column_chunk = metadata.row_groups[0].columns[0];
+    int64_t chunk_offset = column_chunk.meta_data.data_page_offset;
+    format::OffsetIndex index;
+    for (size_t i = 0; i < pages.size(); i += 2) {
+        format::PageLocation location;
+        location.__set_offset(chunk_offset + pages[i].begin);
+        location.__set_compressed_page_size(pages[i].end - pages[i].begin);
+        location.__set_first_row_index(pages[i].first_row);
+        index.page_locations.push_back(location);
+    }
+
+    seastar::file input = seastar::open_file_dma(test_file_name.data(), seastar::open_flags::ro).get0();
+    uint64_t size = input.size().get0();
+    auto contents = input.dma_read_exactly<char>(0, size).get0();
+    input.close().get();
+    uint32_t metadata_len;
+    std::memcpy(&metadata_len, contents.get() + size - 8, 4);
+    uint64_t data_size = size - 8 - metadata_len;
+
+    thrift_serializer index_serializer;
+    bytes_view serialized_index = index_serializer.serialize(index);
+    column_chunk.__set_offset_index_offset(data_size);
+    column_chunk.__set_offset_index_length(serialized_index.size());
+    thrift_serializer metadata_serializer;
+    bytes_view serialized_metadata = metadata_serializer.serialize(metadata);
+    uint32_t new_metadata_len = serialized_metadata.size();
+
+    seastar::file output_file = seastar::open_file_dma(
+            indexed_file_name.data(), seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create).get0();
+    seastar::output_stream<char> output = seastar::make_file_output_stream(output_file);
+    output.write(contents.get(), data_size).get();
+    output.write(reinterpret_cast<const char*>(serialized_index.data()), serialized_index.size()).get();
+    output.write(reinterpret_cast<const char*>(serialized_metadata.data()), serialized_metadata.size()).get();
+    output.write(reinterpret_cast<const char*>(&new_metadata_len), 4).get();
+    output.write("PAR1", 4).get();
+    output.close().get();
+}
+
+// Copies the test file, with the dictionary page of column b located only by data_page_offset,
+// as some writers do.
+void write_file_without_dictionary_offset(file_reader& fr) {
+    format::FileMetaData metadata = fr.metadata();
+    format::ColumnMetaData& column_metadata = metadata.row_groups[0].columns[1].meta_data;
+    BOOST_REQUIRE(column_metadata.__isset.dictionary_page_offset);
+    column_metadata.data_page_offset = column_metadata.dictionary_page_offset;
+    column_metadata.__isset.dictionary_page_offset = false;
+
+    seastar::file input = seastar::open_file_dma(test_file_name.data(), seastar::open_flags::ro).get0();
+    uint64_t size = input.size().get0();
+    auto contents = input.dma_read_exactly<char>(0, size).get0();
+    input.close().get();
+    uint32_t metadata_len;
+    std::memcpy(&metadata_len, contents.get() + size - 8, 4);
+    uint64_t data_size = size - 8 - metadata_len;
+
+    thrift_serializer metadata_serializer;
+    bytes_view serialized_metadata = metadata_serializer.serialize(metadata);
+    uint32_t new_metadata_len = serialized_metadata.size();
+    seastar::file output_file = seastar::open_file_dma(
+            no_dictionary_offset_file_name.data(),
+            seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create).get0();
+    seastar::output_stream<char> output = seastar::make_file_output_stream(output_file);
+    output.write(contents.get(), data_size).get();
+    output.write(reinterpret_cast<const char*>(serialized_metadata.data()), serialized_metadata.size()).get();
+    output.write(reinterpret_cast<const char*>(&new_metadata_len), 4).get();
+    output.write("PAR1", 4).get();
+    output.close().get();
+}
+
+} // namespace
+
+SEASTAR_TEST_CASE(page_ranges_from_page_headers) {
+    return seastar::async([] {
+        write_file();
+        file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+        BOOST_REQUIRE_EQUAL(fr.metadata().row_groups.size(), 1);
+        check_ranges<format::Type::INT64>(fr, 0, 4, 4);
+        check_ranges<format::Type::INT64>(fr, 0, 1, 1);
+        // No more ranges than pages.
+        check_ranges<format::Type::INT64>(fr, 0, 1000, n_rows / rows_per_page);
+        // Every range reads the dictionary page.
+        BOOST_REQUIRE(fr.metadata().row_groups[0].columns[1].meta_data.__isset.dictionary_page_offset);
+        check_ranges<format::Type::INT32>(fr, 1, 3, 3);
+        // Pages of repeated columns need not start at record boundaries.
+        check_ranges<format::Type::INT32>(fr, 2, 4, 1);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(page_ranges_from_offset_index) {
+    return seastar::async([] {
+        write_file();
+        {
+            file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+            write_indexed_file(fr);
+            fr.close().get();
+        }
+        file_reader fr = file_reader::open(std::string(indexed_file_name)).get0();
+        BOOST_REQUIRE(fr.metadata().row_groups[0].columns[0].__isset.offset_index_offset);
+        // Only the pages listed in the index are range boundaries.
+        check_ranges<format::Type::INT64>(fr, 0, 1000, n_rows / rows_per_page / 2);
+        check_ranges<format::Type::INT64>(fr, 0, 5, 5);
+        fr.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(page_ranges_without_dictionary_page_offset) {
+    return seastar::async([] {
+        write_file();
+        {
+            file_reader fr = file_reader::open(std::string(test_file_name)).get0();
+            write_file_without_dictionary_offset(fr);
+            fr.close().get();
+        }
+        file_reader fr = file_reader::open(std::string(no_dictionary_offset_file_name)).get0();
+        std::vector<page_range> ranges = fr.split_column_chunk(0, 1, 3).get0();
+        BOOST_REQUIRE(!ranges.empty());
+        // The dictionary page is found from the first data page.
+        BOOST_CHECK_GT(ranges.front().dictionary_size, 0);
+        BOOST_CHECK_EQUAL(ranges.front().begin, ranges.front().dictionary_size);
+        check_ranges<format::Type::INT32>(fr, 1, 3, 3);
+        fr.close().get();
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,200 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/* Stress tests for reactor stalls in the long loops over pages and dictionaries.
+ * A ticker task measures how long the reactor is kept away from it while
+ * a big page is compressed, decompressed, decoded or encoded. Done in one
+ * task, each of these takes hundreds of milliseconds.
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/future-util.hh>
+#include <parquet4seastar/column_chunk_reader.hh>
+#include <parquet4seastar/column_chunk_writer.hh>
+#include <parquet4seastar/preempt.hh>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_preemption_test.bin";
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+// Far above the task quota, and far below the time the whole work would take in one task.
+constexpr clock::duration max_allowed_stall = std::chrono::milliseconds(50);
+
+// Run work() (in a seastar thread) and return the longest time the reactor didn't run other tasks.
+template <typename Func>
+clock::duration max_stall(Func work) {
+    bool done = false;
+    clock::duration max_gap = clock::duration::zero();
+    seastar::future<> ticker = seastar::do_until([&done] { return done; }, [&max_gap] {
+        auto before = clock::now();
+        return seastar::later().then([&max_gap, before] {
+            max_gap = std::max(max_gap, clock::now() - before);
+        });
+    });
+    work();
+    done = true;
+    ticker.get();
+    return max_gap;
+}
+
+bytes compressible_bytes(size_t size) {
+    bytes b(size, 0);
+    uint32_t x = 1;
+    for (size_t i = 0; i < size; ++i) {
+        x = x * 1103515245 + 12345;
+        b[i] = static_cast<uint8_t>('a' + (x >> 16) % 8);
+    }
+    return b;
+}
+
+} // namespace
+
+// need_preempt() is always true in debug builds, so a loop which checked it before every step
+// would only yield. Every call must make progress.
+SEASTAR_TEST_CASE(preemptible_loops_make_progress) {
+    return seastar::async([] {
+        size_t steps = 0;
+        repeat_preemptible([&steps] {
+            return ++steps == 1000 ? seastar::stop_iteration::yes : seastar::stop_iteration::no;
+        }).get();
+        BOOST_CHECK_EQUAL(steps, 1000);
+
+        auto gzip = compressor::make(format::CompressionCodec::GZIP);
+        bytes raw = compressible_bytes(4 * preemption_step_size + 1);
+        bytes compressed = gzip->compress_preemptible(raw).get0();
+        bytes decompressed = gzip->decompress_preemptible(compressed, bytes(raw.size(), 0)).get0();
+        BOOST_CHECK(decompressed == raw);
+    });
+}
+
+// Buffers of a few bytes are stored inline in the string, so they move with it.
+SEASTAR_TEST_CASE(gzip_round_trip_of_tiny_pages) {
+    return seastar::async([] {
+        auto gzip = compressor::make(format::CompressionCodec::GZIP);
+        for (size_t size = 0; size <= 16; ++size) {
+            bytes raw = compressible_bytes(size);
+            bytes compressed = gzip->compress_preemptible(raw).get0();
+            BOOST_CHECK(gzip->decompress(compressed, bytes(raw.size(), 0)) == raw);
+            bytes decompressed = gzip->decompress_preemptible(compressed, bytes(raw.size(), 0)).get0();
+            BOOST_CHECK(decompressed == raw);
+        }
+    });
+}
+
+SEASTAR_TEST_CASE(gzip_does_not_stall) {
+    return seastar::async([] {
+        auto gzip = compressor::make(format::CompressionCodec::GZIP);
+        bytes raw = compressible_bytes(32 * 1024 * 1024);
+        bytes compressed;
+        auto stall = max_stall([&] {
+            compressed = gzip->compress_preemptible(raw).get0();
+        });
+        BOOST_CHECK_LT(stall.count(), max_allowed_stall.count());
+
+        bytes decompressed;
+        stall = max_stall([&] {
+            decompressed = gzip->decompress_preemptible(compressed, bytes(raw.size(), 0)).get0();
+        });
+        BOOST_CHECK_LT(stall.count(), max_allowed_stall.count());
+        BOOST_CHECK(decompressed == raw);
+    });
+}
+
+SEASTAR_TEST_CASE(dictionary_load_does_not_stall) {
+    return seastar::async([] {
+        // A dictionary page of 2M strings. The writer never produces dictionaries
+        // this big, so the page is put together by hand.
+        constexpr int32_t n_values = 2 * 1024 * 1024;
+        bytes dict;
+        for (int32_t i = 0; i < n_values; ++i) {
+            std::string value = seastar::format("{:012}", i);
+            uint32_t len = value.size();
+            dict.insert(dict.end(), reinterpret_cast<const uint8_t*>(&len), reinterpret_cast<const uint8_t*>(&len) + 4);
+            dict.insert(dict.end(), value.begin(), value.end());
+        }
+        format::PageHeader header;
+        header.__set_type(format::PageType::DICTIONARY_PAGE);
+        header.__set_uncompressed_page_size(dict.size());
+        header.__set_compressed_page_size(dict.size());
+        format::DictionaryPageHeader dict_header;
+        dict_header.__set_num_values(n_values);
+        dict_header.__set_encoding(format::Encoding::PLAIN);
+        header.__set_dictionary_page_header(dict_header);
+        thrift_serializer serializer;
+        bytes_view serialized_header = serializer.serialize(header);
+
+        seastar::file output_file = seastar::open_file_dma(
+                test_file_name.data(), seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create).get0();
+        seastar::output_stream<char> output = seastar::make_file_output_stream(output_file);
+        output.write(reinterpret_cast<const char*>(serialized_header.data()), serialized_header.size()).get();
+        output.write(reinterpret_cast<const char*>(dict.data()), dict.size()).get();
+        output.flush().get();
+        output.close().get();
+
+        seastar::file input_file = seastar::open_file_dma(test_file_name.data(), seastar::open_flags::ro).get0();
+        column_chunk_reader<format::Type::BYTE_ARRAY> r{
+            page_reader{seastar::make_file_input_stream(std::move(input_file))},
+            format::CompressionCodec::UNCOMPRESSED,
+            0,
+            0,
+            std::nullopt};
+        auto stall = max_stall([&] {
+            int32_t def[1];
+            int32_t rep[1];
+            seastar::temporary_buffer<uint8_t> val[1];
+            BOOST_CHECK_EQUAL(r.read_batch(1, def, rep, val).get0(), 0);
+        });
+        BOOST_CHECK_LT(stall.count(), max_allowed_stall.count());
+    });
+}
+
+SEASTAR_TEST_CASE(dictionary_flush_does_not_stall) {
+    return seastar::async([] {
+        // A single page of 32M values from a tiny dictionary.
+        column_chunk_writer<format::Type::INT32> w{
+            0,
+            0,
+            make_value_encoder<format::Type::INT32>(format::Encoding::RLE_DICTIONARY),
+            compressor::make(format::CompressionCodec::GZIP)};
+        uint32_t x = 1;
+        for (int32_t i = 0; i < 32 * 1024 * 1024; ++i) {
+            x = x * 1103515245 + 12345;
+            w.put(0, 0, (x >> 16) % 16);
+        }
+        seastar::file output_file = seastar::open_file_dma(
+                test_file_name.data(), seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create).get0();
+        seastar::output_stream<char> output = seastar::make_file_output_stream(output_file);
+        auto stall = max_stall([&] {
+            w.flush_chunk(output).get0();
+        });
+        output.flush().get();
+        output.close().get();
+        BOOST_CHECK_LT(stall.count(), max_allowed_stall.count());
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,181 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <parquet4seastar/file_writer.hh>
+#include <parquet4seastar/sharded_scan.hh>
+
+namespace parquet4seastar {
+
+namespace {
+
+constexpr int32_t rows_per_row_group = 100;
+
+// Column a holds the row number within the file, column b its negation.
+void write_file(const std::string& path, int n_row_groups) {
+    writer_schema::schema schema;
+    schema.fields.push_back(writer_schema::primitive_node{"a", false, logical_type::INT32{}});
+    schema.fields.push_back(writer_schema::primitive_node{"b", false, logical_type::INT64{}});
+    std::unique_ptr<file_writer> fw = file_writer::open(path, schema).get0();
+    int32_t row = 0;
+    for (int rg = 0; rg < n_row_groups; ++rg) {
+        for (int32_t i = 0; i < rows_per_row_group; ++i, ++row) {
+            fw->column<format::Type::INT32>(0).put(0, 0, row);
+            fw->column<format::Type::INT64>(1).put(0, 0, -row);
+        }
+        fw->flush_row_group().get();
+    }
+    fw->close().get();
+}
+
+struct summary {
+    int64_t records = 0;
+    int64_t values = 0;
+    int64_t sum = 0;
+};
+
+struct summing_consumer {
+    summary s;
+    void start_record() {}
+    void end_record() { ++s.records; }
+    void start_column(const std::string&) {}
+    void start_struct() {}
+    void end_struct() {}
+    void start_field(const std::string&) {}
+    void start_list() {}
+    void end_list() {}
+    void start_map() {}
+    void end_map() {}
+    void separate_key_value() {}
+    void separate_list_values() {}
+    void separate_map_values() {}
+    void append_null() {}
+    void append_value(logical_type::INT32, int32_t v) { ++s.values; s.sum += v; }
+    void append_value(logical_type::INT64, int64_t v) { ++s.values; s.sum += v; }
+    template <typename LogicalType, typename Value>
+    void append_value(LogicalType, Value&&) { ++s.values; }
+    summary finish() { return s; }
+};
+
+std::vector<std::string> write_files() {
+    std::vector<std::string> paths = {
+        "/tmp/parquet4seastar_sharded_scan_test_1.parquet",
+        "/tmp/parquet4seastar_sharded_scan_test_2.parquet"};
+    write_file(paths[0], 7);
+    write_file(paths[1], 3);
+    return paths;
+}
+
+} // namespace
+
+SEASTAR_TEST_CASE(row_groups_are_balanced) {
+    std::vector<std::vector<int64_t>> sizes = {{100, 1, 1, 1}, {50, 50}};
+    std::vector<std::vector<row_group_ref>> plan = distribute_row_groups(sizes, 2);
+    BOOST_REQUIRE_EQUAL(plan.size(), 2);
+    std::vector<int64_t> bytes;
+    std::vector<uint64_t> positions;
+    for (const auto& shard : plan) {
+        int64_t total = 0;
+        for (size_t i = 0; i < shard.size(); ++i) {
+            total += shard[i].byte_size;
+            positions.push_back(shard[i].position);
+            BOOST_CHECK_EQUAL(sizes[shard[i].file][shard[i].row_group], shard[i].byte_size);
+            if (i > 0) {
+                BOOST_CHECK_LT(shard[i - 1].position, shard[i].position);
+            }
+        }
+        bytes.push_back(total);
+    }
+    BOOST_CHECK_EQUAL(bytes[0], 102);
+    BOOST_CHECK_EQUAL(bytes[1], 101);
+    std::sort(positions.begin(), positions.end());
+    BOOST_CHECK(positions == (std::vector<uint64_t>{0, 1, 2, 3, 4, 5}));
+
+    // More shards than row groups.
+    plan = distribute_row_groups({{1}}, 4);
+    BOOST_CHECK_EQUAL(plan[0].size(), 1);
+    BOOST_CHECK(plan[1].empty() && plan[2].empty() && plan[3].empty());
+    return seastar::make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(ordered_scan) {
+    return seastar::async([] {
+        std::vector<std::string> paths = write_files();
+        sharded_scan_options options;
+        options.order = scan_order::ordered;
+        std::vector<row_group_ref> merged;
+        summary total;
+        sharded_scan(paths, options,
+                [] (const row_group_ref&) { return summing_consumer{}; },
+                [&] (const row_group_ref& ref, summary s) {
+                    merged.push_back(ref);
+                    BOOST_CHECK_EQUAL(s.records, rows_per_row_group);
+                    total.records += s.records;
+                    total.values += s.values;
+                    total.sum += s.sum;
+                }).get();
+        BOOST_REQUIRE_EQUAL(merged.size(), 10);
+        for (size_t i = 0; i < merged.size(); ++i) {
+            BOOST_CHECK_EQUAL(merged[i].position, i);
+        }
+        BOOST_CHECK_EQUAL(merged[6].file, 0);
+        BOOST_CHECK_EQUAL(merged[6].row_group, 6);
+        BOOST_CHECK_EQUAL(merged[7].file, 1);
+        BOOST_CHECK_EQUAL(merged[7].row_group, 0);
+        BOOST_CHECK_EQUAL(total.records, 1000);
+        BOOST_CHECK_EQUAL(total.values, 2000);
+        // Both columns cancel out.
+        BOOST_CHECK_EQUAL(total.sum, 0);
+    });
+}
+
+SEASTAR_TEST_CASE(unordered_scan_with_projection) {
+    return seastar::async([] {
+        std::vector<std::string> paths = write_files();
+        sharded_scan_options options;
+        options.columns = {"b"};
+        std::vector<uint64_t> positions;
+        summary total;
+        sharded_scan(paths, options,
+                [] (const row_group_ref&) { return summing_consumer{}; },
+                [&] (const row_group_ref& ref, summary s) {
+                    positions.push_back(ref.position);
+                    total.records += s.records;
+                    total.values += s.values;
+                    total.sum += s.sum;
+                }).get();
+        std::sort(positions.begin(), positions.end());
+        BOOST_CHECK_EQUAL(positions.size(), 10);
+        BOOST_CHECK(std::adjacent_find(positions.begin(), positions.end()) == positions.end());
+        BOOST_CHECK_EQUAL(total.records, 1000);
+        BOOST_CHECK_EQUAL(total.values, 1000);
+        // -(0 + ... + 699) - (0 + ... + 299)
+        BOOST_CHECK_EQUAL(total.sum, -244650 - 44850);
+
+        options.columns = {"c"};
+        BOOST_CHECK_THROW(sharded_scan(paths, options,
+                [] (const row_group_ref&) { return summing_consumer{}; },
+                [] (const row_group_ref&, summary) {}).get(), parquet_exception);
+    });
+}
+
+} // namespace parquet4seastar
@@ -0,0 +1,144 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/core/seastar.hh>
+#include <parquet4seastar/column_chunk_reader.hh>
+#include <parquet4seastar/column_chunk_writer.hh>
+#include <parquet4seastar/tracing.hh>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_tracing_test.bin";
+
+namespace {
+
+struct recorded_event {
+    tracing::phase phase;
+    std::string column;
+    int64_t page_ordinal;
+    uint64_t compressed_size;
+    uint64_t uncompressed_size;
+};
+
+class recording_tracer : public tracing::tracer {
+public:
+    std::vector<recorded_event> events;
+    void record(const tracing::event& e) override {
+        BOOST_CHECK(e.start <= e.end);
+        events.push_back(recorded_event{
+                e.phase, e.ctx ? e.ctx->column : "", e.page_ordinal, e.compressed_size, e.uncompressed_size});
+    }
+    size_t count(tracing::phase p) const {
+        return std::count_if(events.begin(), events.end(), [p] (const recorded_event& e) { return e.phase == p; });
+    }
+};
+
+} // namespace
+
+SEASTAR_TEST_CASE(page_phases_are_traced) {
+    return seastar::async([] {
+        // Write a dictionary page and two data pages.
+        seastar::file output_file = seastar::open_file_dma(
+                test_file_name.data(), seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create).get0();
+        seastar::output_stream<char> output = seastar::make_file_output_stream(output_file);
+        column_chunk_writer<format::Type::INT32> w{
+            0,
+            0,
+            make_value_encoder<format::Type::INT32>(format::Encoding::RLE_DICTIONARY),
+            compressor::make(format::CompressionCodec::SNAPPY)};
+        for (int32_t i = 0; i < 100; ++i) {
+            w.put(0, 0, i % 7);
+        }
+        w.flush_page();
+        for (int32_t i = 0; i < 100; ++i) {
+            w.put(0, 0, i % 5);
+        }
+        w.flush_chunk(output).get0();
+        output.flush().get();
+        output.close().get();
+
+        recording_tracer tracer;
+        tracing::set_tracer(&tracer);
+        seastar::file input_file = seastar::open_file_dma(test_file_name.data(), seastar::open_flags::ro).get0();
+        column_chunk_reader<format::Type::INT32> r{
+            page_reader{seastar::make_file_input_stream(std::move(input_file)),
+                    tracing::make_context(std::string(test_file_name), "a.b")},
+            format::CompressionCodec::SNAPPY,
+            0,
+            0,
+            std::nullopt};
+        int32_t def[256];
+        int32_t rep[256];
+        int32_t val[256];
+        size_t total = 0;
+        while (size_t n = r.read_batch(256, def, rep, val).get0()) {
+            total += n;
+        }
+        tracing::set_tracer(nullptr);
+        BOOST_CHECK_EQUAL(total, 200);
+
+        BOOST_CHECK_EQUAL(tracer.count(tracing::phase::page_header), 3);
+        BOOST_CHECK_EQUAL(tracer.count(tracing::phase::page_read), 3);
+        BOOST_CHECK_EQUAL(tracer.count(tracing::phase::decompress), 3);
+        // One event for the dictionary page and one per batch of values.
+        BOOST_CHECK_GE(tracer.count(tracing::phase::decode), 3);
+        for (const recorded_event& e : tracer.events) {
+            BOOST_CHECK_EQUAL(e.column, "a.b");
+            BOOST_CHECK(e.page_ordinal >= 0 && e.page_ordinal < 3);
+            if (e.phase == tracing::phase::decompress) {
+                BOOST_CHECK_GT(e.compressed_size, 0);
+                BOOST_CHECK_GT(e.uncompressed_size, 0);
+            }
+        }
+    });
+}
+
+SEASTAR_TEST_CASE(nothing_is_traced_without_a_tracer) {
+    tracing::set_tracer(nullptr);
+    BOOST_CHECK(!tracing::make_context("file"));
+    BOOST_CHECK(tracing::start() == tracing::trace_clock::time_point{});
+    return seastar::make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(chrome_trace_format) {
+    tracing::chrome_trace_writer writer{2};
+    tracing::context ctx{"dir/\"quoted\".parquet", "x.y"};
+    auto now = tracing::trace_clock::now();
+    writer.record(tracing::event{tracing::phase::decompress, &ctx, 1, 10, 20, now, now + std::chrono::microseconds(5)});
+    writer.record(tracing::event{tracing::phase::open, nullptr, -1, 0, 0, now, now});
+    writer.record(tracing::event{tracing::phase::open, nullptr, -1, 0, 0, now, now});
+    BOOST_CHECK_EQUAL(writer.size(), 2);
+    BOOST_CHECK_EQUAL(writer.dropped(), 1);
+    std::string json = writer.json();
+    BOOST_CHECK(json.find("\"traceEvents\":[") != std::string::npos);
+    BOOST_CHECK(json.find("\"name\":\"decompress\"") != std::string::npos);
+    BOOST_CHECK(json.find("\"ph\":\"X\"") != std::string::npos);
+    BOOST_CHECK(json.find("\"dur\":5,") != std::string::npos);
+    BOOST_CHECK(json.find("\"file\":\"dir/\\\"quoted\\\".parquet\"") != std::string::npos);
+    BOOST_CHECK(json.find("\"column\":\"x.y\"") != std::string::npos);
+    BOOST_CHECK(json.find("\"compressed_size\":10,\"uncompressed_size\":20}}") != std::string::npos);
+    BOOST_CHECK(json.find("\"dropped_events\":1") != std::string::npos);
+    return seastar::make_ready_future<>();
+}
+
+} // namespace parquet4seastar